@@ -651,6 +651,14 @@ int DualEdgeTriangulation::baseEdgeOfTriangle( Point3D* point )
   return -100;//this means a bug happened
 }
 
+void DualEdgeTriangulation::addPoints( const QList<Point3D*>& points )
+{
+  //each point inside the convex hull adds six half edges
+  mPointVector.reserve( mPointVector.count() + points.count() );
+  mHalfEdge.reserve( mHalfEdge.count() + 6 * points.count() );
+  Triangulation::addPoints( points );
+}
+
 bool DualEdgeTriangulation::calcNormal( double x, double y, Vector3D* result )
 {
   if ( result && mTriangleInterpolator )
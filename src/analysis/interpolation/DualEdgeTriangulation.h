@@ -46,6 +46,11 @@ class ANALYSIS_EXPORT DualEdgeTriangulation: public Triangulation
     void addLine( Line3D* line, bool breakline ) override;
     /** Adds a point to the triangulation and returns the number of this point in case of success or -100 in case of failure*/
     int addPoint( Point3D* p ) override;
+    /** Adds a set of points to the triangulation, ordered along a Hilbert curve
+     * \note added in QGIS 2.16
+     * \note not available in Python bindings
+     */
+    void addPoints( const QList<Point3D*>& points ) override;
     /** Performs a consistency check, remove this later*/
     virtual void performConsistencyTest() override;
     /** Calculates the normal at a point on the surface*/
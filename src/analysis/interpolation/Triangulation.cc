@@ -13,5 +13,100 @@
  *                                                                         *
  ***************************************************************************/
 #include "Triangulation.h"
+#include "MathUtils.h"
 
-//empty file (abstract class)
+#include <QPair>
+#include <QVector>
+
+#include <cfloat>
+#include <cmath>
+
+//! Number of bits of the grid coordinates used to order points along the Hilbert curve
+static const int HILBERT_ORDER = 16;
+
+//! Minimal distance from the line through the first two points of a bulk insertion for the third point
+static const double COLLINEAR_TOLERANCE = 0.00000001;
+
+typedef QPair<quint64, Point3D*> HilbertPoint;
+
+static bool hilbertLessThan( const HilbertPoint& p1, const HilbertPoint& p2 )
+{
+  return p1.first < p2.first;
+}
+
+//! Returns the distance of the grid cell x, y along the Hilbert curve
+static quint64 hilbertDistance( quint32 x, quint32 y )
+{
+  const quint32 n = 1u << HILBERT_ORDER;
+  quint64 d = 0;
+  for ( quint32 s = n / 2; s > 0; s /= 2 )
+  {
+    quint32 rx = ( x & s ) > 0;
+    quint32 ry = ( y & s ) > 0;
+    d += ( quint64 )s * s * (( 3 * rx ) ^ ry );
+
+    //rotate the quadrant
+    if ( ry == 0 )
+    {
+      if ( rx == 1 )
+      {
+        x = n - 1 - x;
+        y = n - 1 - y;
+      }
+      qSwap( x, y );
+    }
+  }
+  return d;
+}
+
+void Triangulation::addPoints( const QList<Point3D*>& points )
+{
+  if ( points.isEmpty() )
+  {
+    return;
+  }
+
+  double xMin = DBL_MAX;
+  double yMin = DBL_MAX;
+  double xMax = -DBL_MAX;
+  double yMax = -DBL_MAX;
+  Q_FOREACH ( Point3D* p, points )
+  {
+    xMin = qMin( xMin, p->getX() );
+    yMin = qMin( yMin, p->getY() );
+    xMax = qMax( xMax, p->getX() );
+    yMax = qMax( yMax, p->getY() );
+  }
+
+  const double cells = ( 1u << HILBERT_ORDER ) - 1;
+  double xScale = xMax > xMin ? cells / ( xMax - xMin ) : 0;
+  double yScale = yMax > yMin ? cells / ( yMax - yMin ) : 0;
+
+  QVector<HilbertPoint> sortedPoints;
+  sortedPoints.reserve( points.size() );
+  Q_FOREACH ( Point3D* p, points )
+  {
+    quint32 x = ( quint32 )(( p->getX() - xMin ) * xScale );
+    quint32 y = ( quint32 )(( p->getY() - yMin ) * yScale );
+    sortedPoints << qMakePair( hilbertDistance( x, y ), p );
+  }
+  qStableSort( sortedPoints.begin(), sortedPoints.end(), hilbertLessThan );
+
+  //the first three points of an empty triangulation must span a triangle
+  if ( getNumberOfPoints() == 0 && sortedPoints.size() > 2 )
+  {
+    for ( int i = 2; i < sortedPoints.size(); ++i )
+    {
+      if ( fabs( MathUtils::leftOf( sortedPoints.at( i ).second, sortedPoints.at( 0 ).second, sortedPoints.at( 1 ).second ) ) > COLLINEAR_TOLERANCE )
+      {
+        qSwap( sortedPoints[2], sortedPoints[i] );
+        break;
+      }
+    }
+  }
+
+  for ( int i = 0; i < sortedPoints.size(); ++i )
+  {
+    addPoint( sortedPoints.at( i ).second );
+  }
+}
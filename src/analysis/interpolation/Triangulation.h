@@ -48,6 +48,17 @@ class ANALYSIS_EXPORT Triangulation
      */
     virtual int addPoint( Point3D* p ) = 0;
 
+    /**
+     * Adds a set of points to the triangulation. The points are inserted in the order
+     * of a Hilbert curve through their bounding box, so that each point is located starting
+     * from the triangle of a nearby predecessor. This is much faster than inserting
+     * unsorted points one by one with addPoint().
+     * Ownership is transferred to this class
+     * \note added in QGIS 2.16
+     * \note not available in Python bindings
+     */
+    virtual void addPoints( const QList<Point3D*>& points );
+
     /**
      * Calculates the normal at a point on the surface and assigns it to 'result'.
      * @return true in case of success and false in case of failure
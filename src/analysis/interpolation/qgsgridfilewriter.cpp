@@ -17,10 +17,27 @@
 
 #include "qgsgridfilewriter.h"
 #include "qgsinterpolator.h"
+#include "qgslogger.h"
 #include "qgsvectorlayer.h"
 #include <QFile>
 #include <QFileInfo>
 #include <QProgressDialog>
+#include <QtConcurrentMap>
+
+#include <cpl_string.h>
+#include <gdal.h>
+
+#if defined(GDAL_VERSION_NUM) && GDAL_VERSION_NUM >= 1800
+#define TO8F(x) (x).toUtf8().constData()
+#else
+#define TO8F(x) QFile::encodeName( x ).constData()
+#endif
+
+//! Value written for cells without interpolation result
+static const int NODATA_VALUE = -9999;
+
+//! Number of rows interpolated in parallel before they are written
+static const int PARALLEL_ROWS = 32;
 
 QgsGridFileWriter::QgsGridFileWriter( QgsInterpolator* i, const QString& outputPath, const QgsRectangle& extent, int nCols, int nRows, double cellSizeX, double cellSizeY )
     : mInterpolator( i )
@@ -47,25 +64,59 @@ QgsGridFileWriter::QgsGridFileWriter()
 int QgsGridFileWriter::writeFile( bool showProgressDialog )
 {
   QFile outputFile( mOutputFilePath );
+  QTextStream outStream;
+  GDALDriverH outputDriver = nullptr;
+  GDALDatasetH outputDataset = nullptr;
+  GDALRasterBandH outputBand = nullptr;
 
-  if ( !outputFile.open( QFile::WriteOnly ) )
+  if ( mOutputFormat.isEmpty() )
   {
-    return 1;
-  }
+    if ( !outputFile.open( QFile::WriteOnly ) )
+    {
+      return 1;
+    }
 
-  if ( !mInterpolator )
-  {
-    outputFile.remove();
-    return 2;
+    if ( !mInterpolator )
+    {
+      outputFile.remove();
+      return 2;
+    }
+
+    outStream.setDevice( &outputFile );
+    outStream.setRealNumberPrecision( 8 );
+    writeHeader( outStream );
   }
+  else
+  {
+    if ( !mInterpolator )
+    {
+      return 2;
+    }
 
-  QTextStream outStream( &outputFile );
-  outStream.setRealNumberPrecision( 8 );
-  writeHeader( outStream );
+    GDALAllRegister();
+    outputDriver = GDALGetDriverByName( mOutputFormat.toLocal8Bit().data() );
+    if ( !outputDriver || !CSLFetchBoolean( GDALGetMetadata( outputDriver, nullptr ), GDAL_DCAP_CREATE, false ) )
+    {
+      return 1;
+    }
+    outputDataset = GDALCreate( outputDriver, TO8F( mOutputFilePath ), mNumColumns, mNumRows, 1, GDT_Float32, nullptr );
+    if ( !outputDataset )
+    {
+      return 1;
+    }
 
-  double currentYValue = mInterpolationExtent.yMaximum() - mCellSizeY / 2.0; //calculate value in the center of the cell
-  double currentXValue;
-  double interpolatedValue;
+    double geoTransform[6];
+    geoTransform[0] = mInterpolationExtent.xMinimum();
+    geoTransform[1] = mCellSizeX;
+    geoTransform[2] = 0;
+    geoTransform[3] = mInterpolationExtent.yMaximum();
+    geoTransform[4] = 0;
+    geoTransform[5] = -mCellSizeY;
+    GDALSetGeoTransform( outputDataset, geoTransform );
+    GDALSetProjection( outputDataset, outputCrs().toWkt().toLocal8Bit().data() );
+    outputBand = GDALGetRasterBand( outputDataset, 1 );
+    GDALSetRasterNoDataValue( outputBand, NODATA_VALUE );
+  }
 
   QProgressDialog* progressDialog = nullptr;
   if ( showProgressDialog )
@@ -74,40 +125,108 @@ int QgsGridFileWriter::writeFile( bool showProgressDialog )
     progressDialog->setWindowModality( Qt::WindowModal );
   }
 
-  for ( int i = 0; i < mNumRows; ++i )
+  //the base data is cached in this thread before rows are interpolated in parallel. If caching
+  //fails, the rows are interpolated one by one
+  int blockSize = 1;
+  if ( mInterpolator->isThreadSafe() && mInterpolator->prepareInterpolation() == 0 )
+  {
+    blockSize = PARALLEL_ROWS;
+  }
+
+  int row = 0;
+  while ( row < mNumRows )
   {
-    currentXValue = mInterpolationExtent.xMinimum() + mCellSizeX / 2.0; //calculate value in the center of the cell
-    for ( int j = 0; j < mNumColumns; ++j )
+    QList<int> rows;
+    for ( int i = row; i < qMin( row + blockSize, mNumRows ); ++i )
+    {
+      rows << i;
+    }
+
+    QList< QVector<double> > rowValues;
+    if ( rows.size() == 1 )
+    {
+      rowValues << interpolateRow( row );
+    }
+    else
+    {
+      rowValues = QtConcurrent::blockingMapped( rows, InterpolateRowWrapper( this ) );
+    }
+
+    //rows are written in order as soon as they are interpolated
+    bool writeFailed = false;
+    Q_FOREACH ( QVector<double> values, rowValues )
     {
-      if ( mInterpolator->interpolatePoint( currentXValue, currentYValue, interpolatedValue ) == 0 )
+      if ( outputBand )
       {
-        outStream << interpolatedValue << ' ';
+        if ( GDALRasterIO( outputBand, GF_Write, 0, row, mNumColumns, 1, values.data(), mNumColumns, 1, GDT_Float64, 0, 0 ) != CE_None )
+        {
+          QgsDebugMsg( QString( "Could not write row %1" ).arg( row ) );
+          writeFailed = true;
+          break;
+        }
       }
       else
       {
-        outStream << "-9999 ";
+        Q_FOREACH ( double value, values )
+        {
+          outStream << value << ' ';
+        }
+        outStream << endl;
+        if ( outStream.status() != QTextStream::Ok )
+        {
+          QgsDebugMsg( QString( "Could not write row %1" ).arg( row ) );
+          writeFailed = true;
+          break;
+        }
       }
-      currentXValue += mCellSizeX;
+      ++row;
+    }
+
+    //the output would be truncated
+    if ( writeFailed )
+    {
+      delete progressDialog;
+      if ( outputDataset )
+      {
+        GDALClose( outputDataset );
+        GDALDeleteDataset( outputDriver, TO8F( mOutputFilePath ) );
+      }
+      else
+      {
+        outputFile.remove();
+      }
+      return 4;
     }
-    outStream << endl;
-    currentYValue -= mCellSizeY;
 
     if ( showProgressDialog )
     {
       if ( progressDialog->wasCanceled() )
       {
-        outputFile.remove();
+        delete progressDialog;
+        if ( outputDataset )
+        {
+          GDALClose( outputDataset );
+          GDALDeleteDataset( outputDriver, TO8F( mOutputFilePath ) );
+        }
+        else
+        {
+          outputFile.remove();
+        }
         return 3;
       }
-      progressDialog->setValue( i );
+      progressDialog->setValue( row );
     }
   }
 
+  if ( outputDataset )
+  {
+    GDALClose( outputDataset );
+    delete progressDialog;
+    return 0;
+  }
+
   // create prj file
-  QgsInterpolator::LayerData ld;
-  ld = mInterpolator->layerData().first();
-  QgsVectorLayer* vl = ld.vectorLayer;
-  QString crs = vl->crs().toWkt();
+  QString crs = outputCrs().toWkt();
   QFileInfo fi( mOutputFilePath );
   QString fileName = fi.absolutePath() + '/' + fi.completeBaseName() + ".prj";
   QFile prjFile( fileName );
@@ -124,6 +243,34 @@ int QgsGridFileWriter::writeFile( bool showProgressDialog )
   return 0;
 }
 
+QVector<double> QgsGridFileWriter::interpolateRow( int row ) const
+{
+  QVector<double> values( mNumColumns );
+  double currentYValue = mInterpolationExtent.yMaximum() - mCellSizeY / 2.0 - row * mCellSizeY; //calculate value in the center of the cell
+  double interpolatedValue;
+  for ( int j = 0; j < mNumColumns; ++j )
+  {
+    double currentXValue = mInterpolationExtent.xMinimum() + mCellSizeX / 2.0 + j * mCellSizeX;
+    if ( mInterpolator->interpolatePoint( currentXValue, currentYValue, interpolatedValue ) == 0 )
+    {
+      values[j] = interpolatedValue;
+    }
+    else
+    {
+      values[j] = NODATA_VALUE;
+    }
+  }
+  return values;
+}
+
+QgsCoordinateReferenceSystem QgsGridFileWriter::outputCrs() const
+{
+  QgsInterpolator::LayerData ld;
+  ld = mInterpolator->layerData().first();
+  QgsVectorLayer* vl = ld.vectorLayer;
+  return vl->crs();
+}
+
 int QgsGridFileWriter::writeHeader( QTextStream& outStream )
 {
   outStream << "NCOLS " << mNumColumns << endl;
@@ -139,7 +286,7 @@ int QgsGridFileWriter::writeHeader( QTextStream& outStream )
     outStream << "DX " << mCellSizeX << endl;
     outStream << "DY " << mCellSizeY << endl;
   }
-  outStream << "NODATA_VALUE -9999" << endl;
+  outStream << "NODATA_VALUE " << NODATA_VALUE << endl;
 
   return 0;
 }
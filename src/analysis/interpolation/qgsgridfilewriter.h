@@ -21,26 +21,55 @@
 #include "qgsrectangle.h"
 #include <QString>
 #include <QTextStream>
+#include <QVector>
 
+class QgsCoordinateReferenceSystem;
 class QgsInterpolator;
 
-/** A class that does interpolation to a grid and writes the results to an ascii grid*/
-//todo: extend such that writing to other file types is possible
+/** A class that does interpolation to a grid and writes the results to an ascii grid
+ * or, if an output format is set, to a raster file written with GDAL*/
 class ANALYSIS_EXPORT QgsGridFileWriter
 {
   public:
     QgsGridFileWriter( QgsInterpolator* i, const QString& outputPath, const QgsRectangle& extent, int nCols, int nRows, double cellSizeX, double cellSizeY );
 
-    /** Writes the grid file.
+    /** Writes the grid file. If the interpolator is thread safe, rows are interpolated in parallel.
      @param showProgressDialog shows a dialog with the possibility to cancel
-    @return 0 in case of success*/
+    @return 0 in case of success, 1 if the file cannot be created, 2 if there is no interpolator,
+    3 if canceled and 4 if writing the data failed*/
 
     int writeFile( bool showProgressDialog = false );
 
+    /** Sets the GDAL driver used to write the grid. The rows are written to the file as soon as
+     * they are interpolated, the driver has to support creation of new files.
+     * @param format short name of the GDAL driver (e.g. "GTiff"), or an empty string to write an ascii grid (the default)
+     * @note added in QGIS 2.16
+     */
+    void setOutputFormat( const QString& format ) { mOutputFormat = format; }
+
+    /** Returns the GDAL driver used to write the grid, an empty string for an ascii grid.
+     * @note added in QGIS 2.16
+     */
+    QString outputFormat() const { return mOutputFormat; }
+
   private:
 
+    class InterpolateRowWrapper
+    {
+      public:
+        typedef QVector<double> result_type;
+        explicit InterpolateRowWrapper( const QgsGridFileWriter* instance ) : mInstance( instance ) {}
+        QVector<double> operator()( int row ) const { return mInstance->interpolateRow( row ); }
+      private:
+        const QgsGridFileWriter* mInstance;
+    };
+
     QgsGridFileWriter(); //forbidden
     int writeHeader( QTextStream& outStream );
+    /** Interpolates the values of the cells of a row, -9999 for cells without value*/
+    QVector<double> interpolateRow( int row ) const;
+    /** Returns the crs of the first interpolated layer*/
+    QgsCoordinateReferenceSystem outputCrs() const;
 
     QgsInterpolator* mInterpolator;
     QString mOutputFilePath;
@@ -50,6 +79,8 @@ class ANALYSIS_EXPORT QgsGridFileWriter
 
     double mCellSizeX;
     double mCellSizeY;
+
+    QString mOutputFormat;
 };
 
 #endif
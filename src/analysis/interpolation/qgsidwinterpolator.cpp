@@ -18,13 +18,98 @@
 #include "qgsidwinterpolator.h"
 #include <cmath>
 #include <limits>
+#include <algorithm>
 
-QgsIDWInterpolator::QgsIDWInterpolator( const QList<LayerData>& layerData ): QgsInterpolator( layerData ), mDistanceCoefficient( 2.0 )
+//! Squared distance of a sample point and its position in the k-d tree
+typedef QPair<double, int> Neighbor;
+
+static bool xLessThan( const vertexData& v1, const vertexData& v2 )
 {
+  return v1.x < v2.x;
+}
 
+static bool yLessThan( const vertexData& v1, const vertexData& v2 )
+{
+  return v1.y < v2.y;
 }
 
-QgsIDWInterpolator::QgsIDWInterpolator(): QgsInterpolator( QList<LayerData>() ), mDistanceCoefficient( 2.0 )
+// Orders the range [begin, end) of data as a k-d tree: the middle element splits the range by x or y
+static void buildTree( QVector<vertexData>& data, int begin, int end, int depth )
+{
+  if ( end - begin < 2 )
+  {
+    return;
+  }
+
+  int middle = ( begin + end ) / 2;
+  std::nth_element( data.begin() + begin, data.begin() + middle, data.begin() + end, depth % 2 == 0 ? xLessThan : yLessThan );
+  buildTree( data, begin, middle, depth + 1 );
+  buildTree( data, middle + 1, end, depth + 1 );
+}
+
+// Collects the points of the tree range within sqrt( bound ) of x, y. If maxCount > 0, only the maxCount nearest points
+// are kept in the neighbors heap and the bound shrinks to the distance of the farthest of them.
+static void searchTree( const QVector<vertexData>& data, int begin, int end, int depth, double x, double y,
+                        int maxCount, double& bound, QVector<Neighbor>& neighbors )
+{
+  if ( begin >= end )
+  {
+    return;
+  }
+
+  int middle = ( begin + end ) / 2;
+  const vertexData& vertex = data.at( middle );
+  double dx = vertex.x - x;
+  double dy = vertex.y - y;
+  double distance = dx * dx + dy * dy;
+  if ( distance <= bound )
+  {
+    neighbors << Neighbor( distance, middle );
+    if ( maxCount > 0 )
+    {
+      std::push_heap( neighbors.begin(), neighbors.end() );
+      if ( neighbors.size() > maxCount )
+      {
+        std::pop_heap( neighbors.begin(), neighbors.end() );
+        neighbors.pop_back();
+      }
+      if ( neighbors.size() == maxCount )
+      {
+        bound = neighbors.front().first;
+      }
+    }
+  }
+
+  //search the side of the split containing the point first, the other one only if it is within the bound
+  double split = depth % 2 == 0 ? x - vertex.x : y - vertex.y;
+  if ( split < 0 )
+  {
+    searchTree( data, begin, middle, depth + 1, x, y, maxCount, bound, neighbors );
+    if ( split * split <= bound )
+      searchTree( data, middle + 1, end, depth + 1, x, y, maxCount, bound, neighbors );
+  }
+  else
+  {
+    searchTree( data, middle + 1, end, depth + 1, x, y, maxCount, bound, neighbors );
+    if ( split * split <= bound )
+      searchTree( data, begin, middle, depth + 1, x, y, maxCount, bound, neighbors );
+  }
+}
+
+QgsIDWInterpolator::QgsIDWInterpolator( const QList<LayerData>& layerData )
+    : QgsInterpolator( layerData )
+    , mDistanceCoefficient( 2.0 )
+    , mSearchRadius( 0.0 )
+    , mMaximumNeighbors( 0 )
+{
+
+}
+
+QgsIDWInterpolator::QgsIDWInterpolator()
+    : QgsInterpolator( QList<LayerData>() )
+    , mDistanceCoefficient( 2.0 )
+    , mSearchRadius( 0.0 )
+    , mMaximumNeighbors( 0 )
 {
 
 }
@@ -34,12 +119,25 @@ QgsIDWInterpolator::~QgsIDWInterpolator()
 
 }
 
-int QgsIDWInterpolator::interpolatePoint( double x, double y, double& result )
+int QgsIDWInterpolator::prepareInterpolation()
 {
-  if ( !mDataIsCached )
+  bool cached = mDataIsCached;
+  int result = QgsInterpolator::prepareInterpolation();
+  if ( !cached )
+    mTreeData.clear();
+
+  if (( mSearchRadius > 0 || mMaximumNeighbors > 0 ) && mTreeData.isEmpty() && !mCachedBaseData.isEmpty() )
   {
-    cacheBaseData();
+    mTreeData = mCachedBaseData;
+    buildTree( mTreeData, 0, mTreeData.size(), 0 );
   }
+  return result;
+}
+
+int QgsIDWInterpolator::interpolatePoint( double x, double y, double& result )
+{
+  // does nothing once prepared, interpolation from several threads relies on that
+  prepareInterpolation();
 
   double currentWeight;
   double distance;
@@ -47,17 +145,45 @@ int QgsIDWInterpolator::interpolatePoint( double x, double y, double& result )
   double sumCounter = 0;
   double sumDenominator = 0;
 
-  Q_FOREACH ( const vertexData& vertex_it, mCachedBaseData )
+  if ( mSearchRadius <= 0 && mMaximumNeighbors <= 0 )
+  {
+    //all points contribute
+    Q_FOREACH ( const vertexData& vertex_it, mCachedBaseData )
+    {
+      distance = sqrt(( vertex_it.x - x ) * ( vertex_it.x - x ) + ( vertex_it.y - y ) * ( vertex_it.y - y ) );
+      if (( distance - 0 ) < std::numeric_limits<double>::min() )
+      {
+        result = vertex_it.z;
+        return 0;
+      }
+      currentWeight = 1 / ( pow( distance, mDistanceCoefficient ) );
+      sumCounter += ( currentWeight * vertex_it.z );
+      sumDenominator += currentWeight;
+    }
+  }
+  else
   {
-    distance = sqrt(( vertex_it.x - x ) * ( vertex_it.x - x ) + ( vertex_it.y - y ) * ( vertex_it.y - y ) );
-    if (( distance - 0 ) < std::numeric_limits<double>::min() )
+    double bound = mSearchRadius > 0 ? mSearchRadius * mSearchRadius : std::numeric_limits<double>::max();
+    QVector<Neighbor> neighbors;
+    if ( mMaximumNeighbors > 0 )
+    {
+      neighbors.reserve( mMaximumNeighbors + 1 );
+    }
+    searchTree( mTreeData, 0, mTreeData.size(), 0, x, y, mMaximumNeighbors, bound, neighbors );
+
+    Q_FOREACH ( const Neighbor& neighbor, neighbors )
     {
-      result = vertex_it.z;
-      return 0;
+      const vertexData& vertex = mTreeData.at( neighbor.second );
+      distance = sqrt( neighbor.first );
+      if (( distance - 0 ) < std::numeric_limits<double>::min() )
+      {
+        result = vertex.z;
+        return 0;
+      }
+      currentWeight = 1 / ( pow( distance, mDistanceCoefficient ) );
+      sumCounter += ( currentWeight * vertex.z );
+      sumDenominator += currentWeight;
     }
-    currentWeight = 1 / ( pow( distance, mDistanceCoefficient ) );
-    sumCounter += ( currentWeight * vertex_it.z );
-    sumDenominator += currentWeight;
   }
 
   if ( sumDenominator == 0.0 )
@@ -35,6 +35,36 @@ class ANALYSIS_EXPORT QgsIDWInterpolator: public QgsInterpolator
 
     void setDistanceCoefficient( double p ) {mDistanceCoefficient = p;}
 
+    /** Sets the search radius for the sample points. Only points within the radius contribute to
+     * the interpolated value, cells without points within the radius get no value.
+     * @param radius search radius in map units, 0 to use all points (the default)
+     * @note added in QGIS 2.16
+     */
+    void setSearchRadius( double radius ) { mSearchRadius = radius; }
+
+    /** Returns the search radius for the sample points, 0 if all points are used.
+     * @note added in QGIS 2.16
+     */
+    double searchRadius() const { return mSearchRadius; }
+
+    /** Sets the number of nearest sample points which contribute to the interpolated value.
+     * @param count number of points, 0 to use all points (the default)
+     * @note added in QGIS 2.16
+     */
+    void setMaximumNeighbors( int count ) { mMaximumNeighbors = count; }
+
+    /** Returns the number of nearest sample points used for interpolation, 0 if all points are used.
+     * @note added in QGIS 2.16
+     */
+    int maximumNeighbors() const { return mMaximumNeighbors; }
+
+    bool isThreadSafe() const override { return true; }
+
+    /** Caches the base data and builds the search tree if the sample points are limited.
+     * @note added in QGIS 2.16
+     */
+    int prepareInterpolation() override;
+
   private:
 
     QgsIDWInterpolator(); //forbidden
@@ -43,6 +73,16 @@ class ANALYSIS_EXPORT QgsIDWInterpolator: public QgsInterpolator
        Smaller values mean sharper peaks at the data points. The default is a
        value of 2*/
     double mDistanceCoefficient;
+
+    /** Search radius for sample points, 0 if not limited*/
+    double mSearchRadius;
+
+    /** Number of nearest sample points used, 0 if not limited*/
+    int mMaximumNeighbors;
+
+    /** Cached base data ordered as a k-d tree: the middle point of each range splits it by x (even depth) or y (odd depth).
+       Only built if the sample points are limited by radius or count*/
+    QVector<vertexData> mTreeData;
 };
 
 #endif
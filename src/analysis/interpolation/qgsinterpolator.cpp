@@ -39,6 +39,17 @@ QgsInterpolator::~QgsInterpolator()
 
 }
 
+int QgsInterpolator::prepareInterpolation()
+{
+  if ( mDataIsCached )
+    return 0;
+
+  int result = cacheBaseData();
+  // do not try again, e.g. from the threads calling interpolatePoint()
+  mDataIsCached = true;
+  return result;
+}
+
 int QgsInterpolator::cacheBaseData()
 {
   if ( mLayerData.size() < 1 )
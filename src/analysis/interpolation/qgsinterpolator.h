@@ -64,6 +64,19 @@ class ANALYSIS_EXPORT QgsInterpolator
        @return 0 in case of success*/
     virtual int interpolatePoint( double x, double y, double& result ) = 0;
 
+    /** Returns true if interpolatePoint() may be called from several threads at the same time,
+     * once prepareInterpolation() has been called.
+     * @note added in QGIS 2.16
+     */
+    virtual bool isThreadSafe() const { return false; }
+
+    /** Caches the base data, so that interpolatePoint() does not modify the interpolator any more
+     * and may be called from several threads. The cache is only filled once, even if caching fails.
+     * @return 0 in case of success
+     * @note added in QGIS 2.16
+     */
+    virtual int prepareInterpolation();
+
     //! @note not available in Python bindings
     const QList<LayerData>& layerData() const { return mLayerData; }
 
@@ -75,7 +88,7 @@ class ANALYSIS_EXPORT QgsInterpolator
 
     QVector<vertexData> mCachedBaseData;
 
-    /** Flag that tells if the cache already has been filled*/
+    /** Flag that tells if the cache already has been filled (or filling it has been tried)*/
     bool mDataIsCached;
 
     //Information about the input vector layers and the attributes (or z-values) that are used for interpolation
@@ -130,6 +130,7 @@ void QgsTINInterpolator::initialize()
     }
   }
 
+  insertPendingPoints();
   delete theProgressDialog;
 
   if ( mInterpolation == CloughTocher )
@@ -164,6 +165,12 @@ void QgsTINInterpolator::initialize()
   }
 }
 
+void QgsTINInterpolator::insertPendingPoints()
+{
+  mTriangulation->addPoints( mPendingPoints );
+  mPendingPoints.clear();
+}
+
 int QgsTINInterpolator::insertData( QgsFeature* f, bool zCoord, int attr, InputType type )
 {
   if ( !f )
@@ -221,11 +228,7 @@ int QgsTINInterpolator::insertData( QgsFeature* f, bool zCoord, int attr, InputT
       {
         z = attributeValue;
       }
-      Point3D* thePoint = new Point3D( x, y, z );
-      if ( mTriangulation->addPoint( thePoint ) == -100 )
-      {
-        return -1;
-      }
+      mPendingPoints << new Point3D( x, y, z );
       break;
     }
     case QGis::WKBMultiPoint25D:
@@ -275,8 +278,7 @@ int QgsTINInterpolator::insertData( QgsFeature* f, bool zCoord, int attr, InputT
 
         if ( type == POINTS )
         {
-          //todo: handle error code -100
-          mTriangulation->addPoint( new Point3D( x, y, z ) );
+          mPendingPoints << new Point3D( x, y, z );
         }
         else
         {
@@ -286,6 +288,8 @@ int QgsTINInterpolator::insertData( QgsFeature* f, bool zCoord, int attr, InputT
 
       if ( type != POINTS )
       {
+        //keep the order of points and lines
+        insertPendingPoints();
         mTriangulation->addLine( line, type == BREAK_LINES );
       }
       break;
@@ -319,8 +323,7 @@ int QgsTINInterpolator::insertData( QgsFeature* f, bool zCoord, int attr, InputT
 
           if ( type == POINTS )
           {
-            //todo: handle error code -100
-            mTriangulation->addPoint( new Point3D( x, y, z ) );
+            mPendingPoints << new Point3D( x, y, z );
           }
           else
           {
@@ -329,6 +332,8 @@ int QgsTINInterpolator::insertData( QgsFeature* f, bool zCoord, int attr, InputT
         }
         if ( type != POINTS )
         {
+          //keep the order of points and lines
+          insertPendingPoints();
           mTriangulation->addLine( line, type == BREAK_LINES );
         }
       }
@@ -363,8 +368,7 @@ int QgsTINInterpolator::insertData( QgsFeature* f, bool zCoord, int attr, InputT
           }
           if ( type == POINTS )
           {
-            //todo: handle error code -100
-            mTriangulation->addPoint( new Point3D( x, y, z ) );
+            mPendingPoints << new Point3D( x, y, z );
           }
           else
           {
@@ -374,6 +378,8 @@ int QgsTINInterpolator::insertData( QgsFeature* f, bool zCoord, int attr, InputT
 
         if ( type != POINTS )
         {
+          //keep the order of points and lines
+          insertPendingPoints();
           mTriangulation->addLine( line, type == BREAK_LINES );
         }
       }
@@ -413,8 +419,7 @@ int QgsTINInterpolator::insertData( QgsFeature* f, bool zCoord, int attr, InputT
             }
             if ( type == POINTS )
             {
-              //todo: handle error code -100
-              mTriangulation->addPoint( new Point3D( x, y, z ) );
+              mPendingPoints << new Point3D( x, y, z );
             }
             else
             {
@@ -423,6 +428,8 @@ int QgsTINInterpolator::insertData( QgsFeature* f, bool zCoord, int attr, InputT
           }
           if ( type != POINTS )
           {
+            //keep the order of points and lines
+            insertPendingPoints();
             mTriangulation->addLine( line, type == BREAK_LINES );
           }
         }
@@ -21,6 +21,7 @@
 #include "qgsinterpolator.h"
 #include <QString>
 
+class Point3D;
 class Triangulation;
 class TriangleInterpolator;
 class QgsFeature;
@@ -59,6 +60,8 @@ class ANALYSIS_EXPORT QgsTINInterpolator: public QgsInterpolator
     QString mTriangulationFilePath;
     /** Type of interpolation*/
     TIN_INTERPOLATION mInterpolation;
+    /** Points which are collected for bulk insertion into the triangulation*/
+    QList<Point3D*> mPendingPoints;
 
     /** Create dual edge triangulation*/
     void initialize();
@@ -67,8 +70,10 @@ class ANALYSIS_EXPORT QgsTINInterpolator: public QgsInterpolator
       @param zCoord true if the z coordinate is the interpolation attribute
       @param attr interpolation attribute index (if zCoord is false)
       @param type point/structure line, break line
-      @return 0 in case of success, -1 if the feature could not be inserted because of numerical problems*/
+      @return 0 in case of success*/
     int insertData( QgsFeature* f, bool zCoord, int attr, InputType type );
+    /** Inserts the collected points into the triangulation at once*/
+    void insertPendingPoints();
 };
 
 #endif
@@ -18,6 +18,114 @@
 #include "qgsgeometry.h"
 #include "qgslogger.h"
 
+#include <QTemporaryFile>
+
+/**
+ * Coordinates of all nodes of the database ordered by id. They are kept in a memory
+ * mapped temporary file, so that the points of ways are found without querying the
+ * nodes table for each way.
+ */
+class QgsOSMNodeCoordinates
+{
+  public:
+    QgsOSMNodeCoordinates()
+        : mEntries( nullptr )
+        , mCount( 0 )
+    {}
+
+    //! Copies coordinates of nodes from the database, returns false on error
+    bool load( sqlite3* database );
+
+    //! Returns points of the nodes, or an empty polyline if some of the nodes are missing
+    QgsPolyline polyline( const QList<QgsOSMId>& nodes ) const;
+
+  private:
+    struct Entry
+    {
+      QgsOSMId id;
+      double lon;
+      double lat;
+    };
+
+    QTemporaryFile mFile;
+    const Entry* mEntries;
+    qint64 mCount;
+};
+
+bool QgsOSMNodeCoordinates::load( sqlite3* database )
+{
+  sqlite3_stmt* stmt;
+  if ( sqlite3_prepare_v2( database, "SELECT id,lon,lat FROM nodes ORDER BY id", -1, &stmt, nullptr ) != SQLITE_OK )
+    return false;
+
+  if ( !mFile.open() )
+  {
+    sqlite3_finalize( stmt );
+    return false;
+  }
+
+  // write the entries in chunks
+  QVector<Entry> chunk;
+  chunk.reserve( 65536 );
+  bool ok = true;
+  int res = SQLITE_DONE;
+  while ( ok && ( res = sqlite3_step( stmt ) ) == SQLITE_ROW )
+  {
+    Entry entry = { sqlite3_column_int64( stmt, 0 ), sqlite3_column_double( stmt, 1 ), sqlite3_column_double( stmt, 2 ) };
+    chunk << entry;
+    if ( chunk.size() == 65536 )
+    {
+      ok = mFile.write( reinterpret_cast<const char*>( chunk.constData() ), chunk.size() * sizeof( Entry ) ) == ( qint64 )( chunk.size() * sizeof( Entry ) );
+      mCount += chunk.size();
+      chunk.resize( 0 );
+    }
+  }
+  sqlite3_finalize( stmt );
+
+  if ( !ok || res != SQLITE_DONE )
+    return false;
+
+  if ( !chunk.isEmpty() )
+  {
+    if ( mFile.write( reinterpret_cast<const char*>( chunk.constData() ), chunk.size() * sizeof( Entry ) ) != ( qint64 )( chunk.size() * sizeof( Entry ) ) )
+      return false;
+    mCount += chunk.size();
+  }
+
+  if ( mCount == 0 )
+    return true;
+
+  mFile.flush();
+  mEntries = reinterpret_cast<const Entry*>( mFile.map( 0, mCount * sizeof( Entry ) ) );
+  return mEntries;
+}
+
+QgsPolyline QgsOSMNodeCoordinates::polyline( const QList<QgsOSMId>& nodes ) const
+{
+  QgsPolyline points;
+  points.reserve( nodes.count() );
+  Q_FOREACH ( QgsOSMId id, nodes )
+  {
+    // binary search of the node
+    qint64 low = 0;
+    qint64 high = mCount;
+    while ( low < high )
+    {
+      qint64 middle = low + ( high - low ) / 2;
+      if ( mEntries[middle].id < id )
+        low = middle + 1;
+      else
+        high = middle;
+    }
+
+    if ( low == mCount || mEntries[low].id != id )
+      return QgsPolyline(); // missing some nodes
+
+    points.append( QgsPoint( mEntries[low].lon, mEntries[low].lat ) );
+  }
+  return points;
+}
+
 
 QgsOSMDatabase::QgsOSMDatabase( const QString& dbFileName )
     : mDbFileName( dbFileName )
@@ -459,13 +567,17 @@ void QgsOSMDatabase::exportSpatiaLiteWays( bool closed, const QString& tableName
     return;
   }
 
+  // points of ways are assembled from a copy of the coordinates of all nodes if possible
+  QgsOSMNodeCoordinates nodeCoordinates;
+  bool useNodeCoordinates = nodeCoordinates.load( mDatabase );
+
   QgsOSMWayIterator ways = listWays();
   QgsOSMWay w;
   while (( w = ways.next() ).isValid() )
   {
     QgsOSMTags t = tags( true, w.id() );
 
-    QgsPolyline polyline = wayPoints( w.id() );
+    QgsPolyline polyline = useNodeCoordinates ? nodeCoordinates.polyline( way( w.id() ).nodes() ) : wayPoints( w.id() );
 
     if ( polyline.count() < 2 )
       continue; // invalid way
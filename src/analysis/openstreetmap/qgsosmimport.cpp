@@ -17,7 +17,543 @@
 #include "qgsslconnect.h"
 
 #include <QStringList>
+#include <QThread>
 #include <QXmlStreamReader>
+#include <QtConcurrentMap>
+#include <QtEndian>
+
+//! Number of rows stored with a single multi-row INSERT statement
+static const int INSERT_BATCH_SIZE = 100;
+
+//! Maximum size of a blob header in PBF files
+static const int PBF_MAX_HEADER_SIZE = 64 * 1024;
+
+//! Maximum size of a blob in PBF files (compressed or not)
+static const int PBF_MAX_BLOB_SIZE = 32 * 1024 * 1024;
+
+/**
+ * Reader of fields of a protocol buffer message, as used by the OpenStreetMap PBF format.
+ * The message does not own its data.
+ */
+class QgsOSMPbfMessage
+{
+  public:
+    QgsOSMPbfMessage( const char* data = nullptr, int size = 0 )
+        : mPos( reinterpret_cast<const uchar*>( data ) )
+        , mEnd( reinterpret_cast<const uchar*>( data ) + size )
+        , mField( 0 )
+        , mWireType( 0 )
+        , mError( false )
+    {}
+
+    //! Moves to the next field, returns false at the end of the message or on error
+    bool next()
+    {
+      if ( atEnd() )
+        return false;
+
+      quint64 key = varint();
+      mField = key >> 3;
+      mWireType = key & 0x7;
+      return !mError;
+    }
+
+    //! Number of the current field
+    int field() const { return mField; }
+
+    bool atEnd() const { return mError || mPos >= mEnd; }
+    bool hasError() const { return mError; }
+
+    //! Reads unsigned variable length integer (also used for packed values)
+    quint64 varint()
+    {
+      quint64 value = 0;
+      for ( int shift = 0; shift < 64 && mPos < mEnd; shift += 7 )
+      {
+        uchar byte = *mPos++;
+        value |= ( quint64 )( byte & 0x7f ) << shift;
+        if ( !( byte & 0x80 ) )
+          return value;
+      }
+      mError = true;
+      return 0;
+    }
+
+    //! Reads zigzag encoded signed variable length integer
+    qint64 svarint()
+    {
+      quint64 value = varint();
+      return ( qint64 )( value >> 1 ) ^ -( qint64 )( value & 1 );
+    }
+
+    //! Returns content of a length delimited field (string, sub-message or packed values)
+    QgsOSMPbfMessage bytes()
+    {
+      quint64 size = mWireType == 2 ? varint() : 0;
+      if ( mWireType != 2 || mError || size > ( quint64 )( mEnd - mPos ) )
+      {
+        mError = true;
+        return QgsOSMPbfMessage();
+      }
+      QgsOSMPbfMessage message( reinterpret_cast<const char*>( mPos ), ( int ) size );
+      mPos += size;
+      return message;
+    }
+
+    //! Returns a copy of the remaining data of the message
+    QByteArray toByteArray() const
+    {
+      return QByteArray( reinterpret_cast<const char*>( mPos ), ( int )( mEnd - mPos ) );
+    }
+
+    //! Skips value of the current field
+    void skip()
+    {
+      switch ( mWireType )
+      {
+        case 0:
+          varint();
+          break;
+        case 1:
+          advance( 8 );
+          break;
+        case 2:
+          bytes();
+          break;
+        case 5:
+          advance( 4 );
+          break;
+        default:
+          mError = true;
+      }
+    }
+
+  private:
+    void advance( int size )
+    {
+      if ( mEnd - mPos < size )
+        mError = true;
+      else
+        mPos += size;
+    }
+
+    const uchar* mPos;
+    const uchar* mEnd;
+    int mField;
+    int mWireType;
+    bool mError;
+};
+
+//! Block of a PBF file as read from the input file
+struct QgsOSMPbfBlob
+{
+  QByteArray type;
+  QByteArray data;
+};
+
+//! Decoded content of a PBF block
+struct QgsOSMPbfBlock
+{
+  //! Node or way of the block
+  struct Element
+  {
+    QgsOSMId id;
+    double lat;
+    double lon;
+    int firstTag;
+    int tagCount;
+    int firstRef;
+    int refCount;
+  };
+
+  QString error;
+  QVector<QByteArray> strings;
+  QVector<Element> nodes;
+  QVector<Element> ways;
+  //! Keys and values of tags of all elements as indexes to strings
+  QVector< QPair<int, int> > tags;
+  //! Nodes of all ways
+  QVector<QgsOSMId> refs;
+};
+
+//! Reads next blob of a PBF file, returns false at the end of the file or on error
+static bool readPbfBlob( QIODevice& input, QgsOSMPbfBlob& blob, QString& error )
+{
+  QByteArray sizeData = input.read( 4 );
+  if ( sizeData.isEmpty() )
+    return false; // end of file
+
+  quint32 headerSize = sizeData.size() == 4 ? qFromBigEndian<quint32>( reinterpret_cast<const uchar*>( sizeData.constData() ) ) : 0;
+  QByteArray header = headerSize > 0 && headerSize <= ( quint32 ) PBF_MAX_HEADER_SIZE ? input.read( headerSize ) : QByteArray();
+  if ( header.isEmpty() || header.size() != ( int ) headerSize )
+  {
+    error = QString( "Invalid PBF blob header at position %1." ).arg( input.pos() );
+    return false;
+  }
+
+  QgsOSMPbfMessage message( header.constData(), header.size() );
+  qint64 dataSize = -1;
+  blob.type.clear();
+  while ( message.next() )
+  {
+    if ( message.field() == 1 )
+      blob.type = message.bytes().toByteArray();
+    else if ( message.field() == 3 )
+      dataSize = message.varint();
+    else
+      message.skip();
+  }
+
+  if ( message.hasError() || dataSize < 0 || dataSize > PBF_MAX_BLOB_SIZE )
+  {
+    error = QString( "Invalid PBF blob header at position %1." ).arg( input.pos() );
+    return false;
+  }
+
+  blob.data = input.read( dataSize );
+  if ( blob.data.size() != dataSize )
+  {
+    error = "Truncated PBF file.";
+    return false;
+  }
+  return true;
+}
+
+//! Returns the uncompressed content of a blob
+static QByteArray pbfBlobData( const QByteArray& blob, QString& error )
+{
+  QgsOSMPbfMessage message( blob.constData(), blob.size() );
+  QByteArray raw;
+  QByteArray zlibData;
+  qint64 rawSize = -1;
+  while ( message.next() )
+  {
+    if ( message.field() == 1 )
+      raw = message.bytes().toByteArray();
+    else if ( message.field() == 2 )
+      rawSize = message.varint();
+    else if ( message.field() == 3 )
+      zlibData = message.bytes().toByteArray();
+    else
+    {
+      // all other fields of a blob hold its data in other compressions (lzma,
+      // bzip2, lz4, zstd), skipping them would silently drop the block
+      error = "Unsupported compression of PBF blob.";
+      return QByteArray();
+    }
+  }
+
+  if ( message.hasError() )
+  {
+    error = "Invalid PBF blob.";
+    return QByteArray();
+  }
+
+  if ( zlibData.isEmpty() )
+    return raw;
+
+  if ( rawSize < 0 || rawSize > PBF_MAX_BLOB_SIZE )
+  {
+    error = "Invalid size of PBF blob.";
+    return QByteArray();
+  }
+
+  // qUncompress() expects the size of the uncompressed data in front of the zlib stream
+  QByteArray compressed( 4, 0 );
+  qToBigEndian<quint32>( rawSize, reinterpret_cast<uchar*>( compressed.data() ) );
+  compressed += zlibData;
+  QByteArray data = qUncompress( compressed );
+  if ( data.size() != rawSize )
+  {
+    error = "Decompressing of PBF blob failed.";
+    return QByteArray();
+  }
+  return data;
+}
+
+static void decodePbfHeader( const QByteArray& data, QgsOSMPbfBlock& block )
+{
+  QgsOSMPbfMessage message( data.constData(), data.size() );
+  while ( message.next() )
+  {
+    if ( message.field() == 4 ) // required_features
+    {
+      QByteArray feature = message.bytes().toByteArray();
+      if ( feature != "OsmSchema-V0.6" && feature != "DenseNodes" )
+      {
+        block.error = QString( "Unsupported feature of PBF file: %1" ).arg( QString::fromUtf8( feature ) );
+        return;
+      }
+    }
+    else
+      message.skip();
+  }
+
+  if ( message.hasError() )
+    block.error = "Invalid PBF header block.";
+}
+
+//! Reads packed values of a repeated field
+static void readPacked( QgsOSMPbfMessage message, QVector<int>& values )
+{
+  while ( !message.atEnd() )
+    values << ( int ) message.varint();
+}
+
+//! Reads packed, zigzag and delta encoded values of a repeated field
+static bool readPackedDelta( QgsOSMPbfMessage message, QVector<qint64>& values )
+{
+  qint64 value = 0;
+  while ( !message.atEnd() )
+  {
+    value += message.svarint();
+    values << value;
+  }
+  return !message.hasError();
+}
+
+//! Coordinate transformation of a primitive block
+struct QgsOSMPbfCoordinates
+{
+  qint64 granularity;
+  qint64 latOffset;
+  qint64 lonOffset;
+
+  double lat( qint64 value ) const { return ( latOffset + granularity * value ) / 1e9; }
+  double lon( qint64 value ) const { return ( lonOffset + granularity * value ) / 1e9; }
+};
+
+//! Appends keys and values given as separate lists to the tags of the block
+static bool addPbfTags( const QVector<int>& keys, const QVector<int>& values, QgsOSMPbfBlock& block, QgsOSMPbfBlock::Element& element )
+{
+  if ( keys.size() != values.size() )
+    return false;
+
+  element.firstTag = block.tags.size();
+  element.tagCount = keys.size();
+  for ( int i = 0; i < keys.size(); ++i )
+    block.tags << qMakePair( keys.at( i ), values.at( i ) );
+  return true;
+}
+
+static bool decodePbfNode( QgsOSMPbfMessage message, const QgsOSMPbfCoordinates& coordinates, QgsOSMPbfBlock& block )
+{
+  QgsOSMPbfBlock::Element node = { 0, 0, 0, 0, 0, 0, 0 };
+  QVector<int> keys;
+  QVector<int> values;
+  while ( message.next() )
+  {
+    switch ( message.field() )
+    {
+      case 1:
+        node.id = message.svarint();
+        break;
+      case 2:
+        readPacked( message.bytes(), keys );
+        break;
+      case 3:
+        readPacked( message.bytes(), values );
+        break;
+      case 8:
+        node.lat = coordinates.lat( message.svarint() );
+        break;
+      case 9:
+        node.lon = coordinates.lon( message.svarint() );
+        break;
+      default:
+        message.skip();
+    }
+  }
+
+  if ( message.hasError() || !addPbfTags( keys, values, block, node ) )
+    return false;
+
+  block.nodes << node;
+  return true;
+}
+
+static bool decodePbfDenseNodes( QgsOSMPbfMessage message, const QgsOSMPbfCoordinates& coordinates, QgsOSMPbfBlock& block )
+{
+  QVector<qint64> ids;
+  QVector<qint64> lats;
+  QVector<qint64> lons;
+  QVector<int> keysValues;
+  bool ok = true;
+  while ( ok && message.next() )
+  {
+    switch ( message.field() )
+    {
+      case 1:
+        ok = readPackedDelta( message.bytes(), ids );
+        break;
+      case 8:
+        ok = readPackedDelta( message.bytes(), lats );
+        break;
+      case 9:
+        ok = readPackedDelta( message.bytes(), lons );
+        break;
+      case 10:
+        readPacked( message.bytes(), keysValues );
+        break;
+      default:
+        message.skip();
+    }
+  }
+
+  if ( !ok || message.hasError() || ids.size() != lats.size() || ids.size() != lons.size() )
+    return false;
+
+  // keys and values of all nodes, the tags of each node are terminated by 0
+  int keyValueIndex = 0;
+  block.nodes.reserve( block.nodes.size() + ids.size() );
+  for ( int i = 0; i < ids.size(); ++i )
+  {
+    QgsOSMPbfBlock::Element node = { ids.at( i ), coordinates.lat( lats.at( i ) ), coordinates.lon( lons.at( i ) ), block.tags.size(), 0, 0, 0 };
+    while ( keyValueIndex < keysValues.size() && keysValues.at( keyValueIndex ) != 0 )
+    {
+      if ( keyValueIndex + 1 >= keysValues.size() )
+        return false;
+      block.tags << qMakePair( keysValues.at( keyValueIndex ), keysValues.at( keyValueIndex + 1 ) );
+      ++node.tagCount;
+      keyValueIndex += 2;
+    }
+    ++keyValueIndex;
+    block.nodes << node;
+  }
+  return true;
+}
+
+static bool decodePbfWay( QgsOSMPbfMessage message, QgsOSMPbfBlock& block )
+{
+  QgsOSMPbfBlock::Element way = { 0, 0, 0, 0, 0, block.refs.size(), 0 };
+  QVector<int> keys;
+  QVector<int> values;
+  QVector<qint64> refs;
+  bool ok = true;
+  while ( ok && message.next() )
+  {
+    switch ( message.field() )
+    {
+      case 1:
+        way.id = message.varint();
+        break;
+      case 2:
+        readPacked( message.bytes(), keys );
+        break;
+      case 3:
+        readPacked( message.bytes(), values );
+        break;
+      case 8:
+        ok = readPackedDelta( message.bytes(), refs );
+        break;
+      default:
+        message.skip();
+    }
+  }
+
+  if ( !ok || message.hasError() || !addPbfTags( keys, values, block, way ) )
+    return false;
+
+  way.refCount = refs.size();
+  block.refs += refs;
+  block.ways << way;
+  return true;
+}
+
+static void decodePbfPrimitiveBlock( const QByteArray& data, QgsOSMPbfBlock& block )
+{
+  QgsOSMPbfCoordinates coordinates = { 100, 0, 0 };
+  QList<QgsOSMPbfMessage> groups;
+
+  QgsOSMPbfMessage message( data.constData(), data.size() );
+  while ( message.next() )
+  {
+    switch ( message.field() )
+    {
+      case 1: // string table
+      {
+        QgsOSMPbfMessage stringTable = message.bytes();
+        while ( stringTable.next() )
+        {
+          if ( stringTable.field() == 1 )
+            block.strings << stringTable.bytes().toByteArray();
+          else
+            stringTable.skip();
+        }
+        if ( stringTable.hasError() )
+        {
+          block.error = "Invalid string table in PBF block.";
+          return;
+        }
+        break;
+      }
+      case 2:
+        // decoded when the granularity and offsets are known
+        groups << message.bytes();
+        break;
+      case 17:
+        coordinates.granularity = message.varint();
+        break;
+      case 19:
+        coordinates.latOffset = message.varint();
+        break;
+      case 20:
+        coordinates.lonOffset = message.varint();
+        break;
+      default:
+        message.skip();
+    }
+  }
+
+  bool ok = !message.hasError();
+  Q_FOREACH ( QgsOSMPbfMessage group, groups )
+  {
+    while ( ok && group.next() )
+    {
+      switch ( group.field() )
+      {
+        case 1:
+          ok = decodePbfNode( group.bytes(), coordinates, block );
+          break;
+        case 2:
+          ok = decodePbfDenseNodes( group.bytes(), coordinates, block );
+          break;
+        case 3:
+          ok = decodePbfWay( group.bytes(), block );
+          break;
+        default:
+          // relations and changesets are not imported
+          group.skip();
+      }
+    }
+    ok = ok && !group.hasError();
+  }
+
+  for ( int i = 0; ok && i < block.tags.size(); ++i )
+  {
+    const QPair<int, int>& tag = block.tags.at( i );
+    ok = tag.first >= 0 && tag.first < block.strings.size() && tag.second >= 0 && tag.second < block.strings.size();
+  }
+
+  if ( !ok )
+    block.error = "Invalid PBF data block.";
+}
+
+//! Decompresses and decodes a blob, called from worker threads
+static QgsOSMPbfBlock decodePbfBlob( const QgsOSMPbfBlob& blob )
+{
+  QgsOSMPbfBlock block;
+  QByteArray data = pbfBlobData( blob.data, block.error );
+  if ( !block.error.isEmpty() )
+    return block;
+
+  if ( blob.type == "OSMHeader" )
+    decodePbfHeader( data, block );
+  else if ( blob.type == "OSMData" )
+    decodePbfPrimitiveBlock( data, block );
+  // blobs of other types are ignored
+  return block;
+}
 
 
 QgsOSMXmlImport::QgsOSMXmlImport( const QString& xmlFilename, const QString& dbFilename )
@@ -29,6 +565,8 @@ QgsOSMXmlImport::QgsOSMXmlImport( const QString& xmlFilename, const QString& dbF
     , mStmtInsertWay( nullptr )
     , mStmtInsertWayNode( nullptr )
     , mStmtInsertWayTag( nullptr )
+    , mStmtInsertNodeBatch( nullptr )
+    , mStmtInsertWayNodeBatch( nullptr )
 {
 
 }
@@ -36,6 +574,8 @@ QgsOSMXmlImport::QgsOSMXmlImport( const QString& xmlFilename, const QString& dbF
 bool QgsOSMXmlImport::import()
 {
   mError.clear();
+  mNodeBatch.clear();
+  mWayNodeBatch.clear();
 
   // open input
   mInputFile.setFileName( mXmlFileName );
@@ -68,37 +608,56 @@ bool QgsOSMXmlImport::import()
   Q_ASSERT( retX == SQLITE_OK );
   Q_UNUSED( retX );
 
-  // start parsing
+  bool res = true;
+  if ( mXmlFileName.endsWith( ".pbf", Qt::CaseInsensitive ) )
+  {
+    res = readPbf();
+  }
+  else
+  {
+    // start parsing
 
-  QXmlStreamReader xml( &mInputFile );
+    QXmlStreamReader xml( &mInputFile );
 
-  while ( !xml.atEnd() )
-  {
-    xml.readNext();
+    while ( !xml.atEnd() )
+    {
+      xml.readNext();
 
-    if ( xml.isEndDocument() )
-      break;
+      if ( xml.isEndDocument() )
+        break;
 
-    if ( xml.isStartElement() )
+      if ( xml.isStartElement() )
+      {
+        if ( xml.name() == "osm" )
+          readRoot( xml );
+        else
+          xml.raiseError( "Invalid root tag" );
+      }
+    }
+
+    if ( xml.hasError() )
     {
-      if ( xml.name() == "osm" )
-        readRoot( xml );
-      else
-        xml.raiseError( "Invalid root tag" );
+      mError = QString( "XML error: %1" ).arg( xml.errorString() );
+      res = false;
     }
   }
 
+  // store the rest of the batches
+  if ( res && ( !flushNodes() || !flushWayNodes() ) )
+  {
+    mError = "Storing nodes failed.";
+    res = false;
+  }
+
   int retY = sqlite3_exec( mDatabase, "COMMIT", nullptr, nullptr, nullptr );
   Q_ASSERT( retY == SQLITE_OK );
   Q_UNUSED( retY );
 
+  // indexes are only created after all rows are inserted
   createIndexes();
 
-  if ( xml.hasError() )
-  {
-    mError = QString( "XML error: %1" ).arg( xml.errorString() );
+  if ( !res )
     return false;
-  }
 
   closeDatabase();
 
@@ -154,6 +713,7 @@ bool QgsOSMXmlImport::createDatabase()
   {
     "PRAGMA cache_size = 100000", // TODO!!!
     "PRAGMA synchronous = OFF", // TODO!!!
+    "PRAGMA journal_mode = OFF", // no rollback needed, a failed import is started from scratch
     above41 ? "SELECT InitSpatialMetadata(1)" : "SELECT InitSpatialMetadata()",
     "CREATE TABLE nodes ( id INTEGER PRIMARY KEY, lat REAL, lon REAL )",
     "CREATE TABLE nodes_tags ( id INTEGER, k TEXT, v TEXT )",
@@ -207,6 +767,29 @@ bool QgsOSMXmlImport::createDatabase()
     }
   }
 
+  // multi-row statements for the largest tables
+  QByteArray sqlInsertNodeBatch = "INSERT INTO nodes ( id, lat, lon ) VALUES (?,?,?)";
+  QByteArray sqlInsertWayNodeBatch = "INSERT INTO ways_nodes ( way_id, node_id, way_pos ) VALUES (?,?,?)";
+  for ( int i = 1; i < INSERT_BATCH_SIZE; ++i )
+  {
+    sqlInsertNodeBatch += ",(?,?,?)";
+    sqlInsertWayNodeBatch += ",(?,?,?)";
+  }
+  QByteArray sqlInsertBatchStatements[] = { sqlInsertNodeBatch, sqlInsertWayNodeBatch };
+  sqlite3_stmt** sqliteInsertBatchStatements[] = { &mStmtInsertNodeBatch, &mStmtInsertWayNodeBatch };
+
+  for ( int i = 0; i < 2; ++i )
+  {
+    if ( sqlite3_prepare_v2( mDatabase, sqlInsertBatchStatements[i].constData(), -1, sqliteInsertBatchStatements[i], nullptr ) != SQLITE_OK )
+    {
+      const char* errMsg = sqlite3_errmsg( mDatabase ); // does not require free
+      mError = QString( "Error preparing SQL command:\n%1\nSQL:\n%2" )
+               .arg( QString::fromUtf8( errMsg ), QString::fromUtf8( sqlInsertBatchStatements[i] ) );
+      closeDatabase();
+      return false;
+    }
+  }
+
   return true;
 }
 
@@ -231,6 +814,8 @@ bool QgsOSMXmlImport::closeDatabase()
   deleteStatement( mStmtInsertWay );
   deleteStatement( mStmtInsertWayNode );
   deleteStatement( mStmtInsertWayTag );
+  deleteStatement( mStmtInsertNodeBatch );
+  deleteStatement( mStmtInsertWayNodeBatch );
 
   Q_ASSERT( !mStmtInsertNode );
 
@@ -254,7 +839,7 @@ void QgsOSMXmlImport::readRoot( QXmlStreamReader& xml )
 
     if ( xml.isStartElement() )
     {
-      if ( ++i == 500 )
+      if ( ++i == 500 && mInputFile.size() > 0 )
       {
         int new_percent = 100 * mInputFile.pos() / mInputFile.size();
         if ( new_percent > percent )
@@ -285,17 +870,11 @@ void QgsOSMXmlImport::readNode( QXmlStreamReader& xml )
   double lon = attrs.value( "lon" ).toString().toDouble();
 
   // insert to DB
-  sqlite3_bind_int64( mStmtInsertNode, 1, id );
-  sqlite3_bind_double( mStmtInsertNode, 2, lat );
-  sqlite3_bind_double( mStmtInsertNode, 3, lon );
-
-  if ( sqlite3_step( mStmtInsertNode ) != SQLITE_DONE )
+  if ( !insertNode( id, lat, lon ) )
   {
     xml.raiseError( QString( "Storing node %1 failed." ).arg( id ) );
   }
 
-  sqlite3_reset( mStmtInsertNode );
-
   while ( !xml.atEnd() )
   {
     xml.readNext();
@@ -320,19 +899,10 @@ void QgsOSMXmlImport::readTag( bool way, QgsOSMId id, QXmlStreamReader& xml )
   QByteArray v = attrs.value( "v" ).toString().toUtf8();
   xml.skipCurrentElement();
 
-  sqlite3_stmt* stmtInsertTag = way ? mStmtInsertWayTag : mStmtInsertNodeTag;
-
-  sqlite3_bind_int64( stmtInsertTag, 1, id );
-  sqlite3_bind_text( stmtInsertTag, 2, k.constData(), -1, SQLITE_STATIC );
-  sqlite3_bind_text( stmtInsertTag, 3, v.constData(), -1, SQLITE_STATIC );
-
-  int res = sqlite3_step( stmtInsertTag );
-  if ( res != SQLITE_DONE )
+  if ( !insertTag( way, id, k, v ) )
   {
-    xml.raiseError( QString( "Storing tag failed [%1]" ).arg( res ) );
+    xml.raiseError( "Storing tag failed." );
   }
-
-  sqlite3_reset( stmtInsertTag );
 }
 
 void QgsOSMXmlImport::readWay( QXmlStreamReader& xml )
@@ -353,15 +923,11 @@ void QgsOSMXmlImport::readWay( QXmlStreamReader& xml )
   QgsOSMId id = attrs.value( "id" ).toString().toLongLong();
 
   // insert to DB
-  sqlite3_bind_int64( mStmtInsertWay, 1, id );
-
-  if ( sqlite3_step( mStmtInsertWay ) != SQLITE_DONE )
+  if ( !insertWay( id ) )
   {
     xml.raiseError( QString( "Storing way %1 failed." ).arg( id ) );
   }
 
-  sqlite3_reset( mStmtInsertWay );
-
   int way_pos = 0;
 
   while ( !xml.atEnd() )
@@ -377,17 +943,11 @@ void QgsOSMXmlImport::readWay( QXmlStreamReader& xml )
       {
         QgsOSMId node_id = xml.attributes().value( "ref" ).toString().toLongLong();
 
-        sqlite3_bind_int64( mStmtInsertWayNode, 1, id );
-        sqlite3_bind_int64( mStmtInsertWayNode, 2, node_id );
-        sqlite3_bind_int( mStmtInsertWayNode, 3, way_pos );
-
-        if ( sqlite3_step( mStmtInsertWayNode ) != SQLITE_DONE )
+        if ( !insertWayNode( id, node_id, way_pos ) )
         {
           xml.raiseError( QString( "Storing ways_nodes %1 - %2 failed." ).arg( id ).arg( node_id ) );
         }
 
-        sqlite3_reset( mStmtInsertWayNode );
-
         way_pos++;
 
         xml.skipCurrentElement();
@@ -399,3 +959,206 @@ void QgsOSMXmlImport::readWay( QXmlStreamReader& xml )
     }
   }
 }
+
+
+bool QgsOSMXmlImport::readPbf()
+{
+  // blocks are decoded in parallel, a few blocks for each thread are read at once
+  const int blobCount = qMax( QThread::idealThreadCount(), 1 ) * 4;
+  int percent = -1;
+  bool atEnd = false;
+
+  while ( !atEnd )
+  {
+    QList<QgsOSMPbfBlob> blobs;
+    while ( blobs.size() < blobCount )
+    {
+      QgsOSMPbfBlob blob;
+      if ( !readPbfBlob( mInputFile, blob, mError ) )
+      {
+        atEnd = true;
+        break;
+      }
+      blobs << blob;
+    }
+
+    if ( !mError.isEmpty() )
+      return false;
+
+    // the rows are stored in the order of the file
+    QList<QgsOSMPbfBlock> blocks = QtConcurrent::blockingMapped( blobs, decodePbfBlob );
+    Q_FOREACH ( const QgsOSMPbfBlock& block, blocks )
+    {
+      if ( !block.error.isEmpty() )
+      {
+        mError = block.error;
+        return false;
+      }
+
+      if ( !storePbfBlock( block ) )
+        return false;
+    }
+
+    if ( mInputFile.size() > 0 )
+    {
+      int new_percent = 100 * mInputFile.pos() / mInputFile.size();
+      if ( new_percent > percent )
+      {
+        emit progress( new_percent );
+        percent = new_percent;
+      }
+    }
+  }
+
+  return true;
+}
+
+bool QgsOSMXmlImport::storePbfBlock( const QgsOSMPbfBlock& block )
+{
+  for ( int i = 0; i < block.nodes.size(); ++i )
+  {
+    const QgsOSMPbfBlock::Element& node = block.nodes.at( i );
+    if ( !insertNode( node.id, node.lat, node.lon ) )
+    {
+      mError = QString( "Storing node %1 failed." ).arg( node.id );
+      return false;
+    }
+
+    for ( int j = node.firstTag; j < node.firstTag + node.tagCount; ++j )
+    {
+      if ( !insertTag( false, node.id, block.strings.at( block.tags.at( j ).first ), block.strings.at( block.tags.at( j ).second ) ) )
+      {
+        mError = "Storing tag failed.";
+        return false;
+      }
+    }
+  }
+
+  for ( int i = 0; i < block.ways.size(); ++i )
+  {
+    const QgsOSMPbfBlock::Element& way = block.ways.at( i );
+    if ( !insertWay( way.id ) )
+    {
+      mError = QString( "Storing way %1 failed." ).arg( way.id );
+      return false;
+    }
+
+    for ( int j = 0; j < way.refCount; ++j )
+    {
+      if ( !insertWayNode( way.id, block.refs.at( way.firstRef + j ), j ) )
+      {
+        mError = QString( "Storing ways_nodes %1 - %2 failed." ).arg( way.id ).arg( block.refs.at( way.firstRef + j ) );
+        return false;
+      }
+    }
+
+    for ( int j = way.firstTag; j < way.firstTag + way.tagCount; ++j )
+    {
+      if ( !insertTag( true, way.id, block.strings.at( block.tags.at( j ).first ), block.strings.at( block.tags.at( j ).second ) ) )
+      {
+        mError = "Storing tag failed.";
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+
+bool QgsOSMXmlImport::insertNode( QgsOSMId id, double lat, double lon )
+{
+  NodeRow row = { id, lat, lon };
+  mNodeBatch << row;
+  return mNodeBatch.size() < INSERT_BATCH_SIZE || flushNodes();
+}
+
+bool QgsOSMXmlImport::insertWayNode( QgsOSMId wayId, QgsOSMId nodeId, int wayPos )
+{
+  WayNodeRow row = { wayId, nodeId, wayPos };
+  mWayNodeBatch << row;
+  return mWayNodeBatch.size() < INSERT_BATCH_SIZE || flushWayNodes();
+}
+
+bool QgsOSMXmlImport::insertWay( QgsOSMId id )
+{
+  sqlite3_bind_int64( mStmtInsertWay, 1, id );
+  int res = sqlite3_step( mStmtInsertWay );
+  sqlite3_reset( mStmtInsertWay );
+  return res == SQLITE_DONE;
+}
+
+bool QgsOSMXmlImport::insertTag( bool way, QgsOSMId id, const QByteArray& k, const QByteArray& v )
+{
+  sqlite3_stmt* stmtInsertTag = way ? mStmtInsertWayTag : mStmtInsertNodeTag;
+
+  sqlite3_bind_int64( stmtInsertTag, 1, id );
+  sqlite3_bind_text( stmtInsertTag, 2, k.constData(), k.size(), SQLITE_STATIC );
+  sqlite3_bind_text( stmtInsertTag, 3, v.constData(), v.size(), SQLITE_STATIC );
+
+  int res = sqlite3_step( stmtInsertTag );
+  sqlite3_reset( stmtInsertTag );
+  return res == SQLITE_DONE;
+}
+
+bool QgsOSMXmlImport::flushNodes()
+{
+  // full batches are stored with a single statement, the rest row by row
+  bool batch = mNodeBatch.size() == INSERT_BATCH_SIZE;
+  sqlite3_stmt* stmt = batch ? mStmtInsertNodeBatch : mStmtInsertNode;
+  bool ok = true;
+  int col = 0;
+  for ( int i = 0; i < mNodeBatch.size() && ok; ++i )
+  {
+    const NodeRow& row = mNodeBatch.at( i );
+    sqlite3_bind_int64( stmt, ++col, row.id );
+    sqlite3_bind_double( stmt, ++col, row.lat );
+    sqlite3_bind_double( stmt, ++col, row.lon );
+    if ( !batch )
+    {
+      ok = sqlite3_step( stmt ) == SQLITE_DONE;
+      sqlite3_reset( stmt );
+      col = 0;
+    }
+  }
+
+  if ( batch )
+  {
+    ok = sqlite3_step( stmt ) == SQLITE_DONE;
+    sqlite3_reset( stmt );
+  }
+
+  mNodeBatch.clear();
+  return ok;
+}
+
+bool QgsOSMXmlImport::flushWayNodes()
+{
+  // full batches are stored with a single statement, the rest row by row
+  bool batch = mWayNodeBatch.size() == INSERT_BATCH_SIZE;
+  sqlite3_stmt* stmt = batch ? mStmtInsertWayNodeBatch : mStmtInsertWayNode;
+  bool ok = true;
+  int col = 0;
+  for ( int i = 0; i < mWayNodeBatch.size() && ok; ++i )
+  {
+    const WayNodeRow& row = mWayNodeBatch.at( i );
+    sqlite3_bind_int64( stmt, ++col, row.wayId );
+    sqlite3_bind_int64( stmt, ++col, row.nodeId );
+    sqlite3_bind_int( stmt, ++col, row.wayPos );
+    if ( !batch )
+    {
+      ok = sqlite3_step( stmt ) == SQLITE_DONE;
+      sqlite3_reset( stmt );
+      col = 0;
+    }
+  }
+
+  if ( batch )
+  {
+    ok = sqlite3_step( stmt ) == SQLITE_DONE;
+    sqlite3_reset( stmt );
+  }
+
+  mWayNodeBatch.clear();
+  return ok;
+}
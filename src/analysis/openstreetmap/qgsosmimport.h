@@ -18,15 +18,20 @@
 
 #include <QFile>
 #include <QObject>
+#include <QVector>
 
 #include "qgsosmbase.h"
 
 class QXmlStreamReader;
+struct QgsOSMPbfBlock;
 
 /**
  * @brief The QgsOSMXmlImport class imports OpenStreetMap XML format to our topological representation
  * in a SQLite database (see QgsOSMDatabase for details).
  *
+ * Input files with .pbf suffix are read in OpenStreetMap PBF format (since QGIS 2.16). Their blocks
+ * are decompressed and decoded in parallel.
+ *
  * How to use the classs:
  * 1. set input XML file name and output DB file name (in constructor or with respective functions)
  * 2. run import()
@@ -45,7 +50,7 @@ class ANALYSIS_EXPORT QgsOSMXmlImport : public QObject
     QString outputDbFileName() const { return mDbFileName; }
 
     /**
-     * Run import. This will parse the XML file and store the data in a SQLite database.
+     * Run import. This will parse the XML (or PBF) file and store the data in a SQLite database.
      * @return true on success, false when import failed (see errorString() for the error)
      */
     bool import();
@@ -71,7 +76,44 @@ class ANALYSIS_EXPORT QgsOSMXmlImport : public QObject
     void readWay( QXmlStreamReader& xml );
     void readTag( bool way, QgsOSMId id, QXmlStreamReader& xml );
 
+    /**
+     * Reads the input file in OpenStreetMap PBF format and stores its nodes and ways.
+     * @return true on success, false on error (see errorString() for the error)
+     * \note added in QGIS 2.16
+     */
+    bool readPbf();
+
   private:
+    //! Row of nodes table waiting for a batched insert
+    struct NodeRow
+    {
+      QgsOSMId id;
+      double lat;
+      double lon;
+    };
+
+    //! Row of ways_nodes table waiting for a batched insert
+    struct WayNodeRow
+    {
+      QgsOSMId wayId;
+      QgsOSMId nodeId;
+      int wayPos;
+    };
+
+    //! Adds a node to the current batch, returns false if storing of the batch failed
+    bool insertNode( QgsOSMId id, double lat, double lon );
+    //! Adds a node of a way to the current batch, returns false if storing of the batch failed
+    bool insertWayNode( QgsOSMId wayId, QgsOSMId nodeId, int wayPos );
+    bool insertWay( QgsOSMId id );
+    bool insertTag( bool way, QgsOSMId id, const QByteArray& k, const QByteArray& v );
+    //! Stores nodes, ways and their tags of a decoded PBF block
+    bool storePbfBlock( const QgsOSMPbfBlock& block );
+    //! Stores the pending nodes, with a single multi-row statement if the batch is full
+    bool flushNodes();
+    //! Stores the pending nodes of ways, with a single multi-row statement if the batch is full
+    bool flushWayNodes();
+
+
     QString mXmlFileName;
     QString mDbFileName;
 
@@ -85,6 +127,11 @@ class ANALYSIS_EXPORT QgsOSMXmlImport : public QObject
     sqlite3_stmt* mStmtInsertWay;
     sqlite3_stmt* mStmtInsertWayNode;
     sqlite3_stmt* mStmtInsertWayTag;
+    sqlite3_stmt* mStmtInsertNodeBatch;
+    sqlite3_stmt* mStmtInsertWayNodeBatch;
+
+    QVector<NodeRow> mNodeBatch;
+    QVector<WayNodeRow> mWayNodeBatch;
 };
 
 
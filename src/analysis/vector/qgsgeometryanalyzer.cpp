@@ -27,7 +27,104 @@
 #include "qgsdistancearea.h"
 #include "qgis.h"
 
+#include <QEventLoop>
+#include <QFutureWatcher>
 #include <QProgressDialog>
+#include <QtConcurrentMap>
+
+#include <qmath.h>
+
+//! Maximum number of geometries united in one step of the cascaded union
+static const int UNION_BATCH_SIZE = 1000;
+
+typedef QPair<QgsPoint, QgsGeometry*> CenteredGeometry;
+
+static bool centerXLessThan( const CenteredGeometry& g1, const CenteredGeometry& g2 )
+{
+  return g1.first.x() < g2.first.x();
+}
+
+static bool centerYLessThan( const CenteredGeometry& g1, const CenteredGeometry& g2 )
+{
+  return g1.first.y() < g2.first.y();
+}
+
+// Splits geometries into batches of nearby geometries: sorted into vertical slices by x, each
+// slice sorted by y and cut into batches (sort-tile-recursive packing)
+static QList< QList<QgsGeometry*> > spatialBatches( const QList<QgsGeometry*>& geometries )
+{
+  QList< QList<QgsGeometry*> > batches;
+  if ( geometries.size() <= UNION_BATCH_SIZE )
+  {
+    batches << geometries;
+    return batches;
+  }
+
+  QVector<CenteredGeometry> items;
+  items.reserve( geometries.size() );
+  Q_FOREACH ( QgsGeometry* geometry, geometries )
+  {
+    items << CenteredGeometry( geometry->boundingBox().center(), geometry );
+  }
+  qSort( items.begin(), items.end(), centerXLessThan );
+
+  int batchCount = ( items.size() + UNION_BATCH_SIZE - 1 ) / UNION_BATCH_SIZE;
+  int sliceSize = qCeil( qSqrt( batchCount ) ) * UNION_BATCH_SIZE;
+  for ( int sliceStart = 0; sliceStart < items.size(); sliceStart += sliceSize )
+  {
+    int sliceEnd = qMin( sliceStart + sliceSize, items.size() );
+    qSort( items.begin() + sliceStart, items.begin() + sliceEnd, centerYLessThan );
+    for ( int batchStart = sliceStart; batchStart < sliceEnd; batchStart += UNION_BATCH_SIZE )
+    {
+      QList<QgsGeometry*> batch;
+      for ( int i = batchStart; i < qMin( batchStart + UNION_BATCH_SIZE, sliceEnd ); ++i )
+      {
+        batch << items.at( i ).second;
+      }
+      batches << batch;
+    }
+  }
+  return batches;
+}
+
+static QgsGeometry* unionBatch( const QList<QgsGeometry*>& geometries )
+{
+  QgsGeometry* batchUnion = QgsGeometry::unaryUnion( geometries );
+  if ( !batchUnion->isEmpty() )
+  {
+    return batchUnion;
+  }
+  delete batchUnion;
+
+  //the union of the batch fails as a whole (eg if it contains an invalid geometry),
+  //unite the geometries one at a time to lose only those which cannot be united
+  QgsGeometry* dissolveGeometry = nullptr;
+  Q_FOREACH ( QgsGeometry* geometry, geometries )
+  {
+    if ( !geometry || geometry->isEmpty() )
+    {
+      continue;
+    }
+    if ( !dissolveGeometry )
+    {
+      dissolveGeometry = new QgsGeometry( *geometry );
+      continue;
+    }
+
+    QgsGeometry* combined = dissolveGeometry->combine( geometry );
+    if ( combined && !combined->isEmpty() )
+    {
+      delete dissolveGeometry;
+      dissolveGeometry = combined;
+    }
+    else
+    {
+      QgsDebugMsg( "geometry could not be united and is missing in the dissolved geometry" );
+      delete combined;
+    }
+  }
+  return dissolveGeometry ? dissolveGeometry : new QgsGeometry();
+}
 
 bool QgsGeometryAnalyzer::simplify( QgsVectorLayer* layer,
                                     const QString& shapefileName,
@@ -392,182 +489,97 @@ bool QgsGeometryAnalyzer::convexHull( QgsVectorLayer* layer, const QString& shap
   QgsCoordinateReferenceSystem crs = layer->crs();
 
   QgsVectorFileWriter vWriter( shapefileName, dp->encoding(), fields, outputType, &crs );
-  QgsFeature currentFeature;
-  QgsGeometry* dissolveGeometry = nullptr; //dissolve geometry
-  QMultiMap<QString, QgsFeatureId> map;
 
+  QgsFeatureRequest request;
+  int featureCount = layer->featureCount();
   if ( onlySelectedFeatures )
   {
-    //use QgsVectorLayer::featureAtId
-    const QgsFeatureIds selection = layer->selectedFeaturesIds();
-    QgsFeatureIds::const_iterator it = selection.constBegin();
-    for ( ; it != selection.constEnd(); ++it )
-    {
-#if 0
-      if ( p )
-      {
-        p->setValue( processedFeatures );
-      }
-      if ( p && p->wasCanceled() )
-      {
-        // break; // it may be better to do something else here?
-        return false;
-      }
-#endif
-      if ( !layer->getFeatures( QgsFeatureRequest().setFilterFid( *it ) ).nextFeature( currentFeature ) )
-      {
-        continue;
-      }
-      map.insert( currentFeature.attribute( uniqueIdField ).toString(), currentFeature.id() );
-    }
+    request.setFilterFids( layer->selectedFeaturesIds() );
+    featureCount = layer->selectedFeatureCount();
   }
-  else
+  if ( p )
   {
-    QgsFeatureIterator fit = layer->getFeatures();
-    while ( fit.nextFeature( currentFeature ) )
+    p->setMaximum( featureCount );
+  }
+
+  //collect the convex hulls of the features by unique id
+  QMap<QString, QList<QgsGeometry*> > groups;
+  QMap<QString, QString> uids;
+  QgsFeatureIterator fit = layer->getFeatures( request );
+  QgsFeature currentFeature;
+  int processedFeatures = 0;
+  while ( fit.nextFeature( currentFeature ) )
+  {
+    if ( p )
     {
-#if 0
-      if ( p )
-      {
-        p->setValue( processedFeatures );
-      }
-      if ( p && p->wasCanceled() )
-      {
-        // break; // it may be better to do something else here?
-        return false;
-      }
-#endif
-      map.insert( currentFeature.attribute( uniqueIdField ).toString(), currentFeature.id() );
+      p->setValue( processedFeatures );
+    }
+    if ( p && p->wasCanceled() )
+    {
+      Q_FOREACH ( const QList<QgsGeometry*>& group, groups )
+        qDeleteAll( group );
+      return false;
     }
+    ++processedFeatures;
+
+    QString currentKey = useField ? currentFeature.attribute( uniqueIdField ).toString() : QString();
+    QList<QgsGeometry*>& group = groups[ currentKey ];
+    if ( !uids.contains( currentKey ) )
+    {
+      uids.insert( currentKey, currentFeature.attribute( uniqueIdField ).toString() );
+    }
+    convexFeature( currentFeature, group );
   }
 
-  QMultiMap<QString, QgsFeatureId>::const_iterator jt = map.constBegin();
-  while ( jt != map.constEnd() )
+  //hull of each group is the hull of the union of the feature hulls
+  QList<QgsGeometry*> unions;
+  if ( !unionGroups( groups.values(), p, unions ) )
   {
-    QString currentKey = jt.key();
-    int processedFeatures = 0;
-    //take only selection
-    if ( onlySelectedFeatures )
+    return false;
+  }
+
+  QMap<QString, QList<QgsGeometry*> >::const_iterator groupIt = groups.constBegin();
+  for ( int i = 0; i < unions.size(); ++i, ++groupIt )
+  {
+    if ( !unions.at( i ) )
     {
-      //use QgsVectorLayer::featureAtId
-      const QgsFeatureIds selection = layer->selectedFeaturesIds();
-      if ( p )
-      {
-        p->setMaximum( selection.size() );
-      }
-      processedFeatures = 0;
-      while ( jt != map.constEnd() && ( jt.key() == currentKey || !useField ) )
-      {
-        if ( p && p->wasCanceled() )
-        {
-          break;
-        }
-        if ( selection.contains( jt.value() ) )
-        {
-          if ( p )
-          {
-            p->setValue( processedFeatures );
-          }
-          if ( !layer->getFeatures( QgsFeatureRequest().setFilterFid( jt.value() ) ).nextFeature( currentFeature ) )
-          {
-            continue;
-          }
-          convexFeature( currentFeature, processedFeatures, &dissolveGeometry );
-          ++processedFeatures;
-        }
-        ++jt;
-      }
-      QList<double> values;
-      if ( !dissolveGeometry )
-      {
-        QgsDebugMsg( "no dissolved geometry - should not happen" );
-        return false;
-      }
-      dissolveGeometry = dissolveGeometry->convexHull();
-      values = simpleMeasure( dissolveGeometry );
-      QgsAttributes attributes( 3 );
-      attributes[0] = QVariant( currentKey );
-      attributes[1] = values.at( 0 );
-      attributes[2] = values.at( 1 );
-      QgsFeature dissolveFeature;
-      dissolveFeature.setAttributes( attributes );
-      dissolveFeature.setGeometry( dissolveGeometry );
-      vWriter.addFeature( dissolveFeature );
-    }
-    //take all features
-    else
+      QgsDebugMsg( "no dissolved geometry - should not happen" );
+      continue;
+    }
+    QgsGeometry* dissolveGeometry = unions.at( i )->convexHull();
+    delete unions.at( i );
+    if ( !dissolveGeometry )
     {
-      int featureCount = layer->featureCount();
-      if ( p )
-      {
-        p->setMaximum( featureCount );
-      }
-      processedFeatures = 0;
-      while ( jt != map.constEnd() && ( jt.key() == currentKey || !useField ) )
-      {
-        if ( p )
-        {
-          p->setValue( processedFeatures );
-        }
-
-        if ( p && p->wasCanceled() )
-        {
-          break;
-        }
-        if ( !layer->getFeatures( QgsFeatureRequest().setFilterFid( jt.value() ) ).nextFeature( currentFeature ) )
-        {
-          continue;
-        }
-        convexFeature( currentFeature, processedFeatures, &dissolveGeometry );
-        ++processedFeatures;
-        ++jt;
-      }
-      QList<double> values;
-      // QgsGeometry* tmpGeometry = 0;
-      if ( !dissolveGeometry )
-      {
-        QgsDebugMsg( "no dissolved geometry - should not happen" );
-        return false;
-      }
-      dissolveGeometry = dissolveGeometry->convexHull();
-      // values = simpleMeasure( tmpGeometry );
-      values = simpleMeasure( dissolveGeometry );
-      QgsAttributes attributes;
-      attributes[0] = QVariant( currentKey );
-      attributes[1] = QVariant( values[ 0 ] );
-      attributes[2] = QVariant( values[ 1 ] );
-      QgsFeature dissolveFeature;
-      dissolveFeature.setAttributes( attributes );
-      dissolveFeature.setGeometry( dissolveGeometry );
-      vWriter.addFeature( dissolveFeature );
+      continue;
     }
+    QList<double> values = simpleMeasure( dissolveGeometry );
+    QgsAttributes attributes( 3 );
+    attributes[0] = QVariant( uids.value( groupIt.key() ) );
+    attributes[1] = values.value( 0 );
+    attributes[2] = values.value( 1 );
+    QgsFeature dissolveFeature;
+    dissolveFeature.setAttributes( attributes );
+    dissolveFeature.setGeometry( dissolveGeometry );
+    vWriter.addFeature( dissolveFeature );
   }
   return true;
 }
 
 
-void QgsGeometryAnalyzer::convexFeature( QgsFeature& f, int nProcessedFeatures, QgsGeometry** dissolveGeometry )
+void QgsGeometryAnalyzer::convexFeature( QgsFeature& f, QList<QgsGeometry*>& dissolveGeometries )
 {
   if ( !f.constGeometry() )
   {
     return;
   }
 
-  const QgsGeometry* featureGeometry = f.constGeometry();
-  QgsGeometry* tmpGeometry = nullptr;
-  QgsGeometry* convexGeometry = nullptr;
-
-  convexGeometry = featureGeometry->convexHull();
-
-  if ( nProcessedFeatures == 0 )
+  QgsGeometry* convexGeometry = f.constGeometry()->convexHull();
+  if ( convexGeometry && !convexGeometry->isEmpty() )
   {
-    *dissolveGeometry = convexGeometry;
+    dissolveGeometries << convexGeometry;
   }
   else
   {
-    tmpGeometry = *dissolveGeometry;
-    *dissolveGeometry = ( *dissolveGeometry )->combine( convexGeometry );
-    delete tmpGeometry;
     delete convexGeometry;
   }
 }
@@ -598,135 +610,67 @@ bool QgsGeometryAnalyzer::dissolve( QgsVectorLayer* layer, const QString& shapef
   QgsCoordinateReferenceSystem crs = layer->crs();
 
   QgsVectorFileWriter vWriter( shapefileName, dp->encoding(), layer->fields(), outputType, &crs );
-  QgsFeature currentFeature;
-  QMultiMap<QString, QgsFeatureId> map;
 
+  QgsFeatureRequest request;
+  int featureCount = layer->featureCount();
   if ( onlySelectedFeatures )
   {
-    //use QgsVectorLayer::featureAtId
-    const QgsFeatureIds selection = layer->selectedFeaturesIds();
-    QgsFeatureIds::const_iterator it = selection.constBegin();
-    for ( ; it != selection.constEnd(); ++it )
-    {
-      if ( !layer->getFeatures( QgsFeatureRequest().setFilterFid( *it ) ).nextFeature( currentFeature ) )
-      {
-        continue;
-      }
-      map.insert( currentFeature.attribute( uniqueIdField ).toString(), currentFeature.id() );
-    }
+    request.setFilterFids( layer->selectedFeaturesIds() );
+    featureCount = layer->selectedFeatureCount();
   }
-  else
+  if ( p )
   {
-    QgsFeatureIterator fit = layer->getFeatures();
-    while ( fit.nextFeature( currentFeature ) )
-    {
-      map.insert( currentFeature.attribute( uniqueIdField ).toString(), currentFeature.id() );
-    }
+    p->setMaximum( featureCount );
   }
 
-  QgsGeometry *dissolveGeometry = nullptr; //dissolve geometry
-  QMultiMap<QString, QgsFeatureId>::const_iterator jt = map.constBegin();
-  QgsFeature outputFeature;
-  while ( jt != map.constEnd() )
+  //collect the geometries by dissolve value, output features get the attributes of the first feature of their group
+  QMap<QString, QList<QgsGeometry*> > groups;
+  QMap<QString, QgsAttributes> groupAttributes;
+  QgsFeatureIterator fit = layer->getFeatures( request );
+  QgsFeature currentFeature;
+  int processedFeatures = 0;
+  while ( fit.nextFeature( currentFeature ) )
   {
-    QString currentKey = jt.key();
-    int processedFeatures = 0;
-    bool first = true;
-    //take only selection
-    if ( onlySelectedFeatures )
+    if ( p )
     {
-      //use QgsVectorLayer::featureAtId
-      const QgsFeatureIds selection = layer->selectedFeaturesIds();
-      if ( p )
-      {
-        p->setMaximum( selection.size() );
-      }
-      while ( jt != map.constEnd() && ( jt.key() == currentKey || !useField ) )
-      {
-        if ( p && p->wasCanceled() )
-        {
-          break;
-        }
-        if ( selection.contains( jt.value() ) )
-        {
-          if ( p )
-          {
-            p->setValue( processedFeatures );
-          }
-          if ( !layer->getFeatures( QgsFeatureRequest().setFilterFid( jt.value() ) ).nextFeature( currentFeature ) )
-          {
-            continue;
-          }
-          if ( first )
-          {
-            outputFeature.setAttributes( currentFeature.attributes() );
-            first = false;
-          }
-          dissolveFeature( currentFeature, processedFeatures, &dissolveGeometry );
-          ++processedFeatures;
-        }
-        ++jt;
-      }
+      p->setValue( processedFeatures );
     }
-    //take all features
-    else
+    if ( p && p->wasCanceled() )
     {
-      int featureCount = layer->featureCount();
-      if ( p )
-      {
-        p->setMaximum( featureCount );
-      }
-      while ( jt != map.constEnd() && ( jt.key() == currentKey || !useField ) )
-      {
-        if ( p )
-        {
-          p->setValue( processedFeatures );
-        }
+      Q_FOREACH ( const QList<QgsGeometry*>& group, groups )
+        qDeleteAll( group );
+      return false;
+    }
+    ++processedFeatures;
 
-        if ( p && p->wasCanceled() )
-        {
-          break;
-        }
-        if ( !layer->getFeatures( QgsFeatureRequest().setFilterFid( jt.value() ) ).nextFeature( currentFeature ) )
-        {
-          continue;
-        }
-        {
-          outputFeature.setAttributes( currentFeature.attributes() );
-          first = false;
-        }
-        dissolveFeature( currentFeature, processedFeatures, &dissolveGeometry );
-        ++processedFeatures;
-        ++jt;
-      }
+    QString currentKey = useField ? currentFeature.attribute( uniqueIdField ).toString() : QString();
+    QList<QgsGeometry*>& group = groups[ currentKey ];
+    if ( !groupAttributes.contains( currentKey ) )
+    {
+      groupAttributes.insert( currentKey, currentFeature.attributes() );
+    }
+    const QgsGeometry* featureGeometry = currentFeature.constGeometry();
+    if ( featureGeometry && !featureGeometry->isEmpty() )
+    {
+      group << new QgsGeometry( *featureGeometry );
     }
-    outputFeature.setGeometry( dissolveGeometry );
-    vWriter.addFeature( outputFeature );
   }
-  return true;
-}
 
-void QgsGeometryAnalyzer::dissolveFeature( QgsFeature& f, int nProcessedFeatures, QgsGeometry** dissolveGeometry )
-{
-  if ( !f.constGeometry() )
+  QList<QgsGeometry*> unions;
+  if ( !unionGroups( groups.values(), p, unions ) )
   {
-    return;
+    return false;
   }
 
-  const QgsGeometry* featureGeometry = f.constGeometry();
-
-  if ( nProcessedFeatures == 0 )
-  {
-    int geomSize = featureGeometry->wkbSize();
-    *dissolveGeometry = new QgsGeometry();
-    unsigned char* wkb = new unsigned char[geomSize];
-    memcpy( wkb, featureGeometry->asWkb(), geomSize );
-    ( *dissolveGeometry )->fromWkb( wkb, geomSize );
-  }
-  else
+  QMap<QString, QList<QgsGeometry*> >::const_iterator groupIt = groups.constBegin();
+  for ( int i = 0; i < unions.size(); ++i, ++groupIt )
   {
-    *dissolveGeometry = ( *dissolveGeometry )->combine( featureGeometry );
+    QgsFeature outputFeature;
+    outputFeature.setAttributes( groupAttributes.value( groupIt.key() ) );
+    outputFeature.setGeometry( unions.at( i ) );
+    vWriter.addFeature( outputFeature );
   }
+  return true;
 }
 
 bool QgsGeometryAnalyzer::buffer( QgsVectorLayer* layer, const QString& shapefileName, double bufferDistance,
@@ -752,7 +696,7 @@ bool QgsGeometryAnalyzer::buffer( QgsVectorLayer* layer, const QString& shapefil
 
   QgsVectorFileWriter vWriter( shapefileName, dp->encoding(), layer->fields(), outputType, &crs );
   QgsFeature currentFeature;
-  QgsGeometry *dissolveGeometry = nullptr; //dissolve geometry (if dissolve enabled)
+  QList<QgsGeometry*> dissolveGeometries; //buffers to dissolve (if dissolve enabled)
 
   //take only selection
   if ( onlySelectedFeatures )
@@ -781,7 +725,7 @@ bool QgsGeometryAnalyzer::buffer( QgsVectorLayer* layer, const QString& shapefil
       {
         continue;
       }
-      bufferFeature( currentFeature, processedFeatures, &vWriter, dissolve, &dissolveGeometry, bufferDistance, bufferDistanceField );
+      bufferFeature( currentFeature, &vWriter, dissolve, dissolveGeometries, bufferDistance, bufferDistanceField );
       ++processedFeatures;
     }
 
@@ -812,7 +756,7 @@ bool QgsGeometryAnalyzer::buffer( QgsVectorLayer* layer, const QString& shapefil
       {
         break;
       }
-      bufferFeature( currentFeature, processedFeatures, &vWriter, dissolve, &dissolveGeometry, bufferDistance, bufferDistanceField );
+      bufferFeature( currentFeature, &vWriter, dissolve, dissolveGeometries, bufferDistance, bufferDistanceField );
       ++processedFeatures;
     }
     if ( p )
@@ -823,7 +767,16 @@ bool QgsGeometryAnalyzer::buffer( QgsVectorLayer* layer, const QString& shapefil
 
   if ( dissolve )
   {
+    QList< QList<QgsGeometry*> > groups;
+    groups << dissolveGeometries;
+    QList<QgsGeometry*> unions;
+    if ( !unionGroups( groups, p, unions ) )
+    {
+      return false;
+    }
+
     QgsFeature dissolveFeature;
+    QgsGeometry* dissolveGeometry = unions.value( 0 );
     if ( !dissolveGeometry )
     {
       QgsDebugMsg( "no dissolved geometry - should not happen" );
@@ -835,8 +788,8 @@ bool QgsGeometryAnalyzer::buffer( QgsVectorLayer* layer, const QString& shapefil
   return true;
 }
 
-void QgsGeometryAnalyzer::bufferFeature( QgsFeature& f, int nProcessedFeatures, QgsVectorFileWriter* vfw, bool dissolve,
-    QgsGeometry** dissolveGeometry, double bufferDistance, int bufferDistanceField )
+void QgsGeometryAnalyzer::bufferFeature( QgsFeature& f, QgsVectorFileWriter* vfw, bool dissolve,
+    QList<QgsGeometry*>& dissolveGeometries, double bufferDistance, int bufferDistanceField )
 {
   if ( !f.constGeometry() )
   {
@@ -845,7 +798,6 @@ void QgsGeometryAnalyzer::bufferFeature( QgsFeature& f, int nProcessedFeatures,
 
   double currentBufferDistance;
   const QgsGeometry* featureGeometry = f.constGeometry();
-  QgsGeometry* tmpGeometry = nullptr;
   QgsGeometry* bufferGeometry = nullptr;
 
   //create buffer
@@ -861,15 +813,13 @@ void QgsGeometryAnalyzer::bufferFeature( QgsFeature& f, int nProcessedFeatures,
 
   if ( dissolve )
   {
-    if ( nProcessedFeatures == 0 )
+    //buffers are united all at once when all features are processed
+    if ( bufferGeometry && !bufferGeometry->isEmpty() )
     {
-      *dissolveGeometry = bufferGeometry;
+      dissolveGeometries << bufferGeometry;
     }
     else
     {
-      tmpGeometry = *dissolveGeometry;
-      *dissolveGeometry = ( *dissolveGeometry )->combine( bufferGeometry );
-      delete tmpGeometry;
       delete bufferGeometry;
     }
   }
@@ -887,6 +837,77 @@ void QgsGeometryAnalyzer::bufferFeature( QgsFeature& f, int nProcessedFeatures,
   }
 }
 
+bool QgsGeometryAnalyzer::unionGroups( const QList< QList<QgsGeometry*> >& groups, QProgressDialog* p, QList<QgsGeometry*>& unions )
+{
+  QList< QList<QgsGeometry*> > pending = groups;
+
+  //cascaded union: nearby geometries of each group are united in batches, then the results
+  //of the batches, until a single geometry is left per group. Batches are united in parallel.
+  Q_FOREVER
+  {
+    QList< QList<QgsGeometry*> > batches;
+    QList<int> batchGroups;
+    for ( int i = 0; i < pending.size(); ++i )
+    {
+      if ( pending.at( i ).size() < 2 )
+      {
+        continue;
+      }
+      Q_FOREACH ( const QList<QgsGeometry*>& batch, spatialBatches( pending.at( i ) ) )
+      {
+        batches << batch;
+        batchGroups << i;
+      }
+      pending[i].clear();
+    }
+    if ( batches.isEmpty() )
+    {
+      break;
+    }
+
+    QFuture<QgsGeometry*> future = QtConcurrent::mapped( batches, unionBatch );
+    if ( p )
+    {
+      QFutureWatcher<QgsGeometry*> watcher;
+      QEventLoop loop;
+      QObject::connect( &watcher, SIGNAL( finished() ), &loop, SLOT( quit() ) );
+      QObject::connect( &watcher, SIGNAL( progressRangeChanged( int, int ) ), p, SLOT( setRange( int, int ) ) );
+      QObject::connect( &watcher, SIGNAL( progressValueChanged( int ) ), p, SLOT( setValue( int ) ) );
+      QObject::connect( p, SIGNAL( canceled() ), &watcher, SLOT( cancel() ) );
+      if ( p->wasCanceled() )
+      {
+        future.cancel();
+      }
+      watcher.setFuture( future );
+      loop.exec();
+    }
+    future.waitForFinished();
+
+    Q_FOREACH ( const QList<QgsGeometry*>& batch, batches )
+      qDeleteAll( batch );
+
+    if ( future.isCanceled() )
+    {
+      qDeleteAll( future.results() );
+      Q_FOREACH ( const QList<QgsGeometry*>& group, pending )
+        qDeleteAll( group );
+      return false;
+    }
+
+    for ( int i = 0; i < batches.size(); ++i )
+    {
+      pending[ batchGroups.at( i )] << future.resultAt( i );
+    }
+  }
+
+  unions.clear();
+  Q_FOREACH ( const QList<QgsGeometry*>& group, pending )
+  {
+    unions << group.value( 0 );
+  }
+  return true;
+}
+
 bool QgsGeometryAnalyzer::eventLayer( QgsVectorLayer* lineLayer, QgsVectorLayer* eventLayer, int lineField, int eventField, QgsFeatureIds &unlocatedFeatureIds, const QString& outputLayer,
                                       const QString& outputFormat, int locationField1, int locationField2, int offsetField, double offsetScale,
                                       bool forceSingleGeometry, QgsVectorDataProvider* memoryProvider, QProgressDialog* p )
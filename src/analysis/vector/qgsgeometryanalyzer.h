@@ -136,12 +136,18 @@ class ANALYSIS_EXPORT QgsGeometryAnalyzer
     /** Helper function to get the cetroid of an individual feature*/
     void centroidFeature( QgsFeature& f, QgsVectorFileWriter* vfw );
     /** Helper function to buffer an individual feature*/
-    void bufferFeature( QgsFeature& f, int nProcessedFeatures, QgsVectorFileWriter* vfw, bool dissolve, QgsGeometry** dissolveGeometry,
+    void bufferFeature( QgsFeature& f, QgsVectorFileWriter* vfw, bool dissolve, QList<QgsGeometry*>& dissolveGeometries,
                         double bufferDistance, int bufferDistanceField );
-    /** Helper function to get the convex hull of feature(s)*/
-    void convexFeature( QgsFeature& f, int nProcessedFeatures, QgsGeometry** dissolveGeometry );
-    /** Helper function to dissolve feature(s)*/
-    void dissolveFeature( QgsFeature& f, int nProcessedFeatures, QgsGeometry** dissolveGeometry );
+    /** Helper function to get the convex hull of a feature*/
+    void convexFeature( QgsFeature& f, QList<QgsGeometry*>& dissolveGeometries );
+    /** Helper function to dissolve groups of geometries by a cascaded union, the groups are processed in parallel.
+     * Deletes the input geometries.
+     * @param groups geometries of each group
+     * @param p progress dialog (or 0 if no progress dialog is to be shown)
+     * @param unions out: united geometry of each group (0 for groups without geometries)
+     * @returns false if canceled
+     */
+    bool unionGroups( const QList< QList<QgsGeometry*> >& groups, QProgressDialog* p, QList<QgsGeometry*>& unions );
 
     //helper functions for event layer
     void addEventLayerFeature( QgsFeature& feature, QgsGeometry* geom, QgsGeometry* lineGeom, QgsVectorFileWriter* fileWriter, QgsFeatureList& memoryFeatures, int offsetField = -1, double offsetScale = 1.0,
@@ -25,7 +25,12 @@
 #include "qgsvectorfilewriter.h"
 #include "qgsvectordataprovider.h"
 #include "qgsdistancearea.h"
+#include "qgsgeometryengine.h"
 #include <QProgressDialog>
+#include <QtConcurrentMap>
+
+//! Number of features intersected in parallel before their results are written
+static const int INTERSECTION_CHUNK_SIZE = 256;
 
 bool QgsOverlayAnalyzer::intersection( QgsVectorLayer* layerA, QgsVectorLayer* layerB,
                                        const QString& shapefileName, bool onlySelectedFeatures,
@@ -53,73 +58,76 @@ bool QgsOverlayAnalyzer::intersection( QgsVectorLayer* layerA, QgsVectorLayer* l
   QgsFeature currentFeature;
   QgsSpatialIndex index;
 
+  QgsFeatureRequest requestA;
+  QgsFeatureRequest requestB;
+  int featureCount = layerA->featureCount();
   //take only selection
   if ( onlySelectedFeatures )
   {
-    const QgsFeatureIds selectionB = layerB->selectedFeaturesIds();
-    QgsFeatureIds::const_iterator it = selectionB.constBegin();
-    for ( ; it != selectionB.constEnd(); ++it )
-    {
-      if ( !layerB->getFeatures( QgsFeatureRequest().setFilterFid( *it ) ).nextFeature( currentFeature ) )
-      {
-        continue;
-      }
-      index.insertFeature( currentFeature );
-    }
-    //use QgsVectorLayer::featureAtId
-    const QgsFeatureIds selectionA = layerA->selectedFeaturesIds();
-    if ( p )
+    requestA.setFilterFids( layerA->selectedFeaturesIds() );
+    requestB.setFilterFids( layerB->selectedFeaturesIds() );
+    featureCount = layerA->selectedFeatureCount();
+  }
+
+  //features of layer B are read only once and kept in memory, the index refers to their position
+  QVector<QgsFeature> featuresB;
+  QHash<QgsFeatureId, int> positionsB;
+  QgsFeatureIterator fit = layerB->getFeatures( requestB );
+  while ( fit.nextFeature( currentFeature ) )
+  {
+    if ( !currentFeature.constGeometry() || currentFeature.constGeometry()->isEmpty() )
     {
-      p->setMaximum( selectionA.size() );
+      continue;
     }
-    QgsFeature currentFeature;
-    int processedFeatures = 0;
-    it = selectionA.constBegin();
-    for ( ; it != selectionA.constEnd(); ++it )
-    {
-      if ( p )
-      {
-        p->setValue( processedFeatures );
-      }
+    positionsB.insert( currentFeature.id(), featuresB.size() );
+    featuresB << currentFeature;
+    index.insertFeature( currentFeature );
+  }
 
-      if ( p && p->wasCanceled() )
+  if ( p )
+  {
+    p->setMaximum( featureCount );
+  }
+  int processedFeatures = 0;
+
+  //features of layer A are intersected in parallel chunks, results are written in the order of the features
+  QList<IntersectionTask> tasks;
+  fit = layerA->getFeatures( requestA );
+  bool moreFeatures = true;
+  while ( moreFeatures )
+  {
+    moreFeatures = fit.nextFeature( currentFeature );
+    if ( moreFeatures )
+    {
+      if ( currentFeature.constGeometry() && !currentFeature.constGeometry()->isEmpty() )
       {
-        break;
+        IntersectionTask task;
+        task.feature = currentFeature;
+        Q_FOREACH ( QgsFeatureId id, index.intersects( currentFeature.constGeometry()->boundingBox() ) )
+        {
+          task.candidates << positionsB.value( id );
+        }
+        tasks << task;
       }
-      if ( !layerA->getFeatures( QgsFeatureRequest().setFilterFid( *it ) ).nextFeature( currentFeature ) )
+      else
       {
-        continue;
+        ++processedFeatures;
       }
-      intersectFeature( currentFeature, &vWriter, layerB, &index );
-      ++processedFeatures;
     }
 
-    if ( p )
+    if ( tasks.size() >= INTERSECTION_CHUNK_SIZE || ( !moreFeatures && !tasks.isEmpty() ) )
     {
-      p->setValue( selectionA.size() );
-    }
-  }
-  //take all features
-  else
-  {
-    QgsFeatureIterator fit = layerB->getFeatures();
-    while ( fit.nextFeature( currentFeature ) )
-    {
-      index.insertFeature( currentFeature );
-    }
-
-    int featureCount = layerA->featureCount();
-    if ( p )
-    {
-      p->setMaximum( featureCount );
-    }
-    int processedFeatures = 0;
-
-    fit = layerA->getFeatures();
+      QList<QgsFeatureList> results = QtConcurrent::blockingMapped( tasks, IntersectFeatureWrapper( this, &featuresB ) );
+      Q_FOREACH ( const QgsFeatureList& outFeatures, results )
+      {
+        Q_FOREACH ( QgsFeature outFeature, outFeatures )
+        {
+          vWriter.addFeature( outFeature );
+        }
+      }
+      processedFeatures += tasks.size();
+      tasks.clear();
 
-    QgsFeature currentFeature;
-    while ( fit.nextFeature( currentFeature ) )
-    {
       if ( p )
       {
         p->setValue( processedFeatures );
@@ -128,57 +136,62 @@ bool QgsOverlayAnalyzer::intersection( QgsVectorLayer* layerA, QgsVectorLayer* l
       {
         break;
       }
-      intersectFeature( currentFeature, &vWriter, layerB, &index );
-      ++processedFeatures;
-    }
-    if ( p )
-    {
-      p->setValue( featureCount );
     }
   }
+
+  if ( p && !p->wasCanceled() )
+  {
+    p->setValue( featureCount );
+  }
   return true;
 }
 
-void QgsOverlayAnalyzer::intersectFeature( QgsFeature& f, QgsVectorFileWriter* vfw,
-    QgsVectorLayer* vl, QgsSpatialIndex* index )
+QgsFeatureList QgsOverlayAnalyzer::intersectFeature( const QgsFeature& f, const QList<int>& candidates, const QVector<QgsFeature>& overlayFeatures )
 {
-  if ( !f.constGeometry() )
+  QgsFeatureList outFeatures;
+  if ( candidates.isEmpty() )
   {
-    return;
+    return outFeatures;
   }
 
+  //the geometry is compared with all candidates, prepare it once
   const QgsGeometry* featureGeometry = f.constGeometry();
-  QgsGeometry* intersectGeometry = nullptr;
-  QgsFeature overlayFeature;
-
-  QList<QgsFeatureId> intersects;
-  intersects = index->intersects( featureGeometry->boundingBox() );
-  QList<QgsFeatureId>::const_iterator it = intersects.constBegin();
-  QgsFeature outFeature;
-  for ( ; it != intersects.constEnd(); ++it )
+  QScopedPointer<QgsGeometryEngine> engine( QgsGeometry::createGeometryEngine( featureGeometry->geometry() ) );
+  engine->prepareGeometry();
+
+  Q_FOREACH ( int candidate, candidates )
   {
-    if ( !vl->getFeatures( QgsFeatureRequest().setFilterFid( *it ) ).nextFeature( overlayFeature ) )
+    const QgsFeature& overlayFeature = overlayFeatures.at( candidate );
+    const QgsAbstractGeometryV2& overlayGeometry = *overlayFeature.constGeometry()->geometry();
+    if ( !engine->intersects( overlayGeometry ) )
     {
       continue;
     }
 
-    if ( featureGeometry->intersects( overlayFeature.constGeometry() ) )
+    //if one geometry contains the other, the intersection is the contained geometry
+    QgsGeometry* intersectGeometry = nullptr;
+    if ( engine->contains( overlayGeometry ) )
     {
-      intersectGeometry = featureGeometry->intersection( overlayFeature.constGeometry() );
-
-      outFeature.setGeometry( intersectGeometry );
-      QgsAttributes attributesA = f.attributes();
-      QgsAttributes attributesB = overlayFeature.attributes();
-      combineAttributeMaps( attributesA, attributesB );
-      outFeature.setAttributes( attributesA );
-
-      //add it to vector file writer
-      if ( vfw )
-      {
-        vfw->addFeature( outFeature );
-      }
+      intersectGeometry = new QgsGeometry( *overlayFeature.constGeometry() );
+    }
+    else if ( engine->within( overlayGeometry ) )
+    {
+      intersectGeometry = new QgsGeometry( *featureGeometry );
     }
+    else
+    {
+      intersectGeometry = new QgsGeometry( engine->intersection( overlayGeometry ) );
+    }
+
+    QgsFeature outFeature;
+    outFeature.setGeometry( intersectGeometry );
+    QgsAttributes attributesA = f.attributes();
+    QgsAttributes attributesB = overlayFeature.attributes();
+    combineAttributeMaps( attributesA, attributesB );
+    outFeature.setAttributes( attributesA );
+    outFeatures << outFeature;
   }
+  return outFeatures;
 }
 
 void QgsOverlayAnalyzer::combineFieldLists( QgsFields& fieldListA, const QgsFields& fieldListB )
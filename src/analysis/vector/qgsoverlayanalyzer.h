@@ -50,8 +50,30 @@ class ANALYSIS_EXPORT QgsOverlayAnalyzer
 
   private:
 
+    //! Feature of the first layer with the positions of the overlay features whose bounding boxes intersect it
+    struct IntersectionTask
+    {
+      QgsFeature feature;
+      QList<int> candidates;
+    };
+
+    class IntersectFeatureWrapper
+    {
+      public:
+        typedef QgsFeatureList result_type;
+        IntersectFeatureWrapper( QgsOverlayAnalyzer* instance, const QVector<QgsFeature>* overlayFeatures )
+            : mInstance( instance ), mOverlayFeatures( overlayFeatures ) {}
+        QgsFeatureList operator()( const IntersectionTask& task ) const { return mInstance->intersectFeature( task.feature, task.candidates, *mOverlayFeatures ); }
+      private:
+        QgsOverlayAnalyzer* mInstance;
+        const QVector<QgsFeature>* mOverlayFeatures;
+    };
+
     void combineFieldLists( QgsFields& fieldListA, const QgsFields& fieldListB );
-    void intersectFeature( QgsFeature& f, QgsVectorFileWriter* vfw, QgsVectorLayer* dp, QgsSpatialIndex* index );
+    /** Helper function to intersect a feature with the candidate overlay features, may be called from
+     * several threads at once
+     */
+    QgsFeatureList intersectFeature( const QgsFeature& f, const QList<int>& candidates, const QVector<QgsFeature>& overlayFeatures );
     void combineAttributeMaps( QgsAttributes& attributesA, const QgsAttributes& attributesB );
 };
 
@@ -49,7 +49,7 @@ void QgsOSMImportDialog::onBrowseXml()
   QSettings settings;
   QString lastDir = settings.value( "/osm/lastDir", QDir::homePath() ).toString();
 
-  QString fileName = QFileDialog::getOpenFileName( this, QString(), lastDir, tr( "OpenStreetMap files (*.osm)" ) );
+  QString fileName = QFileDialog::getOpenFileName( this, QString(), lastDir, tr( "OpenStreetMap files (*.osm *.pbf)" ) );
   if ( fileName.isNull() )
     return;
 
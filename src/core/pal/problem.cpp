@@ -66,6 +66,7 @@ Problem::Problem()
     , featStartId( nullptr )
     , featNbLp( nullptr )
     , inactiveCost( nullptr )
+    , preferredLp( nullptr )
     , sol( nullptr )
     , nbActive( 0 )
     , nbOverlap( 0.0 )
@@ -103,6 +104,9 @@ Problem::~Problem()
   if ( inactiveCost )
     delete[] inactiveCost;
 
+  if ( preferredLp )
+    delete[] preferredLp;
+
   delete candidates;
   delete candidates_sol;
 
@@ -124,6 +128,21 @@ inline bool borderSizeInc( void *l, void *r )
   return ( reinterpret_cast< SubPart* >( l ) )->borderSize > ( reinterpret_cast< SubPart* >( r ) )->borderSize;
 }
 
+void Problem::setPreferredCandidate( int fi, int ci )
+{
+  if ( fi < 0 || fi >= nbft || ci < 0 || ci >= featNbLp[fi] )
+    return;
+
+  if ( !preferredLp )
+  {
+    preferredLp = new int[nbft];
+    for ( int i = 0; i < nbft; i++ )
+      preferredLp[i] = -1;
+  }
+
+  preferredLp[fi] = featStartId[fi] + ci;
+}
+
 void Problem::reduce()
 {
 
@@ -310,6 +329,32 @@ void Problem::init_sol_falp()
       }
     }
 
+  // place preferred candidates first - those which were not removed by reduce()
+  // and which are not in conflict with a preferred candidate placed before
+  if ( preferredLp )
+  {
+    for ( i = 0; i < nbft; i++ )
+    {
+      label = preferredLp[i];
+      if ( label < 0 || label >= featStartId[i] + featNbLp[i] || !list->isIn( label ) )
+        continue;
+
+      lp = mLabelPositions.at( label );
+      sol->s[i] = label;
+
+      for ( j = featStartId[i]; j < featStartId[i] + featNbLp[i]; j++ )
+      {
+        ignoreLabel( mLabelPositions.at( j ), list, candidates );
+      }
+
+      lp->getBoundingBox( amin, amax );
+
+      context->lp = lp;
+      candidates->Search( amin, amax, falpCallback1, reinterpret_cast< void* >( context ) );
+      candidates_sol->Insert( amin, amax, lp );
+    }
+  }
+
   while ( list->getSize() > 0 ) // O (log size)
   {
     if ( pal->isCancelled() )
@@ -2174,6 +2219,16 @@ void Problem::chain_search()
   //initialization();
   init_sol_falp();
 
+  // features placed at their preferred position are considered solved
+  // unless a chain started from another feature moves them
+  if ( preferredLp )
+  {
+    for ( i = 0; i < nbft; i++ )
+    {
+      ok[i] = preferredLp[i] >= 0 && sol->s[i] == preferredLp[i];
+    }
+  }
+
   //check_solution();
   solution_cost();
 
@@ -2190,7 +2245,7 @@ void Problem::chain_search()
       ;
 
     // All seeds are OK
-    if ( seed == iter )
+    if ( seed == iter && ok[seed] )
     {
       break;
     }
@@ -123,6 +123,16 @@ namespace pal
       LabelPosition* getFeatureCandidate( int fi, int ci ) { return mLabelPositions.at( featStartId[fi] + ci ); }
       /////////////////
 
+      /** Sets the candidate which should be placed first for a feature when building
+       * the initial solution (e.g. the position solved during the previous rendering
+       * of the map). Features with an accepted preferred candidate are not used as seeds
+       * by chain_search(), so only the remaining features and the labels in conflict
+       * with them are solved again.
+       * @param fi problem feature id (features counted 0...n-1)
+       * @param ci candidate index within the feature's candidates
+       * @note added in QGIS 2.16
+       */
+      void setPreferredCandidate( int fi, int ci );
 
       void reduce();
 
@@ -222,6 +232,7 @@ namespace pal
       int *featStartId; // [nbft]
       int *featNbLp;    // [nbft]
       double *inactiveCost; //
+      int *preferredLp; // [nbft] - preferred candidate id or -1
 
       Sol *sol;         // [nbft]
       int nbActive;
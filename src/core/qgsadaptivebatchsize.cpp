@@ -0,0 +1,55 @@
+/***************************************************************************
+    qgsadaptivebatchsize.cpp
+    ---------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsadaptivebatchsize.h"
+
+#include "qgslogger.h"
+
+QgsAdaptiveBatchSize::QgsAdaptiveBatchSize( int initialSize, int minimumSize, int maximumSize, qint64 maximumBytes )
+    : mSize( qBound( minimumSize, initialSize, maximumSize ) )
+    , mMinimumSize( minimumSize )
+    , mMaximumSize( maximumSize )
+    , mMaximumBytes( maximumBytes )
+    , mAverageRowBytes( 0 )
+{
+}
+
+void QgsAdaptiveBatchSize::batchReceived( int rows, qint64 bytes, int waitMsecs, int consumeMsecs )
+{
+  if ( rows <= 0 )
+    return;
+
+  // smooth the row size, so that a single batch of large geometries does not shrink the batches too much
+  double rowBytes = static_cast<double>( bytes ) / rows;
+  mAverageRowBytes = mAverageRowBytes > 0 ? 0.7 * mAverageRowBytes + 0.3 * rowBytes : rowBytes;
+
+  int size = mSize;
+
+  // the batch was not ready when it was needed: fetch more rows per round trip.
+  // The first batch (no consume time) is always waited for, so it does not count.
+  if ( consumeMsecs > 0 && waitMsecs * 4 > consumeMsecs && rows >= mSize )
+    size = mSize * 2;
+
+  if ( mAverageRowBytes > 0 )
+    size = qMin( size, static_cast<int>( qMin( static_cast<double>( mMaximumSize ), mMaximumBytes / mAverageRowBytes ) ) );
+
+  size = qBound( mMinimumSize, size, mMaximumSize );
+
+  if ( size != mSize )
+  {
+    QgsDebugMsgLevel( QString( "batch size %1 -> %2 (row %3 bytes, waited %4 ms, consumed in %5 ms)" )
+                      .arg( mSize ).arg( size ).arg( mAverageRowBytes ).arg( waitMsecs ).arg( consumeMsecs ), 3 );
+    mSize = size;
+  }
+}
@@ -0,0 +1,69 @@
+/***************************************************************************
+    qgsadaptivebatchsize.h
+    ---------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSADAPTIVEBATCHSIZE_H
+#define QGSADAPTIVEBATCHSIZE_H
+
+#include <QtGlobal>
+
+/** Helper for feature iterators of database providers which fetch features
+ * from a server in batches (e.g. with FETCH FORWARD n from a cursor).
+ *
+ * The iterator reports every received batch: its number of rows, its size in bytes,
+ * how long the consumer of features had to wait for the batch and how long it took
+ * to consume the previous batch. The batch size grows while waiting for the server
+ * takes a substantial part of the time (i.e. round trips are not hidden behind
+ * the work on the client side) and is limited so that a batch does not take more
+ * than the given amount of memory.
+ *
+ * The sizing does not depend on how the batches are fetched, so it can be used with
+ * both blocking and asynchronous (prefetching) iterators.
+ *
+ * \note not available in Python bindings
+ * \note added in QGIS 2.16
+ */
+class CORE_EXPORT QgsAdaptiveBatchSize
+{
+  public:
+    /** Constructor
+     * @param initialSize number of rows of the first batch
+     * @param minimumSize minimal number of rows of a batch
+     * @param maximumSize maximal number of rows of a batch
+     * @param maximumBytes maximal amount of memory taken by the rows of a batch
+     */
+    QgsAdaptiveBatchSize( int initialSize, int minimumSize, int maximumSize, qint64 maximumBytes );
+
+    //! Number of rows to request in the next batch
+    int size() const { return mSize; }
+
+    /** Adjusts the batch size after a batch has been received
+     * @param rows number of rows in the batch
+     * @param bytes size of data of the rows
+     * @param waitMsecs time the consumer was blocked waiting for the batch
+     * @param consumeMsecs time spent consuming the previous batch (zero for the first one)
+     */
+    void batchReceived( int rows, qint64 bytes, int waitMsecs, int consumeMsecs );
+
+    //! Returns the average size of a row (in bytes) observed so far
+    double averageRowBytes() const { return mAverageRowBytes; }
+
+  private:
+    int mSize;
+    int mMinimumSize;
+    int mMaximumSize;
+    qint64 mMaximumBytes;
+    double mAverageRowBytes;
+};
+
+#endif // QGSADAPTIVEBATCHSIZE_H
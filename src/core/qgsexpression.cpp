@@ -1988,6 +1988,18 @@ static QVariant fcnGeomFromGML( const QVariantList& values, const QgsExpressionC
   return result;
 }
 
+/** Returns the key to cache a measurement of the current feature within the expression context. The key
+ * contains the distance area settings and units of the expression, as other expressions evaluated for the
+ * same feature may measure it differently.
+ */
+static QString measurementCacheKey( const QString& measurement, const QgsDistanceArea* calc, const QgsExpression* parent )
+{
+  return QString( "%1:%2:%3:%4:%5" ).arg( measurement, calc->ellipsoidalEnabled() ? calc->ellipsoid() : QString() )
+         .arg( calc->sourceCrsId() )
+         .arg( static_cast< int >( parent->distanceUnits() ) )
+         .arg( static_cast< int >( parent->areaUnits() ) );
+}
+
 static QVariant fcnGeomArea( const QVariantList&, const QgsExpressionContext* context, QgsExpression* parent )
 {
   FEAT_FROM_CONTEXT( context, f );
@@ -1995,8 +2007,14 @@ static QVariant fcnGeomArea( const QVariantList&, const QgsExpressionContext* co
   QgsDistanceArea* calc = parent->geomCalculator();
   if ( calc )
   {
+    // the renderer, labeling and diagrams may all measure the same feature
+    QString cacheKey = measurementCacheKey( "$area", calc, parent );
+    if ( context->hasCachedFeatureValue( f, cacheKey ) )
+      return context->cachedFeatureValue( f, cacheKey );
+
     double area = calc->measureArea( f.constGeometry() );
     area = calc->convertAreaMeasurement( area, parent->areaUnits() );
+    context->setCachedFeatureValue( f, cacheKey, area );
     return QVariant( area );
   }
   else
@@ -2022,8 +2040,13 @@ static QVariant fcnGeomLength( const QVariantList&, const QgsExpressionContext*
   QgsDistanceArea* calc = parent->geomCalculator();
   if ( calc )
   {
+    QString cacheKey = measurementCacheKey( "$length", calc, parent );
+    if ( context->hasCachedFeatureValue( f, cacheKey ) )
+      return context->cachedFeatureValue( f, cacheKey );
+
     double len = calc->measureLength( f.constGeometry() );
     len = calc->convertLengthMeasurement( len, parent->distanceUnits() );
+    context->setCachedFeatureValue( f, cacheKey, len );
     return QVariant( len );
   }
   else
@@ -2039,8 +2062,13 @@ static QVariant fcnGeomPerimeter( const QVariantList&, const QgsExpressionContex
   QgsDistanceArea* calc = parent->geomCalculator();
   if ( calc )
   {
+    QString cacheKey = measurementCacheKey( "$perimeter", calc, parent );
+    if ( context->hasCachedFeatureValue( f, cacheKey ) )
+      return context->cachedFeatureValue( f, cacheKey );
+
     double len = calc->measurePerimeter( f.constGeometry() );
     len = calc->convertLengthMeasurement( len, parent->distanceUnits() );
+    context->setCachedFeatureValue( f, cacheKey, len );
     return QVariant( len );
   }
   else
@@ -2989,7 +3017,7 @@ static QVariant fcnTransformGeometry( const QVariantList& values, const QgsExpre
 }
 
 
-static QVariant fcnGetFeature( const QVariantList& values, const QgsExpressionContext*, QgsExpression* parent )
+static QVariant fcnGetFeature( const QVariantList& values, const QgsExpressionContext* context, QgsExpression* parent )
 {
   //arguments: 1. layer id / name, 2. key attribute, 3. eq value
   QgsVectorLayer* vl = getVectorLayer( values.at( 0 ), parent );
@@ -3008,6 +3036,12 @@ static QVariant fcnGetFeature( const QVariantList& values, const QgsExpressionCo
   }
 
   const QVariant& attVal = values.at( 2 );
+
+  // the same feature is usually looked up for many features of a layer
+  QString cacheKey = QString( "getfeature:%1:%2:%3:%4" ).arg( vl->id(), parent->needsGeometry() ? "geom" : "nogeom", attribute, attVal.toString() );
+  if ( context && context->hasCachedValue( cacheKey ) )
+    return context->cachedValue( cacheKey );
+
   QgsFeatureRequest req;
   req.setFilterExpression( QString( "%1=%2" ).arg( QgsExpression::quotedColumnRef( attribute ),
                            QgsExpression::quotedString( attVal.toString() ) ) );
@@ -3018,11 +3052,14 @@ static QVariant fcnGetFeature( const QVariantList& values, const QgsExpressionCo
   }
   QgsFeatureIterator fIt = vl->getFeatures( req );
 
+  QVariant result;
   QgsFeature fet;
   if ( fIt.nextFeature( fet ) )
-    return QVariant::fromValue( fet );
+    result = QVariant::fromValue( fet );
 
-  return QVariant();
+  if ( context )
+    context->setCachedValue( cacheKey, result );
+  return result;
 }
 
 static QVariant fcnGetLayerProperty( const QVariantList& values, const QgsExpressionContext*, QgsExpression* parent )
@@ -3198,6 +3235,15 @@ const QStringList& QgsExpression::BuiltinFunctions()
   return gmBuiltinFunctions;
 }
 
+/** Marks a built-in function as pure, ie its result only depends on the values of its parameters
+ * and calls with constant arguments can be evaluated once when the expression is prepared.
+ */
+static QgsExpression::Function* pureFunction( QgsExpression::Function* function )
+{
+  function->setPure( true );
+  return function;
+}
+
 QList<QgsExpression::Function*> QgsExpression::gmFunctions;
 QList<QgsExpression::Function*> QgsExpression::gmOwnedFunctions;
 
@@ -3217,43 +3263,43 @@ const QList<QgsExpression::Function*>& QgsExpression::Functions()
                               << Parameter( "filter", true );
 
     gmFunctions
-    << new StaticFunction( "sqrt", ParameterList() << Parameter( "value" ), fcnSqrt, "Math" )
-    << new StaticFunction( "radians", ParameterList() << Parameter( "degrees" ), fcnRadians, "Math" )
-    << new StaticFunction( "degrees", ParameterList() << Parameter( "radians" ), fcnDegrees, "Math" )
-    << new StaticFunction( "azimuth", ParameterList() << Parameter( "point_a" ) << Parameter( "point_b" ), fcnAzimuth, "Math" )
-    << new StaticFunction( "project", ParameterList() << Parameter( "point" ) << Parameter( "distance" ) << Parameter( "bearing" ), fcnProject, "GeometryGroup" )
-    << new StaticFunction( "abs", ParameterList() << Parameter( "value" ), fcnAbs, "Math" )
-    << new StaticFunction( "cos", ParameterList() << Parameter( "angle" ), fcnCos, "Math" )
-    << new StaticFunction( "sin", ParameterList() << Parameter( "angle" ), fcnSin, "Math" )
-    << new StaticFunction( "tan", ParameterList() << Parameter( "angle" ), fcnTan, "Math" )
-    << new StaticFunction( "asin", ParameterList() << Parameter( "value" ), fcnAsin, "Math" )
-    << new StaticFunction( "acos", ParameterList() << Parameter( "value" ), fcnAcos, "Math" )
-    << new StaticFunction( "atan", ParameterList() << Parameter( "value" ), fcnAtan, "Math" )
-    << new StaticFunction( "atan2", ParameterList() << Parameter( "dx" ) << Parameter( "dy" ), fcnAtan2, "Math" )
-    << new StaticFunction( "exp", ParameterList() << Parameter( "value" ), fcnExp, "Math" )
-    << new StaticFunction( "ln", ParameterList() << Parameter( "value" ), fcnLn, "Math" )
-    << new StaticFunction( "log10", ParameterList() << Parameter( "value" ), fcnLog10, "Math" )
-    << new StaticFunction( "log", ParameterList() << Parameter( "base" ) << Parameter( "value" ), fcnLog, "Math" )
-    << new StaticFunction( "round", ParameterList() << Parameter( "value" ) << Parameter( "places", true, 0 ), fcnRound, "Math" )
+    << pureFunction( new StaticFunction( "sqrt", ParameterList() << Parameter( "value" ), fcnSqrt, "Math" ) )
+    << pureFunction( new StaticFunction( "radians", ParameterList() << Parameter( "degrees" ), fcnRadians, "Math" ) )
+    << pureFunction( new StaticFunction( "degrees", ParameterList() << Parameter( "radians" ), fcnDegrees, "Math" ) )
+    << pureFunction( new StaticFunction( "azimuth", ParameterList() << Parameter( "point_a" ) << Parameter( "point_b" ), fcnAzimuth, "Math" ) )
+    << pureFunction( new StaticFunction( "project", ParameterList() << Parameter( "point" ) << Parameter( "distance" ) << Parameter( "bearing" ), fcnProject, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "abs", ParameterList() << Parameter( "value" ), fcnAbs, "Math" ) )
+    << pureFunction( new StaticFunction( "cos", ParameterList() << Parameter( "angle" ), fcnCos, "Math" ) )
+    << pureFunction( new StaticFunction( "sin", ParameterList() << Parameter( "angle" ), fcnSin, "Math" ) )
+    << pureFunction( new StaticFunction( "tan", ParameterList() << Parameter( "angle" ), fcnTan, "Math" ) )
+    << pureFunction( new StaticFunction( "asin", ParameterList() << Parameter( "value" ), fcnAsin, "Math" ) )
+    << pureFunction( new StaticFunction( "acos", ParameterList() << Parameter( "value" ), fcnAcos, "Math" ) )
+    << pureFunction( new StaticFunction( "atan", ParameterList() << Parameter( "value" ), fcnAtan, "Math" ) )
+    << pureFunction( new StaticFunction( "atan2", ParameterList() << Parameter( "dx" ) << Parameter( "dy" ), fcnAtan2, "Math" ) )
+    << pureFunction( new StaticFunction( "exp", ParameterList() << Parameter( "value" ), fcnExp, "Math" ) )
+    << pureFunction( new StaticFunction( "ln", ParameterList() << Parameter( "value" ), fcnLn, "Math" ) )
+    << pureFunction( new StaticFunction( "log10", ParameterList() << Parameter( "value" ), fcnLog10, "Math" ) )
+    << pureFunction( new StaticFunction( "log", ParameterList() << Parameter( "base" ) << Parameter( "value" ), fcnLog, "Math" ) )
+    << pureFunction( new StaticFunction( "round", ParameterList() << Parameter( "value" ) << Parameter( "places", true, 0 ), fcnRound, "Math" ) )
     << new StaticFunction( "rand", ParameterList() << Parameter( "min" ) << Parameter( "max" ), fcnRnd, "Math" )
     << new StaticFunction( "randf", ParameterList() << Parameter( "min", true, 0.0 ) << Parameter( "max", true, 1.0 ), fcnRndF, "Math" )
-    << new StaticFunction( "max", -1, fcnMax, "Math" )
-    << new StaticFunction( "min", -1, fcnMin, "Math" )
-    << new StaticFunction( "clamp", ParameterList() << Parameter( "min" ) << Parameter( "value" ) << Parameter( "max" ), fcnClamp, "Math" )
-    << new StaticFunction( "scale_linear", 5, fcnLinearScale, "Math" )
-    << new StaticFunction( "scale_exp", 6, fcnExpScale, "Math" )
-    << new StaticFunction( "floor", 1, fcnFloor, "Math" )
-    << new StaticFunction( "ceil", 1, fcnCeil, "Math" )
-    << new StaticFunction( "pi", 0, fcnPi, "Math", QString(), false, QStringList(), false, QStringList() << "$pi" )
-    << new StaticFunction( "to_int", 1, fcnToInt, "Conversions", QString(), false, QStringList(), false, QStringList() << "toint" )
-    << new StaticFunction( "to_real", 1, fcnToReal, "Conversions", QString(), false, QStringList(), false, QStringList() << "toreal" )
-    << new StaticFunction( "to_string", 1, fcnToString, "Conversions", QString(), false, QStringList(), false, QStringList() << "tostring" )
-    << new StaticFunction( "to_datetime", 1, fcnToDateTime, "Conversions", QString(), false, QStringList(), false, QStringList() << "todatetime" )
-    << new StaticFunction( "to_date", 1, fcnToDate, "Conversions", QString(), false, QStringList(), false, QStringList() << "todate" )
-    << new StaticFunction( "to_time", 1, fcnToTime, "Conversions", QString(), false, QStringList(), false, QStringList() << "totime" )
-    << new StaticFunction( "to_interval", 1, fcnToInterval, "Conversions", QString(), false, QStringList(), false, QStringList() << "tointerval" )
-    << new StaticFunction( "coalesce", -1, fcnCoalesce, "Conditionals", QString(), false, QStringList(), false, QStringList(), true )
-    << new StaticFunction( "if", 3, fcnIf, "Conditionals", QString(), False, QStringList(), true )
+    << pureFunction( new StaticFunction( "max", -1, fcnMax, "Math" ) )
+    << pureFunction( new StaticFunction( "min", -1, fcnMin, "Math" ) )
+    << pureFunction( new StaticFunction( "clamp", ParameterList() << Parameter( "min" ) << Parameter( "value" ) << Parameter( "max" ), fcnClamp, "Math" ) )
+    << pureFunction( new StaticFunction( "scale_linear", 5, fcnLinearScale, "Math" ) )
+    << pureFunction( new StaticFunction( "scale_exp", 6, fcnExpScale, "Math" ) )
+    << pureFunction( new StaticFunction( "floor", 1, fcnFloor, "Math" ) )
+    << pureFunction( new StaticFunction( "ceil", 1, fcnCeil, "Math" ) )
+    << pureFunction( new StaticFunction( "pi", 0, fcnPi, "Math", QString(), false, QStringList(), false, QStringList() << "$pi" ) )
+    << pureFunction( new StaticFunction( "to_int", 1, fcnToInt, "Conversions", QString(), false, QStringList(), false, QStringList() << "toint" ) )
+    << pureFunction( new StaticFunction( "to_real", 1, fcnToReal, "Conversions", QString(), false, QStringList(), false, QStringList() << "toreal" ) )
+    << pureFunction( new StaticFunction( "to_string", 1, fcnToString, "Conversions", QString(), false, QStringList(), false, QStringList() << "tostring" ) )
+    << pureFunction( new StaticFunction( "to_datetime", 1, fcnToDateTime, "Conversions", QString(), false, QStringList(), false, QStringList() << "todatetime" ) )
+    << pureFunction( new StaticFunction( "to_date", 1, fcnToDate, "Conversions", QString(), false, QStringList(), false, QStringList() << "todate" ) )
+    << pureFunction( new StaticFunction( "to_time", 1, fcnToTime, "Conversions", QString(), false, QStringList(), false, QStringList() << "totime" ) )
+    << pureFunction( new StaticFunction( "to_interval", 1, fcnToInterval, "Conversions", QString(), false, QStringList(), false, QStringList() << "tointerval" ) )
+    << pureFunction( new StaticFunction( "coalesce", -1, fcnCoalesce, "Conditionals", QString(), false, QStringList(), false, QStringList(), true ) )
+    << pureFunction( new StaticFunction( "if", 3, fcnIf, "Conditionals", QString(), False, QStringList(), true ) )
     << new StaticFunction( "aggregate", ParameterList() << Parameter( "layer" ) << Parameter( "aggregate" ) << Parameter( "expression" )
                            << Parameter( "filter", true ) << Parameter( "concatenator", true ), fcnAggregate, "Aggregates", QString(), False, QStringList(), true )
     << new StaticFunction( "relation_aggregate", ParameterList() << Parameter( "relation" ) << Parameter( "aggregate" ) << Parameter( "expression" ) << Parameter( "concatenator", true ),
@@ -3278,122 +3324,122 @@ const QList<QgsExpression::Function*>& QgsExpression::Functions()
     << new StaticFunction( "max_length", aggParams, fcnAggregateMaxLength, "Aggregates", QString(), False, QStringList(), true )
     << new StaticFunction( "concatenate", aggParams << Parameter( "concatenator", true ), fcnAggregateStringConcat, "Aggregates", QString(), False, QStringList(), true )
 
-    << new StaticFunction( "regexp_match", 2, fcnRegexpMatch, "Conditionals" )
+    << pureFunction( new StaticFunction( "regexp_match", 2, fcnRegexpMatch, "Conditionals" ) )
     << new StaticFunction( "now", 0, fcnNow, "Date and Time", QString(), false, QStringList(), false, QStringList() << "$now" )
-    << new StaticFunction( "age", 2, fcnAge, "Date and Time" )
-    << new StaticFunction( "year", 1, fcnYear, "Date and Time" )
-    << new StaticFunction( "month", 1, fcnMonth, "Date and Time" )
-    << new StaticFunction( "week", 1, fcnWeek, "Date and Time" )
-    << new StaticFunction( "day", 1, fcnDay, "Date and Time" )
-    << new StaticFunction( "hour", 1, fcnHour, "Date and Time" )
-    << new StaticFunction( "minute", 1, fcnMinute, "Date and Time" )
-    << new StaticFunction( "second", 1, fcnSeconds, "Date and Time" )
-    << new StaticFunction( "day_of_week", 1, fcnDayOfWeek, "Date and Time" )
-    << new StaticFunction( "lower", 1, fcnLower, "String" )
-    << new StaticFunction( "upper", 1, fcnUpper, "String" )
-    << new StaticFunction( "title", 1, fcnTitle, "String" )
-    << new StaticFunction( "trim", 1, fcnTrim, "String" )
-    << new StaticFunction( "levenshtein", 2, fcnLevenshtein, "Fuzzy Matching" )
-    << new StaticFunction( "longest_common_substring", 2, fcnLCS, "Fuzzy Matching" )
-    << new StaticFunction( "hamming_distance", 2, fcnHamming, "Fuzzy Matching" )
-    << new StaticFunction( "soundex", 1, fcnSoundex, "Fuzzy Matching" )
-    << new StaticFunction( "char", 1, fcnChar, "String" )
-    << new StaticFunction( "wordwrap", ParameterList() << Parameter( "text" ) << Parameter( "length" ) << Parameter( "delimiter", true, " " ), fcnWordwrap, "String" )
-    << new StaticFunction( "length", 1, fcnLength, "String" )
-    << new StaticFunction( "replace", 3, fcnReplace, "String" )
-    << new StaticFunction( "regexp_replace", 3, fcnRegexpReplace, "String" )
-    << new StaticFunction( "regexp_substr", 2, fcnRegexpSubstr, "String" )
-    << new StaticFunction( "substr", 3, fcnSubstr, "String" )
-    << new StaticFunction( "concat", -1, fcnConcat, "String", QString(), false, QStringList(), false, QStringList(), true )
-    << new StaticFunction( "strpos", 2, fcnStrpos, "String" )
-    << new StaticFunction( "left", 2, fcnLeft, "String" )
-    << new StaticFunction( "right", 2, fcnRight, "String" )
-    << new StaticFunction( "rpad", 3, fcnRPad, "String" )
-    << new StaticFunction( "lpad", 3, fcnLPad, "String" )
-    << new StaticFunction( "format", -1, fcnFormatString, "String" )
-    << new StaticFunction( "format_number", 2, fcnFormatNumber, "String" )
-    << new StaticFunction( "format_date", 2, fcnFormatDate, "String" )
-    << new StaticFunction( "color_rgb", 3, fcnColorRgb, "Color" )
-    << new StaticFunction( "color_rgba", 4, fncColorRgba, "Color" )
+    << pureFunction( new StaticFunction( "age", 2, fcnAge, "Date and Time" ) )
+    << pureFunction( new StaticFunction( "year", 1, fcnYear, "Date and Time" ) )
+    << pureFunction( new StaticFunction( "month", 1, fcnMonth, "Date and Time" ) )
+    << pureFunction( new StaticFunction( "week", 1, fcnWeek, "Date and Time" ) )
+    << pureFunction( new StaticFunction( "day", 1, fcnDay, "Date and Time" ) )
+    << pureFunction( new StaticFunction( "hour", 1, fcnHour, "Date and Time" ) )
+    << pureFunction( new StaticFunction( "minute", 1, fcnMinute, "Date and Time" ) )
+    << pureFunction( new StaticFunction( "second", 1, fcnSeconds, "Date and Time" ) )
+    << pureFunction( new StaticFunction( "day_of_week", 1, fcnDayOfWeek, "Date and Time" ) )
+    << pureFunction( new StaticFunction( "lower", 1, fcnLower, "String" ) )
+    << pureFunction( new StaticFunction( "upper", 1, fcnUpper, "String" ) )
+    << pureFunction( new StaticFunction( "title", 1, fcnTitle, "String" ) )
+    << pureFunction( new StaticFunction( "trim", 1, fcnTrim, "String" ) )
+    << pureFunction( new StaticFunction( "levenshtein", 2, fcnLevenshtein, "Fuzzy Matching" ) )
+    << pureFunction( new StaticFunction( "longest_common_substring", 2, fcnLCS, "Fuzzy Matching" ) )
+    << pureFunction( new StaticFunction( "hamming_distance", 2, fcnHamming, "Fuzzy Matching" ) )
+    << pureFunction( new StaticFunction( "soundex", 1, fcnSoundex, "Fuzzy Matching" ) )
+    << pureFunction( new StaticFunction( "char", 1, fcnChar, "String" ) )
+    << pureFunction( new StaticFunction( "wordwrap", ParameterList() << Parameter( "text" ) << Parameter( "length" ) << Parameter( "delimiter", true, " " ), fcnWordwrap, "String" ) )
+    << pureFunction( new StaticFunction( "length", 1, fcnLength, "String" ) )
+    << pureFunction( new StaticFunction( "replace", 3, fcnReplace, "String" ) )
+    << pureFunction( new StaticFunction( "regexp_replace", 3, fcnRegexpReplace, "String" ) )
+    << pureFunction( new StaticFunction( "regexp_substr", 2, fcnRegexpSubstr, "String" ) )
+    << pureFunction( new StaticFunction( "substr", 3, fcnSubstr, "String" ) )
+    << pureFunction( new StaticFunction( "concat", -1, fcnConcat, "String", QString(), false, QStringList(), false, QStringList(), true ) )
+    << pureFunction( new StaticFunction( "strpos", 2, fcnStrpos, "String" ) )
+    << pureFunction( new StaticFunction( "left", 2, fcnLeft, "String" ) )
+    << pureFunction( new StaticFunction( "right", 2, fcnRight, "String" ) )
+    << pureFunction( new StaticFunction( "rpad", 3, fcnRPad, "String" ) )
+    << pureFunction( new StaticFunction( "lpad", 3, fcnLPad, "String" ) )
+    << pureFunction( new StaticFunction( "format", -1, fcnFormatString, "String" ) )
+    << pureFunction( new StaticFunction( "format_number", 2, fcnFormatNumber, "String" ) )
+    << pureFunction( new StaticFunction( "format_date", 2, fcnFormatDate, "String" ) )
+    << pureFunction( new StaticFunction( "color_rgb", 3, fcnColorRgb, "Color" ) )
+    << pureFunction( new StaticFunction( "color_rgba", 4, fncColorRgba, "Color" ) )
     << new StaticFunction( "ramp_color", 2, fcnRampColor, "Color" )
-    << new StaticFunction( "color_hsl", 3, fcnColorHsl, "Color" )
-    << new StaticFunction( "color_hsla", 4, fncColorHsla, "Color" )
-    << new StaticFunction( "color_hsv", 3, fcnColorHsv, "Color" )
-    << new StaticFunction( "color_hsva", 4, fncColorHsva, "Color" )
-    << new StaticFunction( "color_cmyk", 4, fcnColorCmyk, "Color" )
-    << new StaticFunction( "color_cmyka", 5, fncColorCmyka, "Color" )
-    << new StaticFunction( "color_part", 2, fncColorPart, "Color" )
-    << new StaticFunction( "darker", 2, fncDarker, "Color" )
-    << new StaticFunction( "lighter", 2, fncLighter, "Color" )
-    << new StaticFunction( "set_color_part", 3, fncSetColorPart, "Color" )
+    << pureFunction( new StaticFunction( "color_hsl", 3, fcnColorHsl, "Color" ) )
+    << pureFunction( new StaticFunction( "color_hsla", 4, fncColorHsla, "Color" ) )
+    << pureFunction( new StaticFunction( "color_hsv", 3, fcnColorHsv, "Color" ) )
+    << pureFunction( new StaticFunction( "color_hsva", 4, fncColorHsva, "Color" ) )
+    << pureFunction( new StaticFunction( "color_cmyk", 4, fcnColorCmyk, "Color" ) )
+    << pureFunction( new StaticFunction( "color_cmyka", 5, fncColorCmyka, "Color" ) )
+    << pureFunction( new StaticFunction( "color_part", 2, fncColorPart, "Color" ) )
+    << pureFunction( new StaticFunction( "darker", 2, fncDarker, "Color" ) )
+    << pureFunction( new StaticFunction( "lighter", 2, fncLighter, "Color" ) )
+    << pureFunction( new StaticFunction( "set_color_part", 3, fncSetColorPart, "Color" ) )
     << new StaticFunction( "$geometry", 0, fcnGeometry, "GeometryGroup", QString(), true )
     << new StaticFunction( "$area", 0, fcnGeomArea, "GeometryGroup", QString(), true )
-    << new StaticFunction( "area", 1, fcnArea, "GeometryGroup" )
+    << pureFunction( new StaticFunction( "area", 1, fcnArea, "GeometryGroup" ) )
     << new StaticFunction( "$length", 0, fcnGeomLength, "GeometryGroup", QString(), true )
     << new StaticFunction( "$perimeter", 0, fcnGeomPerimeter, "GeometryGroup", QString(), true )
-    << new StaticFunction( "perimeter", 1, fcnPerimeter, "GeometryGroup" )
+    << pureFunction( new StaticFunction( "perimeter", 1, fcnPerimeter, "GeometryGroup" ) )
     << new StaticFunction( "$x", 0, fcnX, "GeometryGroup", QString(), true )
     << new StaticFunction( "$y", 0, fcnY, "GeometryGroup", QString(), true )
-    << new StaticFunction( "x", 1, fcnGeomX, "GeometryGroup" )
-    << new StaticFunction( "y", 1, fcnGeomY, "GeometryGroup" )
-    << new StaticFunction( "z", 1, fcnGeomZ, "GeometryGroup" )
-    << new StaticFunction( "m", 1, fcnGeomM, "GeometryGroup" )
-    << new StaticFunction( "point_n", 2, fcnPointN, "GeometryGroup" )
-    << new StaticFunction( "start_point", 1, fcnStartPoint, "GeometryGroup" )
-    << new StaticFunction( "end_point", 1, fcnEndPoint, "GeometryGroup" )
-    << new StaticFunction( "nodes_to_points", -1, fcnNodesToPoints, "GeometryGroup" )
-    << new StaticFunction( "segments_to_lines", 1, fcnSegmentsToLines, "GeometryGroup" )
-    << new StaticFunction( "make_point", -1, fcnMakePoint, "GeometryGroup" )
-    << new StaticFunction( "make_point_m", 3, fcnMakePointM, "GeometryGroup" )
-    << new StaticFunction( "make_line", -1, fcnMakeLine, "GeometryGroup" )
-    << new StaticFunction( "make_polygon", -1, fcnMakePolygon, "GeometryGroup" )
+    << pureFunction( new StaticFunction( "x", 1, fcnGeomX, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "y", 1, fcnGeomY, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "z", 1, fcnGeomZ, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "m", 1, fcnGeomM, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "point_n", 2, fcnPointN, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "start_point", 1, fcnStartPoint, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "end_point", 1, fcnEndPoint, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "nodes_to_points", -1, fcnNodesToPoints, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "segments_to_lines", 1, fcnSegmentsToLines, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "make_point", -1, fcnMakePoint, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "make_point_m", 3, fcnMakePointM, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "make_line", -1, fcnMakeLine, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "make_polygon", -1, fcnMakePolygon, "GeometryGroup" ) )
     << new StaticFunction( "$x_at", 1, fcnXat, "GeometryGroup", QString(), true, QStringList(), false, QStringList() << "xat" << "x_at" )
     << new StaticFunction( "$y_at", 1, fcnYat, "GeometryGroup", QString(), true, QStringList(), false, QStringList() << "yat" << "y_at" )
-    << new StaticFunction( "x_min", 1, fcnXMin, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "xmin" )
-    << new StaticFunction( "x_max", 1, fcnXMax, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "xmax" )
-    << new StaticFunction( "y_min", 1, fcnYMin, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "ymin" )
-    << new StaticFunction( "y_max", 1, fcnYMax, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "ymax" )
-    << new StaticFunction( "geom_from_wkt", 1, fcnGeomFromWKT, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "geomFromWKT" )
-    << new StaticFunction( "geom_from_gml", 1, fcnGeomFromGML, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "geomFromGML" )
-    << new StaticFunction( "relate", -1, fcnRelate, "GeometryGroup" )
-    << new StaticFunction( "intersects_bbox", 2, fcnBbox, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "bbox" )
-    << new StaticFunction( "disjoint", 2, fcnDisjoint, "GeometryGroup" )
-    << new StaticFunction( "intersects", 2, fcnIntersects, "GeometryGroup" )
-    << new StaticFunction( "touches", 2, fcnTouches, "GeometryGroup" )
-    << new StaticFunction( "crosses", 2, fcnCrosses, "GeometryGroup" )
-    << new StaticFunction( "contains", 2, fcnContains, "GeometryGroup" )
-    << new StaticFunction( "overlaps", 2, fcnOverlaps, "GeometryGroup" )
-    << new StaticFunction( "within", 2, fcnWithin, "GeometryGroup" )
-    << new StaticFunction( "translate", 3, fcnTranslate, "GeometryGroup" )
-    << new StaticFunction( "buffer", -1, fcnBuffer, "GeometryGroup" )
-    << new StaticFunction( "centroid", 1, fcnCentroid, "GeometryGroup" )
-    << new StaticFunction( "point_on_surface", 1, fcnPointOnSurface, "GeometryGroup" )
-    << new StaticFunction( "reverse", 1, fcnReverse, "GeometryGroup" )
-    << new StaticFunction( "exterior_ring", 1, fcnExteriorRing, "GeometryGroup" )
-    << new StaticFunction( "interior_ring_n", 2, fcnInteriorRingN, "GeometryGroup" )
-    << new StaticFunction( "geometry_n", 2, fcnGeometryN, "GeometryGroup" )
-    << new StaticFunction( "bounds", 1, fcnBounds, "GeometryGroup" )
-    << new StaticFunction( "num_points", 1, fcnGeomNumPoints, "GeometryGroup" )
-    << new StaticFunction( "num_interior_rings", 1, fcnGeomNumInteriorRings, "GeometryGroup" )
-    << new StaticFunction( "num_rings", 1, fcnGeomNumRings, "GeometryGroup" )
-    << new StaticFunction( "num_geometries", 1, fcnGeomNumGeometries, "GeometryGroup" )
-    << new StaticFunction( "bounds_width", 1, fcnBoundsWidth, "GeometryGroup" )
-    << new StaticFunction( "bounds_height", 1, fcnBoundsHeight, "GeometryGroup" )
-    << new StaticFunction( "is_closed", 1, fcnIsClosed, "GeometryGroup" )
-    << new StaticFunction( "convex_hull", 1, fcnConvexHull, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "convexHull" )
-    << new StaticFunction( "difference", 2, fcnDifference, "GeometryGroup" )
-    << new StaticFunction( "distance", 2, fcnDistance, "GeometryGroup" )
-    << new StaticFunction( "intersection", 2, fcnIntersection, "GeometryGroup" )
-    << new StaticFunction( "sym_difference", 2, fcnSymDifference, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "symDifference" )
-    << new StaticFunction( "combine", 2, fcnCombine, "GeometryGroup" )
-    << new StaticFunction( "union", 2, fcnCombine, "GeometryGroup" )
-    << new StaticFunction( "geom_to_wkt", -1, fcnGeomToWKT, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "geomToWKT" )
+    << pureFunction( new StaticFunction( "x_min", 1, fcnXMin, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "xmin" ) )
+    << pureFunction( new StaticFunction( "x_max", 1, fcnXMax, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "xmax" ) )
+    << pureFunction( new StaticFunction( "y_min", 1, fcnYMin, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "ymin" ) )
+    << pureFunction( new StaticFunction( "y_max", 1, fcnYMax, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "ymax" ) )
+    << pureFunction( new StaticFunction( "geom_from_wkt", 1, fcnGeomFromWKT, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "geomFromWKT" ) )
+    << pureFunction( new StaticFunction( "geom_from_gml", 1, fcnGeomFromGML, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "geomFromGML" ) )
+    << pureFunction( new StaticFunction( "relate", -1, fcnRelate, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "intersects_bbox", 2, fcnBbox, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "bbox" ) )
+    << pureFunction( new StaticFunction( "disjoint", 2, fcnDisjoint, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "intersects", 2, fcnIntersects, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "touches", 2, fcnTouches, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "crosses", 2, fcnCrosses, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "contains", 2, fcnContains, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "overlaps", 2, fcnOverlaps, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "within", 2, fcnWithin, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "translate", 3, fcnTranslate, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "buffer", -1, fcnBuffer, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "centroid", 1, fcnCentroid, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "point_on_surface", 1, fcnPointOnSurface, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "reverse", 1, fcnReverse, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "exterior_ring", 1, fcnExteriorRing, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "interior_ring_n", 2, fcnInteriorRingN, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "geometry_n", 2, fcnGeometryN, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "bounds", 1, fcnBounds, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "num_points", 1, fcnGeomNumPoints, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "num_interior_rings", 1, fcnGeomNumInteriorRings, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "num_rings", 1, fcnGeomNumRings, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "num_geometries", 1, fcnGeomNumGeometries, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "bounds_width", 1, fcnBoundsWidth, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "bounds_height", 1, fcnBoundsHeight, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "is_closed", 1, fcnIsClosed, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "convex_hull", 1, fcnConvexHull, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "convexHull" ) )
+    << pureFunction( new StaticFunction( "difference", 2, fcnDifference, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "distance", 2, fcnDistance, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "intersection", 2, fcnIntersection, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "sym_difference", 2, fcnSymDifference, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "symDifference" ) )
+    << pureFunction( new StaticFunction( "combine", 2, fcnCombine, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "union", 2, fcnCombine, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "geom_to_wkt", -1, fcnGeomToWKT, "GeometryGroup", QString(), false, QStringList(), false, QStringList() << "geomToWKT" ) )
     << new StaticFunction( "geometry", 1, fcnGetGeometry, "GeometryGroup", QString(), true )
-    << new StaticFunction( "transform", 3, fcnTransformGeometry, "GeometryGroup" )
-    << new StaticFunction( "extrude", 3, fcnExtrude, "GeometryGroup", QString() )
+    << pureFunction( new StaticFunction( "transform", 3, fcnTransformGeometry, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "extrude", 3, fcnExtrude, "GeometryGroup", QString() ) )
     << new StaticFunction( "order_parts", 3, fcnOrderParts, "GeometryGroup", QString() )
-    << new StaticFunction( "closest_point", 2, fcnClosestPoint, "GeometryGroup" )
-    << new StaticFunction( "shortest_line", 2, fcnShortestLine, "GeometryGroup" )
+    << pureFunction( new StaticFunction( "closest_point", 2, fcnClosestPoint, "GeometryGroup" ) )
+    << pureFunction( new StaticFunction( "shortest_line", 2, fcnShortestLine, "GeometryGroup" ) )
     << new StaticFunction( "$rownum", 0, fcnRowNumber, "deprecated" )
     << new StaticFunction( "$id", 0, fcnFeatureId, "Record" )
     << new StaticFunction( "$currentfeature", 0, fcnFeature, "Record" )
@@ -4542,11 +4588,71 @@ QgsExpression::Node*QgsExpression::NodeInOperator::clone() const
 
 //
 
+/** Returns true if a node always evaluates to the same value, ie it only consists of literals, operators
+ * and calls of pure functions. Conditions are conservatively considered as not static.
+ */
+static bool isStaticNode( const QgsExpression::Node* node )
+{
+  switch ( node->nodeType() )
+  {
+    case QgsExpression::ntLiteral:
+      return true;
+
+    case QgsExpression::ntUnaryOperator:
+      return isStaticNode( static_cast<const QgsExpression::NodeUnaryOperator*>( node )->operand() );
+
+    case QgsExpression::ntBinaryOperator:
+    {
+      const QgsExpression::NodeBinaryOperator* binaryOperator = static_cast<const QgsExpression::NodeBinaryOperator*>( node );
+      return isStaticNode( binaryOperator->opLeft() ) && isStaticNode( binaryOperator->opRight() );
+    }
+
+    case QgsExpression::ntInOperator:
+    {
+      const QgsExpression::NodeInOperator* inOperator = static_cast<const QgsExpression::NodeInOperator*>( node );
+      if ( !isStaticNode( inOperator->node() ) )
+        return false;
+      Q_FOREACH ( QgsExpression::Node* n, inOperator->list()->list() )
+      {
+        if ( !isStaticNode( n ) )
+          return false;
+      }
+      return true;
+    }
+
+    case QgsExpression::ntFunction:
+    {
+      const QgsExpression::NodeFunction* function = static_cast<const QgsExpression::NodeFunction*>( node );
+      if ( !QgsExpression::Functions()[function->fnIndex()]->isPure() )
+        return false;
+      if ( function->args() )
+      {
+        Q_FOREACH ( QgsExpression::Node* n, function->args()->list() )
+        {
+          if ( !isStaticNode( n ) )
+            return false;
+        }
+      }
+      return true;
+    }
+
+    case QgsExpression::ntColumnRef:
+    case QgsExpression::ntCondition:
+      return false;
+  }
+  return false;
+}
+
 QVariant QgsExpression::NodeFunction::eval( QgsExpression *parent, const QgsExpressionContext *context )
 {
   QString name = Functions()[mFnIndex]->name();
   Function* fd = context && context->hasFunction( name ) ? context->function( name ) : Functions()[mFnIndex];
 
+  // calls of pure functions with constant arguments are evaluated once in prepare(),
+  // unless the function is overridden by the context
+  if ( mHasCachedValue && fd == Functions()[mFnIndex] )
+    return mCachedValue;
+
   // evaluate arguments
   QVariantList argValues;
   if ( mArgs )
@@ -4590,6 +4696,24 @@ bool QgsExpression::NodeFunction::prepare( QgsExpression *parent, const QgsExpre
       res = res && n->prepare( parent, context );
     }
   }
+
+  // evaluate calls of pure functions with constant arguments once, the tree
+  // is not shared with other expressions after QgsExpression::prepare()
+  mHasCachedValue = false;
+  mCachedValue = QVariant();
+  if ( res && isStaticNode( this ) && !( context && context->hasFunction( fd->name() ) ) )
+  {
+    QString prevEvalErrorString = parent->evalErrorString();
+    parent->setEvalErrorString( QString() );
+    QVariant value = eval( parent, context );
+    if ( !parent->hasEvalError() )
+    {
+      mCachedValue = value;
+      mHasCachedValue = true;
+    }
+    // errors are reported when the expression is evaluated
+    parent->setEvalErrorString( prevEvalErrorString );
+  }
   return res;
 }
 
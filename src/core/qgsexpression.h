@@ -503,6 +503,7 @@ class CORE_EXPORT QgsExpression
             , mLazyEval( lazyEval )
             , mHandlesNull( handlesNull )
             , mIsContextual( isContextual )
+            , mIsPure( false )
         {
         }
 
@@ -528,6 +529,7 @@ class CORE_EXPORT QgsExpression
             , mLazyEval( lazyEval )
             , mHandlesNull( handlesNull )
             , mIsContextual( isContextual )
+            , mIsPure( false )
         {}
 
         virtual ~Function() {}
@@ -581,6 +583,21 @@ class CORE_EXPORT QgsExpression
          */
         bool isContextual() const { return mIsContextual; }
 
+        /** Returns whether the function is pure, ie its result only depends on the values of its parameters
+         * and not on the feature, the expression context or eg the current time. Calls of pure functions
+         * whose parameters are constant are only evaluated once, when the expression is prepared.
+         * @see setPure()
+         * @note added in QGIS 2.16
+         */
+        bool isPure() const { return mIsPure; }
+
+        /** Sets whether the function is pure, ie its result only depends on the values of its parameters.
+         * Functions are not pure by default.
+         * @see isPure()
+         * @note added in QGIS 2.16
+         */
+        void setPure( bool pure ) { mIsPure = pure; }
+
         /** The group the function belongs to. */
         QString group() const { return mGroup; }
         /** The help text for the function. */
@@ -621,6 +638,7 @@ class CORE_EXPORT QgsExpression
         bool mLazyEval;
         bool mHandlesNull;
         bool mIsContextual; //if true function is only available through an expression context
+        bool mIsPure; //if true the result only depends on the parameter values
     };
 
     /**
@@ -1067,7 +1085,9 @@ class CORE_EXPORT QgsExpression
     class CORE_EXPORT NodeFunction : public Node
     {
       public:
-        NodeFunction( int fnIndex, NodeList* args ) : mFnIndex( fnIndex )
+        NodeFunction( int fnIndex, NodeList* args )
+            : mFnIndex( fnIndex )
+            , mHasCachedValue( false )
         {
           const ParameterList& functionParams = Functions()[mFnIndex]->parameters();
           if ( !args || !args->hasNamedNodes() || functionParams.isEmpty() )
@@ -1199,6 +1219,11 @@ class CORE_EXPORT QgsExpression
         int mFnIndex;
         NodeList* mArgs;
 
+      private:
+        //! Result of a call of a pure function with constant arguments, evaluated in prepare()
+        bool mHasCachedValue;
+        QVariant mCachedValue;
+
     };
 
     class CORE_EXPORT NodeLiteral : public Node
@@ -214,6 +214,8 @@ QgsExpressionContext::QgsExpressionContext( const QgsExpressionContext& other )
   }
   mHighlightedVariables = other.mHighlightedVariables;
   mCachedValues = other.mCachedValues;
+  mCachedFeature = other.mCachedFeature;
+  mCachedFeatureValues = other.mCachedFeatureValues;
 }
 
 QgsExpressionContext& QgsExpressionContext::operator=( const QgsExpressionContext & other )
@@ -226,6 +228,8 @@ QgsExpressionContext& QgsExpressionContext::operator=( const QgsExpressionContex
   }
   mHighlightedVariables = other.mHighlightedVariables;
   mCachedValues = other.mCachedValues;
+  mCachedFeature = other.mCachedFeature;
+  mCachedFeatureValues = other.mCachedFeatureValues;
   return *this;
 }
 
@@ -459,6 +463,38 @@ QVariant QgsExpressionContext::cachedValue( const QString& key ) const
 void QgsExpressionContext::clearCachedValues() const
 {
   mCachedValues.clear();
+  mCachedFeature = QgsFeature();
+  mCachedFeatureValues.clear();
+}
+
+bool QgsExpressionContext::isCachedFeature( const QgsFeature& feature ) const
+{
+  // copies of a feature share their geometry and attributes. As mCachedFeature holds on to them,
+  // a modified feature with the same id can not end up at the same addresses.
+  return !mCachedFeatureValues.isEmpty()
+         && feature.id() == mCachedFeature.id()
+         && feature.constGeometry() == mCachedFeature.constGeometry()
+         && feature.attributes().constData() == mCachedFeature.attributes().constData();
+}
+
+void QgsExpressionContext::setCachedFeatureValue( const QgsFeature& feature, const QString& key, const QVariant& value ) const
+{
+  if ( !isCachedFeature( feature ) )
+  {
+    mCachedFeatureValues.clear();
+    mCachedFeature = feature;
+  }
+  mCachedFeatureValues.insert( key, value );
+}
+
+bool QgsExpressionContext::hasCachedFeatureValue( const QgsFeature& feature, const QString& key ) const
+{
+  return isCachedFeature( feature ) && mCachedFeatureValues.contains( key );
+}
+
+QVariant QgsExpressionContext::cachedFeatureValue( const QgsFeature& feature, const QString& key ) const
+{
+  return isCachedFeature( feature ) ? mCachedFeatureValues.value( key, QVariant() ) : QVariant();
 }
 
 
@@ -21,6 +21,7 @@
 #include <QStringList>
 #include <QSet>
 #include "qgsexpression.h"
+#include "qgsfeature.h"
 
 class QgsExpression;
 class QgsMapLayer;
@@ -474,6 +475,40 @@ class CORE_EXPORT QgsExpressionContext
      */
     void clearCachedValues() const;
 
+    /** Sets a value to cache for a feature within the expression context. Only the values of the most recent
+     * feature are kept, so the cache can be used to share the results of expensive per-feature calculations,
+     * eg measurements, between the renderer, labeling and diagrams while they process the same feature.
+     * @param feature feature the value was calculated for
+     * @param key unique key for retrieving cached value
+     * @param value value to cache
+     * @see hasCachedFeatureValue()
+     * @see cachedFeatureValue()
+     * @see clearCachedValues()
+     * @note added in QGIS 2.16
+     */
+    void setCachedFeatureValue( const QgsFeature& feature, const QString& key, const QVariant& value ) const;
+
+    /** Returns true if the expression context contains a cached value for a feature with a matching key.
+     * The value is only returned for the same feature, ie a feature with a matching id which shares its
+     * geometry and attributes with the feature the value was cached for.
+     * @param feature feature to retrieve the value for
+     * @param key unique key used to store cached value
+     * @see setCachedFeatureValue()
+     * @see cachedFeatureValue()
+     * @note added in QGIS 2.16
+     */
+    bool hasCachedFeatureValue( const QgsFeature& feature, const QString& key ) const;
+
+    /** Returns the matching cached value for a feature, if set.
+     * @param feature feature to retrieve the value for
+     * @param key unique key used to store cached value
+     * @returns matching cached value, or invalid QVariant if not set
+     * @see setCachedFeatureValue()
+     * @see hasCachedFeatureValue()
+     * @note added in QGIS 2.16
+     */
+    QVariant cachedFeatureValue( const QgsFeature& feature, const QString& key ) const;
+
     //! Inbuilt variable name for fields storage
     static const QString EXPR_FIELDS;
     //! Inbuilt variable name for feature storage
@@ -501,6 +536,12 @@ class CORE_EXPORT QgsExpressionContext
     // Cache is mutable because we want to be able to add cached values to const contexts
     mutable QMap< QString, QVariant > mCachedValues;
 
+    //! Feature the cached feature values belong to, the copy keeps its geometry and attributes alive
+    mutable QgsFeature mCachedFeature;
+    mutable QHash< QString, QVariant > mCachedFeatureValues;
+
+    bool isCachedFeature( const QgsFeature& feature ) const;
+
 };
 
 /** \ingroup core
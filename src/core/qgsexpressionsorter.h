@@ -113,8 +113,8 @@ class QgsExpressionSorter
         }
       }
 
-      // Equal
-      return true;
+      // Equal (the comparison must be a strict weak ordering for sorting and merging)
+      return false;
     }
 
     void sortFeatures( QList<QgsFeature>& features, QgsExpressionContext* expressionContext )
@@ -17,7 +17,7 @@
 
 #include "qgssimplifymethod.h"
 
-#include "qgsexpressionsorter.h"
+#include "qgsfeaturesorter.h"
 
 QgsAbstractFeatureIterator::QgsAbstractFeatureIterator( const QgsFeatureRequest& request )
     : mRequest( request )
@@ -27,11 +27,13 @@ QgsAbstractFeatureIterator::QgsAbstractFeatureIterator( const QgsFeatureRequest&
     , mFetchedCount( 0 )
     , mCompileStatus( NoCompilation )
     , mUseCachedFeatures( false )
+    , mSorter( nullptr )
 {
 }
 
 QgsAbstractFeatureIterator::~QgsAbstractFeatureIterator()
 {
+  delete mSorter;
 }
 
 bool QgsAbstractFeatureIterator::nextFeature( QgsFeature& f )
@@ -44,15 +46,9 @@ bool QgsAbstractFeatureIterator::nextFeature( QgsFeature& f )
 
   if ( mUseCachedFeatures )
   {
-    if ( mFeatureIterator != mCachedFeatures.constEnd() )
+    dataOk = mSorter->nextFeature( f );
+    if ( !dataOk )
     {
-      f = mFeatureIterator->mFeature;
-      ++mFeatureIterator;
-      dataOk = true;
-    }
-    else
-    {
-      dataOk = false;
       // even the zombie dies at this point...
       mZombie = false;
     }
@@ -150,7 +146,8 @@ void QgsAbstractFeatureIterator::setupOrderBy( const QList<QgsFeatureRequest::Or
     }
     while ( ++orderByIt != preparedOrderBys.end() );
 
-    // Fetch all features
+    // Fetch all features, the sorter only keeps the first features if there is a limit
+    mSorter = new QgsFeatureSorter( preparedOrderBys, mRequest.limit() );
     QgsIndexedFeature indexedFeature;
     indexedFeature.mIndexes.resize( preparedOrderBys.size() );
 
@@ -166,12 +163,11 @@ void QgsAbstractFeatureIterator::setupOrderBy( const QList<QgsFeatureRequest::Or
       // We need all features, to ignore the limit for this pre-fetch
       // keep the fetched count at 0.
       mFetchedCount = 0;
-      mCachedFeatures.append( indexedFeature );
+      mSorter->addFeature( indexedFeature );
     }
 
-    qSort( mCachedFeatures.begin(), mCachedFeatures.end(), QgsExpressionSorter( preparedOrderBys ) );
+    mSorter->finish();
 
-    mFeatureIterator = mCachedFeatures.constBegin();
     mUseCachedFeatures = true;
     // The real iterator is closed, we are only serving cached features
     mZombie = true;
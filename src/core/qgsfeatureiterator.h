@@ -19,6 +19,7 @@
 #include "qgslogger.h"
 #include "qgsindexedfeature.h"
 
+class QgsFeatureSorter;
 
 /** \ingroup core
  * Interface that can be optionaly attached to an iterator so its
@@ -145,8 +146,8 @@ class CORE_EXPORT QgsAbstractFeatureIterator
 
   private:
     bool mUseCachedFeatures;
-    QList<QgsIndexedFeature> mCachedFeatures;
-    QList<QgsIndexedFeature>::ConstIterator mFeatureIterator;
+    //! Sorts the features locally if the provider cannot order them
+    QgsFeatureSorter* mSorter;
 
     //! returns whether the iterator supports simplify geometries on provider side
     virtual bool providerCanSimplify( QgsSimplifyMethod::MethodType methodType ) const;
@@ -163,7 +164,8 @@ class CORE_EXPORT QgsAbstractFeatureIterator
 
     /**
      * Setup the orderby. Internally calls prepareOrderBy and if false is returned will
-     * cache all features and order them with local expression evaluation.
+     * fetch all features and order them with local expression evaluation. Large feature
+     * sets are sorted in runs spilled to temporary files, see QgsFeatureSorter.
      *
      * @note added in QGIS 2.14
      */
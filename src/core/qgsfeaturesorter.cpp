@@ -0,0 +1,364 @@
+/***************************************************************************
+  qgsfeaturesorter.cpp - QgsFeatureSorter
+  ---------------------------------------
+
+ begin                : October 2026
+ Copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgsfeaturesorter.h"
+#include "qgsexpressionsorter.h"
+#include "qgsgeometry.h"
+#include "qgsgeometryfactory.h"
+#include "qgslogger.h"
+#include "qgswkbptr.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFuture>
+#include <QTemporaryFile>
+#include <QThread>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+
+/// @cond PRIVATE
+
+struct QgsFeatureSorter::Run
+{
+  Run()
+      : file( nullptr )
+      , count( 0 )
+      , position( 0 )
+  {}
+
+  ~Run()
+  {
+    delete file;
+  }
+
+  //! Features of the run, until they have been written to the file
+  QVector<QgsIndexedFeature> features;
+  //! Temporary file with the sorted features, the run is kept in memory if it could not be written
+  QTemporaryFile* file;
+  QFuture<bool> future;
+  QDataStream stream;
+  //! Number of features left in the file, or position of the next feature kept in memory
+  int count;
+  int position;
+  //! Feature of the run which is next in order
+  QgsIndexedFeature current;
+};
+
+/** Orders the runs of the merge heap, the run with the first feature in order is at the top
+ * of the heap. Equal features are returned in the order of their runs.
+ */
+class QgsFeatureSorterRunCompare
+{
+  public:
+    QgsFeatureSorterRunCompare( const QgsFeatureSorter* sorter )
+        : mSorter( sorter )
+        , mExpressionSorter( sorter->mOrderBys )
+    {}
+
+    bool operator()( int run1, int run2 ) const
+    {
+      const QgsIndexedFeature& f1 = mSorter->mRuns.at( run1 )->current;
+      const QgsIndexedFeature& f2 = mSorter->mRuns.at( run2 )->current;
+      if ( mExpressionSorter( f2, f1 ) )
+        return true;
+      if ( mExpressionSorter( f1, f2 ) )
+        return false;
+      return run1 > run2;
+    }
+
+  private:
+    const QgsFeatureSorter* mSorter;
+    QgsExpressionSorter mExpressionSorter;
+};
+
+static void writeIndexedFeature( QDataStream& out, const QgsIndexedFeature& indexedFeature )
+{
+  const QgsFeature& feature = indexedFeature.mFeature;
+  out << indexedFeature.mIndexes << feature.id() << feature.attributes() << feature.isValid();
+
+  const QgsGeometry* geometry = feature.constGeometry();
+  if ( !geometry )
+  {
+    out << static_cast<qint8>( 0 );
+  }
+  else if ( !geometry->geometry() )
+  {
+    out << static_cast<qint8>( 1 );
+  }
+  else
+  {
+    // export the WKB from the abstract geometry, which does not touch the WKB cached by the shared QgsGeometry
+    int size = 0;
+    unsigned char* wkb = geometry->geometry()->asWkb( size );
+    out << static_cast<qint8>( 2 );
+    out.writeBytes( reinterpret_cast<const char*>( wkb ), size );
+    delete [] wkb;
+  }
+}
+
+static bool readIndexedFeature( QDataStream& in, QgsIndexedFeature& indexedFeature, const QgsFields& fields )
+{
+  QgsFeatureId id;
+  QgsAttributes attributes;
+  bool valid;
+  qint8 geometryType;
+  in >> indexedFeature.mIndexes >> id >> attributes >> valid >> geometryType;
+
+  QgsFeature feature( fields, id );
+  feature.setAttributes( attributes );
+  if ( geometryType == 1 )
+  {
+    feature.setGeometry( new QgsGeometry() );
+  }
+  else if ( geometryType == 2 )
+  {
+    char* wkb = nullptr;
+    uint size = 0;
+    in.readBytes( wkb, size );
+    if ( wkb )
+    {
+      feature.setGeometry( new QgsGeometry( QgsGeometryFactory::geomFromWkb( QgsConstWkbPtr( reinterpret_cast<const unsigned char*>( wkb ), size ) ) ) );
+      delete [] wkb;
+    }
+  }
+  feature.setValid( valid );
+  indexedFeature.mFeature = feature;
+
+  return in.status() == QDataStream::Ok;
+}
+
+QgsFeatureSorter::QgsFeatureSorter( const QList<QgsFeatureRequest::OrderByClause>& preparedOrderBys, long limit, int runSize )
+    : mOrderBys( preparedOrderBys )
+    , mLimit( limit )
+    , mRunSize( qMax( 1, runSize ) )
+    , mTopN( limit >= 0 && limit <= mRunSize )
+    , mFinished( false )
+    , mFieldsSet( false )
+    , mFeaturePosition( 0 )
+{
+}
+
+QgsFeatureSorter::~QgsFeatureSorter()
+{
+  Q_FOREACH ( Run* run, mRuns )
+  {
+    run->future.waitForFinished();
+    run->stream.setDevice( nullptr );
+    delete run;
+  }
+}
+
+void QgsFeatureSorter::addFeature( const QgsIndexedFeature& feature )
+{
+  Q_ASSERT( !mFinished );
+
+  if ( !mFieldsSet && feature.mFeature.fields() )
+  {
+    // the fields are not written to the runs, all features of an iterator share them
+    mFields = *feature.mFeature.fields();
+    mFieldsSet = true;
+  }
+
+  mFeatures.append( feature );
+
+  if ( mTopN )
+  {
+    // keep the first features in a heap, its top is the last of them in order
+    QgsExpressionSorter sorter( mOrderBys );
+    std::push_heap( mFeatures.begin(), mFeatures.end(), sorter );
+    if ( mFeatures.size() > mLimit )
+    {
+      std::pop_heap( mFeatures.begin(), mFeatures.end(), sorter );
+      mFeatures.resize( mFeatures.size() - 1 );
+    }
+  }
+  else if ( mFeatures.size() >= mRunSize )
+  {
+    spillRun();
+  }
+}
+
+void QgsFeatureSorter::spillRun()
+{
+  // limit the number of runs in memory to the runs being sorted in parallel
+  int maxRunsInProgress = qMax( 1, QThread::idealThreadCount() );
+  int runsInProgress = 0;
+  Q_FOREACH ( Run* run, mRuns )
+  {
+    if ( !run->future.isFinished() )
+      runsInProgress++;
+  }
+  for ( int i = 0; i < mRuns.size() && runsInProgress >= maxRunsInProgress; ++i )
+  {
+    if ( !mRuns.at( i )->future.isFinished() )
+    {
+      mRuns.at( i )->future.waitForFinished();
+      runsInProgress--;
+    }
+  }
+
+  Run* run = new Run();
+  run->features.swap( mFeatures );
+  // created here, so that the file belongs to this thread
+  run->file = new QTemporaryFile( QDir::tempPath() + "/qgis_orderby_XXXXXX" );
+  run->future = QtConcurrent::run( &QgsFeatureSorter::sortRun, run, mOrderBys, mLimit );
+  mRuns << run;
+}
+
+bool QgsFeatureSorter::sortRun( Run* run, const QList<QgsFeatureRequest::OrderByClause>& orderBys, long limit )
+{
+  std::stable_sort( run->features.begin(), run->features.end(), QgsExpressionSorter( orderBys ) );
+
+  // with a limit, only the first features of a run can be returned
+  if ( limit >= 0 && run->features.size() > limit )
+    run->features.resize( limit );
+
+  if ( !run->file->open() )
+    return false;
+
+  QDataStream out( run->file );
+  Q_FOREACH ( const QgsIndexedFeature& feature, run->features )
+  {
+    writeIndexedFeature( out, feature );
+  }
+
+  if ( out.status() != QDataStream::Ok || !run->file->flush() )
+  {
+    return false;
+  }
+
+  run->count = run->features.size();
+  run->features = QVector<QgsIndexedFeature>();
+  return true;
+}
+
+void QgsFeatureSorter::finish()
+{
+  if ( mFinished )
+    return;
+
+  mFinished = true;
+
+  QgsExpressionSorter sorter( mOrderBys );
+  if ( mTopN )
+  {
+    std::sort_heap( mFeatures.begin(), mFeatures.end(), sorter );
+    return;
+  }
+
+  if ( mRuns.isEmpty() )
+  {
+    // all features fit in memory
+    std::stable_sort( mFeatures.begin(), mFeatures.end(), sorter );
+    return;
+  }
+
+  if ( !mFeatures.isEmpty() )
+    spillRun();
+
+  QgsFeatureSorterRunCompare compare( this );
+  for ( int i = 0; i < mRuns.size(); ++i )
+  {
+    Run* run = mRuns.at( i );
+    if ( run->future.result() )
+    {
+      run->file->seek( 0 );
+      run->stream.setDevice( run->file );
+    }
+    else
+    {
+      QgsDebugMsg( "Could not write sorted features to a temporary file, keeping them in memory" );
+      delete run->file;
+      run->file = nullptr;
+    }
+
+    if ( readRunFeature( run ) )
+    {
+      mMergeHeap << i;
+      std::push_heap( mMergeHeap.begin(), mMergeHeap.end(), compare );
+    }
+  }
+}
+
+bool QgsFeatureSorter::readRunFeature( Run* run )
+{
+  if ( !run->file )
+  {
+    if ( run->position >= run->features.size() )
+      return false;
+
+    run->current = run->features.at( run->position++ );
+    return true;
+  }
+
+  if ( run->count <= 0 )
+    return false;
+
+  run->count--;
+  return readIndexedFeature( run->stream, run->current, mFields );
+}
+
+bool QgsFeatureSorter::nextFeature( QgsFeature& feature )
+{
+  if ( !mFinished )
+    finish();
+
+  if ( mRuns.isEmpty() )
+  {
+    if ( mFeaturePosition >= mFeatures.size() )
+      return false;
+
+    feature = mFeatures.at( mFeaturePosition++ ).mFeature;
+    return true;
+  }
+
+  if ( mMergeHeap.isEmpty() )
+    return false;
+
+  QgsFeatureSorterRunCompare compare( this );
+  std::pop_heap( mMergeHeap.begin(), mMergeHeap.end(), compare );
+  Run* run = mRuns.at( mMergeHeap.last() );
+  feature = run->current.mFeature;
+
+  if ( readRunFeature( run ) )
+  {
+    std::push_heap( mMergeHeap.begin(), mMergeHeap.end(), compare );
+  }
+  else
+  {
+    // release the exhausted run
+    mMergeHeap.resize( mMergeHeap.size() - 1 );
+    run->stream.setDevice( nullptr );
+    delete run->file;
+    run->file = nullptr;
+    run->features = QVector<QgsIndexedFeature>();
+    run->position = 0;
+    run->current = QgsIndexedFeature();
+  }
+  return true;
+}
+
+int QgsFeatureSorter::spilledRunCount() const
+{
+  int count = 0;
+  Q_FOREACH ( Run* run, mRuns )
+  {
+    if ( run->future.result() )
+      count++;
+  }
+  return count;
+}
+
+/// @endcond
@@ -0,0 +1,105 @@
+/***************************************************************************
+  qgsfeaturesorter.h - QgsFeatureSorter
+  -------------------------------------
+
+ begin                : October 2026
+ Copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSFEATURESORTER_H
+#define QGSFEATURESORTER_H
+
+#include "qgsfeaturerequest.h"
+#include "qgsindexedfeature.h"
+
+/// @cond PRIVATE
+
+/** \ingroup core
+ * Sorts features by the values of their order by expressions, for feature iterators whose
+ * provider cannot sort the features itself.
+ *
+ * Features are collected in runs of a bounded size. Full runs are sorted in parallel and spilled
+ * to temporary files, which are merged lazily while the sorted features are read. If all features
+ * fit in a single run, they are sorted in memory. With a limit not larger than the run size only
+ * the first features are kept in a heap.
+ *
+ * \note added in QGIS 2.16
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsFeatureSorter
+{
+  public:
+    //! Default maximum number of features in a run
+    static const int DEFAULT_RUN_SIZE = 50000;
+
+    /** Constructor for QgsFeatureSorter.
+     * @param preparedOrderBys order by clauses with prepared expressions
+     * @param limit maximum number of features to return, or -1 for all features
+     * @param runSize maximum number of features kept in memory per run
+     */
+    explicit QgsFeatureSorter( const QList<QgsFeatureRequest::OrderByClause>& preparedOrderBys, long limit = -1, int runSize = DEFAULT_RUN_SIZE );
+
+    ~QgsFeatureSorter();
+
+    /** Adds a feature with its evaluated order by values. Must not be called after finish().
+     */
+    void addFeature( const QgsIndexedFeature& feature );
+
+    /** Sorts the remaining features and prepares reading the sorted features.
+     */
+    void finish();
+
+    /** Fetches the next feature in sorted order.
+     * @returns false if there are no more features
+     */
+    bool nextFeature( QgsFeature& feature );
+
+    /** Returns the number of runs spilled to temporary files.
+     */
+    int spilledRunCount() const;
+
+  private:
+    struct Run;
+
+    QList<QgsFeatureRequest::OrderByClause> mOrderBys;
+    long mLimit;
+    int mRunSize;
+    bool mTopN;
+    bool mFinished;
+
+    //! Fields of the features, as they are not written to the runs
+    QgsFields mFields;
+    bool mFieldsSet;
+
+    //! Features of the run being collected (a heap in top-N mode)
+    QVector<QgsIndexedFeature> mFeatures;
+    //! Position in mFeatures when all features were sorted in memory
+    int mFeaturePosition;
+
+    //! Runs which have been handed over for sorting and spilling
+    QList<Run*> mRuns;
+    //! Indexes of the runs to read from next, a heap ordered by their current features
+    QVector<int> mMergeHeap;
+
+    //! Hands the collected features over to a worker thread, which sorts and spills them
+    void spillRun();
+    //! Sorts a run and writes it to its temporary file, called from worker threads
+    static bool sortRun( Run* run, const QList<QgsFeatureRequest::OrderByClause>& orderBys, long limit );
+    //! Reads the next feature of a run, returns false if the run is exhausted
+    bool readRunFeature( Run* run );
+
+    QgsFeatureSorter( const QgsFeatureSorter& rh );
+    QgsFeatureSorter& operator=( const QgsFeatureSorter& rh );
+
+    friend class QgsFeatureSorterRunCompare;
+};
+
+/// @endcond
+
+#endif // QGSFEATURESORTER_H
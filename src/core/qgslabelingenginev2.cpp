@@ -15,6 +15,7 @@
 
 #include "qgslabelingenginev2.h"
 
+#include "qgslabelplacementcache.h"
 #include "qgslogger.h"
 #include "qgsproject.h"
 
@@ -72,6 +73,7 @@ QgsLabelingEngineV2::QgsLabelingEngineV2()
     , mCandLine( 8 )
     , mCandPolygon( 8 )
     , mResults( nullptr )
+    , mPlacementCache( nullptr )
 {
   mResults = new QgsLabelingResults;
 }
@@ -257,6 +259,13 @@ void QgsLabelingEngineV2::run( QgsRenderContext& context )
     return; // it has been cancelled
   }
 
+  // reuse label positions from the previous rendering at the same scale and rotation
+  if ( mPlacementCache )
+  {
+    if ( mPlacementCache->init( mMapSettings.scale(), mMapSettings.rotation(), mMapSettings.mapUnitsPerPixel() ) && problem )
+      applyPlacementCache( problem );
+  }
+
 #if 1 // XXX strk
   // features are pre-rotated but not scaled/translated,
   // so we only disable rotation here. Ideally, they'd be
@@ -298,6 +307,10 @@ void QgsLabelingEngineV2::run( QgsRenderContext& context )
     delete labels;
     return;
   }
+
+  if ( mPlacementCache )
+    mPlacementCache->setPlacements( *labels );
+
   painter->setRenderHint( QPainter::Antialiasing );
 
   // sort labels
@@ -330,6 +343,35 @@ void QgsLabelingEngineV2::run( QgsRenderContext& context )
 
 }
 
+void QgsLabelingEngineV2::applyPlacementCache( pal::Problem* problem )
+{
+  int reused = 0;
+  for ( int i = 0; i < problem->getNumFeatures(); i++ )
+  {
+    int count = problem->getFeatureCandidateCount( i );
+    if ( count == 0 )
+      continue;
+
+    QList<pal::LabelPosition*> candidates;
+    candidates.reserve( count );
+    for ( int j = 0; j < count; j++ )
+      candidates << problem->getFeatureCandidate( i, j );
+
+    QgsLabelFeature* lf = candidates.first()->getFeaturePart()->feature();
+    if ( !lf || !lf->provider() )
+      continue;
+
+    int idx = mPlacementCache->matchingCandidate( lf->provider()->layerId(), lf->provider()->providerId(), lf->id(), candidates );
+    if ( idx >= 0 )
+    {
+      problem->setPreferredCandidate( i, idx );
+      reused++;
+    }
+  }
+
+  QgsDebugMsgLevel( QString( "LABELING warm start: %1 of %2 features at cached positions" ).arg( reused ).arg( problem->getNumFeatures() ), 4 );
+}
+
 QgsLabelingResults* QgsLabelingEngineV2::takeResults()
 {
   QgsLabelingResults* res = mResults;
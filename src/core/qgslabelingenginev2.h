@@ -26,6 +26,7 @@
 
 
 class QgsLabelingEngineV2;
+class QgsLabelPlacementCache;
 
 
 /**
@@ -218,6 +219,16 @@ class CORE_EXPORT QgsLabelingEngineV2
     //! Which search method to use for removal collisions between labels
     QgsPalLabeling::Search searchMethod() const { return mSearchMethod; }
 
+    /** Assign a cache of label positions solved during the previous rendering. If the map view
+     * has the same scale and rotation, the solver is warm started from the cached positions.
+     * The cache is updated with the new solution. Does not take ownership of the object.
+     * @note added in QGIS 2.16
+     */
+    void setPlacementCache( QgsLabelPlacementCache* cache ) { mPlacementCache = cache; }
+    //! Returns the cache of label positions used to warm start the solver (may be null)
+    //! @note added in QGIS 2.16
+    QgsLabelPlacementCache* placementCache() const { return mPlacementCache; }
+
     //! Read configuration of the labeling engine from the current project file
     void readSettingsFromProject();
     //! Write configuration of the labeling engine to the current project file
@@ -226,6 +237,9 @@ class CORE_EXPORT QgsLabelingEngineV2
   protected:
     void processProvider( QgsAbstractLabelProvider* provider, QgsRenderContext& context, pal::Pal& p );
 
+    //! Mark candidates matching the cached label positions as preferred in the problem
+    void applyPlacementCache( pal::Problem* problem );
+
   protected:
     //! Associated map settings instance
     QgsMapSettings mMapSettings;
@@ -242,6 +256,9 @@ class CORE_EXPORT QgsLabelingEngineV2
     //! Resulting labeling layout
     QgsLabelingResults* mResults;
 
+    //! Label positions from previous rendering (not owned)
+    QgsLabelPlacementCache* mPlacementCache;
+
   private:
 
     QgsLabelingEngineV2( const QgsLabelingEngineV2& rh );
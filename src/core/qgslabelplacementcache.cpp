@@ -0,0 +1,120 @@
+/***************************************************************************
+  qgslabelplacementcache.cpp
+  --------------------------------------
+  Date                 : October 2026
+  Copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgslabelplacementcache.h"
+
+#include "qgslabelingenginev2.h"
+#include "qgslabelfeature.h"
+
+#include "feature.h"
+#include "labelposition.h"
+
+QgsLabelPlacementCache::QgsLabelPlacementCache()
+    : mScale( 0 )
+    , mRotation( 0 )
+    , mTolerance( 0 )
+{
+}
+
+void QgsLabelPlacementCache::clear()
+{
+  QMutexLocker lock( &mMutex );
+  mScale = 0;
+  mRotation = 0;
+  mPlacements.clear();
+}
+
+bool QgsLabelPlacementCache::init( double scale, double rotation, double tolerance )
+{
+  QMutexLocker lock( &mMutex );
+
+  mTolerance = tolerance;
+
+  // check whether the params are the same
+  if ( qgsDoubleNear( scale, mScale ) &&
+       qgsDoubleNear( rotation, mRotation ) )
+    return true;
+
+  mPlacements.clear();
+
+  // set new params
+  mScale = scale;
+  mRotation = rotation;
+
+  return false;
+}
+
+int QgsLabelPlacementCache::count() const
+{
+  QMutexLocker lock( &mMutex );
+  return mPlacements.count();
+}
+
+int QgsLabelPlacementCache::matchingCandidate( const QString& layerId, const QString& providerId, QgsFeatureId featureId, const QList<pal::LabelPosition*>& candidates ) const
+{
+  QMutexLocker lock( &mMutex );
+
+  QMultiHash<PlacementKey, Placement>::const_iterator it = mPlacements.constFind( key( layerId, providerId, featureId ) );
+  if ( it == mPlacements.constEnd() )
+    return -1;
+
+  // a feature may have more labels (e.g. one per feature part or repeated labels along lines)
+  PlacementKey k = it.key();
+  for ( ; it != mPlacements.constEnd() && it.key() == k; ++it )
+  {
+    for ( int i = 0; i < candidates.count(); ++i )
+    {
+      if ( matches( it.value(), candidates.at( i ) ) )
+        return i;
+    }
+  }
+  return -1;
+}
+
+void QgsLabelPlacementCache::setPlacements( const QList<pal::LabelPosition*>& labels )
+{
+  QMutexLocker lock( &mMutex );
+
+  mPlacements.clear();
+  mPlacements.reserve( labels.count() );
+
+  Q_FOREACH ( pal::LabelPosition* lp, labels )
+  {
+    QgsLabelFeature* lf = lp->getFeaturePart()->feature();
+    if ( !lf || !lf->provider() )
+      continue;
+
+    Placement p;
+    p.x = lp->getX();
+    p.y = lp->getY();
+    p.alpha = lp->getAlpha();
+    p.width = lp->getWidth();
+    p.height = lp->getHeight();
+    mPlacements.insert( key( lf->provider()->layerId(), lf->provider()->providerId(), lf->id() ), p );
+  }
+}
+
+QgsLabelPlacementCache::PlacementKey QgsLabelPlacementCache::key( const QString& layerId, const QString& providerId, QgsFeatureId featureId )
+{
+  return qMakePair( layerId + '|' + providerId, featureId );
+}
+
+bool QgsLabelPlacementCache::matches( const Placement& placement, const pal::LabelPosition* candidate ) const
+{
+  return qAbs( placement.x - candidate->getX() ) <= mTolerance
+         && qAbs( placement.y - candidate->getY() ) <= mTolerance
+         && qAbs( placement.width - candidate->getWidth() ) <= mTolerance
+         && qAbs( placement.height - candidate->getHeight() ) <= mTolerance
+         && qgsDoubleNear( placement.alpha, candidate->getAlpha() );
+}
@@ -0,0 +1,109 @@
+/***************************************************************************
+  qgslabelplacementcache.h
+  --------------------------------------
+  Date                 : October 2026
+  Copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSLABELPLACEMENTCACHE_H
+#define QGSLABELPLACEMENTCACHE_H
+
+#include "qgsfeature.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+
+namespace pal
+{
+  class LabelPosition;
+}
+
+/**
+ * @brief The QgsLabelPlacementCache class keeps positions of labels solved by
+ * the labeling engine during the previous rendering of a map view.
+ *
+ * When the next map view is rendered at the same scale and rotation (typically
+ * when the user pans the map), QgsLabelingEngineV2 uses the stored positions
+ * as a warm start for the solver: label candidates matching the previous positions
+ * are placed first and only newly exposed features and the labels in conflict
+ * with them are solved again.
+ *
+ * Positions are stored in map units in the coordinate space of the labeling engine
+ * (i.e. already rotated by the map rotation).
+ *
+ * The class is thread-safe (multiple classes can access the same instance safely).
+ *
+ * @note this class is not a part of public API yet. See notes in QgsLabelingEngineV2
+ * @note not available in Python bindings
+ * @note added in QGIS 2.16
+ */
+class CORE_EXPORT QgsLabelPlacementCache
+{
+  public:
+
+    //! Solved position of a single label
+    struct Placement
+    {
+      double x;
+      double y;
+      double alpha;
+      double width;
+      double height;
+    };
+
+    QgsLabelPlacementCache();
+
+    //! invalidate the cache contents
+    void clear();
+
+    //! initialize cache: set new parameters and erase cache if parameters have changed
+    //! @param scale map scale of the rendered view
+    //! @param rotation map rotation (in degrees) of the rendered view
+    //! @param tolerance maximum distance (in map units) between a stored position and a candidate for them to match
+    //! @return flag whether the parameters are the same as last time
+    bool init( double scale, double rotation, double tolerance );
+
+    //! Returns number of stored label positions
+    int count() const;
+
+    /** Finds the candidate among the list which matches a position stored for the feature.
+     * @param layerId ID of the layer of the label provider
+     * @param providerId ID of the label provider within the layer
+     * @param featureId ID of the labeled feature
+     * @param candidates label candidates generated for the feature
+     * @returns index of the matching candidate or -1 if no candidate matches
+     */
+    int matchingCandidate( const QString& layerId, const QString& providerId, QgsFeatureId featureId, const QList<pal::LabelPosition*>& candidates ) const;
+
+    //! Replace the stored positions with the solution of the recently rendered map view
+    void setPlacements( const QList<pal::LabelPosition*>& labels );
+
+  private:
+
+    typedef QPair<QString, QgsFeatureId> PlacementKey;
+
+    //! Builds the key which identifies label of a feature from a provider
+    static PlacementKey key( const QString& layerId, const QString& providerId, QgsFeatureId featureId );
+
+    //! Tests whether candidate is at the stored position (within tolerance)
+    bool matches( const Placement& placement, const pal::LabelPosition* candidate ) const;
+
+    mutable QMutex mMutex;
+    double mScale;
+    double mRotation;
+    double mTolerance;
+    QMultiHash<PlacementKey, Placement> mPlacements;
+
+    QgsLabelPlacementCache( const QgsLabelPlacementCache& rh );
+    QgsLabelPlacementCache& operator=( const QgsLabelPlacementCache& rh );
+};
+
+#endif // QGSLABELPLACEMENTCACHE_H
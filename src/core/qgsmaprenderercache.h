@@ -21,6 +21,7 @@
 #include <QMutex>
 
 #include "qgsrectangle.h"
+#include "qgslabelplacementcache.h"
 
 
 /**
@@ -57,6 +58,13 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     //! remove layer from the cache
     void clearCacheImage( const QString& layerId );
 
+    /** Returns cache of label positions from the previous rendering. Unlike the cached images,
+     * label positions are kept when the extent changes, so they can be reused while panning.
+     * @note added in QGIS 2.16
+     * @note not available in Python bindings
+     */
+    QgsLabelPlacementCache* labelPlacementCache() { return &mLabelPlacementCache; }
+
   protected slots:
     //! remove layer (that emitted the signal) from the cache
     void layerRequestedRepaint();
@@ -70,6 +78,7 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     QgsRectangle mExtent;
     double mScale;
     QMap<QString, QImage> mCachedImages;
+    QgsLabelPlacementCache mLabelPlacementCache;
 };
 
 
@@ -18,6 +18,7 @@
 #include "qgslabelingenginev2.h"
 #include "qgslogger.h"
 #include "qgsmaplayerrenderer.h"
+#include "qgsmaprenderercache.h"
 #include "qgspallabeling.h"
 
 #include <QtConcurrentMap>
@@ -67,6 +68,8 @@ void QgsMapRendererParallelJob::start()
     mLabelingEngineV2 = new QgsLabelingEngineV2();
     mLabelingEngineV2->readSettingsFromProject();
     mLabelingEngineV2->setMapSettings( mSettings );
+    if ( mCache )
+      mLabelingEngineV2->setPlacementCache( mCache->labelPlacementCache() );
 #else
     mLabelingEngine = new QgsPalLabeling;
     mLabelingEngine->loadEngineSettings();
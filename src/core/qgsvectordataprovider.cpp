@@ -400,6 +400,60 @@ QVariant QgsVectorDataProvider::aggregate( QgsAggregateCalculator::Aggregate agg
   return QVariant();
 }
 
+QString QgsVectorDataProvider::aggregateSql( QgsAggregateCalculator::Aggregate aggregate, const QgsField& field, const QString& column, bool standardDeviation )
+{
+  switch ( field.type() )
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+    case QVariant::Double:
+      break;
+
+    default:
+      // string and date statistics differ from the database (empty strings, collation)
+      return QString();
+  }
+
+  switch ( aggregate )
+  {
+    case QgsAggregateCalculator::Count:
+      return QString( "count(%1)" ).arg( column );
+    case QgsAggregateCalculator::CountDistinct:
+      return QString( "count(DISTINCT %1)" ).arg( column );
+    case QgsAggregateCalculator::CountMissing:
+      return QString( "count(*)-count(%1)" ).arg( column );
+    case QgsAggregateCalculator::Min:
+      return QString( "min(%1)" ).arg( column );
+    case QgsAggregateCalculator::Max:
+      return QString( "max(%1)" ).arg( column );
+    case QgsAggregateCalculator::Sum:
+      return QString( "sum(%1)" ).arg( column );
+    case QgsAggregateCalculator::Mean:
+      return QString( "avg(%1)" ).arg( column );
+    case QgsAggregateCalculator::Range:
+      return QString( "max(%1)-min(%1)" ).arg( column );
+    case QgsAggregateCalculator::StDev:
+      return standardDeviation ? QString( "stddev_pop(%1)" ).arg( column ) : QString();
+    case QgsAggregateCalculator::StDevSample:
+      return standardDeviation ? QString( "stddev_samp(%1)" ).arg( column ) : QString();
+
+    case QgsAggregateCalculator::Median:
+    case QgsAggregateCalculator::Minority:
+    case QgsAggregateCalculator::Majority:
+    case QgsAggregateCalculator::FirstQuartile:
+    case QgsAggregateCalculator::ThirdQuartile:
+    case QgsAggregateCalculator::InterQuartileRange:
+    case QgsAggregateCalculator::StringMinimumLength:
+    case QgsAggregateCalculator::StringMaximumLength:
+    case QgsAggregateCalculator::StringConcatenate:
+      break;
+  }
+
+  return QString();
+}
+
 void QgsVectorDataProvider::clearMinMaxCache()
 {
   mCacheMinMaxDirty = true;
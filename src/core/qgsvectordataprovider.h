@@ -469,6 +469,19 @@ class CORE_EXPORT QgsVectorDataProvider : public QgsDataProvider
     @return the converted geometry or nullptr if no conversion was necessary or possible*/
     QgsGeometry* convertToProviderType( const QgsGeometry* geom ) const;
 
+    /** Returns a SQL expression calculating an aggregate over a column, for providers handing off
+     * aggregate calculation to the database. Only aggregates over numeric fields are supported,
+     * for which the SQL result is identical to the result of QgsAggregateCalculator (unless it is NULL,
+     * then the calculation should be left to QgsAggregateCalculator).
+     * @param aggregate aggregate to calculate
+     * @param field field to calculate aggregate over
+     * @param column quoted column identifier of the field
+     * @param standardDeviation true if the database provides stddev_pop() and stddev_samp() aggregate functions
+     * @return SQL expression, or an empty string if the aggregate cannot be calculated in SQL
+     * @note added in QGIS 2.16
+     */
+    static QString aggregateSql( QgsAggregateCalculator::Aggregate aggregate, const QgsField& field, const QString& column, bool standardDeviation = true );
+
   private:
     /** Old notation **/
     QMap<QString, QVariant::Type> mOldTypeList;
@@ -3371,9 +3371,9 @@ QVariant QgsVectorLayer::aggregate( QgsAggregateCalculator::Aggregate aggregate,
   if ( attrIndex >= 0 )
   {
     // aggregate is based on a field - if it's a provider field, we could possibly hand over the calculation
-    // to the provider itself
+    // to the provider itself (unless there are uncommitted edits the provider does not know about)
     QgsFields::FieldOrigin origin = mUpdatedFields.fieldOrigin( attrIndex );
-    if ( origin == QgsFields::OriginProvider )
+    if ( origin == QgsFields::OriginProvider && !( mEditBuffer && mEditBuffer->isModified() ) )
     {
       bool providerOk = false;
       QVariant val = mDataProvider->aggregate( aggregate, attrIndex, parameters, context, providerOk );
@@ -18,11 +18,59 @@
 #include "qgsmultibandcolorrenderer.h"
 #include "qgscontrastenhancement.h"
 #include "qgsrastertransparency.h"
+#include "qgsrastervaluecache.h"
 #include "qgsrasterviewport.h"
 #include <QDomDocument>
 #include <QDomElement>
 #include <QImage>
 #include <QSet>
+#include <QVector>
+
+#include <limits>
+
+// Returns the stretched value or NaN if the value is not in displayable range
+static double enhancedValue( QgsContrastEnhancement *enhancement, double value )
+{
+  if ( !enhancement->isValueInDisplayableRange( value ) )
+    return std::numeric_limits<double>::quiet_NaN();
+
+  return enhancement->enhanceContrast( value );
+}
+
+// Reads a row of a color band, stretches its values and flags pixels which are
+// no data or not in displayable range
+static void readColorRow( QgsRasterBlock *block, int row, QgsContrastEnhancement *enhancement,
+                          QgsRasterValueCache<double> *cache, double *values, bool *noData, bool *skip )
+{
+  block->readRow( row, values, noData );
+
+  int width = block->width();
+  for ( int col = 0; col < width; ++col )
+  {
+    if ( noData[col] )
+    {
+      skip[col] = true;
+      continue;
+    }
+
+    if ( !enhancement )
+      continue;
+
+    double value = values[col];
+    if ( cache )
+    {
+      const double *cached = cache->find( value );
+      values[col] = cached ? *cached : cache->insert( value, enhancedValue( enhancement, value ) );
+    }
+    else
+    {
+      values[col] = enhancedValue( enhancement, value );
+    }
+
+    if ( qIsNaN( values[col] ) )
+      skip[col] = true;
+  }
+}
 
 QgsMultiBandColorRenderer::QgsMultiBandColorRenderer( QgsRasterInterface* input, int redBand, int greenBand, int blueBand,
     QgsContrastEnhancement* redEnhancement,
@@ -140,11 +188,6 @@ QgsRasterBlock* QgsMultiBandColorRenderer::block( int bandNo, QgsRectangle  cons
     return outputBlock;
   }
 
-  //In some (common) cases, we can simplify the drawing loop considerably and save render time
-  bool fastDraw = ( !usesTransparency()
-                    && mRedBand > 0 && mGreenBand > 0 && mBlueBand > 0
-                    && mAlphaBand < 1 && !mRedContrastEnhancement && !mGreenContrastEnhancement && !mBlueContrastEnhancement );
-
   QSet<int> bands;
   if ( mRedBand > 0 )
   {
@@ -228,95 +271,78 @@ QgsRasterBlock* QgsMultiBandColorRenderer::block( int bandNo, QgsRectangle  cons
 
   QRgb myDefaultColor = NODATA_COLOR;
 
-  for ( qgssize i = 0; i < ( qgssize )width*height; i++ )
+  // the bands are processed row by row, stretching every distinct value of integer data only once
+  QgsRasterBlock *colorBlocks[3] = { redBlock, greenBlock, blueBlock };
+  QgsContrastEnhancement *enhancements[3] = { mRedContrastEnhancement, mGreenContrastEnhancement, mBlueContrastEnhancement };
+  QVector<double> colorValues[3];
+  QVector< QgsRasterValueCache<double> * > caches( 3, nullptr );
+  for ( int c = 0; c < 3; ++c )
   {
-    if ( fastDraw ) //fast rendering if no transparency, stretching, color inversion, etc.
+    // unused color bands are zero
+    colorValues[c].fill( 0, colorBlocks[c] ? width : 0 );
+    if ( colorBlocks[c] && enhancements[c] &&
+         QgsRasterValueCache<double>::useForBlock( colorBlocks[c]->dataType(), static_cast< qgssize >( width ) * height ) )
     {
-      if ( redBlock->isNoData( i ) ||
-           greenBlock->isNoData( i ) ||
-           blueBlock->isNoData( i ) )
-      {
-        outputBlock->setColor( i, myDefaultColor );
-      }
-      else
-      {
-        int redVal = ( int )redBlock->value( i );
-        int greenVal = ( int )greenBlock->value( i );
-        int blueVal = ( int )blueBlock->value( i );
-        outputBlock->setColor( i, qRgba( redVal, greenVal, blueVal, 255 ) );
-      }
-      continue;
+      caches[c] = new QgsRasterValueCache<double>( colorBlocks[c]->dataType() );
     }
+  }
 
-    bool isNoData = false;
-    double redVal = 0;
-    double greenVal = 0;
-    double blueVal = 0;
-    if ( mRedBand > 0 )
-    {
-      redVal = redBlock->value( i );
-      if ( redBlock->isNoData( i ) ) isNoData = true;
-    }
-    if ( !isNoData && mGreenBand > 0 )
-    {
-      greenVal = greenBlock->value( i );
-      if ( greenBlock->isNoData( i ) ) isNoData = true;
-    }
-    if ( !isNoData && mBlueBand > 0 )
+  QVector<bool> noData( width );
+  QVector<bool> skip( width );
+  QVector<double> alphaValues( mAlphaBand > 0 ? width : 0 );
+
+  for ( int row = 0; row < height; ++row )
+  {
+    skip.fill( false );
+    for ( int c = 0; c < 3; ++c )
     {
-      blueVal = blueBlock->value( i );
-      if ( blueBlock->isNoData( i ) ) isNoData = true;
+      if ( colorBlocks[c] )
+      {
+        readColorRow( colorBlocks[c], row, enhancements[c], caches[c], colorValues[c].data(), noData.data(), skip.data() );
+      }
     }
-    if ( isNoData )
+    if ( mAlphaBand > 0 )
     {
-      outputBlock->setColor( i, myDefaultColor );
-      continue;
+      alphaBlock->readRow( row, alphaValues.data() );
     }
 
-    //apply default color if red, green or blue not in displayable range
-    if (( mRedContrastEnhancement && !mRedContrastEnhancement->isValueInDisplayableRange( redVal ) )
-        || ( mGreenContrastEnhancement && !mGreenContrastEnhancement->isValueInDisplayableRange( redVal ) )
-        || ( mBlueContrastEnhancement && !mBlueContrastEnhancement->isValueInDisplayableRange( redVal ) ) )
+    QRgb *outputRow = reinterpret_cast< QRgb * >( outputBlock->bits( row, 0 ) );
+    for ( int col = 0; col < width; ++col )
     {
-      outputBlock->setColor( i, myDefaultColor );
-      continue;
-    }
+      if ( skip[col] )
+      {
+        outputRow[col] = myDefaultColor;
+        continue;
+      }
 
-    //stretch color values
-    if ( mRedContrastEnhancement )
-    {
-      redVal = mRedContrastEnhancement->enhanceContrast( redVal );
-    }
-    if ( mGreenContrastEnhancement )
-    {
-      greenVal = mGreenContrastEnhancement->enhanceContrast( greenVal );
-    }
-    if ( mBlueContrastEnhancement )
-    {
-      blueVal = mBlueContrastEnhancement->enhanceContrast( blueVal );
-    }
+      double redVal = redBlock ? colorValues[0][col] : 0;
+      double greenVal = greenBlock ? colorValues[1][col] : 0;
+      double blueVal = blueBlock ? colorValues[2][col] : 0;
 
-    //opacity
-    double currentOpacity = mOpacity;
-    if ( mRasterTransparency )
-    {
-      currentOpacity = mRasterTransparency->alphaValue( redVal, greenVal, blueVal, mOpacity * 255 ) / 255.0;
-    }
-    if ( mAlphaBand > 0 )
-    {
-      currentOpacity *= alphaBlock->value( i ) / 255.0;
-    }
+      //opacity
+      double currentOpacity = mOpacity;
+      if ( mRasterTransparency )
+      {
+        currentOpacity = mRasterTransparency->alphaValue( redVal, greenVal, blueVal, mOpacity * 255 ) / 255.0;
+      }
+      if ( mAlphaBand > 0 )
+      {
+        currentOpacity *= alphaValues[col] / 255.0;
+      }
 
-    if ( qgsDoubleNear( currentOpacity, 1.0 ) )
-    {
-      outputBlock->setColor( i, qRgba( redVal, greenVal, blueVal, 255 ) );
-    }
-    else
-    {
-      outputBlock->setColor( i, qRgba( currentOpacity * redVal, currentOpacity * greenVal, currentOpacity * blueVal, currentOpacity * 255 ) );
+      if ( qgsDoubleNear( currentOpacity, 1.0 ) )
+      {
+        outputRow[col] = qRgba( redVal, greenVal, blueVal, 255 );
+      }
+      else
+      {
+        outputRow[col] = qRgba( currentOpacity * redVal, currentOpacity * greenVal, currentOpacity * blueVal, currentOpacity * 255 );
+      }
     }
   }
 
+  qDeleteAll( caches );
+
   //delete input blocks
   QMap<int, QgsRasterBlock*>::const_iterator bandDelIt = bandBlocks.constBegin();
   for ( ; bandDelIt != bandBlocks.constEnd(); ++bandDelIt )
@@ -15,6 +15,7 @@
  *                                                                         *
  ***************************************************************************/
 
+#include <algorithm>
 #include <limits>
 
 #include <QByteArray>
@@ -344,6 +345,81 @@ bool QgsRasterBlock::isNoData( int row, int column )
   return isNoData( static_cast< qgssize >( row )*mWidth + column );
 }
 
+template <typename T>
+static void readRowValues( const void *data, qgssize offset, int count, double *values )
+{
+  const T *src = static_cast< const T * >( data ) + offset;
+  for ( int i = 0; i < count; ++i )
+  {
+    values[i] = static_cast< double >( src[i] );
+  }
+}
+
+void QgsRasterBlock::readRow( int row, double *values, bool *noData ) const
+{
+  if ( !mData || row < 0 || row >= mHeight )
+  {
+    QgsDebugMsg( QString( "Row %1 not available" ).arg( row ) );
+    std::fill( values, values + mWidth, std::numeric_limits<double>::quiet_NaN() );
+    if ( noData )
+      std::fill( noData, noData + mWidth, true );
+    return;
+  }
+
+  qgssize offset = static_cast< qgssize >( row ) * mWidth;
+  switch ( mDataType )
+  {
+    case QGis::Byte:
+      readRowValues< quint8 >( mData, offset, mWidth, values );
+      break;
+    case QGis::UInt16:
+      readRowValues< quint16 >( mData, offset, mWidth, values );
+      break;
+    case QGis::Int16:
+      readRowValues< qint16 >( mData, offset, mWidth, values );
+      break;
+    case QGis::UInt32:
+      readRowValues< quint32 >( mData, offset, mWidth, values );
+      break;
+    case QGis::Int32:
+      readRowValues< qint32 >( mData, offset, mWidth, values );
+      break;
+    case QGis::Float32:
+      readRowValues< float >( mData, offset, mWidth, values );
+      break;
+    case QGis::Float64:
+      readRowValues< double >( mData, offset, mWidth, values );
+      break;
+    default:
+      QgsDebugMsg( QString( "Data type %1 is not supported" ).arg( mDataType ) );
+      std::fill( values, values + mWidth, std::numeric_limits<double>::quiet_NaN() );
+      break;
+  }
+
+  if ( !noData )
+    return;
+
+  if ( mHasNoDataValue )
+  {
+    for ( int i = 0; i < mWidth; ++i )
+    {
+      noData[i] = isNoDataValue( values[i] );
+    }
+  }
+  else if ( mNoDataBitmap )
+  {
+    const char *bitmap = mNoDataBitmap + static_cast< qgssize >( row ) * mNoDataBitmapWidth;
+    for ( int i = 0; i < mWidth; ++i )
+    {
+      noData[i] = bitmap[i / 8] & ( 0x80 >> ( i % 8 ) );
+    }
+  }
+  else
+  {
+    std::fill( noData, noData + mWidth, false );
+  }
+}
+
 bool QgsRasterBlock::setValue( qgssize index, double value )
 {
   if ( !mData )
@@ -186,6 +186,16 @@ class CORE_EXPORT QgsRasterBlock
      *  @return color */
     QRgb color( qgssize index ) const;
 
+    /** \brief Read all values of a row if type of block is numeric. The data type
+     *  is resolved once for the whole row, which is much faster than reading values one by one.
+     *  @param row row index
+     *  @param values array of width() values to be filled
+     *  @param noData optional array of width() flags to be set for no data values
+     *  @note added in QGIS 2.16
+     *  @note not available in python bindings
+     */
+    void readRow( int row, double *values, bool *noData = nullptr ) const;
+
     /** \brief Check if value at position is no data
      *  @param row row index
      *  @param column column index
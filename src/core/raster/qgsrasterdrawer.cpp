@@ -21,9 +21,105 @@
 #include "qgsrasterviewport.h"
 #include "qgsmaptopixel.h"
 #include "qgsrendercontext.h"
+#include <QFuture>
 #include <QImage>
+#include <QMutex>
 #include <QPainter>
 #include <QPrinter>
+#include <QWaitCondition>
+#include <QtConcurrentRun>
+
+namespace
+{
+  //! Part of the raster to be rendered by one of the parallel inputs
+  struct RasterTile
+  {
+    QgsRectangle extent;
+    int nCols;
+    int nRows;
+    int topLeftCol;
+    int topLeftRow;
+  };
+
+  //! State shared by the threads rendering tiles in parallel, protected by the mutex
+  struct ParallelDrawState
+  {
+    int bandNumber;
+    const QgsRenderContext *context;
+    QList<RasterTile> tiles;
+    int nextTile;
+    bool stopped;
+    QVector<QImage> images;
+    QVector<bool> finished;
+    QMutex mutex;
+    QWaitCondition tileFinished;
+  };
+}
+
+// Renders the next tile not taken yet by another thread, returns false if there is none left
+static bool renderNextTile( QgsRasterInterface *input, ParallelDrawState *state )
+{
+  int i;
+  {
+    QMutexLocker locker( &state->mutex );
+    if ( state->stopped || state->nextTile >= state->tiles.size() )
+      return false;
+    i = state->nextTile++;
+  }
+
+  QImage img;
+  if ( !state->context || !state->context->renderingStopped() )
+  {
+    const RasterTile &tile = state->tiles.at( i );
+    QgsRasterBlock *block = input->block( state->bandNumber, tile.extent, tile.nCols, tile.nRows );
+    if ( block )
+    {
+      img = block->image();
+      delete block;
+    }
+    else
+    {
+      QgsDebugMsg( "Cannot get block" );
+    }
+  }
+
+  QMutexLocker locker( &state->mutex );
+  state->images[i] = img;
+  state->finished[i] = true;
+  state->tileFinished.wakeAll();
+  return true;
+}
+
+static void renderTiles( QgsRasterInterface *input, ParallelDrawState *state )
+{
+  while ( renderNextTile( input, state ) )
+    ;
+}
+
+// Because of bug in Acrobat Reader we must use "white" transparent color instead
+// of "black" for PDF. See #9101.
+static void prepareImage( QPainter *p, QImage &img )
+{
+  QPrinter *printer = dynamic_cast<QPrinter *>( p->device() );
+  if ( printer && printer->outputFormat() == QPrinter::PdfFormat )
+  {
+    QgsDebugMsgLevel( "PdfFormat", 4 );
+
+    img = img.convertToFormat( QImage::Format_ARGB32 );
+    QRgb transparentBlack = qRgba( 0, 0, 0, 0 );
+    QRgb transparentWhite = qRgba( 255, 255, 255, 0 );
+    for ( int x = 0; x < img.width(); x++ )
+    {
+      for ( int y = 0; y < img.height(); y++ )
+      {
+        if ( img.pixel( x, y ) == transparentBlack )
+        {
+          img.setPixel( x, y, transparentWhite );
+        }
+      }
+    }
+  }
+}
 
 QgsRasterDrawer::QgsRasterDrawer( QgsRasterIterator* iterator ): mIterator( iterator )
 {
@@ -41,6 +137,12 @@ void QgsRasterDrawer::draw( QPainter* p, QgsRasterViewPort* viewPort, const QgsM
   int bandNumber = 1;
   mIterator->startRasterRead( bandNumber, viewPort->mWidth, viewPort->mHeight, viewPort->mDrawnExtent );
 
+  if ( mParallelInputs.size() > 1 )
+  {
+    drawParallel( p, viewPort, theQgsMapToPixel, ctx, bandNumber );
+    return;
+  }
+
   //number of cols/rows in output pixels
   int nCols = 0;
   int nRows = 0;
@@ -63,35 +165,86 @@ void QgsRasterDrawer::draw( QPainter* p, QgsRasterViewPort* viewPort, const QgsM
     }
 
     QImage img = block->image();
+    prepareImage( p, img );
+
+    drawImage( p, viewPort, img, topLeftCol, topLeftRow, theQgsMapToPixel );
+
+    delete block;
+    if ( ctx && ctx->renderingStopped() )
+      break;
+  }
+}
+
+void QgsRasterDrawer::drawParallel( QPainter* p, QgsRasterViewPort* viewPort, const QgsMapToPixel* theQgsMapToPixel, const QgsRenderContext* ctx, int bandNumber )
+{
+  ParallelDrawState state;
+  state.bandNumber = bandNumber;
+  state.context = ctx;
+  state.nextTile = 0;
+  state.stopped = false;
+
+  RasterTile tile;
+  while ( mIterator->nextRasterPart( bandNumber, tile.nCols, tile.nRows, tile.extent, tile.topLeftCol, tile.topLeftRow ) )
+  {
+    state.tiles << tile;
+  }
+  state.images.resize( state.tiles.size() );
+  state.finished.fill( false, state.tiles.size() );
+
+  // the first input is used by this thread
+  QList< QFuture<void> > futures;
+  for ( int i = 1; i < mParallelInputs.size() && i < state.tiles.size(); ++i )
+  {
+    futures << QtConcurrent::run( renderTiles, mParallelInputs.at( i ), &state );
+  }
 
-    // Because of bug in Acrobat Reader we must use "white" transparent color instead
-    // of "black" for PDF. See #9101.
-    QPrinter *printer = dynamic_cast<QPrinter *>( p->device() );
-    if ( printer && printer->outputFormat() == QPrinter::PdfFormat )
+  // Tiles are painted in order. While the next one is not ready, this thread renders tiles too,
+  // so the drawing progresses even if there is no free thread in the pool.
+  int painted = 0;
+  while ( painted < state.tiles.size() )
+  {
+    QImage img;
+    bool ready = false;
     {
-      QgsDebugMsgLevel( "PdfFormat", 4 );
+      QMutexLocker locker( &state.mutex );
+      if ( state.finished.at( painted ) )
+      {
+        img = state.images.at( painted );
+        state.images[painted] = QImage();
+        ready = true;
+      }
+    }
 
-      img = img.convertToFormat( QImage::Format_ARGB32 );
-      QRgb transparentBlack = qRgba( 0, 0, 0, 0 );
-      QRgb transparentWhite = qRgba( 255, 255, 255, 0 );
-      for ( int x = 0; x < img.width(); x++ )
+    if ( !ready )
+    {
+      if ( !renderNextTile( mParallelInputs.at( 0 ), &state ) )
       {
-        for ( int y = 0; y < img.height(); y++ )
-        {
-          if ( img.pixel( x, y ) == transparentBlack )
-          {
-            img.setPixel( x, y, transparentWhite );
-          }
-        }
+        QMutexLocker locker( &state.mutex );
+        while ( !state.finished.at( painted ) )
+          state.tileFinished.wait( &state.mutex );
       }
+      continue;
     }
 
-    drawImage( p, viewPort, img, topLeftCol, topLeftRow, theQgsMapToPixel );
+    if ( !img.isNull() )
+    {
+      prepareImage( p, img );
+      drawImage( p, viewPort, img, state.tiles.at( painted ).topLeftCol, state.tiles.at( painted ).topLeftRow, theQgsMapToPixel );
+    }
+    ++painted;
 
-    delete block;
     if ( ctx && ctx->renderingStopped() )
       break;
   }
+
+  {
+    QMutexLocker locker( &state.mutex );
+    state.stopped = true;
+  }
+  Q_FOREACH ( QFuture<void> future, futures )
+  {
+    future.waitForFinished();
+  }
 }
 
 void QgsRasterDrawer::drawImage( QPainter* p, QgsRasterViewPort* viewPort, const QImage& img, int topLeftCol, int topLeftRow, const QgsMapToPixel* theQgsMapToPixel ) const
@@ -44,6 +44,16 @@ class CORE_EXPORT QgsRasterDrawer
      */
     void draw( QPainter* p, QgsRasterViewPort* viewPort, const QgsMapToPixel* theQgsMapToPixel, const QgsRenderContext *ctx = nullptr );
 
+    /** Sets inputs for rendering the parts of the raster in parallel. If there are at least two
+     * of them, the iterator is only used to split the view into parts which are then rendered
+     * by several threads, each of them with its own input (the drawing thread uses the first one),
+     * and painted in order. The inputs must be independent copies of the same pipe
+     * (see QgsRasterPipe copy constructor). Ownership is not transferred.
+     * @note added in QGIS 2.16
+     * @note not available in python bindings
+     */
+    void setParallelInputs( const QList<QgsRasterInterface*> &inputs ) { mParallelInputs = inputs; }
+
   protected:
     /** Draws raster part
      * @param p the painter to draw to
@@ -57,7 +67,11 @@ class CORE_EXPORT QgsRasterDrawer
     void drawImage( QPainter* p, QgsRasterViewPort* viewPort, const QImage& img, int topLeftCol, int topLeftRow, const QgsMapToPixel* mapToPixel = nullptr ) const;
 
   private:
+    //! Renders the parts with the parallel inputs and paints them
+    void drawParallel( QPainter* p, QgsRasterViewPort* viewPort, const QgsMapToPixel* theQgsMapToPixel, const QgsRenderContext *ctx, int bandNumber );
+
     QgsRasterIterator* mIterator;
+    QList<QgsRasterInterface*> mParallelInputs;
 };
 
 #endif // QGSRASTERDRAWER_H
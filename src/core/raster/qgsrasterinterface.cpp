@@ -19,7 +19,11 @@
 #include <typeinfo>
 
 #include <QByteArray>
+#include <QFuture>
+#include <QMutex>
+#include <QThread>
 #include <QTime>
+#include <QtConcurrentRun>
 
 #include <qmath.h>
 
@@ -27,8 +31,122 @@
 #include "qgsrasterbandstats.h"
 #include "qgsrasterhistogram.h"
 #include "qgsrasterinterface.h"
+#include "qgsrasterstatsaccumulator.h"
 #include "qgsrectangle.h"
 
+//! Part of the raster read at once when collecting statistics or histograms
+struct StatisticsPart
+{
+  QgsRectangle extent;
+  int width;
+  int height;
+};
+
+//! Parts of the raster which have not been read yet, shared by threads
+struct StatisticsParts
+{
+  int bandNo;
+  QList<StatisticsPart> parts;
+  int next;
+  QMutex mutex;
+};
+
+// Splits the region into parts of the (provider's) block size
+static QList<StatisticsPart> statisticsParts( const QgsRectangle &extent, int width, int height, int xBlockSize, int yBlockSize )
+{
+  if ( xBlockSize == 0 ) // should not happen, but happens
+  {
+    xBlockSize = 500;
+  }
+  if ( yBlockSize == 0 ) // should not happen, but happens
+  {
+    yBlockSize = 500;
+  }
+
+  int nXBlocks = ( width + xBlockSize - 1 ) / xBlockSize;
+  int nYBlocks = ( height + yBlockSize - 1 ) / yBlockSize;
+
+  double xRes = extent.width() / width;
+  double yRes = extent.height() / height;
+
+  QList<StatisticsPart> parts;
+  for ( int yBlock = 0; yBlock < nYBlocks; yBlock++ )
+  {
+    for ( int xBlock = 0; xBlock < nXBlocks; xBlock++ )
+    {
+      StatisticsPart part;
+      part.width = qMin( xBlockSize, width - xBlock * xBlockSize );
+      part.height = qMin( yBlockSize, height - yBlock * yBlockSize );
+
+      double xmin = extent.xMinimum() + xBlock * xBlockSize * xRes;
+      double xmax = xmin + part.width * xRes;
+      double ymin = extent.yMaximum() - yBlock * yBlockSize * yRes;
+      double ymax = ymin - part.height * yRes;
+      part.extent = QgsRectangle( xmin, ymin, xmax, ymax );
+
+      parts << part;
+    }
+  }
+  return parts;
+}
+
+// Reads parts until all are taken and adds their values to the accumulator
+template <class Accumulator>
+static void accumulateParts( QgsRasterInterface *input, StatisticsParts *parts, Accumulator *accumulator )
+{
+  Q_FOREVER
+  {
+    StatisticsPart part;
+    {
+      QMutexLocker locker( &parts->mutex );
+      if ( parts->next >= parts->parts.size() )
+        return;
+      part = parts->parts.at( parts->next++ );
+    }
+
+    QgsRasterBlock *blk = input->block( parts->bandNo, part.extent, part.width, part.height );
+    accumulator->addBlock( blk );
+    delete blk;
+  }
+}
+
+// Collects values of all parts, the calling thread reads with input, each of the
+// readers in another thread. Partial results are merged when all parts are read.
+template <class Accumulator>
+static Accumulator accumulateParallel( QgsRasterInterface *input, const QList<QgsRasterInterface *> &readers,
+    int bandNo, const QList<StatisticsPart> &partList, const Accumulator &empty )
+{
+  StatisticsParts parts;
+  parts.bandNo = bandNo;
+  parts.parts = partList;
+  parts.next = 0;
+
+  QList<Accumulator> partials;
+  for ( int i = 0; i < readers.size(); ++i )
+  {
+    partials << empty;
+  }
+
+  QList< QFuture<void> > futures;
+  for ( int i = 0; i < readers.size(); ++i )
+  {
+    futures << QtConcurrent::run( accumulateParts<Accumulator>, readers.at( i ), &parts, &partials[i] );
+  }
+
+  Accumulator accumulator = empty;
+  accumulateParts( input, &parts, &accumulator );
+
+  Q_FOREACH ( QFuture<void> future, futures )
+  {
+    future.waitForFinished();
+  }
+  Q_FOREACH ( const Accumulator &partial, partials )
+  {
+    accumulator.merge( partial );
+  }
+  return accumulator;
+}
+
 QgsRasterInterface::QgsRasterInterface( QgsRasterInterface * input )
     : mInput( input )
     , mOn( true )
@@ -139,98 +257,18 @@ QgsRasterBandStats QgsRasterInterface::bandStatistics( int theBandNo,
     }
   }
 
-  QgsRectangle myExtent = myRasterBandStats.extent;
-  int myWidth = myRasterBandStats.width;
-  int myHeight = myRasterBandStats.height;
-
-  //int myDataType = dataType( theBandNo );
+  QList<StatisticsPart> myParts = statisticsParts( myRasterBandStats.extent, myRasterBandStats.width, myRasterBandStats.height,
+                                   xBlockSize(), yBlockSize() );
+  QList<QgsRasterInterface *> myReaders = concurrentReaders( myParts.size() );
+  QgsDebugMsgLevel( QString( "%1 parts, %2 additional readers" ).arg( myParts.size() ).arg( myReaders.size() ), 4 );
 
-  int myXBlockSize = xBlockSize();
-  int myYBlockSize = yBlockSize();
-  if ( myXBlockSize == 0 ) // should not happen, but happens
-  {
-    myXBlockSize = 500;
-  }
-  if ( myYBlockSize == 0 ) // should not happen, but happens
-  {
-    myYBlockSize = 500;
-  }
-
-  int myNXBlocks = ( myWidth + myXBlockSize - 1 ) / myXBlockSize;
-  int myNYBlocks = ( myHeight + myYBlockSize - 1 ) / myYBlockSize;
-
-  double myXRes = myExtent.width() / myWidth;
-  double myYRes = myExtent.height() / myHeight;
   // TODO: progress signals
-
-  // used by single pass stdev
-  double myMean = 0;
-  double mySumOfSquares = 0;
-
-  bool myFirstIterationFlag = true;
-  for ( int myYBlock = 0; myYBlock < myNYBlocks; myYBlock++ )
-  {
-    for ( int myXBlock = 0; myXBlock < myNXBlocks; myXBlock++ )
-    {
-      QgsDebugMsgLevel( QString( "myYBlock = %1 myXBlock = %2" ).arg( myYBlock ).arg( myXBlock ), 4 );
-      int myBlockWidth = qMin( myXBlockSize, myWidth - myXBlock * myXBlockSize );
-      int myBlockHeight = qMin( myYBlockSize, myHeight - myYBlock * myYBlockSize );
-
-      double xmin = myExtent.xMinimum() + myXBlock * myXBlockSize * myXRes;
-      double xmax = xmin + myBlockWidth * myXRes;
-      double ymin = myExtent.yMaximum() - myYBlock * myYBlockSize * myYRes;
-      double ymax = ymin - myBlockHeight * myYRes;
-
-      QgsRectangle myPartExtent( xmin, ymin, xmax, ymax );
-
-      QgsRasterBlock* blk = block( theBandNo, myPartExtent, myBlockWidth, myBlockHeight );
-
-      // Collect the histogram counts.
-      for ( qgssize i = 0; i < ( static_cast< qgssize >( myBlockHeight ) ) * myBlockWidth; i++ )
-      {
-        if ( blk->isNoData( i ) ) continue; // NULL
-
-        double myValue = blk->value( i );
-
-        myRasterBandStats.sum += myValue;
-        myRasterBandStats.elementCount++;
-
-        if ( myFirstIterationFlag )
-        {
-          myFirstIterationFlag = false;
-          myRasterBandStats.minimumValue = myValue;
-          myRasterBandStats.maximumValue = myValue;
-        }
-        else
-        {
-          if ( myValue < myRasterBandStats.minimumValue )
-          {
-            myRasterBandStats.minimumValue = myValue;
-          }
-          if ( myValue > myRasterBandStats.maximumValue )
-          {
-            myRasterBandStats.maximumValue = myValue;
-          }
-        }
-
-        // Single pass stdev
-        double myDelta = myValue - myMean;
-        myMean += myDelta / myRasterBandStats.elementCount;
-        mySumOfSquares += myDelta * ( myValue - myMean );
-      }
-      delete blk;
-    }
-  }
-
-  myRasterBandStats.range = myRasterBandStats.maximumValue - myRasterBandStats.minimumValue;
-  myRasterBandStats.mean = myRasterBandStats.sum / myRasterBandStats.elementCount;
-
-  myRasterBandStats.sumOfSquares = mySumOfSquares; // OK with single pass?
+  QgsRasterStatsAccumulator myAccumulator = accumulateParallel( this, myReaders, theBandNo, myParts, QgsRasterStatsAccumulator() );
+  qDeleteAll( myReaders );
 
   // stdDev may differ  from GDAL stats, because GDAL is using naive single pass
   // algorithm which is more error prone (because of rounding errors)
-  // Divide result by sample size - 1 and get square root to get stdev
-  myRasterBandStats.stdDev = sqrt( mySumOfSquares / ( myRasterBandStats.elementCount - 1 ) );
+  myAccumulator.fillStatistics( myRasterBandStats );
 
   QgsDebugMsgLevel( "************ STATS **************", 4 );
   QgsDebugMsgLevel( QString( "MIN %1" ).arg( myRasterBandStats.minimumValue ), 4 );
@@ -238,6 +276,7 @@ QgsRasterBandStats QgsRasterInterface::bandStatistics( int theBandNo,
   QgsDebugMsgLevel( QString( "RANGE %1" ).arg( myRasterBandStats.range ), 4 );
   QgsDebugMsgLevel( QString( "MEAN %1" ).arg( myRasterBandStats.mean ), 4 );
   QgsDebugMsgLevel( QString( "STDDEV %1" ).arg( myRasterBandStats.stdDev ), 4 );
+  QgsDebugMsgLevel( QString( "MEAN STANDARD ERROR %1" ).arg( myAccumulator.meanStandardError() ), 4 );
 
   myRasterBandStats.statsGathered = QgsRasterBandStats::All;
   mStatistics.append( myRasterBandStats );
@@ -245,6 +284,20 @@ QgsRasterBandStats QgsRasterInterface::bandStatistics( int theBandNo,
   return myRasterBandStats;
 }
 
+QList<QgsRasterInterface *> QgsRasterInterface::concurrentReaders( int thePartCount ) const
+{
+  QList<QgsRasterInterface *> readers;
+  int count = qMin( QThread::idealThreadCount(), thePartCount ) - 1;
+  for ( int i = 0; i < count; ++i )
+  {
+    QgsRasterInterface *reader = concurrentReader();
+    if ( !reader )
+      break;
+    readers << reader;
+  }
+  return readers;
+}
+
 void QgsRasterInterface::initHistogram( QgsRasterHistogram &theHistogram,
                                         int theBandNo,
                                         int theBinCount,
@@ -418,24 +471,6 @@ QgsRasterHistogram QgsRasterInterface::histogram( int theBandNo,
   int myWidth = myHistogram.width;
   int myHeight = myHistogram.height;
   QgsRectangle myExtent = myHistogram.extent;
-  myHistogram.histogramVector.resize( myBinCount );
-
-  int myXBlockSize = xBlockSize();
-  int myYBlockSize = yBlockSize();
-  if ( myXBlockSize == 0 ) // should not happen, but happens
-  {
-    myXBlockSize = 500;
-  }
-  if ( myYBlockSize == 0 ) // should not happen, but happens
-  {
-    myYBlockSize = 500;
-  }
-
-  int myNXBlocks = ( myWidth + myXBlockSize - 1 ) / myXBlockSize;
-  int myNYBlocks = ( myHeight + myYBlockSize - 1 ) / myYBlockSize;
-
-  double myXRes = myExtent.width() / myWidth;
-  double myYRes = myExtent.height() / myHeight;
 
   double myMinimum = myHistogram.minimum;
   double myMaximum = myHistogram.maximum;
@@ -448,49 +483,16 @@ QgsRasterHistogram QgsRasterInterface::histogram( int theBandNo,
 
   QgsDebugMsgLevel( QString( "binCount = %1 myMinimum = %2 myMaximum = %3" ).arg( myHistogram.binCount ).arg( myMinimum ).arg( myMaximum ), 4 );
 
-  double myBinSize = ( myMaximum - myMinimum ) / myBinCount;
+  QList<StatisticsPart> myParts = statisticsParts( myExtent, myWidth, myHeight, xBlockSize(), yBlockSize() );
+  QList<QgsRasterInterface *> myReaders = concurrentReaders( myParts.size() );
 
   // TODO: progress signals
-  for ( int myYBlock = 0; myYBlock < myNYBlocks; myYBlock++ )
-  {
-    for ( int myXBlock = 0; myXBlock < myNXBlocks; myXBlock++ )
-    {
-      int myBlockWidth = qMin( myXBlockSize, myWidth - myXBlock * myXBlockSize );
-      int myBlockHeight = qMin( myYBlockSize, myHeight - myYBlock * myYBlockSize );
-
-      double xmin = myExtent.xMinimum() + myXBlock * myXBlockSize * myXRes;
-      double xmax = xmin + myBlockWidth * myXRes;
-      double ymin = myExtent.yMaximum() - myYBlock * myYBlockSize * myYRes;
-      double ymax = ymin - myBlockHeight * myYRes;
-
-      QgsRectangle myPartExtent( xmin, ymin, xmax, ymax );
+  QgsRasterHistogramAccumulator myAccumulator = accumulateParallel( this, myReaders, theBandNo, myParts,
+      QgsRasterHistogramAccumulator( myBinCount, myMinimum, myMaximum, theIncludeOutOfRange ) );
+  qDeleteAll( myReaders );
 
-      QgsRasterBlock* blk = block( theBandNo, myPartExtent, myBlockWidth, myBlockHeight );
-
-      // Collect the histogram counts.
-      for ( qgssize i = 0; i < ( static_cast< qgssize >( myBlockHeight ) ) * myBlockWidth; i++ )
-      {
-        if ( blk->isNoData( i ) )
-        {
-          continue; // NULL
-        }
-        double myValue = blk->value( i );
-
-        int myBinIndex = static_cast <int>( qFloor(( myValue - myMinimum ) /  myBinSize ) );
-
-        if (( myBinIndex < 0 || myBinIndex > ( myBinCount - 1 ) ) && !theIncludeOutOfRange )
-        {
-          continue;
-        }
-        if ( myBinIndex < 0 ) myBinIndex = 0;
-        if ( myBinIndex > ( myBinCount - 1 ) ) myBinIndex = myBinCount - 1;
-
-        myHistogram.histogramVector[myBinIndex] += 1;
-        myHistogram.nonNullCount++;
-      }
-      delete blk;
-    }
-  }
+  myHistogram.histogramVector = myAccumulator.counts();
+  myHistogram.nonNullCount = myAccumulator.count();
 
   myHistogram.valid = true;
   mHistograms.append( myHistogram );
@@ -146,6 +146,8 @@ class CORE_EXPORT QgsRasterInterface
      * @param theExtent Extent used to calc statistics, if empty, whole raster extent is used.
      * @param theSampleSize Approximate number of cells in sample. If 0, all cells (whole raster will be used). If raster does not have exact size (WCS without exact size for example), provider decides size of sample.
      * @return Band statistics.
+     * @note Blocks of the raster are read in parallel if the source supports it (see concurrentReader()).
+     * If statistics are computed from a sample, the standard error of the mean is stdDev / sqrt( elementCount ).
      */
     virtual QgsRasterBandStats bandStatistics( int theBandNo,
         int theStats = QgsRasterBandStats::All,
@@ -241,6 +243,20 @@ class CORE_EXPORT QgsRasterInterface
                          int theStats = QgsRasterBandStats::All,
                          const QgsRectangle & theExtent = QgsRectangle(),
                          int theBinCount = 0 );
+
+    /** Returns a copy of the interface which reads blocks independently of this one, so that
+     * it may be used in another thread while this interface is in use, or nullptr if it is
+     * not possible (default). It is used to read blocks in parallel when collecting statistics
+     * and histograms. The caller takes ownership of the returned object.
+     * @note added in QGIS 2.16
+     * @note not available in python bindings
+     */
+    virtual QgsRasterInterface *concurrentReader() const { return nullptr; }
+
+  private:
+
+    //! Creates readers of blocks for threads other than the calling one, at most one less than the number of parts
+    QList<QgsRasterInterface *> concurrentReaders( int thePartCount ) const;
 };
 
 #endif
@@ -53,6 +53,22 @@ bool QgsRasterIterator::readNextRasterPart( int bandNumber,
 {
   QgsDebugMsgLevel( "Entered", 4 );
   *block = nullptr;
+
+  QgsRectangle blockRect;
+  if ( !nextRasterPart( bandNumber, nCols, nRows, blockRect, topLeftCol, topLeftRow ) )
+  {
+    return false;
+  }
+
+  *block = mInput->block( bandNumber, blockRect, nCols, nRows );
+  return true;
+}
+
+bool QgsRasterIterator::nextRasterPart( int bandNumber,
+                                        int& nCols, int& nRows,
+                                        QgsRectangle& blockExtent,
+                                        int& topLeftCol, int& topLeftRow )
+{
   //get partinfo
   QMap<int, RasterPartInfo>::iterator partIt = mRasterPartInfos.find( bandNumber );
   if ( partIt == mRasterPartInfos.end() )
@@ -91,9 +107,8 @@ bool QgsRasterIterator::readNextRasterPart( int bandNumber,
   double ymin = pInfo.currentRow + nRows == pInfo.nRows ? viewPortExtent.yMinimum() :  // avoid extra FP math if not necessary
                 viewPortExtent.yMaximum() - ( pInfo.currentRow + nRows ) / static_cast< double >( pInfo.nRows ) * viewPortExtent.height();
   double ymax = viewPortExtent.yMaximum() - pInfo.currentRow / static_cast< double >( pInfo.nRows ) * viewPortExtent.height();
-  QgsRectangle blockRect( xmin, ymin, xmax, ymax );
+  blockExtent = QgsRectangle( xmin, ymin, xmax, ymax );
 
-  *block = mInput->block( bandNumber, blockRect, nCols, nRows );
   topLeftCol = pInfo.currentCol;
   topLeftRow = pInfo.currentRow;
 
@@ -55,6 +55,23 @@ class CORE_EXPORT QgsRasterIterator
                              QgsRasterBlock **block,
                              int& topLeftCol, int& topLeftRow );
 
+    /** Advances to the next part of raster data without reading it, e.g. to read the parts in parallel
+       with separate copies of the input.
+       @param bandNumber band to read
+       @param nCols number of columns on output device
+       @param nRows number of rows on output device
+       @param blockExtent extent of the part
+       @param topLeftCol top left column
+       @param topLeftRow top left row
+       @return false if the last part was already returned
+       @note added in QGIS 2.16
+       @note not available in python bindings
+     */
+    bool nextRasterPart( int bandNumber,
+                         int& nCols, int& nRows,
+                         QgsRectangle& blockExtent,
+                         int& topLeftCol, int& topLeftRow );
+
     void stopRasterRead( int bandNumber );
 
     const QgsRasterInterface* input() const { return mInput; }
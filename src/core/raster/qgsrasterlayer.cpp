@@ -838,6 +838,12 @@ void QgsRasterLayer::setDataProvider( QString const & provider )
     this,          SIGNAL( statusChanged( QString ) )
   );
 
+  // Redraw when the provider data changed, e.g. pyramids built in background
+  connect(
+    mDataProvider, SIGNAL( dataChanged() ),
+    this,          SLOT( triggerRepaint() )
+  );
+
   //mark the layer as valid
   mValid = true;
 
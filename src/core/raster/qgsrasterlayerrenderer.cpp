@@ -20,12 +20,16 @@
 #include "qgsrasteriterator.h"
 #include "qgsrasterlayer.h"
 
+#include <QSettings>
+#include <QThread>
+
 
 QgsRasterLayerRenderer::QgsRasterLayerRenderer( QgsRasterLayer* layer, QgsRenderContext& rendererContext )
     : QgsMapLayerRenderer( layer->id() )
     , mRasterViewPort( nullptr )
     , mPipe( nullptr )
     , mContext( rendererContext )
+    , mParallelThreads( 1 )
 {
 
   mPainter = rendererContext.painter();
@@ -174,12 +178,24 @@ QgsRasterLayerRenderer::QgsRasterLayerRenderer( QgsRasterLayer* layer, QgsRender
 
   // copy the whole raster pipe!
   mPipe = new QgsRasterPipe( *layer->pipe() );
+
+  // Large views of local rasters are rendered in parallel tiles, each thread with its own copy of the pipe.
+  // Remote providers are left alone, they already fetch their data in parallel requests.
+  QSettings settings;
+  int threads = qMin( QThread::idealThreadCount(), settings.value( "/qgis/parallel_raster_threads", 8 ).toInt() );
+  qgssize tilePixels = static_cast< qgssize >( PARALLEL_TILE_SIZE ) * PARALLEL_TILE_SIZE;
+  if ( threads > 1 && layer->dataProvider()->name() == "gdal" &&
+       static_cast< qgssize >( mRasterViewPort->mWidth ) * mRasterViewPort->mHeight >= 2 * tilePixels )
+  {
+    mParallelThreads = threads;
+  }
 }
 
 QgsRasterLayerRenderer::~QgsRasterLayerRenderer()
 {
   delete mRasterViewPort;
   delete mPipe;
+  qDeleteAll( mParallelPipes );
 }
 
 bool QgsRasterLayerRenderer::render()
@@ -198,18 +214,45 @@ bool QgsRasterLayerRenderer::render()
   // procedure to use :
   //
 
-  QgsRasterProjector *projector = mPipe->projector();
+  // The copies of the pipe for parallel rendering are made here in the rendering thread, copying a pipe
+  // reopens the data source. No more copies are made than there are tiles to render.
+  if ( mParallelThreads > 1 && mParallelPipes.isEmpty() )
+  {
+    int tiles = (( mRasterViewPort->mWidth + PARALLEL_TILE_SIZE - 1 ) / PARALLEL_TILE_SIZE ) *
+                (( mRasterViewPort->mHeight + PARALLEL_TILE_SIZE - 1 ) / PARALLEL_TILE_SIZE );
+    for ( int i = 1; i < qMin( mParallelThreads, tiles ); ++i )
+    {
+      mParallelPipes << new QgsRasterPipe( *mPipe );
+    }
+  }
 
-  // TODO add a method to interface to get provider and get provider
-  // params in QgsRasterProjector
-  if ( projector )
+  QList<QgsRasterPipe*> pipes;
+  pipes << mPipe << mParallelPipes;
+
+  QList<QgsRasterInterface*> inputs;
+  Q_FOREACH ( QgsRasterPipe *pipe, pipes )
   {
-    projector->setCRS( mRasterViewPort->mSrcCRS, mRasterViewPort->mDestCRS );
+    QgsRasterProjector *projector = pipe->projector();
+
+    // TODO add a method to interface to get provider and get provider
+    // params in QgsRasterProjector
+    if ( projector )
+    {
+      projector->setCRS( mRasterViewPort->mSrcCRS, mRasterViewPort->mDestCRS );
+    }
+
+    inputs << pipe->last();
   }
 
   // Drawer to pipe?
   QgsRasterIterator iterator( mPipe->last() );
   QgsRasterDrawer drawer( &iterator );
+  if ( !mParallelPipes.isEmpty() )
+  {
+    iterator.setMaximumTileWidth( PARALLEL_TILE_SIZE );
+    iterator.setMaximumTileHeight( PARALLEL_TILE_SIZE );
+    drawer.setParallelInputs( inputs );
+  }
   drawer.draw( mPainter, mRasterViewPort, mMapToPixel, &mContext );
 
   QgsDebugMsgLevel( QString( "total raster draw time (ms):     %1" ).arg( time.elapsed(), 5 ), 4 );
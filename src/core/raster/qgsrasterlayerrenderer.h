@@ -18,6 +18,8 @@
 
 #include "qgsmaplayerrenderer.h"
 
+#include <QList>
+
 class QPainter;
 
 class QgsMapToPixel;
@@ -48,6 +50,15 @@ class QgsRasterLayerRenderer : public QgsMapLayerRenderer
 
     QgsRasterPipe* mPipe;
     QgsRenderContext& mContext;
+
+    //! Number of threads rendering tiles in parallel, 1 if the view is not rendered in parallel
+    int mParallelThreads;
+
+    //! Copies of the pipe used to render tiles in parallel, created when rendering
+    QList<QgsRasterPipe*> mParallelPipes;
+
+    //! Size of tiles rendered in parallel (in pixels)
+    static const int PARALLEL_TILE_SIZE = 512;
 };
 
 #endif // QGSRASTERLAYERRENDERER_H
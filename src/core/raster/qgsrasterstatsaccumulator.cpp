@@ -0,0 +1,135 @@
+/***************************************************************************
+    qgsrasterstatsaccumulator.cpp
+    ---------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsrasterstatsaccumulator.h"
+
+#include "qgsrasterbandstats.h"
+#include "qgsrasterblock.h"
+
+#include <limits>
+
+QgsRasterStatsAccumulator::QgsRasterStatsAccumulator()
+    : mCount( 0 )
+    , mMinimum( std::numeric_limits<double>::max() )
+    , mMaximum( -std::numeric_limits<double>::max() )
+    , mSum( 0.0 )
+    , mMean( 0.0 )
+    , mSumOfSquares( 0.0 )
+{
+}
+
+void QgsRasterStatsAccumulator::addBlock( const QgsRasterBlock *block )
+{
+  if ( !block )
+    return;
+
+  int width = block->width();
+  QVector<double> values( width );
+  QVector<bool> noData( width );
+  for ( int row = 0; row < block->height(); ++row )
+  {
+    block->readRow( row, values.data(), noData.data() );
+    for ( int col = 0; col < width; ++col )
+    {
+      if ( !noData[col] )
+        addValue( values[col] );
+    }
+  }
+}
+
+void QgsRasterStatsAccumulator::merge( const QgsRasterStatsAccumulator &other )
+{
+  if ( other.mCount == 0 )
+    return;
+  if ( mCount == 0 )
+  {
+    *this = other;
+    return;
+  }
+
+  // Chan et al. pairwise update of the mean and the sum of squared differences
+  double count = static_cast< double >( mCount ) + static_cast< double >( other.mCount );
+  double delta = other.mMean - mMean;
+  mMean += delta * other.mCount / count;
+  mSumOfSquares += other.mSumOfSquares + delta * delta * mCount * other.mCount / count;
+
+  mCount += other.mCount;
+  mSum += other.mSum;
+  mMinimum = qMin( mMinimum, other.mMinimum );
+  mMaximum = qMax( mMaximum, other.mMaximum );
+}
+
+double QgsRasterStatsAccumulator::stdDev() const
+{
+  if ( mCount < 2 )
+    return 0.0;
+  return sqrt( mSumOfSquares / ( mCount - 1 ) );
+}
+
+double QgsRasterStatsAccumulator::meanStandardError() const
+{
+  if ( mCount < 2 )
+    return std::numeric_limits<double>::quiet_NaN();
+  return stdDev() / sqrt( static_cast< double >( mCount ) );
+}
+
+void QgsRasterStatsAccumulator::fillStatistics( QgsRasterBandStats &stats ) const
+{
+  stats.elementCount = mCount;
+  stats.minimumValue = mMinimum;
+  stats.maximumValue = mMaximum;
+  stats.range = mMaximum - mMinimum;
+  stats.sum = mSum;
+  stats.mean = mSum / mCount;
+  stats.sumOfSquares = mSumOfSquares;
+  stats.stdDev = stdDev();
+}
+
+QgsRasterHistogramAccumulator::QgsRasterHistogramAccumulator( int binCount, double minimum, double maximum, bool includeOutOfRange )
+    : mCounts( binCount )
+    , mMinimum( minimum )
+    , mBinSize( ( maximum - minimum ) / binCount )
+    , mIncludeOutOfRange( includeOutOfRange )
+    , mCount( 0 )
+{
+}
+
+void QgsRasterHistogramAccumulator::addBlock( const QgsRasterBlock *block )
+{
+  if ( !block )
+    return;
+
+  int width = block->width();
+  QVector<double> values( width );
+  QVector<bool> noData( width );
+  for ( int row = 0; row < block->height(); ++row )
+  {
+    block->readRow( row, values.data(), noData.data() );
+    for ( int col = 0; col < width; ++col )
+    {
+      if ( !noData[col] )
+        addValue( values[col] );
+    }
+  }
+}
+
+void QgsRasterHistogramAccumulator::merge( const QgsRasterHistogramAccumulator &other )
+{
+  Q_ASSERT( other.mCounts.size() == mCounts.size() );
+  for ( int i = 0; i < mCounts.size(); ++i )
+  {
+    mCounts[i] += other.mCounts.at( i );
+  }
+  mCount += other.mCount;
+}
@@ -0,0 +1,154 @@
+/***************************************************************************
+    qgsrasterstatsaccumulator.h
+    ---------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSRASTERSTATSACCUMULATOR_H
+#define QGSRASTERSTATSACCUMULATOR_H
+
+#include "qgis.h"
+
+#include <QVector>
+
+#include <qmath.h>
+
+class QgsRasterBandStats;
+class QgsRasterBlock;
+
+/** \ingroup core
+ * Partial statistics of raster values.
+ *
+ * Mean and variance are updated with Welford's single pass algorithm. Accumulators
+ * filled from different parts of a raster (e.g. in different threads) may be merged
+ * together, which gives the same result as if all values were added to one accumulator.
+ *
+ * \note added in QGIS 2.16
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsRasterStatsAccumulator
+{
+  public:
+    QgsRasterStatsAccumulator();
+
+    //! Adds a single value
+    void addValue( double value )
+    {
+      ++mCount;
+      mSum += value;
+      if ( value < mMinimum )
+        mMinimum = value;
+      if ( value > mMaximum )
+        mMaximum = value;
+
+      double delta = value - mMean;
+      mMean += delta / mCount;
+      mSumOfSquares += delta * ( value - mMean );
+    }
+
+    //! Adds all values of the block which are not no data
+    void addBlock( const QgsRasterBlock *block );
+
+    //! Merges statistics collected by another accumulator
+    void merge( const QgsRasterStatsAccumulator &other );
+
+    //! Number of added values
+    qgssize count() const { return mCount; }
+
+    //! Minimum value, std::numeric_limits<double>::max() if no value was added
+    double minimum() const { return mMinimum; }
+
+    //! Maximum value, -std::numeric_limits<double>::max() if no value was added
+    double maximum() const { return mMaximum; }
+
+    //! Sum of values
+    double sum() const { return mSum; }
+
+    //! Mean of values
+    double mean() const { return mMean; }
+
+    //! Sum of squared differences from the mean
+    double sumOfSquares() const { return mSumOfSquares; }
+
+    //! Sample standard deviation of values
+    double stdDev() const;
+
+    /** Standard error of the mean, i.e. the expected error of mean() if the values
+     * were sampled from a larger population (for example a raster read at lower resolution)
+     */
+    double meanStandardError() const;
+
+    //! Fills count, minimum, maximum, range, sum, mean, sum of squares and standard deviation in stats
+    void fillStatistics( QgsRasterBandStats &stats ) const;
+
+  private:
+    qgssize mCount;
+    double mMinimum;
+    double mMaximum;
+    double mSum;
+    double mMean;
+    double mSumOfSquares;
+};
+
+/** \ingroup core
+ * Partial histogram of raster values. Accumulators with the same bins, filled
+ * from different parts of a raster, may be merged together.
+ *
+ * \note added in QGIS 2.16
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsRasterHistogramAccumulator
+{
+  public:
+
+    /** Constructor
+     * @param binCount number of bins
+     * @param minimum lower bound of the first bin
+     * @param maximum upper bound of the last bin
+     * @param includeOutOfRange count values outside of the bins in the first or last bin
+     */
+    QgsRasterHistogramAccumulator( int binCount, double minimum, double maximum, bool includeOutOfRange );
+
+    //! Adds a single value
+    void addValue( double value )
+    {
+      int bin = static_cast< int >( qFloor(( value - mMinimum ) / mBinSize ) );
+      if ( bin < 0 || bin >= mCounts.size() )
+      {
+        if ( !mIncludeOutOfRange )
+          return;
+        bin = bin < 0 ? 0 : mCounts.size() - 1;
+      }
+      mCounts[bin] += 1;
+      ++mCount;
+    }
+
+    //! Adds all values of the block which are not no data
+    void addBlock( const QgsRasterBlock *block );
+
+    //! Merges counts collected by another accumulator with the same bins
+    void merge( const QgsRasterHistogramAccumulator &other );
+
+    //! Number of values in each bin
+    const QVector<int> &counts() const { return mCounts; }
+
+    //! Number of values counted in bins
+    int count() const { return mCount; }
+
+  private:
+    QVector<int> mCounts;
+    double mMinimum;
+    double mBinSize;
+    bool mIncludeOutOfRange;
+    int mCount;
+};
+
+#endif // QGSRASTERSTATSACCUMULATOR_H
@@ -0,0 +1,93 @@
+/***************************************************************************
+    qgsrastervaluecache.h
+    ---------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSRASTERVALUECACHE_H
+#define QGSRASTERVALUECACHE_H
+
+#include "qgis.h"
+
+#include <QBitArray>
+#include <QVector>
+
+/** \ingroup core
+ * Lookup table of results computed for raster values.
+ *
+ * Renderers use it to run costly per value computations (shading, contrast
+ * enhancement, transparency) only once for each distinct value of a block
+ * instead of once for each pixel. It is only available for integer data types
+ * of up to 16 bits, the entries are computed lazily when a value is found
+ * for the first time.
+ *
+ * \note added in QGIS 2.16
+ * \note not available in Python bindings
+ */
+template <typename T>
+class QgsRasterValueCache
+{
+  public:
+
+    //! Returns true if values of the data type can be cached
+    static bool supportsDataType( QGis::DataType dataType )
+    {
+      return dataType == QGis::Byte || dataType == QGis::UInt16 || dataType == QGis::Int16;
+    }
+
+    /** Returns true if it pays off to cache values of a block with given data type and number of pixels,
+     * i.e. the data type is supported and filling the table is cheap compared to computing every pixel
+     */
+    static bool useForBlock( QGis::DataType dataType, qgssize pixelCount )
+    {
+      return supportsDataType( dataType ) && pixelCount >= static_cast< qgssize >( tableSize( dataType ) ) / 4;
+    }
+
+    /** Constructor
+     * @param dataType data type of cached values, must be supported (see supportsDataType())
+     */
+    explicit QgsRasterValueCache( QGis::DataType dataType )
+        : mOffset( dataType == QGis::Int16 ? 32768 : 0 )
+        , mResults( tableSize( dataType ) )
+        , mCached( tableSize( dataType ) )
+    {}
+
+    /** Returns cached result for the value or nullptr if it has not been inserted yet
+     * @param value raster value, must be within the range of the data type
+     */
+    const T *find( double value ) const
+    {
+      int i = static_cast< int >( value ) + mOffset;
+      return mCached.testBit( i ) ? &mResults.at( i ) : nullptr;
+    }
+
+    //! Stores result for the value
+    const T &insert( double value, const T &result )
+    {
+      int i = static_cast< int >( value ) + mOffset;
+      mCached.setBit( i );
+      mResults[i] = result;
+      return mResults.at( i );
+    }
+
+  private:
+
+    static int tableSize( QGis::DataType dataType )
+    {
+      return dataType == QGis::Byte ? 256 : 65536;
+    }
+
+    int mOffset;
+    QVector<T> mResults;
+    QBitArray mCached;
+};
+
+#endif // QGSRASTERVALUECACHE_H
@@ -18,9 +18,51 @@
 #include "qgssinglebandgrayrenderer.h"
 #include "qgscontrastenhancement.h"
 #include "qgsrastertransparency.h"
+#include "qgsrastervaluecache.h"
 #include <QDomDocument>
 #include <QDomElement>
 #include <QImage>
+#include <QScopedPointer>
+#include <QVector>
+
+namespace
+{
+  //! Result of the computation of gray for a raster value
+  struct GrayValue
+  {
+    bool valid;   //!< false if the value is outside of the displayable range
+    double gray;  //!< gray with contrast enhancement and gradient applied
+    double alpha; //!< opacity of the renderer for the value
+  };
+}
+
+static GrayValue grayValue( QgsContrastEnhancement *contrastEnhancement, const QgsRasterTransparency *transparency,
+                            double opacity, QgsSingleBandGrayRenderer::Gradient gradient, double value )
+{
+  GrayValue gray = { false, value, opacity };
+
+  if ( transparency )
+  {
+    gray.alpha = transparency->alphaValue( value, opacity * 255 ) / 255.0;
+  }
+
+  if ( contrastEnhancement )
+  {
+    if ( !contrastEnhancement->isValueInDisplayableRange( value ) )
+    {
+      return gray;
+    }
+    gray.gray = contrastEnhancement->enhanceContrast( value );
+  }
+
+  if ( gradient == QgsSingleBandGrayRenderer::WhiteToBlack )
+  {
+    gray.gray = 255 - gray.gray;
+  }
+
+  gray.valid = true;
+  return gray;
+}
 
 QgsSingleBandGrayRenderer::QgsSingleBandGrayRenderer( QgsRasterInterface* input, int grayBand ):
     QgsRasterRenderer( input, "singlebandgray" ), mGrayBand( grayBand ), mGradient( BlackToWhite ), mContrastEnhancement( nullptr )
@@ -124,47 +166,67 @@ QgsRasterBlock* QgsSingleBandGrayRenderer::block( int bandNo, QgsRectangle  cons
   }
 
   QRgb myDefaultColor = NODATA_COLOR;
-  for ( qgssize i = 0; i < ( qgssize )width*height; i++ )
+
+  // compute every distinct value of integer data only once
+  QScopedPointer< QgsRasterValueCache<GrayValue> > cache;
+  if ( QgsRasterValueCache<GrayValue>::useForBlock( inputBlock->dataType(), static_cast< qgssize >( width ) * height ) )
   {
-    if ( inputBlock->isNoData( i ) )
-    {
-      outputBlock->setColor( i, myDefaultColor );
-      continue;
-    }
-    double grayVal = inputBlock->value( i );
+    cache.reset( new QgsRasterValueCache<GrayValue>( inputBlock->dataType() ) );
+  }
 
-    double currentAlpha = mOpacity;
-    if ( mRasterTransparency )
-    {
-      currentAlpha = mRasterTransparency->alphaValue( grayVal, mOpacity * 255 ) / 255.0;
-    }
+  QVector<double> values( width );
+  QVector<bool> noData( width );
+  QVector<double> alphaValues( mAlphaBand > 0 ? width : 0 );
+
+  for ( int row = 0; row < height; ++row )
+  {
+    inputBlock->readRow( row, values.data(), noData.data() );
     if ( mAlphaBand > 0 )
     {
-      currentAlpha *= alphaBlock->value( i ) / 255.0;
+      alphaBlock->readRow( row, alphaValues.data() );
     }
 
-    if ( mContrastEnhancement )
+    QRgb *outputRow = reinterpret_cast< QRgb * >( outputBlock->bits( row, 0 ) );
+    for ( int col = 0; col < width; ++col )
     {
-      if ( !mContrastEnhancement->isValueInDisplayableRange( grayVal ) )
+      if ( noData[col] )
       {
-        outputBlock->setColor( i, myDefaultColor );
+        outputRow[col] = myDefaultColor;
         continue;
       }
-      grayVal = mContrastEnhancement->enhanceContrast( grayVal );
-    }
 
-    if ( mGradient == WhiteToBlack )
-    {
-      grayVal = 255 - grayVal;
-    }
+      double val = values[col];
+      GrayValue gray;
+      if ( cache )
+      {
+        const GrayValue *cached = cache->find( val );
+        gray = cached ? *cached : cache->insert( val, grayValue( mContrastEnhancement, mRasterTransparency, mOpacity, mGradient, val ) );
+      }
+      else
+      {
+        gray = grayValue( mContrastEnhancement, mRasterTransparency, mOpacity, mGradient, val );
+      }
 
-    if ( qgsDoubleNear( currentAlpha, 1.0 ) )
-    {
-      outputBlock->setColor( i, qRgba( grayVal, grayVal, grayVal, 255 ) );
-    }
-    else
-    {
-      outputBlock->setColor( i, qRgba( currentAlpha * grayVal, currentAlpha * grayVal, currentAlpha * grayVal, currentAlpha * 255 ) );
+      if ( !gray.valid )
+      {
+        outputRow[col] = myDefaultColor;
+        continue;
+      }
+
+      double currentAlpha = gray.alpha;
+      if ( mAlphaBand > 0 )
+      {
+        currentAlpha *= alphaValues[col] / 255.0;
+      }
+
+      if ( qgsDoubleNear( currentAlpha, 1.0 ) )
+      {
+        outputRow[col] = qRgba( gray.gray, gray.gray, gray.gray, 255 );
+      }
+      else
+      {
+        outputRow[col] = qRgba( currentAlpha * gray.gray, currentAlpha * gray.gray, currentAlpha * gray.gray, currentAlpha * 255 );
+      }
     }
   }
 
@@ -18,10 +18,45 @@
 #include "qgssinglebandpseudocolorrenderer.h"
 #include "qgsrastershader.h"
 #include "qgsrastertransparency.h"
+#include "qgsrastervaluecache.h"
 #include "qgsrasterviewport.h"
 #include <QDomDocument>
 #include <QDomElement>
 #include <QImage>
+#include <QScopedPointer>
+#include <QVector>
+
+namespace
+{
+  //! Result of shading of a raster value
+  struct ShadedValue
+  {
+    bool valid;     //!< false if the shader has no color for the value
+    QRgb color;     //!< color premultiplied by its alpha
+    double opacity; //!< opacity of the renderer for the value
+  };
+}
+
+static ShadedValue shadeValue( QgsRasterShader *shader, const QgsRasterTransparency *transparency, double opacity, double value )
+{
+  ShadedValue shaded = { false, 0, 0.0 };
+  int red, green, blue, alpha;
+  shaded.valid = shader->shade( value, &red, &green, &blue, &alpha );
+  if ( !shaded.valid )
+    return shaded;
+
+  if ( alpha < 255 )
+  {
+    // Working with premultiplied colors, so multiply values by alpha
+    red *= ( alpha / 255.0 );
+    blue *= ( alpha / 255.0 );
+    green *= ( alpha / 255.0 );
+  }
+  shaded.color = qRgba( red, green, blue, alpha );
+
+  shaded.opacity = transparency ? transparency->alphaValue( value, opacity * 255 ) / 255.0 : opacity;
+  return shaded;
+}
 
 QgsSingleBandPseudoColorRenderer::QgsSingleBandPseudoColorRenderer( QgsRasterInterface* input, int band, QgsRasterShader* shader ):
     QgsRasterRenderer( input, "singlebandpseudocolor" )
@@ -157,47 +192,71 @@ QgsRasterBlock* QgsSingleBandPseudoColorRenderer::block( int bandNo, QgsRectangl
 
   QRgb myDefaultColor = NODATA_COLOR;
 
-  for ( qgssize i = 0; i < ( qgssize )width*height; i++ )
+  // shade every distinct value of integer data only once
+  QScopedPointer< QgsRasterValueCache<ShadedValue> > cache;
+  if ( QgsRasterValueCache<ShadedValue>::useForBlock( inputBlock->dataType(), static_cast< qgssize >( width ) * height ) )
   {
-    if ( inputBlock->isNoData( i ) )
-    {
-      outputBlock->setColor( i, myDefaultColor );
-      continue;
-    }
-    double val = inputBlock->value( i );
-    int red, green, blue, alpha;
-    if ( !mShader->shade( val, &red, &green, &blue, &alpha ) )
-    {
-      outputBlock->setColor( i, myDefaultColor );
-      continue;
-    }
+    cache.reset( new QgsRasterValueCache<ShadedValue>( inputBlock->dataType() ) );
+  }
 
-    if ( alpha < 255 )
-    {
-      // Working with premultiplied colors, so multiply values by alpha
-      red *= ( alpha / 255.0 );
-      blue *= ( alpha / 255.0 );
-      green *= ( alpha / 255.0 );
-    }
+  // the transparency is only used with hasTransparency
+  const QgsRasterTransparency *transparency = hasTransparency ? mRasterTransparency : nullptr;
 
-    if ( !hasTransparency )
+  QVector<double> values( width );
+  QVector<bool> noData( width );
+  QVector<double> alphaValues( mAlphaBand > 0 ? width : 0 );
+
+  for ( int row = 0; row < height; ++row )
+  {
+    inputBlock->readRow( row, values.data(), noData.data() );
+    if ( mAlphaBand > 0 )
     {
-      outputBlock->setColor( i, qRgba( red, green, blue, alpha ) );
+      alphaBlock->readRow( row, alphaValues.data() );
     }
-    else
+
+    QRgb *outputRow = reinterpret_cast< QRgb * >( outputBlock->bits( row, 0 ) );
+    for ( int col = 0; col < width; ++col )
     {
-      //opacity
-      double currentOpacity = mOpacity;
-      if ( mRasterTransparency )
+      if ( noData[col] )
+      {
+        outputRow[col] = myDefaultColor;
+        continue;
+      }
+
+      double val = values[col];
+      ShadedValue shaded;
+      if ( cache )
       {
-        currentOpacity = mRasterTransparency->alphaValue( val, mOpacity * 255 ) / 255.0;
+        const ShadedValue *cached = cache->find( val );
+        shaded = cached ? *cached : cache->insert( val, shadeValue( mShader, transparency, mOpacity, val ) );
       }
-      if ( mAlphaBand > 0 )
+      else
       {
-        currentOpacity *= alphaBlock->value( i ) / 255.0;
+        shaded = shadeValue( mShader, transparency, mOpacity, val );
       }
 
-      outputBlock->setColor( i, qRgba( currentOpacity * red, currentOpacity * green, currentOpacity * blue, currentOpacity * alpha ) );
+      if ( !shaded.valid )
+      {
+        outputRow[col] = myDefaultColor;
+        continue;
+      }
+
+      if ( !hasTransparency )
+      {
+        outputRow[col] = shaded.color;
+      }
+      else
+      {
+        //opacity
+        double currentOpacity = shaded.opacity;
+        if ( mAlphaBand > 0 )
+        {
+          currentOpacity *= alphaValues[col] / 255.0;
+        }
+
+        outputRow[col] = qRgba( currentOpacity * qRed( shaded.color ), currentOpacity * qGreen( shaded.color ),
+                                currentOpacity * qBlue( shaded.color ), currentOpacity * qAlpha( shaded.color ) );
+      }
     }
   }
 
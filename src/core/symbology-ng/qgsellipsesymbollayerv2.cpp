@@ -20,6 +20,7 @@
 #include "qgsvectorlayer.h"
 #include "qgsdatadefined.h"
 #include "qgslogger.h"
+#include "qgsmarkerstampcache.h"
 #include "qgsunittypes.h"
 
 #include <QPainter>
@@ -39,6 +40,7 @@ QgsEllipseSymbolLayerV2::QgsEllipseSymbolLayerV2()
     , mPenJoinStyle( DEFAULT_ELLIPSE_JOINSTYLE )
     , mOutlineWidth( 0 )
     , mOutlineWidthUnit( QgsSymbolV2::MM )
+    , mStampCache( nullptr )
 {
   mColor = Qt::white;
   mPen.setColor( mOutlineColor );
@@ -53,6 +55,7 @@ QgsEllipseSymbolLayerV2::QgsEllipseSymbolLayerV2()
 
 QgsEllipseSymbolLayerV2::~QgsEllipseSymbolLayerV2()
 {
+  delete mStampCache;
 }
 
 QgsSymbolLayerV2* QgsEllipseSymbolLayerV2::create( const QgsStringMap& properties )
@@ -253,9 +256,9 @@ void QgsEllipseSymbolLayerV2::renderPoint( QPointF point, QgsSymbolV2RenderConte
   }
   double scaledWidth = mSymbolWidth;
   double scaledHeight = mSymbolHeight;
+  QString symbolName = mSymbolName;
   if ( hasDataDefinedProperty( QgsSymbolLayerV2::EXPR_WIDTH ) || hasDataDefinedProperty( QgsSymbolLayerV2::EXPR_HEIGHT ) || hasDataDefinedProperty( QgsSymbolLayerV2::EXPR_SYMBOL_NAME ) )
   {
-    QString symbolName =  mSymbolName;
     if ( hasDataDefinedProperty( QgsSymbolLayerV2::EXPR_SYMBOL_NAME ) )
     {
       context.setOriginalValueVariable( mSymbolName );
@@ -276,6 +279,18 @@ void QgsEllipseSymbolLayerV2::renderPoint( QPointF point, QgsSymbolV2RenderConte
     return;
   }
 
+  if ( mStampCache && mStampCache->isEnabled() )
+  {
+    QRectF pathBounds = mPainterPath.boundingRect();
+    QgsMarkerStampCache::Key key;
+    if ( mStampCache->markerKey( p, point + offset, symbolName, pathBounds.width(), pathBounds.height(), angle, mPen, mBrush, key )
+         && ( mStampCache->drawStamp( p, point + offset, key )
+              || mStampCache->drawNewStamp( p, point + offset, key, mPainterPath, mPen, mBrush ) ) )
+    {
+      return;
+    }
+  }
+
   QMatrix transform;
   transform.translate( point.x() + offset.x(), point.y() + offset.y() );
   if ( !qgsDoubleNear( angle, 0.0 ) )
@@ -354,10 +369,15 @@ void QgsEllipseSymbolLayerV2::startRender( QgsSymbolV2RenderContext& context )
   mPen.setWidthF( QgsSymbolLayerV2Utils::convertToPainterUnits( context.renderContext(), mOutlineWidth, mOutlineWidthUnit, mOutlineWidthMapUnitScale ) );
   mBrush.setColor( mColor );
   prepareExpressions( context );
+
+  delete mStampCache;
+  mStampCache = QgsMarkerStampCache::supportsContext( context.renderContext() ) ? new QgsMarkerStampCache() : nullptr;
 }
 
 void QgsEllipseSymbolLayerV2::stopRender( QgsSymbolV2RenderContext & )
 {
+  delete mStampCache;
+  mStampCache = nullptr;
 }
 
 QgsEllipseSymbolLayerV2* QgsEllipseSymbolLayerV2::clone() const
@@ -21,6 +21,7 @@
 #include <QPainterPath>
 
 class QgsExpression;
+class QgsMarkerStampCache;
 
 /** A symbol layer for rendering objects with major and minor axis (e.g. ellipse, rectangle )*/
 class CORE_EXPORT QgsEllipseSymbolLayerV2: public QgsMarkerSymbolLayerV2
@@ -118,6 +119,9 @@ class CORE_EXPORT QgsEllipseSymbolLayerV2: public QgsMarkerSymbolLayerV2
     QPen mPen;
     QBrush mBrush;
 
+    //! Stamps of rendered markers, only set while rendering
+    QgsMarkerStampCache* mStampCache;
+
     /** Setup mPainterPath
       @param symbolName name of symbol
       @param context render context
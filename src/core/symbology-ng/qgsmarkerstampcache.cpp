@@ -0,0 +1,201 @@
+/***************************************************************************
+    qgsmarkerstampcache.cpp
+    ---------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsmarkerstampcache.h"
+
+#include "qgis.h"
+#include "qgsrendercontext.h"
+
+#include <QPaintEngine>
+#include <QPainter>
+#include <QPainterPath>
+
+#include <qmath.h>
+
+//! Number of drawn markers after which the cache may disable itself
+static const int MIN_MARKERS_BEFORE_DISABLING = 256;
+
+QgsMarkerStampCache::Key::Key()
+    : width( 0 )
+    , height( 0 )
+    , angle( 0 )
+    , phaseX( 0 )
+    , phaseY( 0 )
+    , fillColor( 0 )
+    , outlineColor( 0 )
+    , outlineWidth( 0 )
+    , outlineStyle( 0 )
+{
+}
+
+bool QgsMarkerStampCache::Key::operator==( const QgsMarkerStampCache::Key& other ) const
+{
+  return width == other.width && height == other.height && angle == other.angle
+         && phaseX == other.phaseX && phaseY == other.phaseY
+         && fillColor == other.fillColor && outlineColor == other.outlineColor
+         && outlineWidth == other.outlineWidth && outlineStyle == other.outlineStyle
+         && name == other.name;
+}
+
+uint qHash( const QgsMarkerStampCache::Key& key )
+{
+  uint hash = qHash( key.name );
+  hash = hash * 31 + key.width;
+  hash = hash * 31 + key.height;
+  hash = hash * 31 + key.angle;
+  hash = hash * 31 + ( key.phaseX << 2 | key.phaseY );
+  hash = hash * 31 + key.fillColor;
+  hash = hash * 31 + key.outlineColor;
+  hash = hash * 31 + key.outlineWidth;
+  hash = hash * 31 + key.outlineStyle;
+  return hash;
+}
+
+QgsMarkerStampCache::QgsMarkerStampCache( int maximumSize )
+    : mStamps( maximumSize )
+    , mEnabled( true )
+    , mHits( 0 )
+    , mMisses( 0 )
+{
+}
+
+bool QgsMarkerStampCache::supportsContext( const QgsRenderContext& context )
+{
+  QPainter* p = context.painter();
+  return p && !context.forceVectorOutput() && qgsDoubleNear( context.rasterScaleFactor(), 1.0 )
+         && p->paintEngine() && p->paintEngine()->type() == QPaintEngine::Raster;
+}
+
+bool QgsMarkerStampCache::markerKey( QPainter* p, QPointF point, const QString& name, double width, double height, double angle,
+                                     const QPen& pen, const QBrush& brush, QgsMarkerStampCache::Key& key ) const
+{
+  if ( !mEnabled || !p || p->transform().type() > QTransform::TxTranslate )
+    return false;
+
+  if ( width > MAXIMUM_STAMP_SIZE || height > MAXIMUM_STAMP_SIZE )
+    return false;
+
+  // only solid fills can be copied, patterns would not be aligned with the neighbouring markers
+  if ( brush.style() != Qt::NoBrush && brush.style() != Qt::SolidPattern )
+    return false;
+
+  key.name = name;
+  key.width = qRound( width * 16 );
+  key.height = qRound( height * 16 );
+  key.angle = qRound( angle ) % 360;
+  if ( key.angle < 0 )
+    key.angle += 360;
+  devicePixel( p, point, key.phaseX, key.phaseY );
+  key.fillColor = brush.style() == Qt::NoBrush ? 0 : brush.color().rgba();
+  if ( pen.style() == Qt::NoPen )
+  {
+    key.outlineColor = 0;
+    key.outlineWidth = 0;
+    key.outlineStyle = 0;
+  }
+  else
+  {
+    key.outlineColor = pen.color().rgba();
+    key.outlineWidth = qRound( pen.widthF() * 16 );
+    key.outlineStyle = pen.style() | pen.joinStyle() | pen.capStyle();
+  }
+  return true;
+}
+
+bool QgsMarkerStampCache::drawStamp( QPainter* p, QPointF point, const QgsMarkerStampCache::Key& key )
+{
+  const Stamp* stamp = mStamps.object( key );
+  if ( !stamp )
+    return false;
+
+  draw( p, point, *stamp );
+  ++mHits;
+  return true;
+}
+
+bool QgsMarkerStampCache::drawNewStamp( QPainter* p, QPointF point, const QgsMarkerStampCache::Key& key, const QPainterPath& path, const QPen& pen, const QBrush& brush )
+{
+  ++mMisses;
+  if ( mMisses > MIN_MARKERS_BEFORE_DISABLING && mMisses > mHits )
+  {
+    // most markers are distinct, stamps do not pay off
+    mEnabled = false;
+  }
+
+  QTransform rotation;
+  rotation.rotate( key.angle );
+  QPainterPath rotatedPath = rotation.map( path );
+
+  // room for the outline (including miter joins) and for the sub-pixel offset
+  double margin = pen.style() == Qt::NoPen ? 1.0 : qMax( pen.widthF(), 1.0 ) + 1.0;
+  QRectF bounds = rotatedPath.boundingRect().adjusted( -margin, -margin, margin + 1, margin + 1 );
+  int left = qFloor( bounds.left() );
+  int top = qFloor( bounds.top() );
+  int width = qCeil( bounds.right() ) - left;
+  int height = qCeil( bounds.bottom() ) - top;
+  if ( width > MAXIMUM_STAMP_SIZE || height > MAXIMUM_STAMP_SIZE )
+    return false;
+
+  Stamp* stamp = new Stamp;
+  stamp->origin = QPoint( left, top );
+  stamp->image = QImage( width, height, QImage::Format_ARGB32_Premultiplied );
+  stamp->image.fill( 0 );
+
+  QPainter stampPainter( &stamp->image );
+  stampPainter.setRenderHint( QPainter::Antialiasing, p->testRenderHint( QPainter::Antialiasing ) );
+  stampPainter.translate( -left + key.phaseX / 4.0, -top + key.phaseY / 4.0 );
+  stampPainter.setPen( pen );
+  stampPainter.setBrush( brush );
+  stampPainter.drawPath( rotatedPath );
+  stampPainter.end();
+
+  draw( p, point, *stamp );
+
+  // cost in kilobytes, the cache deletes stamps which do not fit right away
+  mStamps.insert( key, stamp, width * height * 4 / 1024 + 1 );
+  return true;
+}
+
+QPoint QgsMarkerStampCache::devicePixel( QPainter* p, QPointF point, int& phaseX, int& phaseY )
+{
+  const QTransform& transform = p->transform();
+  double x = point.x() + transform.dx();
+  double y = point.y() + transform.dy();
+
+  int pixelX = qFloor( x );
+  int pixelY = qFloor( y );
+  phaseX = qRound(( x - pixelX ) * 4 );
+  phaseY = qRound(( y - pixelY ) * 4 );
+  if ( phaseX == 4 )
+  {
+    ++pixelX;
+    phaseX = 0;
+  }
+  if ( phaseY == 4 )
+  {
+    ++pixelY;
+    phaseY = 0;
+  }
+  return QPoint( pixelX, pixelY );
+}
+
+void QgsMarkerStampCache::draw( QPainter* p, QPointF point, const QgsMarkerStampCache::Stamp& stamp )
+{
+  int phaseX, phaseY;
+  QPoint pixel = devicePixel( p, point, phaseX, phaseY ) + stamp.origin;
+
+  // the painter is only translated, place the image exactly on device pixels
+  const QTransform& transform = p->transform();
+  p->drawImage( QPointF( pixel.x() - transform.dx(), pixel.y() - transform.dy() ), stamp.image );
+}
@@ -0,0 +1,158 @@
+/***************************************************************************
+    qgsmarkerstampcache.h
+    ---------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSMARKERSTAMPCACHE_H
+#define QGSMARKERSTAMPCACHE_H
+
+#include <QBrush>
+#include <QCache>
+#include <QImage>
+#include <QPen>
+#include <QPointF>
+#include <QString>
+
+class QPainter;
+class QPainterPath;
+class QgsRenderContext;
+
+/** \ingroup core
+ * Cache of rasterized markers ("stamps") for marker symbol layers with data defined
+ * properties.
+ *
+ * Markers which cannot use a single prerendered image (e.g. because their rotation,
+ * size or colors are data defined) are rasterized once for each distinct combination
+ * of evaluated parameters and then copied to the destination. The rotation is quantized
+ * to whole degrees, sizes and outline widths to 1/16 of a pixel. The position of the marker
+ * is kept with a precision of 1/4 of a pixel by caching separate stamps for sub-pixel offsets.
+ *
+ * Stamps are only used when drawing to a raster device without scaling or rotation of the
+ * painter. The cache disables itself if most markers turn out to be distinct, as rasterizing
+ * a stamp for each of them would be slower than painting them directly.
+ *
+ * The cache is meant to be owned by a symbol layer during rendering, it is not thread safe.
+ *
+ * \note added in QGIS 2.16
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsMarkerStampCache
+{
+  public:
+
+    //! Evaluated parameters of a marker which identify its stamp
+    struct Key
+    {
+      Key();
+
+      bool operator==( const Key& other ) const;
+
+      //! Shape name, character or other identifier of the marker
+      QString name;
+      //! Width in 1/16 of pixel
+      int width;
+      //! Height in 1/16 of pixel
+      int height;
+      //! Rotation in degrees
+      int angle;
+      //! Sub-pixel position (0-3) in x direction
+      int phaseX;
+      //! Sub-pixel position (0-3) in y direction
+      int phaseY;
+      //! Fill color, 0 if the marker is not filled
+      QRgb fillColor;
+      //! Outline color, 0 if the marker has no outline
+      QRgb outlineColor;
+      //! Outline width in 1/16 of pixel
+      int outlineWidth;
+      //! Outline pen style, join style and cap style
+      int outlineStyle;
+    };
+
+    /** Constructor
+     * @param maximumSize maximum size of cached stamps in kilobytes
+     */
+    explicit QgsMarkerStampCache( int maximumSize = 4096 );
+
+    /** Returns true if stamps may be used for rendering with the context, i.e. the output
+     * is a raster image at the resolution of the painter
+     */
+    static bool supportsContext( const QgsRenderContext& context );
+
+    /** Builds key of the marker. Returns false if the marker cannot be drawn from a stamp
+     * and has to be painted directly.
+     * @param p destination painter
+     * @param point position of the center of the marker in painter coordinates
+     * @param name identifier of the marker shape
+     * @param width marker width in painter units, before rotation
+     * @param height marker height in painter units, before rotation
+     * @param angle marker rotation in degrees
+     * @param pen marker outline
+     * @param brush marker fill
+     * @param key destination key
+     */
+    bool markerKey( QPainter* p, QPointF point, const QString& name, double width, double height, double angle,
+                    const QPen& pen, const QBrush& brush, Key& key ) const;
+
+    /** Draws the cached stamp of the marker at point. Returns false if the stamp
+     * is not cached yet, see drawNewStamp().
+     */
+    bool drawStamp( QPainter* p, QPointF point, const Key& key );
+
+    /** Rasterizes the marker into a new stamp and draws it at point. Returns false if the
+     * stamp could not be created (e.g. it is too large) and the marker has to be painted directly.
+     * @param p destination painter
+     * @param point position of the center of the marker in painter coordinates
+     * @param key key of the marker from markerKey()
+     * @param path marker outline centered at the origin, not rotated
+     * @param pen marker outline
+     * @param brush marker fill
+     */
+    bool drawNewStamp( QPainter* p, QPointF point, const Key& key, const QPainterPath& path, const QPen& pen, const QBrush& brush );
+
+    //! Returns true if the cache has not disabled itself because of too many distinct markers
+    bool isEnabled() const { return mEnabled; }
+
+    //! Number of markers drawn from cached stamps
+    int hits() const { return mHits; }
+
+    //! Number of rasterized stamps
+    int misses() const { return mMisses; }
+
+    //! Maximum width or height of a stamp in pixels, larger markers are painted directly
+    static const int MAXIMUM_STAMP_SIZE = 256;
+
+  private:
+
+    struct Stamp
+    {
+      QImage image;
+      //! Position of the image relative to the pixel of the marker center
+      QPoint origin;
+    };
+
+    //! Returns position of pixel containing point in device coordinates
+    static QPoint devicePixel( QPainter* p, QPointF point, int& phaseX, int& phaseY );
+
+    void draw( QPainter* p, QPointF point, const Stamp& stamp );
+
+    QCache<Key, Stamp> mStamps;
+    bool mEnabled;
+    int mHits;
+    int mMisses;
+
+    Q_DISABLE_COPY( QgsMarkerStampCache )
+};
+
+uint qHash( const QgsMarkerStampCache::Key& key );
+
+#endif // QGSMARKERSTAMPCACHE_H
@@ -21,6 +21,7 @@
 #include "qgsexpression.h"
 #include "qgsrendercontext.h"
 #include "qgslogger.h"
+#include "qgsmarkerstampcache.h"
 #include "qgssvgcache.h"
 #include "qgsunittypes.h"
 
@@ -693,6 +694,7 @@ QgsSimpleMarkerSymbolLayerV2::QgsSimpleMarkerSymbolLayerV2( const QString& name,
     , mPenJoinStyle( penJoinStyle )
     , mName( name )
     , mUsingCache( false )
+    , mStampCache( nullptr )
 {
   mColor = color;
 }
@@ -706,10 +708,16 @@ QgsSimpleMarkerSymbolLayerV2::QgsSimpleMarkerSymbolLayerV2( QgsSimpleMarkerSymbo
     , mPenJoinStyle( penJoinStyle )
     , mName( encodeShape( shape ) )
     , mUsingCache( false )
+    , mStampCache( nullptr )
 {
   mColor = color;
 }
 
+QgsSimpleMarkerSymbolLayerV2::~QgsSimpleMarkerSymbolLayerV2()
+{
+  delete mStampCache;
+}
+
 QgsSymbolLayerV2* QgsSimpleMarkerSymbolLayerV2::create( const QgsStringMap& props )
 {
   Shape shape = Circle;
@@ -880,6 +888,23 @@ void QgsSimpleMarkerSymbolLayerV2::startRender( QgsSymbolV2RenderContext& contex
     mCache = QImage();
     mSelCache = QImage();
   }
+
+  // markers with data defined rotation, size or colors are drawn from stamps
+  // rendered once for each distinct combination of the evaluated values
+  delete mStampCache;
+  mStampCache = nullptr;
+  if ( !mUsingCache && !hasDataDefinedProperty( QgsSymbolLayerV2::EXPR_NAME ) && QgsMarkerStampCache::supportsContext( context.renderContext() ) )
+  {
+    mStampCache = new QgsMarkerStampCache();
+  }
+}
+
+void QgsSimpleMarkerSymbolLayerV2::stopRender( QgsSymbolV2RenderContext& context )
+{
+  delete mStampCache;
+  mStampCache = nullptr;
+
+  QgsSimpleMarkerSymbolLayerBase::stopRender( context );
 }
 
 
@@ -971,6 +996,26 @@ void QgsSimpleMarkerSymbolLayerV2::draw( QgsSymbolV2RenderContext &context, QgsS
     return;
   }
 
+  prepareDataDefinedStyle( context );
+
+  if ( shapeIsFilled( shape ) )
+  {
+    p->setBrush( context.selected() ? mSelBrush : mBrush );
+  }
+  else
+  {
+    p->setBrush( Qt::NoBrush );
+  }
+  p->setPen( context.selected() ? mSelPen : mPen );
+
+  if ( !polygon.isEmpty() )
+    p->drawPolygon( polygon );
+  else
+    p->drawPath( path );
+}
+
+void QgsSimpleMarkerSymbolLayerV2::prepareDataDefinedStyle( QgsSymbolV2RenderContext& context )
+{
   bool ok = true;
   if ( hasDataDefinedProperty( QgsSymbolLayerV2::EXPR_COLOR ) )
   {
@@ -1019,21 +1064,6 @@ void QgsSimpleMarkerSymbolLayerV2::draw( QgsSymbolV2RenderContext &context, QgsS
       mSelPen.setJoinStyle( QgsSymbolLayerV2Utils::decodePenJoinStyle( style ) );
     }
   }
-
-  if ( shapeIsFilled( shape ) )
-  {
-    p->setBrush( context.selected() ? mSelBrush : mBrush );
-  }
-  else
-  {
-    p->setBrush( Qt::NoBrush );
-  }
-  p->setPen( context.selected() ? mSelPen : mPen );
-
-  if ( !polygon.isEmpty() )
-    p->drawPolygon( polygon );
-  else
-    p->drawPath( path );
 }
 
 void QgsSimpleMarkerSymbolLayerV2::renderPoint( QPointF point, QgsSymbolV2RenderContext& context )
@@ -1064,12 +1094,59 @@ void QgsSimpleMarkerSymbolLayerV2::renderPoint( QPointF point, QgsSymbolV2Render
                           point.y() - s / 2.0 + offset.y(),
                           s, s ), img );
   }
-  else
+  else if ( !mStampCache || !mStampCache->isEnabled() || !renderPointStamp( point, context ) )
   {
     QgsSimpleMarkerSymbolLayerBase::renderPoint( point, context );
   }
 }
 
+bool QgsSimpleMarkerSymbolLayerV2::renderPointStamp( QPointF point, QgsSymbolV2RenderContext& context )
+{
+  QPainter *p = context.renderContext().painter();
+
+  bool hasDataDefinedSize = false;
+  double scaledSize = calculateSize( context, hasDataDefinedSize );
+
+  bool hasDataDefinedRotation = false;
+  QPointF offset;
+  double angle = 0;
+  calculateOffsetAndRotation( context, scaledSize, hasDataDefinedRotation, offset, angle );
+
+  // the shape was already scaled and rotated in startRender() unless size or rotation are data defined
+  double size = QgsSymbolLayerV2Utils::convertToPainterUnits( context.renderContext(), scaledSize, mSizeUnit, mSizeMapUnitScale );
+  if ( !hasDataDefinedRotation )
+    angle = 0;
+
+  prepareDataDefinedStyle( context );
+  QPen pen = context.selected() ? mSelPen : mPen;
+  QBrush brush = !shapeIsFilled( mShape ) ? QBrush() : context.selected() ? mSelBrush : mBrush;
+
+  QgsMarkerStampCache::Key key;
+  if ( !mStampCache->markerKey( p, point + offset, QString(), size, size, angle, pen, brush, key ) )
+    return false;
+
+  if ( mStampCache->drawStamp( p, point + offset, key ) )
+    return true;
+
+  QTransform transform;
+  if ( hasDataDefinedSize )
+  {
+    transform.scale( size / 2.0, size / 2.0 );
+  }
+
+  QPainterPath path;
+  if ( !mPolygon.isEmpty() )
+  {
+    path.addPolygon( transform.map( mPolygon ) );
+    path.closeSubpath();
+  }
+  else
+  {
+    path = transform.map( mPath );
+  }
+  return mStampCache->drawNewStamp( p, point + offset, key, path, pen, brush );
+}
+
 QgsStringMap QgsSimpleMarkerSymbolLayerV2::properties() const
 {
   QgsStringMap map;
@@ -2478,6 +2555,7 @@ QRectF QgsSvgMarkerSymbolLayerV2::bounds( QPointF point, QgsSymbolV2RenderContex
 QgsFontMarkerSymbolLayerV2::QgsFontMarkerSymbolLayerV2( const QString& fontFamily, QChar chr, double pointSize, const QColor& color, double angle )
     : mFontMetrics( nullptr )
     , mChrWidth( 0 )
+    , mStampCache( nullptr )
 {
   mFontFamily = fontFamily;
   mChr = chr;
@@ -2497,6 +2575,7 @@ QgsFontMarkerSymbolLayerV2::QgsFontMarkerSymbolLayerV2( const QString& fontFamil
 QgsFontMarkerSymbolLayerV2::~QgsFontMarkerSymbolLayerV2()
 {
   delete mFontMetrics;
+  delete mStampCache;
 }
 
 QgsSymbolLayerV2* QgsFontMarkerSymbolLayerV2::create( const QgsStringMap& props )
@@ -2576,11 +2655,17 @@ void QgsFontMarkerSymbolLayerV2::startRender( QgsSymbolV2RenderContext& context
   mChrOffset = QPointF( mChrWidth / 2.0, -mFontMetrics->ascent() / 2.0 );
   mOrigSize = mSize; // save in case the size would be data defined
   prepareExpressions( context );
+
+  // converting characters to paths is expensive, they are drawn from stamps when possible
+  delete mStampCache;
+  mStampCache = QgsMarkerStampCache::supportsContext( context.renderContext() ) ? new QgsMarkerStampCache() : nullptr;
 }
 
 void QgsFontMarkerSymbolLayerV2::stopRender( QgsSymbolV2RenderContext& context )
 {
   Q_UNUSED( context );
+  delete mStampCache;
+  mStampCache = nullptr;
 }
 
 QString QgsFontMarkerSymbolLayerV2::characterToRender( QgsSymbolV2RenderContext& context, QPointF& charOffset, double& charWidth )
@@ -2736,7 +2821,6 @@ void QgsFontMarkerSymbolLayerV2::renderPoint( QPointF point, QgsSymbolV2RenderCo
   {
     p->setPen( Qt::NoPen );
   }
-  p->save();
 
   QPointF chrOffset = mChrOffset;
   double chrWidth;
@@ -2749,6 +2833,30 @@ void QgsFontMarkerSymbolLayerV2::renderPoint( QPointF point, QgsSymbolV2RenderCo
   double angle = 0;
   calculateOffsetAndRotation( context, sizeToRender, hasDataDefinedRotation, offset, angle );
 
+  if ( mStampCache && mStampCache->isEnabled() )
+  {
+    double pixelSize = mFont.pixelSize() * sizeToRender / mOrigSize;
+    QgsMarkerStampCache::Key key;
+    if ( mStampCache->markerKey( p, point + offset, charToRender, pixelSize, pixelSize, angle, p->pen(), mBrush, key ) )
+    {
+      if ( mStampCache->drawStamp( p, point + offset, key ) )
+        return;
+
+      QTransform scale;
+      if ( !qgsDoubleNear( sizeToRender, mOrigSize ) )
+      {
+        double s = sizeToRender / mOrigSize;
+        scale.scale( s, s );
+      }
+      QPainterPath path;
+      path.addText( -chrOffset.x(), -chrOffset.y(), mFont, charToRender );
+      if ( mStampCache->drawNewStamp( p, point + offset, key, scale.map( path ), p->pen(), mBrush ) )
+        return;
+    }
+  }
+
+  p->save();
+
   transform.translate( point.x() + offset.x(), point.y() + offset.y() );
 
   if ( !qgsDoubleNear( angle, 0.0 ) )
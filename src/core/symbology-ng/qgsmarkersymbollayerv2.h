@@ -32,6 +32,8 @@
 #include <QPolygonF>
 #include <QFont>
 
+class QgsMarkerStampCache;
+
 /** \ingroup core
  * \class QgsSimpleMarkerSymbolLayerBase
  * \brief Abstract base class for simple marker symbol layers. Handles creation of the symbol shapes but
@@ -226,6 +228,8 @@ class CORE_EXPORT QgsSimpleMarkerSymbolLayerV2 : public QgsSimpleMarkerSymbolLay
                                   const QColor& borderColor = DEFAULT_SIMPLEMARKER_BORDERCOLOR,
                                   Qt::PenJoinStyle penJoinStyle = DEFAULT_SIMPLEMARKER_JOINSTYLE );
 
+    ~QgsSimpleMarkerSymbolLayerV2();
+
     // static methods
 
     /** Creates a new QgsSimpleMarkerSymbolLayerV2.
@@ -244,6 +248,7 @@ class CORE_EXPORT QgsSimpleMarkerSymbolLayerV2 : public QgsSimpleMarkerSymbolLay
 
     QString layerType() const override;
     void startRender( QgsSymbolV2RenderContext& context ) override;
+    void stopRender( QgsSymbolV2RenderContext& context ) override;
     void renderPoint( QPointF point, QgsSymbolV2RenderContext& context ) override;
     QgsStringMap properties() const override;
     QgsSimpleMarkerSymbolLayerV2* clone() const override;
@@ -420,6 +425,15 @@ class CORE_EXPORT QgsSimpleMarkerSymbolLayerV2 : public QgsSimpleMarkerSymbolLay
   private:
 
     virtual void draw( QgsSymbolV2RenderContext& context, Shape shape, const QPolygonF& polygon, const QPainterPath& path ) override;
+
+    //! Updates pens and brush from data defined colors and outline properties
+    void prepareDataDefinedStyle( QgsSymbolV2RenderContext& context );
+
+    //! Draws the marker from a cached stamp, returns false if it has to be painted directly
+    bool renderPointStamp( QPointF point, QgsSymbolV2RenderContext& context );
+
+    //! Stamps of markers with data defined rotation, size or colors, only set while rendering
+    QgsMarkerStampCache* mStampCache;
 };
 
 /** \ingroup core
@@ -661,6 +675,9 @@ class CORE_EXPORT QgsFontMarkerSymbolLayerV2 : public QgsMarkerSymbolLayerV2
     QPen mPen;
     QBrush mBrush;
 
+    //! Stamps of rendered characters, only set while rendering
+    QgsMarkerStampCache* mStampCache;
+
     QString characterToRender( QgsSymbolV2RenderContext& context, QPointF& charOffset, double& charWidth );
     void calculateOffsetAndRotation( QgsSymbolV2RenderContext& context, double scaledSize, bool& hasDataDefinedRotation, QPointF& offset, double& angle ) const;
     double calculateSize( QgsSymbolV2RenderContext& context );
@@ -34,6 +34,369 @@
 #include <QDomElement>
 #include <QUuid>
 
+#include <cfloat>
+#include <limits>
+
+//! Minimum number of rules with recognized filters for which an index is built
+static const int MIN_INDEXED_RULES = 4;
+
+//! Same as the check of QgsExpression whether a value is compared as a number
+static bool isDoubleSafe( const QVariant& v )
+{
+  switch ( v.type() )
+  {
+    case QVariant::Double:
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+      return true;
+    case QVariant::String:
+    {
+      bool ok;
+      double value = v.toString().toDouble( &ok );
+      return ok && qIsFinite( value ) && !qIsNaN( value );
+    }
+    default:
+      return false;
+  }
+}
+
+/**
+ * Index of filters of a list of rules which selects the rules whose filter may accept
+ * a feature without evaluating their expressions.
+ *
+ * Filters comparing a field with literal values ("field" = value, "field" IN (values))
+ * are looked up in hashes, numeric ranges of a field ("field" >= a AND "field" < b) in an
+ * interval list. The comparisons follow the rules of QgsExpression (numeric comparison
+ * if both values are numbers, string comparison otherwise), so that the selected rules
+ * are exactly those whose filter would be true. Rules with other filters are always selected
+ * and their expressions evaluated.
+ */
+class QgsRuleFilterIndex
+{
+  public:
+
+    /** Creates index of filters of rules. Returns nullptr if there are too few rules with
+     * recognized filters to make the index useful.
+     */
+    static QgsRuleFilterIndex* create( const QgsRuleBasedRendererV2::RuleList& rules, const QgsFields& fields );
+
+    /** Returns flags for each rule of the index (in the order of creation), true if the filter
+     * of the rule may accept the feature. The returned vector is reused by the next call.
+     */
+    const QVector<bool>& candidates( const QgsFeature& feature ) const;
+
+  private:
+
+    struct Range
+    {
+      Range()
+          : minimum( -std::numeric_limits<double>::infinity() )
+          , minimumInclusive( false )
+          , maximum( std::numeric_limits<double>::infinity() )
+          , maximumInclusive( false )
+          , rule( -1 )
+      {}
+
+      bool contains( double value ) const
+      {
+        return ( value > minimum || ( minimumInclusive && value == minimum ) )
+               && ( value < maximum || ( maximumInclusive && value == maximum ) );
+      }
+
+      bool operator<( const Range& other ) const { return minimum < other.minimum; }
+
+      double minimum;
+      bool minimumInclusive;
+      double maximum;
+      bool maximumInclusive;
+      int rule;
+    };
+
+    struct FieldIndex
+    {
+      //! rules by numeric literal
+      QMultiMap<double, int> numbers;
+      //! rules by string form of numeric literal
+      QMultiHash<QString, int> numberStrings;
+      //! rules by non-numeric literal
+      QMultiHash<QString, int> strings;
+      //! numeric ranges sorted by lower bound
+      QVector<Range> ranges;
+      //! highest upper bound of the ranges up to each position
+      QVector<double> rangeMaxima;
+    };
+
+    QgsRuleFilterIndex() {}
+
+    static bool fieldAndLiteral( const QgsExpression::Node* left, const QgsExpression::Node* right, const QgsFields& fields, int& field, QVariant& literal, bool& swapped );
+    bool addEquality( const QgsExpression::Node* node, const QgsFields& fields, int rule );
+    static bool toRange( const QgsExpression::Node* node, const QgsFields& fields, int& field, Range& range );
+    bool addRange( const QgsExpression::Node* node, const QgsFields& fields, int rule );
+    void markRules( const QMultiHash<QString, int>& rules, const QString& value ) const;
+
+    QMap<int, FieldIndex> mFields;
+    QList<int> mAlwaysCandidates;
+    mutable QVector<bool> mCandidates;
+};
+
+QgsRuleFilterIndex* QgsRuleFilterIndex::create( const QgsRuleBasedRendererV2::RuleList& rules, const QgsFields& fields )
+{
+  QgsRuleFilterIndex* index = new QgsRuleFilterIndex();
+  index->mCandidates.resize( rules.count() );
+
+  int indexed = 0;
+  for ( int i = 0; i < rules.count(); ++i )
+  {
+    QgsRuleBasedRendererV2::Rule* rule = rules.at( i );
+    const QgsExpression::Node* node = rule->filter() && !rule->isElse() ? rule->filter()->rootNode() : nullptr;
+    if ( node && ( index->addEquality( node, fields, i ) || index->addRange( node, fields, i ) ) )
+      ++indexed;
+    else
+      index->mAlwaysCandidates << i;
+  }
+
+  if ( indexed < MIN_INDEXED_RULES )
+  {
+    delete index;
+    return nullptr;
+  }
+
+  for ( QMap<int, FieldIndex>::iterator it = index->mFields.begin(); it != index->mFields.end(); ++it )
+  {
+    FieldIndex& fieldIndex = it.value();
+    qStableSort( fieldIndex.ranges );
+    double maximum = -std::numeric_limits<double>::infinity();
+    Q_FOREACH ( const Range& range, fieldIndex.ranges )
+    {
+      maximum = qMax( maximum, range.maximum );
+      fieldIndex.rangeMaxima << maximum;
+    }
+  }
+  return index;
+}
+
+bool QgsRuleFilterIndex::fieldAndLiteral( const QgsExpression::Node* left, const QgsExpression::Node* right, const QgsFields& fields, int& field, QVariant& literal, bool& swapped )
+{
+  swapped = left->nodeType() == QgsExpression::ntLiteral;
+  if ( swapped )
+    qSwap( left, right );
+  if ( left->nodeType() != QgsExpression::ntColumnRef || right->nodeType() != QgsExpression::ntLiteral )
+    return false;
+
+  field = fields.fieldNameIndex( static_cast< const QgsExpression::NodeColumnRef* >( left )->name() );
+  literal = static_cast< const QgsExpression::NodeLiteral* >( right )->value();
+  return field >= 0;
+}
+
+bool QgsRuleFilterIndex::addEquality( const QgsExpression::Node* node, const QgsFields& fields, int rule )
+{
+  int field = -1;
+  QList<QVariant> values;
+  if ( node->nodeType() == QgsExpression::ntBinaryOperator )
+  {
+    const QgsExpression::NodeBinaryOperator* op = static_cast< const QgsExpression::NodeBinaryOperator* >( node );
+    QVariant literal;
+    bool swapped;
+    if ( op->op() != QgsExpression::boEQ || !fieldAndLiteral( op->opLeft(), op->opRight(), fields, field, literal, swapped ) )
+      return false;
+    values << literal;
+  }
+  else if ( node->nodeType() == QgsExpression::ntInOperator )
+  {
+    const QgsExpression::NodeInOperator* op = static_cast< const QgsExpression::NodeInOperator* >( node );
+    if ( op->isNotIn() || op->node()->nodeType() != QgsExpression::ntColumnRef )
+      return false;
+    field = fields.fieldNameIndex( static_cast< const QgsExpression::NodeColumnRef* >( op->node() )->name() );
+    if ( field < 0 )
+      return false;
+    Q_FOREACH ( const QgsExpression::Node* item, op->list()->list() )
+    {
+      if ( item->nodeType() != QgsExpression::ntLiteral )
+        return false;
+      values << static_cast< const QgsExpression::NodeLiteral* >( item )->value();
+    }
+  }
+  else
+  {
+    return false;
+  }
+
+  FieldIndex& fieldIndex = mFields[field];
+  Q_FOREACH ( const QVariant& value, values )
+  {
+    // NULL is never equal to anything
+    if ( value.isNull() )
+      continue;
+
+    if ( isDoubleSafe( value ) )
+    {
+      fieldIndex.numbers.insert( value.toDouble(), rule );
+      fieldIndex.numberStrings.insert( value.toString(), rule );
+    }
+    else
+    {
+      fieldIndex.strings.insert( value.toString(), rule );
+    }
+  }
+  return true;
+}
+
+bool QgsRuleFilterIndex::toRange( const QgsExpression::Node* node, const QgsFields& fields, int& field, Range& range )
+{
+  if ( node->nodeType() != QgsExpression::ntBinaryOperator )
+    return false;
+
+  const QgsExpression::NodeBinaryOperator* op = static_cast< const QgsExpression::NodeBinaryOperator* >( node );
+  if ( op->op() == QgsExpression::boAnd )
+  {
+    int rightField = -1;
+    Range rightRange;
+    if ( !toRange( op->opLeft(), fields, field, range ) || !toRange( op->opRight(), fields, rightField, rightRange ) || field != rightField )
+      return false;
+
+    if ( rightRange.minimum > range.minimum || ( rightRange.minimum == range.minimum && !rightRange.minimumInclusive ) )
+    {
+      range.minimum = rightRange.minimum;
+      range.minimumInclusive = rightRange.minimumInclusive;
+    }
+    if ( rightRange.maximum < range.maximum || ( rightRange.maximum == range.maximum && !rightRange.maximumInclusive ) )
+    {
+      range.maximum = rightRange.maximum;
+      range.maximumInclusive = rightRange.maximumInclusive;
+    }
+    return true;
+  }
+
+  QgsExpression::BinaryOperator comparison = op->op();
+  if ( comparison != QgsExpression::boLT && comparison != QgsExpression::boLE && comparison != QgsExpression::boGT && comparison != QgsExpression::boGE )
+    return false;
+
+  QVariant literal;
+  bool swapped;
+  if ( !fieldAndLiteral( op->opLeft(), op->opRight(), fields, field, literal, swapped ) || literal.isNull() || !isDoubleSafe( literal ) )
+    return false;
+
+  if ( swapped )
+  {
+    // literal on the left side: 5 < "field" is "field" > 5
+    switch ( comparison )
+    {
+      case QgsExpression::boLT:
+        comparison = QgsExpression::boGT;
+        break;
+      case QgsExpression::boLE:
+        comparison = QgsExpression::boGE;
+        break;
+      case QgsExpression::boGT:
+        comparison = QgsExpression::boLT;
+        break;
+      default:
+        comparison = QgsExpression::boLE;
+        break;
+    }
+  }
+
+  double value = literal.toDouble();
+  if ( comparison == QgsExpression::boGT || comparison == QgsExpression::boGE )
+  {
+    range.minimum = value;
+    range.minimumInclusive = comparison == QgsExpression::boGE;
+  }
+  else
+  {
+    range.maximum = value;
+    range.maximumInclusive = comparison == QgsExpression::boLE;
+  }
+  return true;
+}
+
+bool QgsRuleFilterIndex::addRange( const QgsExpression::Node* node, const QgsFields& fields, int rule )
+{
+  int field = -1;
+  Range range;
+  if ( !toRange( node, fields, field, range ) )
+    return false;
+
+  range.rule = rule;
+  mFields[field].ranges << range;
+  return true;
+}
+
+const QVector<bool>& QgsRuleFilterIndex::candidates( const QgsFeature& feature ) const
+{
+  mCandidates.fill( false );
+  Q_FOREACH ( int rule, mAlwaysCandidates )
+    mCandidates[rule] = true;
+
+  for ( QMap<int, FieldIndex>::const_iterator it = mFields.constBegin(); it != mFields.constEnd(); ++it )
+  {
+    QVariant value = feature.attribute( it.key() );
+    // comparisons with NULL are never true
+    if ( value.isNull() )
+      continue;
+
+    const FieldIndex& fieldIndex = it.value();
+    bool isNumber = isDoubleSafe( value );
+    if ( !fieldIndex.strings.isEmpty() || ( !isNumber && !fieldIndex.numberStrings.isEmpty() ) )
+    {
+      QString string = value.toString();
+      markRules( fieldIndex.strings, string );
+      if ( !isNumber )
+      {
+        // compared as strings by the expressions
+        markRules( fieldIndex.numberStrings, string );
+      }
+    }
+
+    if ( !isNumber )
+    {
+      // ranges are compared as strings as well, leave it to the expressions
+      Q_FOREACH ( const Range& range, fieldIndex.ranges )
+        mCandidates[range.rule] = true;
+      continue;
+    }
+
+    double number = value.toDouble();
+    if ( !fieldIndex.numbers.isEmpty() )
+    {
+      // equality of numbers allows for a small difference, see qgsDoubleNear()
+      double epsilon = 4 * DBL_EPSILON;
+      QMultiMap<double, int>::const_iterator numberIt = fieldIndex.numbers.lowerBound( number - epsilon );
+      for ( ; numberIt != fieldIndex.numbers.constEnd() && numberIt.key() <= number + epsilon; ++numberIt )
+      {
+        if ( qgsDoubleNear( number - numberIt.key(), 0.0 ) )
+          mCandidates[numberIt.value()] = true;
+      }
+    }
+
+    if ( !fieldIndex.ranges.isEmpty() )
+    {
+      // ranges starting at or below the value, scanned back while they may reach the value
+      Range key;
+      key.minimum = number;
+      int i = qUpperBound( fieldIndex.ranges.constBegin(), fieldIndex.ranges.constEnd(), key ) - fieldIndex.ranges.constBegin();
+      for ( --i; i >= 0 && fieldIndex.rangeMaxima.at( i ) >= number; --i )
+      {
+        const Range& range = fieldIndex.ranges.at( i );
+        if ( range.contains( number ) )
+          mCandidates[range.rule] = true;
+      }
+    }
+  }
+  return mCandidates;
+}
+
+void QgsRuleFilterIndex::markRules( const QMultiHash<QString, int>& rules, const QString& value ) const
+{
+  QMultiHash<QString, int>::const_iterator it = rules.constFind( value );
+  for ( ; it != rules.constEnd() && it.key() == value; ++it )
+  {
+    mCandidates[it.value()] = true;
+  }
+}
+
 
 QgsRuleBasedRendererV2::Rule::Rule( QgsSymbolV2* symbol, int scaleMinDenom, int scaleMaxDenom, const QString& filterExp, const QString& label, const QString& description, bool elseRule )
     : mParent( nullptr )
@@ -46,6 +409,8 @@ QgsRuleBasedRendererV2::Rule::Rule( QgsSymbolV2* symbol, int scaleMinDenom, int
     , mElseRule( elseRule )
     , mIsActive( true )
     , mFilter( nullptr )
+    , mChildrenIndex( nullptr )
+    , mActiveChildrenIndex( nullptr )
 {
   if ( mElseRule )
     mFilterExp = "ELSE";
@@ -58,6 +423,8 @@ QgsRuleBasedRendererV2::Rule::~Rule()
 {
   delete mSymbol;
   delete mFilter;
+  delete mChildrenIndex;
+  delete mActiveChildrenIndex;
   qDeleteAll( mChildren );
   // do NOT delete parent
 }
@@ -275,8 +642,17 @@ bool QgsRuleBasedRendererV2::Rule::isFilterOK( QgsFeature& f, QgsRenderContext*
     return true;
 
   context->expressionContext().setFeature( f );
+
+  // the filter is tested several times per feature, eg when checking whether it will be rendered for
+  // labeling and when rendering it
+  QString cacheKey = QString( "rulefilter:%1" ).arg( mRuleKey );
+  if ( context->expressionContext().hasCachedFeatureValue( f, cacheKey ) )
+    return context->expressionContext().cachedFeatureValue( f, cacheKey ).toBool();
+
   QVariant res = mFilter->evaluate( &context->expressionContext() );
-  return res.toInt() != 0;
+  bool ok = res.toInt() != 0;
+  context->expressionContext().setCachedFeatureValue( f, cacheKey, ok );
+  return ok;
 }
 
 bool QgsRuleBasedRendererV2::Rule::isScaleOK( double scale ) const
@@ -435,6 +811,10 @@ bool QgsRuleBasedRendererV2::Rule::startRender( QgsRenderContext& context, const
 bool QgsRuleBasedRendererV2::Rule::startRender( QgsRenderContext& context, const QgsFields& fields, QString& filter )
 {
   mActiveChildren.clear();
+  delete mChildrenIndex;
+  mChildrenIndex = nullptr;
+  delete mActiveChildrenIndex;
+  mActiveChildrenIndex = nullptr;
 
   if ( ! mIsActive )
     return false;
@@ -463,6 +843,10 @@ bool QgsRuleBasedRendererV2::Rule::startRender( QgsRenderContext& context, const
     }
   }
 
+  // index filters of children, so that only rules which may match a feature are evaluated
+  mChildrenIndex = QgsRuleFilterIndex::create( mChildren, fields );
+  mActiveChildrenIndex = QgsRuleFilterIndex::create( mActiveChildren, fields );
+
   // subfilters (on the same level) are joined with OR
   // Finally they are joined with their parent (this) with AND
   QString sf;
@@ -568,10 +952,12 @@ QgsRuleBasedRendererV2::Rule::RenderResult QgsRuleBasedRendererV2::Rule::renderF
   bool willrendersomething = false;
 
   // process children
-  Q_FOREACH ( Rule* rule, mChildren )
+  const QVector<bool>* candidates = mChildrenIndex ? &mChildrenIndex->candidates( featToRender.feat ) : nullptr;
+  for ( int i = 0; i < mChildren.count(); ++i )
   {
-    // Don't process else rules yet
-    if ( !rule->isElse() )
+    Rule* rule = mChildren.at( i );
+    // Don't process else rules yet, skip rules whose filter cannot match
+    if ( !rule->isElse() && ( !candidates || candidates->at( i ) ) )
     {
       RenderResult res = rule->renderFeature( featToRender, context, renderQueue );
       // consider inactive items as "rendered" so the else rule will ignore them
@@ -603,9 +989,10 @@ bool QgsRuleBasedRendererV2::Rule::willRenderFeature( QgsFeature& feat, QgsRende
   if ( mSymbol )
     return true;
 
-  Q_FOREACH ( Rule* rule, mActiveChildren )
+  const QVector<bool>* candidates = mActiveChildrenIndex ? &mActiveChildrenIndex->candidates( feat ) : nullptr;
+  for ( int i = 0; i < mActiveChildren.count(); ++i )
   {
-    if ( rule->willRenderFeature( feat, context ) )
+    if ( ( !candidates || candidates->at( i ) ) && mActiveChildren.at( i )->willRenderFeature( feat, context ) )
       return true;
   }
   return false;
@@ -619,9 +1006,11 @@ QgsSymbolV2List QgsRuleBasedRendererV2::Rule::symbolsForFeature( QgsFeature& fea
   if ( mSymbol )
     lst.append( mSymbol );
 
-  Q_FOREACH ( Rule* rule, mActiveChildren )
+  const QVector<bool>* candidates = mActiveChildrenIndex ? &mActiveChildrenIndex->candidates( feat ) : nullptr;
+  for ( int i = 0; i < mActiveChildren.count(); ++i )
   {
-    lst += rule->symbolsForFeature( feat, context );
+    if ( !candidates || candidates->at( i ) )
+      lst += mActiveChildren.at( i )->symbolsForFeature( feat, context );
   }
   return lst;
 }
@@ -633,9 +1022,11 @@ QSet<QString> QgsRuleBasedRendererV2::Rule::legendKeysForFeature( QgsFeature& fe
     return lst;
   lst.insert( mRuleKey );
 
-  Q_FOREACH ( Rule* rule, mActiveChildren )
+  const QVector<bool>* candidates = mActiveChildrenIndex ? &mActiveChildrenIndex->candidates( feat ) : nullptr;
+  for ( int i = 0; i < mActiveChildren.count(); ++i )
   {
-    lst.unite( rule->legendKeysForFeature( feat, context ) );
+    if ( !candidates || candidates->at( i ) )
+      lst.unite( mActiveChildren.at( i )->legendKeysForFeature( feat, context ) );
   }
   return lst;
 }
@@ -649,9 +1040,11 @@ QgsRuleBasedRendererV2::RuleList QgsRuleBasedRendererV2::Rule::rulesForFeature(
   if ( mSymbol )
     lst.append( this );
 
-  Q_FOREACH ( Rule* rule, mActiveChildren )
+  const QVector<bool>* candidates = mActiveChildrenIndex ? &mActiveChildrenIndex->candidates( feat ) : nullptr;
+  for ( int i = 0; i < mActiveChildren.count(); ++i )
   {
-    lst += rule->rulesForFeature( feat, context );
+    if ( !candidates || candidates->at( i ) )
+      lst += mActiveChildren.at( i )->rulesForFeature( feat, context );
   }
   return lst;
 }
@@ -668,6 +1061,10 @@ void QgsRuleBasedRendererV2::Rule::stopRender( QgsRenderContext& context )
 
   mActiveChildren.clear();
   mSymbolNormZLevels.clear();
+  delete mChildrenIndex;
+  mChildrenIndex = nullptr;
+  delete mActiveChildrenIndex;
+  mActiveChildrenIndex = nullptr;
 }
 
 QgsRuleBasedRendererV2::Rule* QgsRuleBasedRendererV2::Rule::create( QDomElement& ruleElem, QgsSymbolV2Map& symbolMap )
@@ -23,6 +23,7 @@
 #include "qgsrendererv2.h"
 
 class QgsExpression;
+class QgsRuleFilterIndex;
 
 class QgsCategorizedSymbolRendererV2;
 class QgsGraduatedSymbolRendererV2;
@@ -402,6 +403,9 @@ class CORE_EXPORT QgsRuleBasedRendererV2 : public QgsFeatureRendererV2
         // temporary while rendering
         QSet<int> mSymbolNormZLevels;
         RuleList mActiveChildren;
+        // temporary while rendering: indexes of filters of children and active children (may be null)
+        QgsRuleFilterIndex* mChildrenIndex;
+        QgsRuleFilterIndex* mActiveChildrenIndex;
 
       private:
 
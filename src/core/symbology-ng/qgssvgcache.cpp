@@ -36,6 +36,16 @@
 #include <QNetworkReply>
 #include <QNetworkRequest>
 
+#include <cstring>
+
+//! Hash of the exact value of a double
+static uint hashDouble( double value )
+{
+  quint64 bits;
+  memcpy( &bits, &value, sizeof( bits ) );
+  return qHash( bits );
+}
+
 QgsSvgCacheEntry::QgsSvgCacheEntry()
     : file( QString() )
     , size( 0.0 )
@@ -105,6 +115,7 @@ QgsSvgCache::QgsSvgCache( QObject *parent )
     , mTotalSize( 0 )
     , mLeastRecentEntry( nullptr )
     , mMostRecentEntry( nullptr )
+    , mDocumentCache( mMaximumSize / 4 )
 {
   mMissingSvg = QString( "<svg width='10' height='10'><text x='5' y='10' font-size='10' text-anchor='middle'>?</text></svg>" ).toAscii();
 }
@@ -118,7 +129,19 @@ QgsSvgCache::~QgsSvgCache()
 const QImage& QgsSvgCache::svgAsImage( const QString& file, double size, const QColor& fill, const QColor& outline, double outlineWidth,
                                        double widthScaleFactor, double rasterScaleFactor, bool& fitsInCache )
 {
-  QMutexLocker locker( &mMutex );
+  {
+    QReadLocker locker( &mLock );
+    QgsSvgCacheEntry* entry = findEntry( file, size, fill, outline, outlineWidth, widthScaleFactor, rasterScaleFactor );
+    if ( entry && entry->image )
+    {
+      entry->recentlyUsed.fetchAndStoreRelaxed( 1 );
+      mHitCount.ref();
+      fitsInCache = true;
+      return *( entry->image );
+    }
+  }
+
+  QWriteLocker locker( &mLock );
 
   fitsInCache = true;
   QgsSvgCacheEntry* currentEntry = cacheEntry( file, size, fill, outline, outlineWidth, widthScaleFactor, rasterScaleFactor );
@@ -163,7 +186,18 @@ const QImage& QgsSvgCache::svgAsImage( const QString& file, double size, const Q
 const QPicture& QgsSvgCache::svgAsPicture( const QString& file, double size, const QColor& fill, const QColor& outline, double outlineWidth,
     double widthScaleFactor, double rasterScaleFactor, bool forceVectorOutput )
 {
-  QMutexLocker locker( &mMutex );
+  {
+    QReadLocker locker( &mLock );
+    QgsSvgCacheEntry* entry = findEntry( file, size, fill, outline, outlineWidth, widthScaleFactor, rasterScaleFactor );
+    if ( entry && entry->picture )
+    {
+      entry->recentlyUsed.fetchAndStoreRelaxed( 1 );
+      mHitCount.ref();
+      return *( entry->picture );
+    }
+  }
+
+  QWriteLocker locker( &mLock );
 
   QgsSvgCacheEntry* currentEntry = cacheEntry( file, size, fill, outline, outlineWidth, widthScaleFactor, rasterScaleFactor );
 
@@ -181,7 +215,18 @@ const QPicture& QgsSvgCache::svgAsPicture( const QString& file, double size, con
 const QByteArray& QgsSvgCache::svgContent( const QString& file, double size, const QColor& fill, const QColor& outline, double outlineWidth,
     double widthScaleFactor, double rasterScaleFactor )
 {
-  QMutexLocker locker( &mMutex );
+  {
+    QReadLocker locker( &mLock );
+    QgsSvgCacheEntry* entry = findEntry( file, size, fill, outline, outlineWidth, widthScaleFactor, rasterScaleFactor );
+    if ( entry )
+    {
+      entry->recentlyUsed.fetchAndStoreRelaxed( 1 );
+      mHitCount.ref();
+      return entry->svgContent;
+    }
+  }
+
+  QWriteLocker locker( &mLock );
 
   QgsSvgCacheEntry *currentEntry = cacheEntry( file, size, fill, outline, outlineWidth, widthScaleFactor, rasterScaleFactor );
 
@@ -190,7 +235,18 @@ const QByteArray& QgsSvgCache::svgContent( const QString& file, double size, con
 
 QSizeF QgsSvgCache::svgViewboxSize( const QString& file, double size, const QColor& fill, const QColor& outline, double outlineWidth, double widthScaleFactor, double rasterScaleFactor )
 {
-  QMutexLocker locker( &mMutex );
+  {
+    QReadLocker locker( &mLock );
+    QgsSvgCacheEntry* entry = findEntry( file, size, fill, outline, outlineWidth, widthScaleFactor, rasterScaleFactor );
+    if ( entry )
+    {
+      entry->recentlyUsed.fetchAndStoreRelaxed( 1 );
+      mHitCount.ref();
+      return entry->viewboxSize;
+    }
+  }
+
+  QWriteLocker locker( &mLock );
 
   QgsSvgCacheEntry *currentEntry = cacheEntry( file, size, fill, outline, outlineWidth, widthScaleFactor, rasterScaleFactor );
 
@@ -207,7 +263,7 @@ QgsSvgCacheEntry* QgsSvgCache::insertSVG( const QString& file, double size, cons
 
   replaceParamsAndCacheSvg( entry );
 
-  mEntryLookup.insert( file, entry );
+  mEntryLookup.insert( entryKey( file, size, fill, outline, outlineWidth, widthScaleFactor, rasterScaleFactor ), entry );
 
   //insert to most recent place in entry list
   if ( !mMostRecentEntry ) //inserting first entry
@@ -314,8 +370,8 @@ void QgsSvgCache::replaceParamsAndCacheSvg( QgsSvgCacheEntry* entry )
     return;
   }
 
-  QDomDocument svgDoc;
-  if ( !svgDoc.setContent( getImageData( entry->file ) ) )
+  QDomDocument svgDoc = svgDocument( entry->file );
+  if ( svgDoc.isNull() )
   {
     return;
   }
@@ -332,6 +388,28 @@ void QgsSvgCache::replaceParamsAndCacheSvg( QgsSvgCacheEntry* entry )
   mTotalSize += entry->svgContent.size();
 }
 
+QDomDocument QgsSvgCache::svgDocument( const QString& path )
+{
+  QDomDocument* cachedDoc = mDocumentCache.object( path );
+  if ( cachedDoc )
+  {
+    return cachedDoc->cloneNode( true ).toDocument();
+  }
+
+  QByteArray data = getImageData( path );
+  QDomDocument* doc = new QDomDocument();
+  if ( !doc->setContent( data ) )
+  {
+    delete doc;
+    return QDomDocument();
+  }
+
+  // the cache deletes the document right away if it is too large
+  QDomDocument svgDoc = doc->cloneNode( true ).toDocument();
+  mDocumentCache.insert( path, doc, data.size() );
+  return svgDoc;
+}
+
 double QgsSvgCache::calcSizeScaleFactor( QgsSvgCacheEntry* entry, const QDomElement& docElem, QSizeF& viewboxSize ) const
 {
   QString viewBox;
@@ -580,30 +658,18 @@ QgsSvgCacheEntry* QgsSvgCache::cacheEntry( const QString& file, double size, con
     double widthScaleFactor, double rasterScaleFactor )
 {
   //search entries in mEntryLookup
-  QgsSvgCacheEntry* currentEntry = nullptr;
-  QList<QgsSvgCacheEntry*> entries = mEntryLookup.values( file );
-
-  QList<QgsSvgCacheEntry*>::iterator entryIt = entries.begin();
-  for ( ; entryIt != entries.end(); ++entryIt )
-  {
-    QgsSvgCacheEntry* cacheEntry = *entryIt;
-    if ( qgsDoubleNear( cacheEntry->size, size ) && cacheEntry->fill == fill && cacheEntry->outline == outline &&
-         qgsDoubleNear( cacheEntry->outlineWidth, outlineWidth ) && qgsDoubleNear( cacheEntry->widthScaleFactor, widthScaleFactor )
-         && qgsDoubleNear( cacheEntry->rasterScaleFactor, rasterScaleFactor ) )
-    {
-      currentEntry = cacheEntry;
-      break;
-    }
-  }
+  QgsSvgCacheEntry* currentEntry = findEntry( file, size, fill, outline, outlineWidth, widthScaleFactor, rasterScaleFactor );
 
   //if not found: create new entry
   //cache and replace params in svg content
   if ( !currentEntry )
   {
+    mMissCount.ref();
     currentEntry = insertSVG( file, size, fill, outline, outlineWidth, widthScaleFactor, rasterScaleFactor );
   }
   else
   {
+    mHitCount.ref();
     takeEntryFromList( currentEntry );
     if ( !mMostRecentEntry ) //list is empty
     {
@@ -625,6 +691,47 @@ QgsSvgCacheEntry* QgsSvgCache::cacheEntry( const QString& file, double size, con
   return currentEntry;
 }
 
+QgsSvgCacheEntry* QgsSvgCache::findEntry( const QString& file, double size, const QColor& fill, const QColor& outline, double outlineWidth,
+    double widthScaleFactor, double rasterScaleFactor ) const
+{
+  uint key = entryKey( file, size, fill, outline, outlineWidth, widthScaleFactor, rasterScaleFactor );
+  QMultiHash< uint, QgsSvgCacheEntry* >::const_iterator entryIt = mEntryLookup.constFind( key );
+  for ( ; entryIt != mEntryLookup.constEnd() && entryIt.key() == key; ++entryIt )
+  {
+    QgsSvgCacheEntry* cacheEntry = entryIt.value();
+    if ( cacheEntry->lookupKey == file && qgsDoubleNear( cacheEntry->size, size ) && cacheEntry->fill == fill && cacheEntry->outline == outline &&
+         qgsDoubleNear( cacheEntry->outlineWidth, outlineWidth ) && qgsDoubleNear( cacheEntry->widthScaleFactor, widthScaleFactor )
+         && qgsDoubleNear( cacheEntry->rasterScaleFactor, rasterScaleFactor ) )
+    {
+      return cacheEntry;
+    }
+  }
+  return nullptr;
+}
+
+uint QgsSvgCache::entryKey( const QString& file, double size, const QColor& fill, const QColor& outline, double outlineWidth,
+                            double widthScaleFactor, double rasterScaleFactor )
+{
+  uint hash = qHash( file );
+  hash = hash * 31 + hashDouble( size );
+  hash = hash * 31 + qHash( fill.rgba() );
+  hash = hash * 31 + qHash( outline.rgba() );
+  hash = hash * 31 + hashDouble( outlineWidth );
+  hash = hash * 31 + hashDouble( widthScaleFactor );
+  hash = hash * 31 + hashDouble( rasterScaleFactor );
+  return hash;
+}
+
+int QgsSvgCache::hitCount() const
+{
+  return mHitCount.fetchAndAddRelaxed( 0 );
+}
+
+int QgsSvgCache::missCount() const
+{
+  return mMissCount.fetchAndAddRelaxed( 0 );
+}
+
 void QgsSvgCache::replaceElemParams( QDomElement& elem, const QColor& fill, const QColor& outline, double outlineWidth )
 {
   if ( elem.isNull() )
@@ -891,10 +998,11 @@ void QgsSvgCache::containsElemParams( const QDomElement& elem, bool& hasFillPara
   }
 }
 
-void QgsSvgCache::removeCacheEntry( const QString& s, QgsSvgCacheEntry* entry )
+void QgsSvgCache::removeCacheEntry( QgsSvgCacheEntry* entry )
 {
+  mEntryLookup.remove( entryKey( entry->lookupKey, entry->size, entry->fill, entry->outline, entry->outlineWidth,
+                                 entry->widthScaleFactor, entry->rasterScaleFactor ), entry );
   delete entry;
-  mEntryLookup.remove( s, entry );
 }
 
 void QgsSvgCache::printEntryList()
@@ -927,9 +1035,22 @@ void QgsSvgCache::trimToMaximumSize()
     entry = entry->nextEntry;
 
     takeEntryFromList( bkEntry );
-    mEntryLookup.remove( bkEntry->lookupKey, bkEntry );
+
+    // entries used since the last trim get a second chance, they are moved to the most recent place
+    // (they were used with read access only, which does not allow to update the list)
+    if ( bkEntry->recentlyUsed.fetchAndStoreRelaxed( 0 ) && mMostRecentEntry )
+    {
+      bkEntry->previousEntry = mMostRecentEntry;
+      bkEntry->nextEntry = nullptr;
+      mMostRecentEntry->nextEntry = bkEntry;
+      mMostRecentEntry = bkEntry;
+      if ( !entry )
+        entry = bkEntry;
+      continue;
+    }
+
     mTotalSize -= bkEntry->dataSize();
-    delete bkEntry;
+    removeCacheEntry( bkEntry );
   }
 }
 
@@ -18,10 +18,13 @@
 #ifndef QGSSVGCACHE_H
 #define QGSSVGCACHE_H
 
+#include <QAtomicInt>
+#include <QCache>
 #include <QColor>
+#include <QDomDocument>
 #include <QMap>
 #include <QMultiHash>
-#include <QMutex>
+#include <QReadWriteLock>
 #include <QString>
 #include <QUrl>
 #include <QObject>
@@ -73,6 +76,13 @@ class CORE_EXPORT QgsSvgCacheEntry
     QgsSvgCacheEntry* nextEntry;
     QgsSvgCacheEntry* previousEntry;
 
+    /** Set when the entry is used without moving it in the list of entries (which
+     * needs exclusive access to the cache), such entries are kept when trimming the cache
+     * @note added in QGIS 2.16
+     * @note not available in python bindings
+     */
+    QAtomicInt recentlyUsed;
+
     /** Don't consider image, picture, last used timestamp for comparison*/
     bool operator==( const QgsSvgCacheEntry& other ) const;
     /** Return memory usage in bytes*/
@@ -194,6 +204,19 @@ class CORE_EXPORT QgsSvgCache : public QObject
     const QByteArray& svgContent( const QString& file, double size, const QColor& fill, const QColor& outline, double outlineWidth,
                                   double widthScaleFactor, double rasterScaleFactor );
 
+    /** Returns the number of requests answered with an existing cache entry.
+     * @note added in QGIS 2.16
+     * @note not available in python bindings
+     */
+    int hitCount() const;
+
+    /** Returns the number of requests which needed a new cache entry (i.e. the SVG content with
+     * replaced parameters was generated).
+     * @note added in QGIS 2.16
+     * @note not available in python bindings
+     */
+    int missCount() const;
+
   signals:
     /** Emit a signal to be caught by qgisapp and display a msg on status bar */
     void statusChanged( const QString&  theStatusQString );
@@ -232,8 +255,8 @@ class CORE_EXPORT QgsSvgCache : public QObject
     void downloadProgress( qint64, qint64 );
 
   private:
-    /** Entry pointers accessible by file name*/
-    QMultiHash< QString, QgsSvgCacheEntry* > mEntryLookup;
+    /** Entry pointers accessible by hash of all parameters, see entryKey()*/
+    QMultiHash< uint, QgsSvgCacheEntry* > mEntryLookup;
     /** Estimated total size of all images, pictures and svgContent*/
     long mTotalSize;
 
@@ -259,7 +282,22 @@ class CORE_EXPORT QgsSvgCache : public QObject
     double calcSizeScaleFactor( QgsSvgCacheEntry* entry, const QDomElement& docElem, QSizeF& viewboxSize ) const;
 
     /** Release memory and remove cache entry from mEntryLookup*/
-    void removeCacheEntry( const QString& s, QgsSvgCacheEntry* entry );
+    void removeCacheEntry( QgsSvgCacheEntry* entry );
+
+    /** Returns hash of all parameters identifying an entry*/
+    static uint entryKey( const QString& file, double size, const QColor& fill, const QColor& outline, double outlineWidth,
+                          double widthScaleFactor, double rasterScaleFactor );
+
+    /** Returns existing entry without changing its position in the list of entries, or nullptr
+     * if there is none. Needs at least read access to the cache.
+     */
+    QgsSvgCacheEntry* findEntry( const QString& file, double size, const QColor& fill, const QColor& outline, double outlineWidth,
+                                 double widthScaleFactor, double rasterScaleFactor ) const;
+
+    /** Returns a copy of the parsed SVG document, parsing it only if it was not parsed before.
+     * Returns null document if the SVG cannot be parsed.
+     */
+    QDomDocument svgDocument( const QString& path );
 
     /** For debugging*/
     void printEntryList();
@@ -267,9 +305,18 @@ class CORE_EXPORT QgsSvgCache : public QObject
     /** SVG content to be rendered if SVG file was not found. */
     QByteArray mMissingSvg;
 
-    //! Mutex to prevent concurrent access to the class from multiple threads at once (may corrupt the entries otherwise).
-    QMutex mMutex;
+    /** Lock to prevent concurrent access to the class from multiple threads at once (may corrupt the entries otherwise).
+     * Existing entries are read with read access, so that threads rendering the same symbols do not block each other.
+     */
+    QReadWriteLock mLock;
+
+    /** Parsed SVG documents (without replaced parameters), by path. They are shared by entries of
+     * different sizes and colors of the same SVG. Needs write access to the cache.
+     */
+    QCache< QString, QDomDocument > mDocumentCache;
 
+    mutable QAtomicInt mHitCount;
+    mutable QAtomicInt mMissCount;
 };
 
 #endif // QGSSVGCACHE_H
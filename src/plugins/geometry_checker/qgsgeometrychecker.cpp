@@ -19,8 +19,10 @@
 #include "utils/qgsfeaturepool.h"
 
 #include <QtConcurrentMap>
+#include <QElapsedTimer>
 #include <QFutureWatcher>
 #include <QMutex>
+#include <QThread>
 #include <QTimer>
 
 
@@ -56,7 +58,29 @@ QFuture<void> QgsGeometryChecker::execute( int *totalSteps )
     }
   }
 
-  QFuture<void> future = QtConcurrent::map( mChecks, RunCheckWrapper( this ) );
+  // Feature checks only look at one feature and its neighbours at a time, so their features are
+  // split into spatial tiles which are checked concurrently. Layer checks (i.e. gaps) need to see
+  // all features at once and run as a single task.
+  mCheckTasks.clear();
+  mCheckTimes.clear();
+  QList<QgsFeatureIds> tiles = mFeaturePool->getTiles( QThread::idealThreadCount() * sTilesPerThread );
+  Q_FOREACH ( const QgsGeometryCheck* check, mChecks )
+  {
+    mCheckTimes.insert( check, 0 );
+    if ( check->getCheckType() <= QgsGeometryCheck::FeatureCheck && !tiles.isEmpty() )
+    {
+      Q_FOREACH ( const QgsFeatureIds& tile, tiles )
+      {
+        mCheckTasks.append( CheckTask( check, tile ) );
+      }
+    }
+    else
+    {
+      mCheckTasks.append( CheckTask( check ) );
+    }
+  }
+
+  QFuture<void> future = QtConcurrent::map( mCheckTasks, RunCheckWrapper( this ) );
 
   QFutureWatcher<void>* watcher = new QFutureWatcher<void>();
   watcher->setFuture( future );
@@ -237,15 +261,19 @@ bool QgsGeometryChecker::fixError( QgsGeometryCheckError* error, int method )
   return true;
 }
 
-void QgsGeometryChecker::runCheck( const QgsGeometryCheck* check )
+void QgsGeometryChecker::runCheck( const CheckTask& task )
 {
   // Run checks
   QList<QgsGeometryCheckError*> errors;
   QStringList messages;
-  check->collectErrors( errors, messages, &mProgressCounter );
+  QElapsedTimer timer;
+  timer.start();
+  task.check->collectErrors( errors, messages, &mProgressCounter, task.ids );
+  qint64 elapsed = timer.elapsed();
   mErrorListMutex.lock();
   mCheckErrors.append( errors );
   mMessages.append( messages );
+  mCheckTimes[task.check] += elapsed;
   mErrorListMutex.unlock();
   Q_FOREACH ( QgsGeometryCheckError* error, errors )
   {
@@ -19,6 +19,7 @@
 
 #include <QFuture>
 #include <QList>
+#include <QMap>
 #include <QMutex>
 #include <QStringList>
 
@@ -40,6 +41,8 @@ class QgsGeometryChecker : public QObject
     bool fixError( QgsGeometryCheckError *error, int method );
     const QList<QgsGeometryCheck*> getChecks() const { return mChecks; }
     const QStringList& getMessages() const { return mMessages; }
+    //! Processing time in milliseconds spent by each check, summed over all threads
+    const QMap<const QgsGeometryCheck*, qint64>& getCheckTimes() const { return mCheckTimes; }
 
   public slots:
     void setMergeAttributeIndex( int mergeAttributeIndex ) { mMergeAttributeIndex = mergeAttributeIndex; }
@@ -50,24 +53,39 @@ class QgsGeometryChecker : public QObject
     void progressValue( int value );
 
   private:
+    //! A check run on a subset of the features, all features if ids is empty
+    struct CheckTask
+    {
+      CheckTask( const QgsGeometryCheck* _check, const QgsFeatureIds& _ids = QgsFeatureIds() )
+          : check( _check )
+          , ids( _ids )
+      {}
+      const QgsGeometryCheck* check;
+      QgsFeatureIds ids;
+    };
+
     class RunCheckWrapper
     {
       public:
         explicit RunCheckWrapper( QgsGeometryChecker* instance ) : mInstance( instance ) {}
-        void operator()( const QgsGeometryCheck* check ) { mInstance->runCheck( check ); }
+        void operator()( const CheckTask& task ) { mInstance->runCheck( task ); }
       private:
         QgsGeometryChecker* mInstance;
     };
 
+    static const int sTilesPerThread = 4;
+
     QList<QgsGeometryCheck*> mChecks;
     QgsFeaturePool* mFeaturePool;
     QList<QgsGeometryCheckError*> mCheckErrors;
     QStringList mMessages;
+    QList<CheckTask> mCheckTasks;
+    QMap<const QgsGeometryCheck*, qint64> mCheckTimes;
     QMutex mErrorListMutex;
     int mMergeAttributeIndex;
     QAtomicInt mProgressCounter;
 
-    void runCheck( const QgsGeometryCheck* check );
+    void runCheck( const CheckTask& task );
 
   private slots:
     void emitProgressValue();
@@ -93,6 +93,12 @@ QgsGeometryCheckerResultTab::~QgsGeometryCheckerResultTab()
 void QgsGeometryCheckerResultTab::finalize()
 {
   ui.tableWidgetErrors->setSortingEnabled( true );
+  QStringList checkTimes;
+  Q_FOREACH ( const QgsGeometryCheck* check, mChecker->getChecks() )
+  {
+    checkTimes.append( tr( "%1: %2 s" ).arg( check->errorDescription() ).arg( mChecker->getCheckTimes().value( check ) / 1000., 0, 'f', 2 ) );
+  }
+  ui.labelCheckTimes->setText( tr( "Check processing times: %1" ).arg( checkTimes.join( ", " ) ) );
   if ( !mChecker->getMessages().isEmpty() )
   {
     QDialog dialog;
@@ -22,12 +22,12 @@
 #include "qgsgeomutils.h"
 
 #include <QMutexLocker>
+#include <QVector>
 #include <qmath.h>
 #include <limits>
 
 QgsFeaturePool::QgsFeaturePool( QgsVectorLayer *layer, bool selectedOnly )
-    : mFeatureCache( sCacheSize )
-    , mLayer( layer )
+    : mLayer( layer )
     , mSelectedOnly( selectedOnly )
 {
   if ( selectedOnly )
@@ -39,39 +39,29 @@ QgsFeaturePool::QgsFeaturePool( QgsVectorLayer *layer, bool selectedOnly )
     mFeatureIds = layer->allFeatureIds();
   }
 
-  // Build spatial index
+  // Read features (attribute values are needed when merging by attribute) and build spatial index
   QgsFeature feature;
-  QgsFeatureRequest req;
-  req.setSubsetOfAttributes( QgsAttributeList() );
-  QgsFeatureIterator it = layer->getFeatures( req );
+  QgsFeatureIterator it = layer->getFeatures();
   while ( it.nextFeature( feature ) )
   {
+    mFeatures.insert( feature.id(), feature );
     mIndex.insertFeature( feature );
   }
 }
 
-bool QgsFeaturePool::get( QgsFeatureId id , QgsFeature& feature )
+bool QgsFeaturePool::get( QgsFeatureId id , QgsFeature& feature ) const
 {
-  QMutexLocker lock( &mLayerMutex );
-  QgsFeature* pfeature = mFeatureCache.object( id );
-  if ( pfeature )
+  QHash<QgsFeatureId, QgsFeature>::const_iterator it = mFeatures.constFind( id );
+  if ( it == mFeatures.constEnd() )
   {
-    //feature was cached
-    feature = *pfeature;
+    return false;
   }
-
-  // Feature not in cache, retrieve from layer
-  pfeature = new QgsFeature();
-  // TODO: avoid always querying all attributes (attribute values are needed when merging by attribute)
-  if ( !mLayer->getFeatures( QgsFeatureRequest( id ) ).nextFeature( *pfeature ) )
+  feature = it.value();
+  // The geometry of the snapshot is shared between threads, hand out a private copy
+  if ( feature.constGeometry() && feature.constGeometry()->geometry() )
   {
-    delete pfeature;
-    return false;
+    feature.setGeometry( new QgsGeometry( feature.constGeometry()->geometry()->clone() ) );
   }
-  //make a copy of pfeature into feature parameter
-  feature = QgsFeature( *pfeature );
-  //ownership of pfeature is transferred to cache
-  mFeatureCache.insert( id, pfeature );
   return true;
 }
 
@@ -79,7 +69,6 @@ void QgsFeaturePool::addFeature( QgsFeature& feature )
 {
   QgsFeatureList features;
   features.append( feature );
-  mLayerMutex.lock();
   mLayer->dataProvider()->addFeatures( features );
   feature.setFeatureId( features.front().id() );
   if ( mSelectedOnly )
@@ -88,7 +77,9 @@ void QgsFeaturePool::addFeature( QgsFeature& feature )
     selectedFeatureIds.insert( feature.id() );
     mLayer->selectByIds( selectedFeatureIds );
   }
-  mLayerMutex.unlock();
+  QgsFeature poolFeature( feature );
+  poolFeature.setGeometry( new QgsGeometry( feature.geometry()->geometry()->clone() ) );
+  mFeatures.insert( feature.id(), poolFeature );
   mIndexMutex.lock();
   mIndex.insertFeature( feature );
   mIndexMutex.unlock();
@@ -105,11 +96,11 @@ void QgsFeaturePool::updateFeature( QgsFeature& feature )
     attribMap.insert( i, feature.attributes().at( i ) );
   }
   changedAttributesMap.insert( feature.id(), attribMap );
-  mLayerMutex.lock();
-  mFeatureCache.remove( feature.id() ); // Remove to force reload on next get()
   mLayer->dataProvider()->changeGeometryValues( geometryMap );
   mLayer->dataProvider()->changeAttributeValues( changedAttributesMap );
-  mLayerMutex.unlock();
+  QgsFeature poolFeature( feature );
+  poolFeature.setGeometry( new QgsGeometry( feature.geometry()->geometry()->clone() ) );
+  mFeatures.insert( feature.id(), poolFeature );
   mIndexMutex.lock();
   mIndex.deleteFeature( feature );
   mIndex.insertFeature( feature );
@@ -121,10 +112,8 @@ void QgsFeaturePool::deleteFeature( QgsFeature& feature )
   mIndexMutex.lock();
   mIndex.deleteFeature( feature );
   mIndexMutex.unlock();
-  mLayerMutex.lock();
-  mFeatureCache.remove( feature.id() );
+  mFeatures.remove( feature.id() );
   mLayer->dataProvider()->deleteFeatures( QgsFeatureIds() << feature.id() );
-  mLayerMutex.unlock();
 }
 
 QgsFeatureIds QgsFeaturePool::getIntersects( const QgsRectangle &rect )
@@ -132,3 +121,51 @@ QgsFeatureIds QgsFeaturePool::getIntersects( const QgsRectangle &rect )
   QMutexLocker lock( &mIndexMutex );
   return QgsFeatureIds::fromList( mIndex.intersects( rect ) );
 }
+
+QList<QgsFeatureIds> QgsFeaturePool::getTiles( int count ) const
+{
+  // Grid over the centers of the feature bounding boxes
+  QHash<QgsFeatureId, QgsPoint> centers;
+  QgsFeatureIds noGeometryIds;
+  QgsRectangle extent;
+  Q_FOREACH ( QgsFeatureId id, mFeatureIds )
+  {
+    QHash<QgsFeatureId, QgsFeature>::const_iterator it = mFeatures.constFind( id );
+    if ( it == mFeatures.constEnd() || !it.value().constGeometry() || !it.value().constGeometry()->geometry() )
+    {
+      noGeometryIds.insert( id );
+      continue;
+    }
+    QgsPoint center = it.value().constGeometry()->geometry()->boundingBox().center();
+    if ( centers.isEmpty() )
+    {
+      extent = QgsRectangle( center, center );
+    }
+    else
+    {
+      extent.combineExtentWith( center.x(), center.y() );
+    }
+    centers.insert( id, center );
+  }
+
+  int side = qMax( 1, qCeil( qSqrt( count ) ) );
+  QVector<QgsFeatureIds> grid( side * side );
+  for ( QHash<QgsFeatureId, QgsPoint>::const_iterator it = centers.constBegin(); it != centers.constEnd(); ++it )
+  {
+    int col = extent.width() > 0 ? qMin( side - 1, static_cast<int>(( it.value().x() - extent.xMinimum() ) / extent.width() * side ) ) : 0;
+    int row = extent.height() > 0 ? qMin( side - 1, static_cast<int>(( it.value().y() - extent.yMinimum() ) / extent.height() * side ) ) : 0;
+    grid[row * side + col].insert( it.key() );
+  }
+  // Features which cannot be located are checked along with the first tile
+  grid[0].unite( noGeometryIds );
+
+  QList<QgsFeatureIds> tiles;
+  Q_FOREACH ( const QgsFeatureIds& tile, grid )
+  {
+    if ( !tile.isEmpty() )
+    {
+      tiles.append( tile );
+    }
+  }
+  return tiles;
+}
@@ -17,9 +17,8 @@
 #ifndef QGS_FEATUREPOOL_H
 #define QGS_FEATUREPOOL_H
 
-#include <QCache>
-#include <QLinkedList>
-#include <QMap>
+#include <QHash>
+#include <QList>
 #include <QMutex>
 #include "qgsfeature.h"
 #include "qgsspatialindex.h"
@@ -27,11 +26,20 @@
 
 class QgsVectorLayer;
 
+/**
+ * Holds the features of the checked layer and a spatial index of them.
+ *
+ * All features are read into an in-memory snapshot when the pool is constructed, so that
+ * get() does not need to access the layer and can be called from concurrently running checks
+ * without locking. Each returned feature receives its own copy of the geometry.
+ * addFeature(), updateFeature() and deleteFeature() modify the snapshot and the layer and
+ * must not be called while checks are running.
+ */
 class QgsFeaturePool
 {
   public:
     QgsFeaturePool( QgsVectorLayer* layer, bool selectedOnly = false );
-    bool get( QgsFeatureId id, QgsFeature& feature );
+    bool get( QgsFeatureId id, QgsFeature& feature ) const;
     void addFeature( QgsFeature &feature );
     void updateFeature( QgsFeature &feature );
     void deleteFeature( QgsFeature &feature );
@@ -41,23 +49,17 @@ class QgsFeaturePool
     bool getSelectedOnly() const { return mSelectedOnly; }
     void clearLayer() { mLayer = nullptr; }
 
-  private:
-    struct MapEntry
-    {
-      MapEntry( QgsFeature* _feature, QLinkedList<QgsFeatureId>::iterator _ageIt )
-          : feature( _feature )
-          , ageIt( _ageIt )
-      {}
-      QgsFeature* feature;
-      QLinkedList<QgsFeatureId>::iterator ageIt;
-    };
-
-    static const int sCacheSize = 1000;
+    /**
+     * Splits the checked features into spatially coherent tiles of a regular grid, according
+     * to the centers of their bounding boxes. Empty tiles are omitted.
+     * @param count approximate number of tiles
+     */
+    QList<QgsFeatureIds> getTiles( int count ) const;
 
-    QCache<QgsFeatureId, QgsFeature> mFeatureCache;
+  private:
+    QHash<QgsFeatureId, QgsFeature> mFeatures;
     QgsVectorLayer* mLayer;
     QgsFeatureIds mFeatureIds;
-    QMutex mLayerMutex;
     QMutex mIndexMutex;
     QgsSpatialIndex mIndex;
     bool mSelectedOnly;
@@ -26,10 +26,21 @@
 #include <qgisinterface.h>
 #include <qgslogger.h>
 #include <qgsmessagelog.h>
+#include <qgsgeometryengine.h>
+#include <qgspointv2.h>
+
+#include <QtConcurrentMap>
+#include <QScopedPointer>
+#include <QThread>
+#include <qmath.h>
+
 #include <cmath>
 #include <set>
 #include <map>
 
+//! approximate number of features of the first layer per tile of the tiled tests
+static const int TILE_FEATURE_COUNT = 5000;
+
 topolTest::topolTest( QgisInterface* qgsIface )
 {
   theQgsInterface = qgsIface;
@@ -122,9 +133,6 @@ topolTest::topolTest( QgisInterface* qgsIface )
 
 topolTest::~topolTest()
 {
-  QMap<QString, QgsSpatialIndex*>::const_iterator lit = mLayerIndexes.constBegin();
-  for ( ; lit != mLayerIndexes.constEnd(); ++lit )
-    delete *lit;
 }
 
 void topolTest::setTestCancelled()
@@ -226,6 +234,7 @@ ErrorList topolTest::checkCloseFeature( double tolerance, QgsVectorLayer* layer1
 }
 #endif
 
+
 ErrorList topolTest::checkDanglingLines( double tolerance, QgsVectorLayer* layer1, QgsVectorLayer* layer2, bool isExtent )
 {
   Q_UNUSED( tolerance );
@@ -240,16 +249,14 @@ ErrorList topolTest::checkDanglingLines( double tolerance, QgsVectorLayer* layer
     return errorList;
   }
 
-  QList<FeatureLayer>::iterator it;
-
-  qDebug() << mFeatureList1.count();
-
   QgsPoint startPoint;
   QgsPoint endPoint;
 
   std::multimap<QgsPoint, QgsFeatureId, PointComparer> endVerticesMap;
 
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
+  // only the end points are kept, the features are streamed
+  QgsFeatureIterator fit = layer1->getFeatures( validatedFeatures( isExtent ? theQgsInterface->mapCanvas()->extent() : QgsRectangle() ) );
+  while ( fit.nextFeature( f ) )
   {
     if ( !( ++i % 100 ) )
       emit progress( i );
@@ -257,7 +264,7 @@ ErrorList topolTest::checkDanglingLines( double tolerance, QgsVectorLayer* layer
     if ( testCancelled() )
       break;
 
-    QgsGeometry* g1 = it->feature.geometry();
+    const QgsGeometry* g1 = f.constGeometry();
 
     if ( !g1 )
     {
@@ -280,8 +287,8 @@ ErrorList topolTest::checkDanglingLines( double tolerance, QgsVectorLayer* layer
         startPoint = line[0];
         endPoint = line[line.size() - 1];
 
-        endVerticesMap.insert( std::pair<QgsPoint, QgsFeatureId>( startPoint, it->feature.id() ) );
-        endVerticesMap.insert( std::pair<QgsPoint, QgsFeatureId>( endPoint, it->feature.id() ) );
+        endVerticesMap.insert( std::pair<QgsPoint, QgsFeatureId>( startPoint, f.id() ) );
+        endVerticesMap.insert( std::pair<QgsPoint, QgsFeatureId>( endPoint, f.id() ) );
 
       }
     }
@@ -290,8 +297,8 @@ ErrorList topolTest::checkDanglingLines( double tolerance, QgsVectorLayer* layer
       QgsPolyline polyline = g1->asPolyline();
       startPoint = polyline[0];
       endPoint = polyline[polyline.size()-1];
-      endVerticesMap.insert( std::pair<QgsPoint, QgsFeatureId>( startPoint, it->feature.id() ) );
-      endVerticesMap.insert( std::pair<QgsPoint, QgsFeatureId>( endPoint, it->feature.id() ) );
+      endVerticesMap.insert( std::pair<QgsPoint, QgsFeatureId>( startPoint, f.id() ) );
+      endVerticesMap.insert( std::pair<QgsPoint, QgsFeatureId>( endPoint, f.id() ) );
     }
   }
 
@@ -342,54 +349,45 @@ ErrorList topolTest::checkDanglingLines( double tolerance, QgsVectorLayer* layer
 
 ErrorList topolTest::checkDuplicates( double tolerance, QgsVectorLayer *layer1, QgsVectorLayer *layer2, bool isExtent )
 {
-  Q_UNUSED( tolerance );
   Q_UNUSED( layer2 );
+  return runTiledTest( &topolTest::checkDuplicatesInTile, tolerance, layer1, layer1, isExtent );
+}
+
+ErrorList topolTest::checkDuplicatesInTile( const TopolTile& tile )
+{
   //TODO: multilines - check all separate pieces
-  int i = 0;
   ErrorList errorList;
 
-  QList<QgsFeatureId> duplicateIds;
-
-  QgsSpatialIndex* index = mLayerIndexes[layer1->id()];
-
-  QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
+  QgsGeometry* canvasExtentPoly = QgsGeometry::fromRect( tile.canvasExtent );
 
-  QMap<QgsFeatureId, FeatureLayer>::const_iterator it;
-  for ( it = mFeatureMap2.constBegin(); it != mFeatureMap2.constEnd(); ++it )
+  QList<FeatureLayer>::const_iterator it;
+  for ( it = tile.features.constBegin(); it != tile.features.constEnd(); ++it )
   {
-    if ( !( ++i % 100 ) )
-      emit progress( i );
-
     QgsFeatureId currentId = it->feature.id();
 
-    if ( duplicateIds.contains( currentId ) )
-    {
-      //is already a duplicate geometry..skip..
-      continue;
-    }
-
-    if ( testCancelled() )
-      break;
-
     const QgsGeometry* g1 = it->feature.constGeometry();
     QgsRectangle bb = g1->boundingBox();
 
-    QList<QgsFeatureId> crossingIds;
-    crossingIds = index->intersects( bb );
+    QScopedPointer<QgsGeometryEngine> g1Engine( QgsGeometry::createGeometryEngine( g1->geometry() ) );
+    g1Engine->prepareGeometry();
 
-    QList<QgsFeatureId>::Iterator cit = crossingIds.begin();
-    QList<QgsFeatureId>::ConstIterator crossingIdsEnd = crossingIds.end();
+    QList<QgsFeatureId> crossingIds;
+    crossingIds = tile.candidateIndex.intersects( bb );
 
-    bool duplicate = false;
+    // equal geometries are reported by the feature with the lowest id
+    QList<const FeatureLayer*> duplicates;
+    bool reported = false;
 
+    QList<QgsFeatureId>::const_iterator cit = crossingIds.constBegin();
+    QList<QgsFeatureId>::const_iterator crossingIdsEnd = crossingIds.constEnd();
     for ( ; cit != crossingIdsEnd; ++cit )
     {
-      duplicate = false;
       // skip itself
-      if ( mFeatureMap2[*cit].feature.id() == it->feature.id() )
+      if ( *cit == currentId )
         continue;
 
-      const QgsGeometry* g2 = mFeatureMap2[*cit].feature.constGeometry();
+      const FeatureLayer& candidate = *tile.candidates.constFind( *cit );
+      const QgsGeometry* g2 = candidate.feature.constGeometry();
       if ( !g2 )
       {
         QgsMessageLog::logMessage( tr( "Invalid second geometry in duplicate geometry test." ), tr( "Topology plugin" ) );
@@ -402,39 +400,45 @@ ErrorList topolTest::checkDuplicates( double tolerance, QgsVectorLayer *layer1,
         continue;
       }
 
-      if ( g1->equals( g2 ) )
+      if ( g1Engine->isEqual( *g2->geometry() ) )
       {
-        duplicate = true;
-        duplicateIds.append( mFeatureMap2[*cit].feature.id() );
+        if ( *cit < currentId )
+        {
+          reported = true;
+          break;
+        }
+        duplicates << &candidate;
       }
+    }
 
-      if ( duplicate )
-      {
-
+    if ( reported )
+    {
+      //is already a duplicate geometry..skip..
+      continue;
+    }
 
-        QList<FeatureLayer> fls;
-        fls << *it << *it;
-        QScopedPointer<QgsGeometry> conflict( new QgsGeometry( *g1 ) );
+    for ( int d = 0; d < duplicates.size(); ++d )
+    {
+      QList<FeatureLayer> fls;
+      fls << *it << *it;
+      QScopedPointer<QgsGeometry> conflict( new QgsGeometry( *g1 ) );
 
-        if ( isExtent )
+      if ( tile.isExtent )
+      {
+        if ( canvasExtentPoly->disjoint( conflict.data() ) )
         {
-          if ( canvasExtentPoly->disjoint( conflict.data() ) )
-          {
-            continue;
-          }
-          if ( canvasExtentPoly->crosses( conflict.data() ) )
-          {
-            conflict.reset( conflict->intersection( canvasExtentPoly ) );
-          }
+          continue;
+        }
+        if ( canvasExtentPoly->crosses( conflict.data() ) )
+        {
+          conflict.reset( conflict->intersection( canvasExtentPoly ) );
         }
-
-        TopolErrorDuplicates* err = new TopolErrorDuplicates( bb, conflict.take(), fls );
-
-        errorList << err;
       }
 
-    }
+      TopolErrorDuplicates* err = new TopolErrorDuplicates( bb, conflict.take(), fls );
 
+      errorList << err;
+    }
   }
   delete canvasExtentPoly;
   return errorList;
@@ -442,74 +446,55 @@ ErrorList topolTest::checkDuplicates( double tolerance, QgsVectorLayer *layer1,
 
 ErrorList topolTest::checkOverlaps( double tolerance, QgsVectorLayer *layer1, QgsVectorLayer *layer2, bool isExtent )
 {
-  Q_UNUSED( tolerance );
   Q_UNUSED( layer2 );
-  int i = 0;
-  ErrorList errorList;
 
   // could be enabled for lines and points too
   // so duplicate rule may be removed?
 
   if ( layer1->geometryType() != QGis::Polygon )
   {
-    return errorList;
+    return ErrorList();
   }
 
-  QList<QgsFeatureId> *duplicateIds = new QList<QgsFeatureId>();
+  return runTiledTest( &topolTest::checkOverlapsInTile, tolerance, layer1, layer1, isExtent );
+}
 
-  QgsSpatialIndex* index = mLayerIndexes[layer1->id()];
-  if ( !index )
-  {
-    qDebug() << "no index present";
-    delete duplicateIds;
-    return errorList;
-  }
+ErrorList topolTest::checkOverlapsInTile( const TopolTile& tile )
+{
+  ErrorList errorList;
 
-  QMap<QgsFeatureId, FeatureLayer>::const_iterator it;
-  for ( it = mFeatureMap2.constBegin(); it != mFeatureMap2.constEnd(); ++it )
-  {
-    if ( !( ++i % 100 ) )
-      emit progress( i );
+  QgsGeometry* canvasExtentPoly = QgsGeometry::fromRect( tile.canvasExtent );
 
+  QList<FeatureLayer>::const_iterator it;
+  for ( it = tile.features.constBegin(); it != tile.features.constEnd(); ++it )
+  {
     QgsFeatureId currentId = it->feature.id();
 
-    if ( duplicateIds->contains( currentId ) )
-    {
-      //is already a duplicate geometry..skip..
-      continue;
-    }
-
-    if ( testCancelled() )
-      break;
-
     const QgsGeometry* g1 = it->feature.constGeometry();
 
     if ( !g1->isGeosValid() )
     {
-      qDebug() << "invalid geometry(g1) found..skipping.." << it->feature.id();
+      qDebug() << "invalid geometry(g1) found..skipping.." << currentId;
       continue;
     }
 
     QgsRectangle bb = g1->boundingBox();
 
-    QList<QgsFeatureId> crossingIds;
-    crossingIds = index->intersects( bb );
-
-    QList<QgsFeatureId>::Iterator cit = crossingIds.begin();
-    QList<QgsFeatureId>::ConstIterator crossingIdsEnd = crossingIds.end();
-
-    bool duplicate = false;
+    QScopedPointer<QgsGeometryEngine> g1Engine( QgsGeometry::createGeometryEngine( g1->geometry() ) );
+    g1Engine->prepareGeometry();
 
-    QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
+    QList<QgsFeatureId> crossingIds;
+    crossingIds = tile.candidateIndex.intersects( bb );
 
+    QList<QgsFeatureId>::const_iterator cit = crossingIds.constBegin();
+    QList<QgsFeatureId>::const_iterator crossingIdsEnd = crossingIds.constEnd();
     for ( ; cit != crossingIdsEnd; ++cit )
     {
-      duplicate = false;
-      // skip itself
-      if ( mFeatureMap2[*cit].feature.id() == it->feature.id() )
+      // report each pair of overlapping features only once, by the feature with the lower id
+      if ( *cit <= currentId )
         continue;
 
-      const QgsGeometry* g2 = mFeatureMap2[*cit].feature.constGeometry();
+      const QgsGeometry* g2 = tile.candidates.constFind( *cit )->feature.constGeometry();
       if ( !g2 )
       {
         QgsMessageLog::logMessage( tr( "Invalid second geometry in overlaps test." ), tr( "Topology plugin" ) );
@@ -524,25 +509,17 @@ ErrorList topolTest::checkOverlaps( double tolerance, QgsVectorLayer *layer1, Qg
 
       if ( !g2->isGeosValid() )
       {
-        QgsMessageLog::logMessage( tr( "Skipping invalid second geometry of feature %1 in overlaps test." ).arg( it->feature.id() ), tr( "Topology plugin" ) );
+        QgsMessageLog::logMessage( tr( "Skipping invalid second geometry of feature %1 in overlaps test." ).arg( *cit ), tr( "Topology plugin" ) );
         continue;
       }
 
-
-      qDebug() << "checking overlap for" << it->feature.id();
-      if ( g1->overlaps( g2 ) )
-      {
-        duplicate = true;
-        duplicateIds->append( mFeatureMap2[*cit].feature.id() );
-      }
-
-      if ( duplicate )
+      if ( g1Engine->overlaps( *g2->geometry() ) )
       {
         QList<FeatureLayer> fls;
         fls << *it << *it;
         QScopedPointer< QgsGeometry > conflictGeom( g1->intersection( g2 ) );
 
-        if ( isExtent )
+        if ( tile.isExtent )
         {
           if ( canvasExtentPoly->disjoint( conflictGeom.data() ) )
           {
@@ -558,13 +535,10 @@ ErrorList topolTest::checkOverlaps( double tolerance, QgsVectorLayer *layer1, Qg
 
         errorList << err;
       }
-
     }
-    delete canvasExtentPoly;
   }
 
-  delete duplicateIds;
-
+  delete canvasExtentPoly;
   return errorList;
 }
 
@@ -585,16 +559,15 @@ ErrorList topolTest::checkGaps( double tolerance, QgsVectorLayer *layer1, QgsVec
     return errorList;
   }
 
-  QList<FeatureLayer>::iterator it;
-  QgsGeometry* g1;
+  const QgsGeometry* g1;
 
   QList<GEOSGeometry*> geomList;
 
-  qDebug() << mFeatureList1.count() << " features in list!";
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
+  // the gaps are found in the union of all polygons, only their GEOS geometries are kept
+  QgsFeature f;
+  QgsFeatureIterator fit = layer1->getFeatures( validatedFeatures( isExtent ? theQgsInterface->mapCanvas()->extent() : QgsRectangle() ) );
+  while ( fit.nextFeature( f ) )
   {
-    qDebug() << "reading features-" << i;
-
     if ( !( ++i % 100 ) )
     {
       emit progress( i );
@@ -605,7 +578,7 @@ ErrorList topolTest::checkGaps( double tolerance, QgsVectorLayer *layer1, QgsVec
       break;
     }
 
-    g1 = it->feature.geometry();
+    g1 = f.constGeometry();
 
     if ( !g1 )
     {
@@ -619,7 +592,7 @@ ErrorList topolTest::checkGaps( double tolerance, QgsVectorLayer *layer1, QgsVec
 
     if ( !g1->isGeosValid() )
     {
-      qDebug() << "invalid geometry found..skipping.." << it->feature.id();
+      qDebug() << "invalid geometry found..skipping.." << f.id();
       continue;
     }
 
@@ -736,16 +709,14 @@ ErrorList topolTest::checkPseudos( double tolerance, QgsVectorLayer *layer1, Qgs
     return errorList;
   }
 
-  QList<FeatureLayer>::iterator it;
-
-  qDebug() << mFeatureList1.count();
-
   QgsPoint startPoint;
   QgsPoint endPoint;
 
   std::multimap<QgsPoint, QgsFeatureId, PointComparer> endVerticesMap;
 
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
+  // only the end points are kept, the features are streamed
+  QgsFeatureIterator fit = layer1->getFeatures( validatedFeatures( isExtent ? theQgsInterface->mapCanvas()->extent() : QgsRectangle() ) );
+  while ( fit.nextFeature( f ) )
   {
     if ( !( ++i % 100 ) )
       emit progress( i );
@@ -753,7 +724,7 @@ ErrorList topolTest::checkPseudos( double tolerance, QgsVectorLayer *layer1, Qgs
     if ( testCancelled() )
       break;
 
-    QgsGeometry* g1 = it->feature.geometry();
+    const QgsGeometry* g1 = f.constGeometry();
 
     if ( !g1 )
     {
@@ -776,8 +747,8 @@ ErrorList topolTest::checkPseudos( double tolerance, QgsVectorLayer *layer1, Qgs
         startPoint = line[0];
         endPoint = line[line.size() - 1];
 
-        endVerticesMap.insert( std::pair<QgsPoint, QgsFeatureId>( startPoint, it->feature.id() ) );
-        endVerticesMap.insert( std::pair<QgsPoint, QgsFeatureId>( endPoint, it->feature.id() ) );
+        endVerticesMap.insert( std::pair<QgsPoint, QgsFeatureId>( startPoint, f.id() ) );
+        endVerticesMap.insert( std::pair<QgsPoint, QgsFeatureId>( endPoint, f.id() ) );
 
       }
     }
@@ -786,8 +757,8 @@ ErrorList topolTest::checkPseudos( double tolerance, QgsVectorLayer *layer1, Qgs
       QgsPolyline polyline = g1->asPolyline();
       startPoint = polyline[0];
       endPoint = polyline[polyline.size()-1];
-      endVerticesMap.insert( std::pair<QgsPoint, QgsFeatureId>( startPoint, it->feature.id() ) );
-      endVerticesMap.insert( std::pair<QgsPoint, QgsFeatureId>( endPoint, it->feature.id() ) );
+      endVerticesMap.insert( std::pair<QgsPoint, QgsFeatureId>( startPoint, f.id() ) );
+      endVerticesMap.insert( std::pair<QgsPoint, QgsFeatureId>( endPoint, f.id() ) );
     }
   }
 
@@ -838,25 +809,18 @@ ErrorList topolTest::checkPseudos( double tolerance, QgsVectorLayer *layer1, Qgs
 
 ErrorList topolTest::checkValid( double tolerance, QgsVectorLayer* layer1, QgsVectorLayer* layer2, bool isExtent )
 {
-  Q_UNUSED( tolerance );
-  Q_UNUSED( layer1 );
   Q_UNUSED( layer2 );
-  Q_UNUSED( isExtent );
+  return runTiledTest( &topolTest::checkValidInTile, tolerance, layer1, nullptr, isExtent );
+}
 
-  int i = 0;
+ErrorList topolTest::checkValidInTile( const TopolTile& tile )
+{
   ErrorList errorList;
-  QgsFeature f;
-
-  QList<FeatureLayer>::Iterator it;
 
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
+  QList<FeatureLayer>::const_iterator it;
+  for ( it = tile.features.constBegin(); it != tile.features.constEnd(); ++it )
   {
-    if ( !( ++i % 100 ) )
-      emit progress( ++i );
-    if ( testCancelled() )
-      break;
-
-    QgsGeometry* g = it->feature.geometry();
+    const QgsGeometry* g = it->feature.constGeometry();
     if ( !g )
     {
       QgsMessageLog::logMessage( tr( "Invalid geometry in validity test." ), tr( "Topology plugin" ) );
@@ -884,49 +848,44 @@ ErrorList topolTest::checkValid( double tolerance, QgsVectorLayer* layer1, QgsVe
 
 ErrorList topolTest::checkPointCoveredBySegment( double tolerance, QgsVectorLayer* layer1, QgsVectorLayer* layer2, bool isExtent )
 {
-  Q_UNUSED( tolerance );
-
-  int i = 0;
-
-  ErrorList errorList;
-
   if ( layer1->geometryType() != QGis::Point )
   {
-    return errorList;
+    return ErrorList();
   }
   if ( layer2->geometryType() == QGis::Point )
   {
-    return errorList;
+    return ErrorList();
   }
 
-  QgsSpatialIndex* index = mLayerIndexes[layer2->id()];
-  QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
-
+  return runTiledTest( &topolTest::checkPointCoveredBySegmentInTile, tolerance, layer1, layer2, isExtent );
+}
 
-  QList<FeatureLayer>::Iterator it;
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
-  {
-    if ( !( ++i % 100 ) )
-      emit progress( i );
+ErrorList topolTest::checkPointCoveredBySegmentInTile( const TopolTile& tile )
+{
+  ErrorList errorList;
 
-    if ( testCancelled() )
-      break;
+  QgsGeometry* canvasExtentPoly = QgsGeometry::fromRect( tile.canvasExtent );
 
-    QgsGeometry* g1 = it->feature.geometry();
+  QList<FeatureLayer>::const_iterator it;
+  for ( it = tile.features.constBegin(); it != tile.features.constEnd(); ++it )
+  {
+    const QgsGeometry* g1 = it->feature.constGeometry();
     QgsRectangle bb = g1->boundingBox();
 
+    QScopedPointer<QgsGeometryEngine> g1Engine( QgsGeometry::createGeometryEngine( g1->geometry() ) );
+    g1Engine->prepareGeometry();
+
     QList<QgsFeatureId> crossingIds;
-    crossingIds = index->intersects( bb );
+    crossingIds = tile.candidateIndex.intersects( bb );
 
-    QList<QgsFeatureId>::Iterator cit = crossingIds.begin();
-    QList<QgsFeatureId>::ConstIterator crossingIdsEnd = crossingIds.end();
+    QList<QgsFeatureId>::const_iterator cit = crossingIds.constBegin();
+    QList<QgsFeatureId>::const_iterator crossingIdsEnd = crossingIds.constEnd();
 
     bool touched = false;
 
     for ( ; cit != crossingIdsEnd; ++cit )
     {
-      QgsFeature& f = mFeatureMap2[*cit].feature;
-      const QgsGeometry* g2 = f.constGeometry();
+      const QgsGeometry* g2 = tile.candidates.constFind( *cit )->feature.constGeometry();
 
       if ( !g2 )
       {
@@ -935,7 +894,7 @@ ErrorList topolTest::checkPointCoveredBySegment( double tolerance, QgsVectorLaye
       }
 
       // test if point touches other geometry
-      if ( g1->touches( g2 ) )
+      if ( g1Engine->touches( *g2->geometry() ) )
       {
         touched = true;
         break;
@@ -946,7 +905,7 @@ ErrorList topolTest::checkPointCoveredBySegment( double tolerance, QgsVectorLaye
     {
       QgsGeometry* conflictGeom = new QgsGeometry( *g1 );
 
-      if ( isExtent )
+      if ( tile.isExtent )
       {
         if ( canvasExtentPoly->disjoint( conflictGeom ) )
         {
@@ -970,16 +929,16 @@ ErrorList topolTest::checkPointCoveredBySegment( double tolerance, QgsVectorLaye
 
 ErrorList topolTest::checkSegmentLength( double tolerance, QgsVectorLayer* layer1, QgsVectorLayer* layer2, bool isExtent )
 {
-  Q_UNUSED( layer1 );
   Q_UNUSED( layer2 );
-  Q_UNUSED( isExtent );
+  return runTiledTest( &topolTest::checkSegmentLengthInTile, tolerance, layer1, nullptr, isExtent );
+}
 
-  int i = 0;
+ErrorList topolTest::checkSegmentLengthInTile( const TopolTile& tile )
+{
   ErrorList errorList;
-  QgsFeature f;
+  double tolerance = tile.tolerance;
 
-
-  QList<FeatureLayer>::iterator it;
+  QList<FeatureLayer>::const_iterator it;
 
   QgsPolygon pol;
 
@@ -991,19 +950,9 @@ ErrorList topolTest::checkSegmentLength( double tolerance, QgsVectorLayer* layer
   TopolErrorShort* err;
   double distance;
 
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
+  for ( it = tile.features.constBegin(); it != tile.features.constEnd(); ++it )
   {
-    if ( !( ++i % 100 ) )
-    {
-      emit progress( i );
-    }
-
-    if ( testCancelled() )
-    {
-      break;
-    }
-
-    QgsGeometry* g1 = it->feature.geometry();
+    const QgsGeometry* g1 = it->feature.constGeometry();
 
 
     // switching by type here, because layer can contain both single and multi version geometries
@@ -1124,41 +1073,39 @@ ErrorList topolTest::checkSegmentLength( double tolerance, QgsVectorLayer* layer
 
 ErrorList topolTest::checkOverlapWithLayer( double tolerance, QgsVectorLayer* layer1, QgsVectorLayer* layer2, bool isExtent )
 {
-  Q_UNUSED( tolerance );
+  return runTiledTest( &topolTest::checkOverlapWithLayerInTile, tolerance, layer1, layer2, isExtent );
+}
 
-  int i = 0;
+ErrorList topolTest::checkOverlapWithLayerInTile( const TopolTile& tile )
+{
   ErrorList errorList;
 
-  bool skipItself = layer1 == layer2;
-  QgsSpatialIndex* index = mLayerIndexes[layer2->id()];
+  bool skipItself = tile.layer1 == tile.layer2;
 
-  QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
+  QgsGeometry* canvasExtentPoly = QgsGeometry::fromRect( tile.canvasExtent );
 
 
-  QList<FeatureLayer>::iterator it;
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
+  QList<FeatureLayer>::const_iterator it;
+  for ( it = tile.features.constBegin(); it != tile.features.constEnd(); ++it )
   {
-    if ( !( ++i % 100 ) )
-      emit progress( i );
-
-    if ( testCancelled() )
-      break;
-
-    QgsGeometry* g1 = it->feature.geometry();
+    const QgsGeometry* g1 = it->feature.constGeometry();
     QgsRectangle bb = g1->boundingBox();
 
+    QScopedPointer<QgsGeometryEngine> g1Engine( QgsGeometry::createGeometryEngine( g1->geometry() ) );
+    g1Engine->prepareGeometry();
+
     QList<QgsFeatureId> crossingIds;
-    crossingIds = index->intersects( bb );
+    crossingIds = tile.candidateIndex.intersects( bb );
 
-    QList<QgsFeatureId>::Iterator cit = crossingIds.begin();
-    QList<QgsFeatureId>::ConstIterator crossingIdsEnd = crossingIds.end();
+    QList<QgsFeatureId>::const_iterator cit = crossingIds.constBegin();
+    QList<QgsFeatureId>::const_iterator crossingIdsEnd = crossingIds.constEnd();
     for ( ; cit != crossingIdsEnd; ++cit )
     {
-      QgsFeature& f = mFeatureMap2[*cit].feature;
-      const QgsGeometry* g2 = f.constGeometry();
+      const FeatureLayer& fl = *tile.candidates.constFind( *cit );
+      const QgsGeometry* g2 = fl.feature.constGeometry();
 
       // skip itself, when invoked with the same layer
-      if ( skipItself && f.id() == it->feature.id() )
+      if ( skipItself && fl.feature.id() == it->feature.id() )
         continue;
 
       if ( !g2 )
@@ -1167,7 +1114,7 @@ ErrorList topolTest::checkOverlapWithLayer( double tolerance, QgsVectorLayer* la
         continue;
       }
 
-      if ( g1->overlaps( g2 ) )
+      if ( g1Engine->overlaps( *g2->geometry() ) )
       {
         QgsRectangle r = bb;
         QgsRectangle r2 = g2->boundingBox();
@@ -1180,7 +1127,7 @@ ErrorList topolTest::checkOverlapWithLayer( double tolerance, QgsVectorLayer* la
           continue;
         }
 
-        if ( isExtent )
+        if ( tile.isExtent )
         {
           if ( canvasExtentPoly->disjoint( conflictGeom.data() ) )
           {
@@ -1195,9 +1142,6 @@ ErrorList topolTest::checkOverlapWithLayer( double tolerance, QgsVectorLayer* la
         //c = new QgsGeometry;
 
         QList<FeatureLayer> fls;
-        FeatureLayer fl;
-        fl.feature = f;
-        fl.layer = layer2;
         fls << *it << fl;
         TopolErrorIntersection* err = new TopolErrorIntersection( r, conflictGeom.take(), fls );
 
@@ -1213,55 +1157,48 @@ ErrorList topolTest::checkOverlapWithLayer( double tolerance, QgsVectorLayer* la
 
 ErrorList topolTest::checkPointCoveredByLineEnds( double tolerance, QgsVectorLayer *layer1, QgsVectorLayer *layer2, bool isExtent )
 {
-  Q_UNUSED( tolerance );
-
-  int i = 0;
-  ErrorList errorList;
-
-
   if ( layer1->geometryType() != QGis::Point )
   {
-    return errorList;
+    return ErrorList();
   }
 
   if ( layer2->geometryType() != QGis::Line )
   {
-    return errorList;
+    return ErrorList();
   }
 
-  QgsSpatialIndex* index = mLayerIndexes[layer2->id()];
-  QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
+  return runTiledTest( &topolTest::checkPointCoveredByLineEndsInTile, tolerance, layer1, layer2, isExtent );
+}
 
+ErrorList topolTest::checkPointCoveredByLineEndsInTile( const TopolTile& tile )
+{
+  ErrorList errorList;
 
-  QList<FeatureLayer>::Iterator it;
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
+  QgsGeometry* canvasExtentPoly = QgsGeometry::fromRect( tile.canvasExtent );
+
+
+  QList<FeatureLayer>::const_iterator it;
+  for ( it = tile.features.constBegin(); it != tile.features.constEnd(); ++it )
   {
-    if ( !( ++i % 100 ) )
-      emit progress( i );
-    if ( testCancelled() )
-      break;
-    QgsGeometry* g1 = it->feature.geometry();
+    const QgsGeometry* g1 = it->feature.constGeometry();
     QgsRectangle bb = g1->boundingBox();
+    QScopedPointer<QgsGeometryEngine> g1Engine( QgsGeometry::createGeometryEngine( g1->geometry() ) );
+    g1Engine->prepareGeometry();
     QList<QgsFeatureId> crossingIds;
-    crossingIds = index->intersects( bb );
-    QList<QgsFeatureId>::Iterator cit = crossingIds.begin();
-    QList<QgsFeatureId>::ConstIterator crossingIdsEnd = crossingIds.end();
+    crossingIds = tile.candidateIndex.intersects( bb );
+    QList<QgsFeatureId>::const_iterator cit = crossingIds.constBegin();
+    QList<QgsFeatureId>::const_iterator crossingIdsEnd = crossingIds.constEnd();
     bool touched = false;
     for ( ; cit != crossingIdsEnd; ++cit )
     {
-      QgsFeature& f = mFeatureMap2[*cit].feature;
-      const QgsGeometry* g2 = f.constGeometry();
+      const QgsGeometry* g2 = tile.candidates.constFind( *cit )->feature.constGeometry();
       if ( !g2 || !g2->asGeos() )
       {
         QgsMessageLog::logMessage( tr( "Second geometry missing or GEOS import failed." ), tr( "Topology plugin" ) );
         continue;
       }
       QgsPolyline g2Line = g2->asPolyline();
-      QgsGeometry* startPoint = QgsGeometry::fromPoint( g2Line.at( 0 ) );
-      QgsGeometry* endPoint = QgsGeometry::fromPoint( g2Line.last() );
-      touched = g1->intersects( startPoint ) || g1->intersects( endPoint );
-      delete startPoint;
-      delete endPoint;
+      touched = g1Engine->intersects( QgsPointV2( g2Line.at( 0 ) ) ) || g1Engine->intersects( QgsPointV2( g2Line.last() ) );
 
       if ( touched )
       {
@@ -1271,7 +1208,7 @@ ErrorList topolTest::checkPointCoveredByLineEnds( double tolerance, QgsVectorLay
     if ( !touched )
     {
       QgsGeometry* conflictGeom = new QgsGeometry( *g1 );
-      if ( isExtent )
+      if ( tile.isExtent )
       {
         if ( canvasExtentPoly->disjoint( conflictGeom ) )
         {
@@ -1294,44 +1231,41 @@ ErrorList topolTest::checkPointCoveredByLineEnds( double tolerance, QgsVectorLay
 
 ErrorList topolTest::checkyLineEndsCoveredByPoints( double tolerance, QgsVectorLayer *layer1, QgsVectorLayer *layer2, bool isExtent )
 {
-  Q_UNUSED( tolerance );
-
-  int i = 0;
-  ErrorList errorList;
-
-
   if ( layer1->geometryType() != QGis::Line )
   {
-    return errorList;
+    return ErrorList();
   }
 
   if ( layer2->geometryType() != QGis::Point )
   {
-    return errorList;
+    return ErrorList();
   }
 
-  QgsSpatialIndex* index = mLayerIndexes[layer2->id()];
+  return runTiledTest( &topolTest::checkyLineEndsCoveredByPointsInTile, tolerance, layer1, layer2, isExtent );
+}
+
+ErrorList topolTest::checkyLineEndsCoveredByPointsInTile( const TopolTile& tile )
+{
+  ErrorList errorList;
 
-  QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
+  QgsGeometry* canvasExtentPoly = QgsGeometry::fromRect( tile.canvasExtent );
 
-  QList<FeatureLayer>::Iterator it;
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
+  QList<FeatureLayer>::const_iterator it;
+  for ( it = tile.features.constBegin(); it != tile.features.constEnd(); ++it )
   {
-    if ( !( ++i % 100 ) )
-      emit progress( i );
-    if ( testCancelled() )
-      break;
-    QgsGeometry* g1 = it->feature.geometry();
+    const QgsGeometry* g1 = it->feature.constGeometry();
 
     QgsPolyline g1Polyline = g1->asPolyline();
-    QgsGeometry* startPoint = QgsGeometry::fromPoint( g1Polyline.at( 0 ) );
-    QgsGeometry* endPoint = QgsGeometry::fromPoint( g1Polyline.last() );
+    QgsPointV2 startPoint( g1Polyline.at( 0 ) );
+    QgsPointV2 endPoint( g1Polyline.last() );
+    QScopedPointer<QgsGeometryEngine> startEngine( QgsGeometry::createGeometryEngine( &startPoint ) );
+    QScopedPointer<QgsGeometryEngine> endEngine( QgsGeometry::createGeometryEngine( &endPoint ) );
 
     QgsRectangle bb = g1->boundingBox();
     QList<QgsFeatureId> crossingIds;
-    crossingIds = index->intersects( bb );
-    QList<QgsFeatureId>::Iterator cit = crossingIds.begin();
-    QList<QgsFeatureId>::ConstIterator crossingIdsEnd = crossingIds.end();
+    crossingIds = tile.candidateIndex.intersects( bb );
+    QList<QgsFeatureId>::const_iterator cit = crossingIds.constBegin();
+    QList<QgsFeatureId>::const_iterator crossingIdsEnd = crossingIds.constEnd();
     bool touched = false;
 
     bool touchStartPoint = false;
@@ -1339,8 +1273,7 @@ ErrorList topolTest::checkyLineEndsCoveredByPoints( double tolerance, QgsVectorL
 
     for ( ; cit != crossingIdsEnd; ++cit )
     {
-      QgsFeature& f = mFeatureMap2[*cit].feature;
-      const QgsGeometry* g2 = f.constGeometry();
+      const QgsGeometry* g2 = tile.candidates.constFind( *cit )->feature.constGeometry();
       if ( !g2 || !g2->asGeos() )
       {
         QgsMessageLog::logMessage( tr( "Second geometry missing or GEOS import failed." ), tr( "Topology plugin" ) );
@@ -1348,12 +1281,12 @@ ErrorList topolTest::checkyLineEndsCoveredByPoints( double tolerance, QgsVectorL
       }
 
 
-      if ( g2->intersects( startPoint ) )
+      if ( startEngine->intersects( *g2->geometry() ) )
       {
         touchStartPoint = true;
       }
 
-      if ( g2->intersects( endPoint ) )
+      if ( endEngine->intersects( *g2->geometry() ) )
       {
         touchEndPoint = true;
       }
@@ -1365,14 +1298,12 @@ ErrorList topolTest::checkyLineEndsCoveredByPoints( double tolerance, QgsVectorL
       }
 
     }
-    delete startPoint;
-    delete endPoint;
 
     if ( !touched )
     {
       QScopedPointer<QgsGeometry> conflictGeom( new QgsGeometry( *g1 ) );
 
-      if ( isExtent )
+      if ( tile.isExtent )
       {
         if ( canvasExtentPoly->disjoint( conflictGeom.data() ) )
         {
@@ -1397,49 +1328,47 @@ ErrorList topolTest::checkyLineEndsCoveredByPoints( double tolerance, QgsVectorL
 
 ErrorList topolTest::checkPointInPolygon( double tolerance, QgsVectorLayer *layer1, QgsVectorLayer *layer2, bool isExtent )
 {
-  Q_UNUSED( tolerance );
-
-  int i = 0;
-  ErrorList errorList;
-
   if ( layer1->geometryType() != QGis::Point )
   {
-    return errorList;
+    return ErrorList();
   }
 
   if ( layer2->geometryType() != QGis::Polygon )
   {
-    return errorList;
+    return ErrorList();
   }
 
-  QgsSpatialIndex* index = mLayerIndexes[layer2->id()];
+  return runTiledTest( &topolTest::checkPointInPolygonInTile, tolerance, layer1, layer2, isExtent );
+}
 
-  QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
+ErrorList topolTest::checkPointInPolygonInTile( const TopolTile& tile )
+{
+  ErrorList errorList;
 
-  QList<FeatureLayer>::Iterator it;
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
+  QgsGeometry* canvasExtentPoly = QgsGeometry::fromRect( tile.canvasExtent );
+
+  QList<FeatureLayer>::const_iterator it;
+  for ( it = tile.features.constBegin(); it != tile.features.constEnd(); ++it )
   {
-    if ( !( ++i % 100 ) )
-      emit progress( i );
-    if ( testCancelled() )
-      break;
-    QgsGeometry* g1 = it->feature.geometry();
+    const QgsGeometry* g1 = it->feature.constGeometry();
     QgsRectangle bb = g1->boundingBox();
+    QScopedPointer<QgsGeometryEngine> g1Engine( QgsGeometry::createGeometryEngine( g1->geometry() ) );
+    g1Engine->prepareGeometry();
     QList<QgsFeatureId> crossingIds;
-    crossingIds = index->intersects( bb );
-    QList<QgsFeatureId>::Iterator cit = crossingIds.begin();
-    QList<QgsFeatureId>::ConstIterator crossingIdsEnd = crossingIds.end();
+    crossingIds = tile.candidateIndex.intersects( bb );
+    QList<QgsFeatureId>::const_iterator cit = crossingIds.constBegin();
+    QList<QgsFeatureId>::const_iterator crossingIdsEnd = crossingIds.constEnd();
     bool touched = false;
     for ( ; cit != crossingIdsEnd; ++cit )
     {
-      QgsFeature& f = mFeatureMap2[*cit].feature;
-      const QgsGeometry* g2 = f.constGeometry();
+      const QgsGeometry* g2 = tile.candidates.constFind( *cit )->feature.constGeometry();
       if ( !g2 || !g2->asGeos() )
       {
         QgsMessageLog::logMessage( tr( "Second geometry missing or GEOS import failed." ), tr( "Topology plugin" ) );
         continue;
       }
-      if ( g2->contains( g1 ) )
+      // the polygon contains the point
+      if ( g1Engine->within( *g2->geometry() ) )
       {
         touched = true;
         break;
@@ -1449,7 +1378,7 @@ ErrorList topolTest::checkPointInPolygon( double tolerance, QgsVectorLayer *laye
     {
       QgsGeometry* conflictGeom = new QgsGeometry( *g1 );
 
-      if ( isExtent )
+      if ( tile.isExtent )
       {
         if ( canvasExtentPoly->disjoint( conflictGeom ) )
         {
@@ -1474,48 +1403,44 @@ ErrorList topolTest::checkPointInPolygon( double tolerance, QgsVectorLayer *laye
 
 ErrorList topolTest::checkPolygonContainsPoint( double tolerance, QgsVectorLayer *layer1, QgsVectorLayer *layer2, bool isExtent )
 {
-  Q_UNUSED( tolerance );
-  Q_UNUSED( isExtent );
-
-  int i = 0;
-  ErrorList errorList;
-
   if ( layer1->geometryType() != QGis::Polygon )
   {
-    return errorList;
+    return ErrorList();
   }
 
   if ( layer2->geometryType() != QGis::Point )
   {
-    return errorList;
+    return ErrorList();
   }
 
-  QgsSpatialIndex* index = mLayerIndexes[layer2->id()];
+  return runTiledTest( &topolTest::checkPolygonContainsPointInTile, tolerance, layer1, layer2, isExtent );
+}
 
-  QList<FeatureLayer>::Iterator it;
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
+ErrorList topolTest::checkPolygonContainsPointInTile( const TopolTile& tile )
+{
+  ErrorList errorList;
+
+  QList<FeatureLayer>::const_iterator it;
+  for ( it = tile.features.constBegin(); it != tile.features.constEnd(); ++it )
   {
-    if ( !( ++i % 100 ) )
-      emit progress( i );
-    if ( testCancelled() )
-      break;
-    QgsGeometry* g1 = it->feature.geometry();
+    const QgsGeometry* g1 = it->feature.constGeometry();
     QgsRectangle bb = g1->boundingBox();
+    QScopedPointer<QgsGeometryEngine> g1Engine( QgsGeometry::createGeometryEngine( g1->geometry() ) );
+    g1Engine->prepareGeometry();
     QList<QgsFeatureId> crossingIds;
-    crossingIds = index->intersects( bb );
-    QList<QgsFeatureId>::Iterator cit = crossingIds.begin();
-    QList<QgsFeatureId>::ConstIterator crossingIdsEnd = crossingIds.end();
+    crossingIds = tile.candidateIndex.intersects( bb );
+    QList<QgsFeatureId>::const_iterator cit = crossingIds.constBegin();
+    QList<QgsFeatureId>::const_iterator crossingIdsEnd = crossingIds.constEnd();
     bool touched = false;
     for ( ; cit != crossingIdsEnd; ++cit )
     {
-      QgsFeature& f = mFeatureMap2[*cit].feature;
-      const QgsGeometry* g2 = f.constGeometry();
+      const QgsGeometry* g2 = tile.candidates.constFind( *cit )->feature.constGeometry();
       if ( !g2 || !g2->asGeos() )
       {
         QgsMessageLog::logMessage( tr( "Second geometry missing or GEOS import failed." ), tr( "Topology plugin" ) );
         continue;
       }
-      if ( g1->contains( g2 ) )
+      if ( g1Engine->contains( *g2->geometry() ) )
       {
         touched = true;
         break;
@@ -1536,21 +1461,17 @@ ErrorList topolTest::checkPolygonContainsPoint( double tolerance, QgsVectorLayer
 
 ErrorList topolTest::checkMultipart( double tolerance, QgsVectorLayer *layer1, QgsVectorLayer *layer2, bool isExtent )
 {
-  Q_UNUSED( tolerance );
   Q_UNUSED( layer2 );
-  Q_UNUSED( layer1 );
-  Q_UNUSED( isExtent );
+  return runTiledTest( &topolTest::checkMultipartInTile, tolerance, layer1, nullptr, isExtent );
+}
 
-  int i = 0;
+ErrorList topolTest::checkMultipartInTile( const TopolTile& tile )
+{
   ErrorList errorList;
-  QList<FeatureLayer>::Iterator it;
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
+  QList<FeatureLayer>::const_iterator it;
+  for ( it = tile.features.constBegin(); it != tile.features.constEnd(); ++it )
   {
-    if ( !( ++i % 100 ) )
-      emit progress( ++i );
-    if ( testCancelled() )
-      break;
-    QgsGeometry* g = it->feature.geometry();
+    const QgsGeometry* g = it->feature.constGeometry();
     if ( !g )
     {
       QgsMessageLog::logMessage( tr( "Missing geometry in multipart check." ), tr( "Topology plugin" ) );
@@ -1571,98 +1492,141 @@ ErrorList topolTest::checkMultipart( double tolerance, QgsVectorLayer *layer1, Q
   return errorList;
 }
 
-void topolTest::fillFeatureMap( QgsVectorLayer* layer, const QgsRectangle& extent )
+QgsFeatureRequest topolTest::validatedFeatures( const QgsRectangle& extent ) const
 {
-  QgsFeatureIterator fit;
   if ( extent.isEmpty() )
   {
-    fit = layer->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ) );
-  }
-  else
-  {
-    fit = layer->getFeatures( QgsFeatureRequest()
-                              .setFilterRect( extent )
-                              .setFlags( QgsFeatureRequest::ExactIntersect )
-                              .setSubsetOfAttributes( QgsAttributeList() ) );
+    return QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() );
   }
 
-  QgsFeature f;
-
-  while ( fit.nextFeature( f ) )
-  {
-    if ( f.constGeometry() )
-    {
-      mFeatureMap2[f.id()] = FeatureLayer( layer, f );
-    }
-  }
+  return QgsFeatureRequest()
+         .setFilterRect( extent )
+         .setFlags( QgsFeatureRequest::ExactIntersect )
+         .setSubsetOfAttributes( QgsAttributeList() );
 }
 
-void topolTest::fillFeatureList( QgsVectorLayer* layer, const QgsRectangle& extent )
+ErrorList topolTest::runTiledTest( tileTestFunction test, double tolerance, QgsVectorLayer* layer1, QgsVectorLayer* layer2, bool isExtent )
 {
-  QgsFeatureIterator fit;
-  if ( extent.isEmpty() )
-  {
-    fit = layer->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ) );
-  }
-  else
+  ErrorList errorList;
+
+  QgsRectangle canvasExtent = theQgsInterface->mapCanvas()->extent();
+  QgsRectangle extent = isExtent ? canvasExtent : layer1->extent();
+
+  // Split the validated extent into a grid of tiles, so that only the features of a few tiles
+  // are in memory at once. Each feature of the first layer belongs to the tile containing the
+  // center of its bounding box, features outside of the extent to the nearest tile.
+  // A single tile is used if the provider does not know the feature count.
+  int side = 1;
+  long featureCount = layer1->featureCount();
+  if ( featureCount > 0 && extent.width() > 0 && extent.height() > 0 )
   {
-    fit = layer->getFeatures( QgsFeatureRequest()
-                              .setFilterRect( extent )
-                              .setFlags( QgsFeatureRequest::ExactIntersect )
-                              .setSubsetOfAttributes( QgsAttributeList() ) );
+    side = qMax( 1, qCeil( qSqrt( static_cast<double>( featureCount ) / TILE_FEATURE_COUNT ) ) );
   }
+  double tileWidth = extent.width() / side;
+  double tileHeight = extent.height() / side;
 
-  QgsFeature f;
+  int batchSize = qMax( 1, QThread::idealThreadCount() );
+  QList<TopolTile> batch;
+  int i = 0;
 
-  while ( fit.nextFeature( f ) )
+  for ( int tileIndex = 0; tileIndex < side * side; ++tileIndex )
   {
-    if ( f.constGeometry() )
+    int row = tileIndex / side;
+    int column = tileIndex % side;
+
+    TopolTile tile;
+    tile.layer1 = layer1;
+    tile.layer2 = layer2;
+    tile.tolerance = tolerance;
+    tile.isExtent = isExtent;
+    tile.canvasExtent = canvasExtent;
+
+    QgsFeatureRequest request = QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() );
+    if ( side > 1 || isExtent )
     {
-      mFeatureList1 << FeatureLayer( layer, f );
+      // the last column and row end exactly at the extent, rounding must not leave out features on its border
+      double xMax = column == side - 1 ? extent.xMaximum() : extent.xMinimum() + ( column + 1 ) * tileWidth;
+      double yMax = row == side - 1 ? extent.yMaximum() : extent.yMinimum() + ( row + 1 ) * tileHeight;
+      request.setFilterRect( QgsRectangle( extent.xMinimum() + column * tileWidth, extent.yMinimum() + row * tileHeight, xMax, yMax ) );
     }
-  }
 
-}
+    QgsRectangle candidateRect;
+    QgsFeature f;
+    QgsFeatureIterator fit = layer1->getFeatures( request );
+    while ( fit.nextFeature( f ) )
+    {
+      const QgsGeometry* g = f.constGeometry();
+      if ( !g || !g->geometry() )
+        continue;
 
-QgsSpatialIndex* topolTest::createIndex( QgsVectorLayer* layer, const QgsRectangle& extent )
-{
-  QgsSpatialIndex* index = new QgsSpatialIndex();
+      QgsRectangle bb = g->boundingBox();
+      if ( side > 1 )
+      {
+        QgsPoint center = bb.center();
+        if ( qBound( 0, qFloor(( center.x() - extent.xMinimum() ) / tileWidth ), side - 1 ) != column ||
+             qBound( 0, qFloor(( center.y() - extent.yMinimum() ) / tileHeight ), side - 1 ) != row )
+          continue;
+      }
 
-  QgsFeatureIterator fit;
-  if ( extent.isEmpty() )
-  {
-    fit = layer->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ) );
-  }
-  else
-  {
-    fit = layer->getFeatures( QgsFeatureRequest()
-                              .setFilterRect( extent )
-                              .setFlags( QgsFeatureRequest::ExactIntersect )
-                              .setSubsetOfAttributes( QgsAttributeList() ) );
-  }
+      if ( isExtent && !g->intersects( canvasExtent ) )
+        continue;
 
+      if ( tile.features.isEmpty() )
+        candidateRect = bb;
+      else
+        candidateRect.combineExtentWith( bb );
 
-  int i = 0;
-  QgsFeature f;
-  while ( fit.nextFeature( f ) )
-  {
-    if ( !( ++i % 100 ) )
-      emit progress( i );
+      // geometries of the edit buffer are shared between reads, the worker threads must not
+      // fill the GEOS cache of a shared geometry
+      f.setGeometry( new QgsGeometry( g->geometry()->clone() ) );
+      tile.features << FeatureLayer( layer1, f );
+    }
 
-    if ( testCancelled() )
+    // features which may interact with the features of the tile
+    if ( layer2 && !tile.features.isEmpty() )
     {
-      delete index;
-      return nullptr;
+      fit = layer2->getFeatures( QgsFeatureRequest().setFilterRect( candidateRect ).setSubsetOfAttributes( QgsAttributeList() ) );
+      while ( fit.nextFeature( f ) )
+      {
+        const QgsGeometry* g = f.constGeometry();
+        if ( !g || !g->geometry() )
+          continue;
+
+        if ( isExtent && !g->intersects( canvasExtent ) )
+          continue;
+
+        f.setGeometry( new QgsGeometry( g->geometry()->clone() ) );
+        tile.candidateIndex.insertFeature( f );
+        tile.candidates.insert( f.id(), FeatureLayer( layer2, f ) );
+      }
     }
 
-    if ( f.constGeometry() )
+    if ( testCancelled() )
+      return errorList;
+
+    if ( !tile.features.isEmpty() )
+      batch << tile;
+
+    if ( batch.size() == batchSize || ( tileIndex == side * side - 1 && !batch.isEmpty() ) )
     {
-      index->insertFeature( f );
-      mFeatureMap2[f.id()] = FeatureLayer( layer, f );
+      // evaluate the tiles of the batch in parallel
+      Q_FOREACH ( const ErrorList& tileErrors, QtConcurrent::blockingMapped( batch, TileTestWrapper( this, test ) ) )
+      {
+        errorList << tileErrors;
+      }
+      Q_FOREACH ( const TopolTile& batchTile, batch )
+      {
+        i += batchTile.features.size();
+      }
+      batch.clear();
+      emit progress( i );
+
+      if ( testCancelled() )
+        break;
     }
   }
 
-  return index;
+  return errorList;
 }
 
 ErrorList topolTest::runTest( const QString& testName, QgsVectorLayer* layer1, QgsVectorLayer* layer2, ValidateType type, double tolerance )
@@ -1682,70 +1646,8 @@ ErrorList topolTest::runTest( const QString& testName, QgsVectorLayer* layer1, Q
     return errors;
   }
 
-  mFeatureList1.clear();
-  mFeatureMap2.clear();
-
-  //checking if new features are not
-  //being recognised due to indexing not being upto date
-
-  mLayerIndexes.clear();
-
-  if ( mTopologyRuleMap[testName].useSecondLayer )
-  {
-    // validate all features or current extent
-    QgsRectangle extent;
-    if ( type == ValidateExtent )
-    {
-      extent = theQgsInterface->mapCanvas()->extent();
-    }
-    else
-    {
-      extent = QgsRectangle();
-    }
-
-    fillFeatureList( layer1, extent );
-    //fillFeatureMap( layer1, extent );
-
-    if ( !mLayerIndexes.contains( layer2->id() ) )
-    {
-      mLayerIndexes[layer2->id()] = createIndex( layer2, extent );
-    }
-  }
-  else
-  {
-    // validate all features or current extent
-    QgsRectangle extent;
-    if ( type == ValidateExtent )
-    {
-      extent = theQgsInterface->mapCanvas()->extent();
-      if ( mTopologyRuleMap[testName].useSpatialIndex )
-      {
-        mLayerIndexes[layer1->id()] = createIndex( layer1, theQgsInterface->mapCanvas()->extent() );
-      }
-      else
-      {
-        fillFeatureList( layer1, extent );
-      }
-    }
-    else
-    {
-      if ( mTopologyRuleMap[testName].useSpatialIndex )
-      {
-        if ( !mLayerIndexes.contains( layer1->id() ) )
-        {
-
-          mLayerIndexes[layer1->id()] = createIndex( layer1, QgsRectangle() );
-        }
-      }
-      else
-      {
-        fillFeatureList( layer1, QgsRectangle() );
-      }
-    }
-
-  }
-
   //call test routine
+  //features are read by the test itself, so newly added features are always recognised
   bool isValidatingExtent;
   if ( type == ValidateExtent )
   {
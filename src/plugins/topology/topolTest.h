@@ -18,6 +18,7 @@
 #ifndef TOPOLTEST_H
 #define TOPOLTEST_H
 
+#include <QHash>
 #include <QObject>
 
 #include <qgsvectorlayer.h>
@@ -27,12 +28,14 @@
 #include "topolError.h"
 
 class topolTest;
+class TopolTile;
 class QgisInterface;
 class WKTReader;
 
 enum ValidateType { ValidateAll, ValidateExtent, ValidateSelected };
 
 typedef ErrorList( topolTest::*testFunction )( double, QgsVectorLayer*, QgsVectorLayer*, bool );
+typedef ErrorList( topolTest::*tileTestFunction )( const TopolTile& );
 
 class TopologyRule
 {
@@ -98,6 +101,35 @@ class PointComparer
 };
 
 
+/**
+  features of the first layer within one tile of the validated extent
+  together with the features which may interact with them
+  */
+class TopolTile
+{
+  public:
+    TopolTile()
+        : layer1( nullptr )
+        , layer2( nullptr )
+        , tolerance( 0 )
+        , isExtent( false )
+    {}
+
+    QgsVectorLayer* layer1;
+    QgsVectorLayer* layer2;
+    double tolerance;
+    bool isExtent;
+    //! canvas extent, conflicts are clipped to it when validating the extent
+    QgsRectangle canvasExtent;
+    //! features of the first layer whose bounding box center lies in the tile
+    QList<FeatureLayer> features;
+    //! features of the second layer (or the first one for tests within a layer) intersecting the bounding boxes of the features
+    QHash<QgsFeatureId, FeatureLayer> candidates;
+    //! spatial index of the candidates
+    QgsSpatialIndex candidateIndex;
+};
+
+
 class topolTest: public QObject
 {
     Q_OBJECT
@@ -257,34 +289,54 @@ class topolTest: public QObject
     void setTestCancelled();
 
   private:
-    QMap<QString, QgsSpatialIndex*> mLayerIndexes;
-    QMap<QString, TopologyRule> mTopologyRuleMap;
+    class TileTestWrapper
+    {
+      public:
+        typedef ErrorList result_type;
+        TileTestWrapper( topolTest* instance, tileTestFunction test ) : mInstance( instance ), mTest( test ) {}
+        ErrorList operator()( const TopolTile& tile ) const { return ( mInstance->*mTest )( tile ); }
+      private:
+        topolTest* mInstance;
+        tileTestFunction mTest;
+    };
 
-    QList<FeatureLayer> mFeatureList1;
-    QMap<QgsFeatureId, FeatureLayer> mFeatureMap2;
+    QMap<QString, TopologyRule> mTopologyRuleMap;
 
     QgisInterface* theQgsInterface;
     bool mTestCancelled;
 
     /**
-     * Builds spatial index for the layer
-     * @param layer pointer to the layer
+     * Runs a test tile by tile. Features of the tiles are read in the calling thread,
+     * the test is evaluated for several tiles at once in parallel.
+     * @param test test evaluating one tile, called from worker threads
+     * @param tolerance possible tolerance
+     * @param layer1 pointer to the first layer
+     * @param layer2 pointer to the layer of the candidate features, nullptr if the test does not need them
+     * @param isExtent true if only the canvas extent is validated
      */
-    QgsSpatialIndex* createIndex( QgsVectorLayer* layer, const QgsRectangle& extent );
+    ErrorList runTiledTest( tileTestFunction test, double tolerance, QgsVectorLayer* layer1, QgsVectorLayer* layer2, bool isExtent );
 
     /**
-     * Fills the feature list with features from the layer
-     * @param layer pointer to the layer
-     * @param extent of the layer to add features
+     * Returns request for the features of the layer which should be validated
+     * @param extent validated extent, all features if empty
      */
-    void fillFeatureList( QgsVectorLayer* layer, const QgsRectangle& extent );
+    QgsFeatureRequest validatedFeatures( const QgsRectangle& extent ) const;
 
     /**
-     * Fills the feature map with features from the layer
-     * @param layer pointer to the layer
-     * @param extent of the layer to create index
+     * Tile tests, evaluate the features of a single tile.
+     * These are called from worker threads and must not access the map canvas.
      */
-    void fillFeatureMap( QgsVectorLayer* layer, const QgsRectangle& extent );
+    ErrorList checkOverlapWithLayerInTile( const TopolTile& tile );
+    ErrorList checkSegmentLengthInTile( const TopolTile& tile );
+    ErrorList checkPointCoveredBySegmentInTile( const TopolTile& tile );
+    ErrorList checkValidInTile( const TopolTile& tile );
+    ErrorList checkDuplicatesInTile( const TopolTile& tile );
+    ErrorList checkOverlapsInTile( const TopolTile& tile );
+    ErrorList checkPointCoveredByLineEndsInTile( const TopolTile& tile );
+    ErrorList checkPointInPolygonInTile( const TopolTile& tile );
+    ErrorList checkPolygonContainsPointInTile( const TopolTile& tile );
+    ErrorList checkMultipartInTile( const TopolTile& tile );
+    ErrorList checkyLineEndsCoveredByPointsInTile( const TopolTile& tile );
 
     /**
      * Returns true if the test was cancelled
@@ -29,12 +29,32 @@
 #include <QRegExp>
 #include <QUrl>
 
+#include <cstring>
+
+// Interval (in lines) at which byte offsets of lines are recorded for random access
+static const int LINE_INDEX_INTERVAL = 256;
+
+// Test whether lines of a file in the encoding can be split on single 0x0A bytes and
+// decoded independently.  This holds for UTF-8, single byte encodings and the common
+// multibyte encodings, but not for UTF-16/32 (or files with such byte order mark).
+static bool lineFeedIsSingleByte( QTextCodec *codec, const QByteArray &fileStart )
+{
+  if ( fileStart.startsWith( "\xFF\xFE" ) || fileStart.startsWith( "\xFE\xFF" ) )
+    return false;
+  return codec->fromUnicode( QString( "\n\r,;\t\"" ) ) == QByteArray( "\n\r,;\t\"" );
+}
 
 QgsDelimitedTextFile::QgsDelimitedTextFile( const QString& url )
     : mFileName( QString() )
     , mEncoding( "UTF-8" )
     , mFile( nullptr )
     , mStream( nullptr )
+    , mCodec( nullptr )
+    , mRawAccess( false )
+    , mMappedData( nullptr )
+    , mMappedSize( 0 )
+    , mDataStart( 0 )
+    , mPosition( 0 )
     , mUseWatcher( true )
     , mWatcher( nullptr )
     , mDefinitionValid( false )
@@ -75,9 +95,17 @@ void QgsDelimitedTextFile::close()
   }
   if ( mFile )
   {
+    // deleting the file also removes the memory mapping
     delete mFile;
     mFile = nullptr;
   }
+  mCodec = nullptr;
+  mRawAccess = false;
+  mMappedData = nullptr;
+  mMappedSize = 0;
+  mDataStart = 0;
+  mPosition = 0;
+  mLineOffsets.clear();
   if ( mWatcher )
   {
     delete mWatcher;
@@ -104,11 +132,40 @@ bool QgsDelimitedTextFile::open()
     }
     if ( mFile )
     {
-      mStream = new QTextStream( mFile );
+      QTextCodec *codec = nullptr;
       if ( ! mEncoding.isEmpty() )
       {
-        QTextCodec *codec =  QTextCodec::codecForName( mEncoding.toAscii() );
-        mStream->setCodec( codec );
+        codec = QTextCodec::codecForName( mEncoding.toAscii() );
+      }
+      mCodec = codec ? codec : QTextCodec::codecForLocale();
+
+      QByteArray fileStart = mFile->peek( 3 );
+      mRawAccess = lineFeedIsSingleByte( mCodec, fileStart );
+      if ( mRawAccess )
+      {
+        // Skip UTF-8 byte order mark, as QTextStream does
+        if ( fileStart.startsWith( "\xEF\xBB\xBF" ) ) mDataStart = 3;
+        // A watched file is expected to be changed by other programs. Reading a mapping of a
+        // truncated file crashes, and on Windows the mapping prevents replacing the file.
+        if ( ! mUseWatcher )
+        {
+          mMappedSize = mFile->size();
+          mMappedData = mFile->map( 0, mMappedSize );
+          if ( ! mMappedData )
+          {
+            QgsDebugMsg( "Data file " + mFileName + " could not be memory mapped - reading it sequentially" );
+            mMappedSize = 0;
+          }
+        }
+        rewind();
+      }
+      else
+      {
+        mStream = new QTextStream( mFile );
+        if ( codec )
+        {
+          mStream->setCodec( codec );
+        }
       }
       if ( mUseWatcher )
       {
@@ -339,6 +396,7 @@ void QgsDelimitedTextFile::setTypeWhitespace()
   setTypeRegexp( "\\s+" );
   mDiscardEmptyFields = true;
   mType = DelimTypeWhitespace;
+  mParser = &QgsDelimitedTextFile::parseWhitespace;
 }
 
 void QgsDelimitedTextFile::setTypeRegexp( const QString& regexp )
@@ -555,15 +613,16 @@ QgsDelimitedTextFile::Status  QgsDelimitedTextFile::reset()
   if ( ! isValid() || ! open() ) return InvalidDefinition;
 
   // Reset the file pointer
-  mStream->seek( 0 );
+  rewind();
   mLineNumber = 0;
   mRecordNumber = -1;
   mRecordLineNumber = -1;
 
   // Skip header lines
+  QString buffer;
   for ( int i = mSkipLines; i-- > 0; )
   {
-    if ( mStream->readLine().isNull() ) return RecordEOF;
+    if ( ! readLine( buffer ) ) return RecordEOF;
     mLineNumber++;
   }
   // Read the column names
@@ -580,16 +639,14 @@ QgsDelimitedTextFile::Status  QgsDelimitedTextFile::reset()
 
 QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bool skipBlank )
 {
-  if ( ! mStream )
+  if ( ! mFile )
   {
     Status status = reset();
     if ( status != RecordOk ) return status;
   }
 
-  while ( ! mStream->atEnd() )
+  while ( readLine( buffer ) )
   {
-    buffer = mStream->readLine();
-    if ( buffer.isNull() ) break;
     mLineNumber++;
     if ( skipBlank && buffer.isEmpty() ) continue;
     return RecordOk;
@@ -599,13 +656,78 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bo
   return RecordEOF;
 }
 
+void QgsDelimitedTextFile::rewind()
+{
+  if ( mRawAccess )
+  {
+    mPosition = mDataStart;
+    if ( ! mMappedData ) mFile->seek( mPosition );
+  }
+  else
+  {
+    mStream->seek( 0 );
+  }
+}
+
+bool QgsDelimitedTextFile::readLine( QString &buffer )
+{
+  if ( ! mRawAccess )
+  {
+    if ( mStream->atEnd() ) return false;
+    buffer = mStream->readLine();
+    return ! buffer.isNull();
+  }
+
+  // Remember where the line starts if it is the next one to index
+  if ( mLineNumber >= 0 && mLineNumber % LINE_INDEX_INTERVAL == 0 && mLineNumber / LINE_INDEX_INTERVAL == mLineOffsets.size() )
+  {
+    mLineOffsets.append( mPosition );
+  }
+
+  if ( mMappedData )
+  {
+    if ( mPosition >= mMappedSize ) return false;
+    const char *start = reinterpret_cast<const char *>( mMappedData ) + mPosition;
+    const char *eol = static_cast<const char *>( memchr( start, '\n', mMappedSize - mPosition ) );
+    qint64 length = eol ? eol - start : mMappedSize - mPosition;
+    mPosition += eol ? length + 1 : length;
+    if ( length > 0 && start[length - 1] == '\r' ) length--;
+    buffer = mCodec->toUnicode( start, static_cast<int>( length ) );
+    return true;
+  }
+
+  QByteArray line = mFile->readLine();
+  if ( line.isEmpty() ) return false;
+  mPosition += line.size();
+  if ( line.endsWith( '\n' ) ) line.chop( 1 );
+  if ( line.endsWith( '\r' ) ) line.chop( 1 );
+  buffer = mCodec->toUnicode( line );
+  return true;
+}
+
 bool QgsDelimitedTextFile::setNextLineNumber( long nextLineNumber )
 {
-  if ( ! mStream ) return false;
+  if ( ! mFile ) return false;
+
+  // Jump to the closest indexed line before the requested one if
+  // that saves reading lines (or reading from the start of the file)
+  if ( mRawAccess && ! mLineOffsets.isEmpty() && nextLineNumber > 0 )
+  {
+    int index = qMin( static_cast<int>(( nextLineNumber - 1 ) / LINE_INDEX_INTERVAL ), mLineOffsets.size() - 1 );
+    long indexedLineNumber = static_cast<long>( index ) * LINE_INDEX_INTERVAL;
+    if ( mLineNumber > nextLineNumber - 1 || mLineNumber < indexedLineNumber )
+    {
+      mRecordNumber = -1;
+      mPosition = mLineOffsets[index];
+      if ( ! mMappedData ) mFile->seek( mPosition );
+      mLineNumber = indexedLineNumber;
+    }
+  }
+
   if ( mLineNumber > nextLineNumber - 1 )
   {
     mRecordNumber = -1;
-    mStream->seek( 0 );
+    rewind();
     mLineNumber = 0;
   }
   QString buffer;
@@ -692,8 +814,65 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::parseRegexp( QString &buffer,
   return RecordOk;
 }
 
+QgsDelimitedTextFile::Status QgsDelimitedTextFile::parseWhitespace( QString &buffer, QStringList &fields )
+{
+  const QChar *data = buffer.constData();
+  int size = buffer.size();
+  int pos = 0;
+  while ( pos < size )
+  {
+    int matchPos = pos;
+    while ( matchPos < size && ! data[matchPos].isSpace() ) matchPos++;
+
+    // If no more whitespace, then field is to end of record
+    appendField( fields, buffer.mid( pos, matchPos - pos ) );
+    if ( matchPos >= size ) break;
+
+    // Advance past the whitespace
+    pos = matchPos;
+    while ( pos < size && data[pos].isSpace() ) pos++;
+
+    // Quit loop if we have enough fields.
+    if ( mMaxFields > 0 && fields.size() >= mMaxFields ) break;
+  }
+  return RecordOk;
+}
+
+QgsDelimitedTextFile::Status QgsDelimitedTextFile::parseUnquoted( QString &buffer, QStringList &fields )
+{
+  QChar delim = mDelimChars.at( 0 );
+  int pos = 0;
+  while ( true )
+  {
+    int delimPos = buffer.indexOf( delim, pos );
+    if ( delimPos < 0 ) break;
+    appendField( fields, buffer.mid( pos, delimPos - pos ) );
+    pos = delimPos + 1;
+  }
+  // As in parseQuoted, the last field is only added if it has non-blank characters
+  QString field = buffer.mid( pos );
+  if ( ! field.trimmed().isEmpty() )
+  {
+    appendField( fields, field );
+  }
+  return RecordOk;
+}
+
 QgsDelimitedTextFile::Status QgsDelimitedTextFile::parseQuoted( QString &buffer, QStringList &fields )
 {
+  // Most records have no quote or escape characters at all, in which case
+  // they can be split on a single delimiter without examining each character
+  if ( mDelimChars.size() == 1 )
+  {
+    bool special = false;
+    for ( int i = 0; i < mQuoteChar.size() && ! special; i++ )
+      special = buffer.contains( mQuoteChar.at( i ) );
+    for ( int i = 0; i < mEscapeChar.size() && ! special; i++ )
+      special = buffer.contains( mEscapeChar.at( i ) );
+    if ( ! special )
+      return parseUnquoted( buffer, fields );
+  }
+
   Status status = RecordOk;
   QString field;        // String in which to accumulate next field
   bool escaped = false; // Next char is escaped
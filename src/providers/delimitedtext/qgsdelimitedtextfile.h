@@ -22,11 +22,13 @@
 #include <QRegExp>
 #include <QUrl>
 #include <QObject>
+#include <QVector>
 
 class QgsFeature;
 class QgsField;
 class QFile;
 class QFileSystemWatcher;
+class QTextCodec;
 class QTextStream;
 
 
@@ -65,6 +67,14 @@ class QTextStream;
 *   The field is ignored for csv and whitespace
 * - quoteChar, optional, a single character used for quoting plain fields
 * - escapeChar, optional, a single characer used for escaping (may be the same as quoteChar)
+*
+* For encodings in which a line feed is always a single byte (UTF-8, the ISO-8859
+* family, most multibyte encodings) the file is read directly from a memory mapping
+* (or from the raw file if it cannot be mapped or is watched for changes) and each
+* line is decoded separately.
+* The byte offset of every LINE_INDEX_INTERVAL'th line is remembered while reading,
+* so that setNextRecordId() can jump close to any record already visited instead of
+* reading the file again from its start. Other encodings are read through a QTextStream.
 */
 
 // Note: this has been implemented as a single class rather than a set of classes based
@@ -325,8 +335,21 @@ class QgsDelimitedTextFile : public QObject
 
     /** Parse reqular expression delimited fields */
     Status parseRegexp( QString &buffer, QStringList &fields );
+    /** Parse whitespace delimited fields (same result as parseRegexp with a whitespace delimiter) */
+    Status parseWhitespace( QString &buffer, QStringList &fields );
     /** Parse quote delimited fields, where quote and escape are different */
     Status parseQuoted( QString &buffer, QStringList &fields );
+    /** Parse a record containing neither quote nor escape characters delimited by a single character */
+    Status parseUnquoted( QString &buffer, QStringList &fields );
+
+    /** Read the next line of the file (without the end of line characters)
+     * @return false if the end of the file was reached
+     */
+    bool readLine( QString &buffer );
+
+    /** Position the file before its first line (after any byte order mark)
+     */
+    void rewind();
 
     /** Return the next line from the data file.  If skipBlank is true then
      * blank lines will be skipped - this is for compatibility with previous
@@ -350,6 +373,17 @@ class QgsDelimitedTextFile : public QObject
     QString mEncoding;
     QFile *mFile;
     QTextStream *mStream;
+
+    // Direct access to the file contents - used instead of mStream if a line feed
+    // is always encoded as a single byte
+    QTextCodec *mCodec;
+    bool mRawAccess;
+    uchar *mMappedData;
+    qint64 mMappedSize;
+    qint64 mDataStart;
+    qint64 mPosition;
+    // Byte offsets of the start of lines 1, LINE_INDEX_INTERVAL+1, 2*LINE_INDEX_INTERVAL+1, ...
+    QVector<qint64> mLineOffsets;
     bool mUseWatcher;
     QFileSystemWatcher *mWatcher;
 
@@ -19,6 +19,7 @@
 #include "qgslogger.h"
 #include "qgsgdalproviderbase.h"
 #include "qgsgdalprovider.h"
+#include "qgsgdalpyramidbuilder.h"
 #include "qgsconfig.h"
 
 #include "qgsapplication.h"
@@ -38,12 +39,15 @@
 #include <QImage>
 #include <QSettings>
 #include <QColor>
+#include <QCoreApplication>
 #include <QProcess>
 #include <QMessageBox>
 #include <QDir>
 #include <QFileInfo>
 #include <QFile>
 #include <QHash>
+#include <QSet>
+#include <QThread>
 #include <QTime>
 #include <QTextDocument>
 #include <QDebug>
@@ -59,6 +63,11 @@
 static QString PROVIDER_KEY = "gdal";
 static QString PROVIDER_DESCRIPTION = "GDAL provider";
 
+// data sources with overviews being built in background, only used in the main thread
+static QSet<QString> sBuildingPyramids;
+// data sources whose overviews failed to build or were canceled, not built again in this session
+static QSet<QString> sFailedPyramids;
+
 struct QgsGdalProgress
 {
   int type;
@@ -105,6 +114,7 @@ QgsGdalProvider::QgsGdalProvider( const QString &uri, QgsError error )
     , mYBlockSize( 0 )
     , mGdalBaseDataset( nullptr )
     , mGdalDataset( nullptr )
+    , mPyramidBuilder( nullptr )
 {
   mGeoTransform[0] =  0;
   mGeoTransform[1] =  1;
@@ -127,6 +137,7 @@ QgsGdalProvider::QgsGdalProvider( const QString &uri, bool update )
     , mYBlockSize( 0 )
     , mGdalBaseDataset( nullptr )
     , mGdalDataset( nullptr )
+    , mPyramidBuilder( nullptr )
 {
   mGeoTransform[0] =  0;
   mGeoTransform[1] =  1;
@@ -187,6 +198,67 @@ QgsGdalProvider* QgsGdalProvider::clone() const
   return provider;
 }
 
+void QgsGdalProvider::buildPyramidsInBackground()
+{
+  // only in the main thread which handles the result, and only once for a data source
+  if ( !mValid || mHasPyramids || mUpdate || mPyramidBuilder || mGdalDataset != mGdalBaseDataset ||
+       !QCoreApplication::instance() || QThread::currentThread() != QCoreApplication::instance()->thread() ||
+       sBuildingPyramids.contains( dataSourceUri() ) || sFailedPyramids.contains( dataSourceUri() ) ||
+       !QgsGdalPyramidBuilder::shouldBuild( dataSourceUri(), mWidth, mHeight ) )
+    return;
+
+  QSettings settings;
+  QString method = settings.value( "/Raster/defaultPyramidsResampling", "AVERAGE" ).toString();
+  sBuildingPyramids.insert( dataSourceUri() );
+  mPyramidBuilder = new QgsGdalPyramidBuilder( dataSourceUri(), QgsGdalPyramidBuilder::defaultLevels( mWidth, mHeight ), method, this );
+  connect( mPyramidBuilder, SIGNAL( progress( double ) ), this, SLOT( pyramidBuilderProgress( double ) ) );
+  connect( mPyramidBuilder, SIGNAL( finished( bool ) ), this, SLOT( pyramidsBuilt( bool ) ) );
+  mPyramidBuilder->start();
+}
+
+QgsRasterInterface *QgsGdalProvider::concurrentReader() const
+{
+  // a clone opens its own dataset, but it would not see data written by this provider
+  if ( mUpdate || !mValid )
+    return nullptr;
+  return clone();
+}
+
+void QgsGdalProvider::pyramidBuilderProgress( double theProgress )
+{
+  emitProgress( QgsRaster::ProgressPyramids, theProgress, tr( "Building pyramids" ) );
+  emitProgressUpdate( static_cast< int >( theProgress ) );
+}
+
+void QgsGdalProvider::pyramidsBuilt( bool success )
+{
+  sBuildingPyramids.remove( dataSourceUri() );
+  mPyramidBuilder->deleteLater();
+  mPyramidBuilder = nullptr;
+
+  if ( !success )
+  {
+    QgsDebugMsg( "Building pyramids in background failed" );
+    sFailedPyramids.insert( dataSourceUri() );
+    return;
+  }
+
+  QgsDebugMsg( "Reopening dataset to use pyramids built in background" );
+  GDALDatasetH dataset = gdalOpen( TO8F( dataSourceUri() ), GA_ReadOnly );
+  if ( !dataset )
+    return;
+
+  GDALDereferenceDataset( mGdalBaseDataset );
+  GDALClose( mGdalDataset );
+  //Since we are not a virtual warped dataset, mGdalDataSet and mGdalBaseDataset are supposed to be the same
+  mGdalBaseDataset = dataset;
+  GDALReferenceDataset( mGdalBaseDataset );
+  mGdalDataset = mGdalBaseDataset;
+  mHasPyramids = true;
+
+  emit dataChanged();
+}
+
 bool QgsGdalProvider::crsFromWkt( const char *wkt )
 {
 
@@ -228,6 +300,13 @@ bool QgsGdalProvider::crsFromWkt( const char *wkt )
 QgsGdalProvider::~QgsGdalProvider()
 {
   QgsDebugMsg( "entering." );
+  if ( mPyramidBuilder )
+  {
+    // cancels the building
+    delete mPyramidBuilder;
+    sBuildingPyramids.remove( dataSourceUri() );
+    sFailedPyramids.insert( dataSourceUri() );
+  }
   if ( mGdalBaseDataset )
   {
     GDALDereferenceDataset( mGdalBaseDataset );
@@ -1666,6 +1745,12 @@ QString QgsGdalProvider::buildPyramids( const QList<QgsRasterPyramid> & theRaste
   QByteArray ba = theResamplingMethod.toLocal8Bit();
   const char *theMethod = ba.data();
 
+  // let GDAL compute and compress the overviews in multiple threads where supported,
+  // unless the user configured it
+  bool myNumThreadsSet = !CPLGetConfigOption( "GDAL_NUM_THREADS", nullptr );
+  if ( myNumThreadsSet )
+    CPLSetThreadLocalConfigOption( "GDAL_NUM_THREADS", "ALL_CPUS" );
+
   //build the pyramid and show progress to console
   QgsDebugMsg( QString( "Building overviews at %1 levels using resampling method %2"
                       ).arg( myOverviewLevelsVector.size() ).arg( theMethod ) );
@@ -1680,6 +1765,9 @@ QString QgsGdalProvider::buildPyramids( const QList<QgsRasterPyramid> & theRaste
                                   0, nullptr,
                                   progressCallback, &myProg ); //this is the arg for the gdal progress callback
 
+    if ( myNumThreadsSet )
+      CPLSetThreadLocalConfigOption( "GDAL_NUM_THREADS", nullptr );
+
     if ( myError == CE_Failure || CPLGetLastErrorNo() == CPLE_NotSupported )
     {
       QgsDebugMsg( QString( "Building pyramids failed using resampling method [%1]" ).arg( theMethod ) );
@@ -1937,7 +2025,10 @@ void QgsGdalProvider::emitProgressUpdate( int theProgress )
  */
 QGISEXTERN QgsGdalProvider * classFactory( const QString *uri )
 {
-  return new QgsGdalProvider( *uri );
+  // providers of layers are created here, clones of them do not build overviews again
+  QgsGdalProvider *provider = new QgsGdalProvider( *uri );
+  provider->buildPyramidsInBackground();
+  return provider;
 }
 /** Required key function (used to map the plugin to a data store type)
 */
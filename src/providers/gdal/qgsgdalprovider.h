@@ -44,6 +44,7 @@ int CPL_STDCALL progressCallback( double dfComplete,
 
 
 class QgsCoordinateTransform;
+class QgsGdalPyramidBuilder;
 
 /**
 
@@ -75,6 +76,13 @@ class QgsGdalProvider : public QgsRasterDataProvider, QgsGdalProviderBase
 
     QgsGdalProvider * clone() const override;
 
+    /** Starts building overviews in background if the raster is large and has none
+     * (see QgsGdalPyramidBuilder::shouldBuild()). Failed or canceled builds are not
+     * started again for the same data source. Only called for the providers of layers,
+     * not for their clones.
+     */
+    void buildPyramidsInBackground();
+
     /** \brief   Renders the layer as an image
      */
     QImage* draw( QgsRectangle  const & viewExtent, int pixelWidth, int pixelHeight ) override;
@@ -247,6 +255,15 @@ class QgsGdalProvider : public QgsRasterDataProvider, QgsGdalProviderBase
     QString validatePyramidsConfigOptions( QgsRaster::RasterPyramidsFormat pyramidsFormat,
                                            const QStringList & theConfigOptions, const QString & fileFormat ) override;
 
+  protected:
+    QgsRasterInterface *concurrentReader() const override;
+
+  private slots:
+    void pyramidBuilderProgress( double theProgress );
+
+    //! Reopens the dataset to use overviews built in background
+    void pyramidsBuilt( bool success );
+
   private:
     // update mode
     bool mUpdate;
@@ -300,6 +317,9 @@ class QgsGdalProvider : public QgsRasterDataProvider, QgsGdalProviderBase
 
     /** \brief sublayers list saved for subsequent access */
     QStringList mSubLayers;
+
+    //! Builder of overviews running in background, if any
+    QgsGdalPyramidBuilder *mPyramidBuilder;
 };
 
 #endif
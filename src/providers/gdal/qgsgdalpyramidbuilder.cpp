@@ -0,0 +1,162 @@
+/***************************************************************************
+    qgsgdalpyramidbuilder.cpp  -  Builds overviews of GDAL rasters in background
+    ---------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsgdalpyramidbuilder.h"
+#include "qgsgdalproviderbase.h"
+#include "qgslogger.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QtConcurrentRun>
+
+#include <cpl_conv.h>
+
+QgsGdalPyramidBuilder::QgsGdalPyramidBuilder( const QString &uri, const QVector<int> &levels, const QString &resamplingMethod, QObject *parent )
+    : QObject( parent )
+    , mUri( uri )
+    , mLevels( levels )
+    , mResamplingMethod( resamplingMethod.toLocal8Bit() )
+    , mLastPercent( -1 )
+    , mCanceled( false )
+    , mFutureWatcher( nullptr )
+{
+}
+
+QgsGdalPyramidBuilder::~QgsGdalPyramidBuilder()
+{
+  if ( mFutureWatcher && !mFutureWatcher->isFinished() )
+  {
+    QgsDebugMsg( "building not finished -> cancel and wait" );
+    cancel();
+    mFutureWatcher->waitForFinished();
+  }
+}
+
+void QgsGdalPyramidBuilder::start()
+{
+  QgsDebugMsg( QString( "building overviews of %1 in background" ).arg( mUri ) );
+  mFutureWatcher = new QFutureWatcher<bool>( this );
+  connect( mFutureWatcher, SIGNAL( finished() ), SLOT( onFinished() ) );
+  mFutureWatcher->setFuture( QtConcurrent::run( run, this ) );
+}
+
+bool QgsGdalPyramidBuilder::isCanceled()
+{
+  QMutexLocker locker( &mMutex );
+  return mCanceled;
+}
+
+void QgsGdalPyramidBuilder::cancel()
+{
+  QMutexLocker locker( &mMutex );
+  mCanceled = true;
+}
+
+bool QgsGdalPyramidBuilder::run( QgsGdalPyramidBuilder *builder )
+{
+  GDALDatasetH dataset = QgsGdalProviderBase::gdalOpen( TO8F( builder->mUri ), GA_ReadOnly );
+  if ( !dataset )
+  {
+    QgsDebugMsg( QString( "cannot open %1: %2" ).arg( builder->mUri, CPLGetLastErrorMsg() ) );
+    return false;
+  }
+
+  // overviews are built for a temporary virtual copy of the raster and moved
+  // in place when complete, so that datasets opened in the meantime never
+  // find an incomplete .ovr file
+  QString tmpUri = builder->mUri + ".tmp.vrt";
+  GDALDatasetH vrtDataset = GDALCreateCopy( GDALGetDriverByName( "VRT" ), TO8F( tmpUri ), dataset, FALSE, nullptr, nullptr, nullptr );
+  GDALClose( dataset );
+  if ( !vrtDataset )
+  {
+    QgsDebugMsg( QString( "cannot create %1: %2" ).arg( tmpUri, CPLGetLastErrorMsg() ) );
+    return false;
+  }
+
+  // let GDAL compute and compress the overviews in multiple threads where supported,
+  // the option is set for this thread only so that it does not affect rendering
+  CPLSetThreadLocalConfigOption( "GDAL_NUM_THREADS", "ALL_CPUS" );
+  CPLSetThreadLocalConfigOption( "USE_RRD", "NO" );
+
+  CPLErr err = GDALBuildOverviews( vrtDataset, builder->mResamplingMethod.constData(),
+                                   builder->mLevels.size(), builder->mLevels.data(),
+                                   0, nullptr, progressCallback, builder );
+
+  CPLSetThreadLocalConfigOption( "GDAL_NUM_THREADS", nullptr );
+  CPLSetThreadLocalConfigOption( "USE_RRD", nullptr );
+
+  GDALClose( vrtDataset );
+  QFile::remove( tmpUri );
+
+  bool success = err != CE_Failure && !builder->isCanceled();
+  if ( success )
+    success = QFile::rename( tmpUri + ".ovr", builder->mUri + ".ovr" );
+  if ( !success )
+    QFile::remove( tmpUri + ".ovr" );
+
+  QgsDebugMsg( QString( "building overviews of %1 %2" ).arg( builder->mUri, success ? "finished" : "failed" ) );
+  return success;
+}
+
+int CPL_STDCALL QgsGdalPyramidBuilder::progressCallback( double dfComplete, const char *pszMessage, void *pProgressArg )
+{
+  Q_UNUSED( pszMessage );
+  QgsGdalPyramidBuilder *builder = static_cast<QgsGdalPyramidBuilder *>( pProgressArg );
+  if ( builder->isCanceled() )
+    return false;
+
+  // progress is delivered to other thread, do not flood it
+  int percent = static_cast< int >( dfComplete * 100 );
+  if ( percent != builder->mLastPercent )
+  {
+    builder->mLastPercent = percent;
+    emit builder->progress( dfComplete * 100 );
+  }
+  return true;
+}
+
+void QgsGdalPyramidBuilder::onFinished()
+{
+  emit finished( mFutureWatcher->result() );
+}
+
+QVector<int> QgsGdalPyramidBuilder::defaultLevels( int width, int height )
+{
+  QVector<int> levels;
+  int divisor = 2;
+  while (( width / divisor > 32 ) && (( height / divisor ) > 32 ) )
+  {
+    levels << divisor;
+    divisor *= 2;
+  }
+  return levels;
+}
+
+bool QgsGdalPyramidBuilder::shouldBuild( const QString &uri, int width, int height )
+{
+  QSettings settings;
+  if ( !settings.value( "/Raster/autoBuildPyramids", false ).toBool() )
+    return false;
+
+  double megapixels = static_cast< double >( width ) * height / 1e6;
+  if ( megapixels < settings.value( "/Raster/autoBuildPyramidsMinSize", 25 ).toDouble() )
+    return false;
+
+  QFileInfo fileInfo( uri );
+  if ( !fileInfo.isFile() || QFileInfo( uri + ".ovr" ).exists() )
+    return false;
+
+  return QFileInfo( fileInfo.absolutePath() ).isWritable();
+}
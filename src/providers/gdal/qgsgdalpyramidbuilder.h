@@ -0,0 +1,99 @@
+/***************************************************************************
+    qgsgdalpyramidbuilder.h  -  Builds overviews of GDAL rasters in background
+    ---------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSGDALPYRAMIDBUILDER_H
+#define QGSGDALPYRAMIDBUILDER_H
+
+#include "qgsgdalproviderbase.h"
+
+#include <QFutureWatcher>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+/**
+  \brief Builds overviews of a GDAL raster in a worker thread.
+
+  The raster is opened with its own dataset handle and the overviews are always
+  written to an external .ovr file, which appears only when it is complete. Datasets
+  of providers reading the raster are not modified, they have to be reopened to
+  use the overviews.
+*/
+class QgsGdalPyramidBuilder : public QObject
+{
+    Q_OBJECT
+  public:
+    /**
+     * @param uri GDAL data source
+     * @param levels overview decimation factors
+     * @param resamplingMethod GDAL resampling method, e.g. AVERAGE
+     * @param parent parent object
+     */
+    QgsGdalPyramidBuilder( const QString &uri, const QVector<int> &levels, const QString &resamplingMethod, QObject *parent = nullptr );
+
+    //! Cancels the building and waits until the worker thread stops
+    ~QgsGdalPyramidBuilder();
+
+    //! Starts building in a worker thread
+    void start();
+
+    //! Returns true if building was canceled
+    bool isCanceled();
+
+    /** Returns overview decimation factors suitable for a raster of given size,
+     * the same which are offered for building by the provider
+     */
+    static QVector<int> defaultLevels( int width, int height );
+
+    /** Returns true if overviews of the raster should be built automatically,
+     * i.e. it is enabled in settings (/Raster/autoBuildPyramids), the raster is
+     * a local file in a writable directory and it is larger than the configured
+     * size (/Raster/autoBuildPyramidsMinSize in megapixels)
+     */
+    static bool shouldBuild( const QString &uri, int width, int height );
+
+  public slots:
+    void cancel();
+
+  signals:
+    //! Emitted from the worker thread with progress in percents
+    void progress( double percent );
+
+    //! Emitted when building finished, success is false if it failed or was canceled
+    void finished( bool success );
+
+  private slots:
+    void onFinished();
+
+  private:
+    static bool run( QgsGdalPyramidBuilder *builder );
+
+    //! GDAL progress callback, stops building when canceled
+    static int CPL_STDCALL progressCallback( double dfComplete, const char *pszMessage, void *pProgressArg );
+
+    QString mUri;
+    QVector<int> mLevels;
+    QByteArray mResamplingMethod;
+
+    //! Last reported progress, only used in the worker thread
+    int mLastPercent;
+
+    QMutex mMutex;
+    bool mCanceled;
+
+    QFutureWatcher<bool> *mFutureWatcher;
+};
+
+#endif // QGSGDALPYRAMIDBUILDER_H
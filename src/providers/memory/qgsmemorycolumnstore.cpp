@@ -0,0 +1,423 @@
+/***************************************************************************
+    qgsmemorycolumnstore.cpp
+    ---------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgsmemorycolumnstore.h"
+
+#include "qgsgeometry.h"
+
+#include <cstring>
+
+// WKB is appended to chunks of this size, so that the arena never needs
+// to be reallocated as a whole
+static const int ARENA_CHUNK_SIZE = 1 << 20;
+
+// deleted rows are compacted once there is at least this many of them
+// and they occupy more than half of the rows
+static const int COMPACT_MIN_ROWS = 1024;
+
+
+QgsMemoryColumnStore::QgsMemoryColumnStore()
+    : mDeletedCount( 0 )
+    , mArenaSize( 0 )
+    , mArenaGarbage( 0 )
+{
+}
+
+QgsGeometry* QgsMemoryColumnStore::geometry( int row ) const
+{
+  const GeometryRef& ref = mGeometries.at( row );
+  if ( ref.chunk < 0 )
+    return nullptr;
+
+  QgsGeometry* geom = new QgsGeometry();
+  if ( ref.size > 0 )
+  {
+    unsigned char* wkb = new unsigned char[ref.size];
+    memcpy( wkb, mArena.at( ref.chunk ).constData() + ref.offset, ref.size );
+    geom->fromWkb( wkb, ref.size );
+  }
+  return geom;
+}
+
+QVariant QgsMemoryColumnStore::attribute( int row, int field ) const
+{
+  if ( field < 0 || field >= mColumns.count() )
+    return QVariant();
+
+  return value( mColumns.at( field ), row );
+}
+
+void QgsMemoryColumnStore::feature( int row, QgsFeature& feature, const QgsAttributeList& attributes, bool fetchGeometry ) const
+{
+  feature.setFeatureId( mIds.at( row ) );
+
+  QgsAttributes attrs( mColumns.count() );
+  Q_FOREACH ( int field, attributes )
+  {
+    if ( field >= 0 && field < mColumns.count() )
+      attrs[field] = value( mColumns.at( field ), row );
+  }
+  feature.setAttributes( attrs );
+
+  feature.setGeometry( fetchGeometry ? geometry( row ) : nullptr );
+  feature.setValid( true );
+}
+
+void QgsMemoryColumnStore::addField( QVariant::Type type )
+{
+  Column column;
+  column.type = type;
+  switch ( type )
+  {
+    case QVariant::Int:
+    case QVariant::LongLong:
+      column.storage = Column::Integer;
+      break;
+    case QVariant::Double:
+      column.storage = Column::Double;
+      break;
+    case QVariant::String:
+      column.storage = Column::String;
+      break;
+    default:
+      column.storage = Column::Variant;
+      break;
+  }
+
+  resizeColumn( column, mIds.count() );
+  column.nulls.fill( true );
+  column.invalid.fill( true );
+  mColumns.append( column );
+}
+
+void QgsMemoryColumnStore::removeField( int field )
+{
+  if ( field >= 0 && field < mColumns.count() )
+    mColumns.remove( field );
+}
+
+void QgsMemoryColumnStore::addFeature( const QgsFeature& feature )
+{
+  int row = mIds.count();
+  mIds.append( feature.id() );
+  mRows.insert( feature.id(), row );
+  mDeleted.resize( row + 1 );
+
+  const QgsGeometry* geom = feature.constGeometry();
+  mGeometries.append( appendGeometry( geom ) );
+  mBoundingBoxes.append( geom ? geom->boundingBox() : QgsRectangle() );
+
+  const QgsAttributes& attrs = feature.attributes();
+  for ( int i = 0; i < mColumns.count(); ++i )
+  {
+    Column& column = mColumns[i];
+    resizeColumn( column, row + 1 );
+    setValue( column, row, i < attrs.count() ? attrs.at( i ) : QVariant() );
+  }
+}
+
+bool QgsMemoryColumnStore::deleteFeature( QgsFeatureId id )
+{
+  QHash<QgsFeatureId, int>::iterator it = mRows.find( id );
+  if ( it == mRows.end() )
+    return false;
+
+  int row = it.value();
+  mRows.erase( it );
+  mDeleted.setBit( row );
+  mDeletedCount++;
+
+  // release memory held by the values right away, the rest waits for compaction
+  for ( int i = 0; i < mColumns.count(); ++i )
+    setValue( mColumns[i], row, QVariant() );
+
+  GeometryRef& ref = mGeometries[row];
+  if ( ref.chunk >= 0 )
+    mArenaGarbage += ref.size;
+  ref.chunk = -1;
+  ref.offset = 0;
+  ref.size = 0;
+  mBoundingBoxes[row] = QgsRectangle();
+
+  compactIfNeeded();
+  return true;
+}
+
+bool QgsMemoryColumnStore::changeAttributeValue( QgsFeatureId id, int field, const QVariant& value )
+{
+  int r = row( id );
+  if ( r < 0 || field < 0 || field >= mColumns.count() )
+    return false;
+
+  setValue( mColumns[field], r, value );
+  return true;
+}
+
+bool QgsMemoryColumnStore::changeGeometry( QgsFeatureId id, const QgsGeometry& geometry )
+{
+  int r = row( id );
+  if ( r < 0 )
+    return false;
+
+  // the old WKB stays in the arena until the next compaction
+  const GeometryRef& oldRef = mGeometries.at( r );
+  if ( oldRef.chunk >= 0 )
+    mArenaGarbage += oldRef.size;
+
+  mGeometries[r] = appendGeometry( &geometry );
+  mBoundingBoxes[r] = geometry.boundingBox();
+
+  compactIfNeeded();
+  return true;
+}
+
+void QgsMemoryColumnStore::resizeColumn( Column& column, int rowCount )
+{
+  switch ( column.storage )
+  {
+    case Column::Integer:
+      column.integers.resize( rowCount );
+      break;
+    case Column::Double:
+      column.doubles.resize( rowCount );
+      break;
+    case Column::String:
+      column.strings.resize( rowCount );
+      break;
+    case Column::Variant:
+      column.variants.resize( rowCount );
+      return;
+  }
+  column.nulls.resize( rowCount );
+  column.invalid.resize( rowCount );
+}
+
+void QgsMemoryColumnStore::setValue( Column& column, int row, const QVariant& value )
+{
+  if ( column.storage != Column::Variant )
+  {
+    if ( !value.isValid() || ( value.isNull() && value.type() == column.type ) )
+    {
+      if ( column.storage == Column::String )
+        column.strings[row] = QString();
+      column.nulls.setBit( row );
+      column.invalid.setBit( row, !value.isValid() );
+      return;
+    }
+
+    if ( setTypedValue( column, row, value ) )
+    {
+      column.nulls.clearBit( row );
+      column.invalid.clearBit( row );
+      return;
+    }
+
+    convertToVariant( column );
+  }
+
+  column.variants[row] = value;
+}
+
+bool QgsMemoryColumnStore::setTypedValue( Column& column, int row, const QVariant& value )
+{
+  switch ( column.storage )
+  {
+    case Column::Integer:
+      if ( value.type() != column.type )
+        return false;
+
+      column.integers[row] = value.toLongLong();
+      return true;
+
+    case Column::Double:
+      if ( value.type() != QVariant::Double )
+        return false;
+
+      column.doubles[row] = value.toDouble();
+      return true;
+
+    case Column::String:
+      if ( value.type() != QVariant::String )
+        return false;
+
+      column.strings[row] = value.toString();
+      return true;
+
+    case Column::Variant:
+      break;
+  }
+  return false;
+}
+
+void QgsMemoryColumnStore::convertToVariant( Column& column )
+{
+  int rowCount = column.nulls.size();
+  column.variants.resize( rowCount );
+  for ( int row = 0; row < rowCount; ++row )
+    column.variants[row] = value( column, row );
+
+  column.storage = Column::Variant;
+  column.integers.clear();
+  column.doubles.clear();
+  column.strings.clear();
+  column.nulls.clear();
+  column.invalid.clear();
+}
+
+QVariant QgsMemoryColumnStore::value( const Column& column, int row )
+{
+  if ( column.storage == Column::Variant )
+    return column.variants.at( row );
+
+  if ( column.nulls.testBit( row ) )
+    return column.invalid.testBit( row ) ? QVariant() : QVariant( column.type );
+
+  switch ( column.storage )
+  {
+    case Column::Integer:
+      if ( column.type == QVariant::Int )
+        return QVariant( static_cast<int>( column.integers.at( row ) ) );
+      return QVariant( static_cast<qlonglong>( column.integers.at( row ) ) );
+    case Column::Double:
+      return QVariant( column.doubles.at( row ) );
+    case Column::String:
+      return QVariant( column.strings.at( row ) );
+    case Column::Variant:
+      break;
+  }
+  return QVariant();
+}
+
+QgsMemoryColumnStore::GeometryRef QgsMemoryColumnStore::appendGeometry( const QgsGeometry* geometry )
+{
+  GeometryRef ref;
+  ref.chunk = -1;
+  ref.offset = 0;
+  ref.size = 0;
+
+  if ( !geometry )
+    return ref;
+
+  const unsigned char* wkb = geometry->asWkb();
+  int size = wkb ? geometry->wkbSize() : 0;
+
+  if ( mArena.isEmpty() || ( !mArena.last().isEmpty() && mArena.last().size() + size > ARENA_CHUNK_SIZE ) )
+  {
+    mArena.append( QByteArray() );
+    mArena.last().reserve( qMax( size, ARENA_CHUNK_SIZE ) );
+  }
+
+  QByteArray& chunk = mArena.last();
+  ref.chunk = mArena.count() - 1;
+  ref.offset = chunk.size();
+  ref.size = size;
+  if ( size > 0 )
+    chunk.append( reinterpret_cast<const char*>( wkb ), size );
+
+  mArenaSize += size;
+  return ref;
+}
+
+void QgsMemoryColumnStore::compactIfNeeded()
+{
+  if (( mDeletedCount >= COMPACT_MIN_ROWS && mDeletedCount * 2 > mIds.count() ) ||
+      ( mArenaGarbage >= ARENA_CHUNK_SIZE && mArenaGarbage * 2 > mArenaSize ) )
+    compact();
+}
+
+void QgsMemoryColumnStore::compact()
+{
+  QVector<int> liveRows;
+  liveRows.reserve( count() );
+  for ( int row = 0; row < mIds.count(); ++row )
+  {
+    if ( !mDeleted.testBit( row ) )
+      liveRows.append( row );
+  }
+
+  QVector<QgsFeatureId> ids;
+  QVector<QgsRectangle> boundingBoxes;
+  ids.reserve( liveRows.count() );
+  boundingBoxes.reserve( liveRows.count() );
+  mRows.clear();
+  Q_FOREACH ( int row, liveRows )
+  {
+    mRows.insert( mIds.at( row ), ids.count() );
+    ids.append( mIds.at( row ) );
+    boundingBoxes.append( mBoundingBoxes.at( row ) );
+  }
+
+  // copy WKB of live geometries to a new arena
+  QList<QByteArray> oldArena = mArena;
+  QVector<GeometryRef> oldGeometries = mGeometries;
+  mArena.clear();
+  mArenaSize = 0;
+  mArenaGarbage = 0;
+  mGeometries.clear();
+  mGeometries.reserve( liveRows.count() );
+  Q_FOREACH ( int row, liveRows )
+  {
+    GeometryRef ref = oldGeometries.at( row );
+    if ( ref.chunk >= 0 )
+    {
+      if ( mArena.isEmpty() || ( !mArena.last().isEmpty() && mArena.last().size() + ref.size > ARENA_CHUNK_SIZE ) )
+      {
+        mArena.append( QByteArray() );
+        mArena.last().reserve( qMax( ref.size, ARENA_CHUNK_SIZE ) );
+      }
+      QByteArray& chunk = mArena.last();
+      const char* wkb = oldArena.at( ref.chunk ).constData() + ref.offset;
+      ref.chunk = mArena.count() - 1;
+      ref.offset = chunk.size();
+      chunk.append( wkb, ref.size );
+      mArenaSize += ref.size;
+    }
+    mGeometries.append( ref );
+  }
+
+  for ( int i = 0; i < mColumns.count(); ++i )
+  {
+    Column& column = mColumns[i];
+    Column compacted;
+    compacted.type = column.type;
+    compacted.storage = column.storage;
+    resizeColumn( compacted, liveRows.count() );
+    for ( int j = 0; j < liveRows.count(); ++j )
+    {
+      int row = liveRows.at( j );
+      switch ( column.storage )
+      {
+        case Column::Integer:
+          compacted.integers[j] = column.integers.at( row );
+          break;
+        case Column::Double:
+          compacted.doubles[j] = column.doubles.at( row );
+          break;
+        case Column::String:
+          compacted.strings[j] = column.strings.at( row );
+          break;
+        case Column::Variant:
+          compacted.variants[j] = column.variants.at( row );
+          continue;
+      }
+      compacted.nulls.setBit( j, column.nulls.testBit( row ) );
+      compacted.invalid.setBit( j, column.invalid.testBit( row ) );
+    }
+    column = compacted;
+  }
+
+  mIds = ids;
+  mBoundingBoxes = boundingBoxes;
+  mDeleted = QBitArray( ids.count() );
+  mDeletedCount = 0;
+}
@@ -0,0 +1,166 @@
+/***************************************************************************
+    qgsmemorycolumnstore.h
+    ---------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSMEMORYCOLUMNSTORE_H
+#define QGSMEMORYCOLUMNSTORE_H
+
+#include "qgsfeature.h"
+#include "qgsrectangle.h"
+
+#include <QBitArray>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+class QgsGeometry;
+
+/**
+ * Column oriented storage of features for the memory provider.
+ *
+ * Attribute values are kept in one typed array per field (integers, doubles or strings)
+ * with a bitmap of null values, geometries are kept as WKB in a list of large contiguous
+ * chunks together with their bounding boxes and feature ids are mapped to rows with a hash.
+ * Rows of deleted features are only flagged and the storage gets compacted once they
+ * make up a large part of it.
+ *
+ * Values of another type than the field (e.g. a string or a 64 bit integer assigned to
+ * an integer field) switch the whole column to generic QVariant storage, so values are
+ * returned with the same type and value as they were stored.
+ *
+ * All the data are held in implicitly shared Qt containers, copying the store (e.g. for
+ * a feature source) is therefore cheap.
+ */
+class QgsMemoryColumnStore
+{
+  public:
+    QgsMemoryColumnStore();
+
+    //! Number of stored features
+    int count() const { return mIds.count() - mDeletedCount; }
+
+    //! Number of rows including the rows of deleted features not yet compacted
+    int rowCount() const { return mIds.count(); }
+
+    //! Returns row of the feature or -1 if there is no such feature
+    int row( QgsFeatureId id ) const { return mRows.value( id, -1 ); }
+
+    //! Returns whether the row belongs to a deleted feature
+    bool isDeleted( int row ) const { return mDeleted.testBit( row ); }
+
+    //! Returns feature id stored in the row
+    QgsFeatureId featureId( int row ) const { return mIds.at( row ); }
+
+    //! Returns whether the feature in the row has a geometry
+    bool hasGeometry( int row ) const { return mGeometries.at( row ).chunk >= 0; }
+
+    //! Returns bounding box of the geometry in the row (null rectangle if there is no geometry)
+    const QgsRectangle& boundingBox( int row ) const { return mBoundingBoxes.at( row ); }
+
+    //! Returns a new geometry built from the row or nullptr if there is no geometry. Caller takes ownership.
+    QgsGeometry* geometry( int row ) const;
+
+    //! Returns value of the attribute in the row
+    QVariant attribute( int row, int field ) const;
+
+    /** Fills the feature with data of the row
+     * @param row row of the feature
+     * @param feature feature to fill
+     * @param attributes indexes of attributes to fetch, other attributes are left NULL
+     * @param fetchGeometry whether to set the geometry of the feature
+     */
+    void feature( int row, QgsFeature& feature, const QgsAttributeList& attributes, bool fetchGeometry ) const;
+
+    //! Appends a new column for a field of given type, values of existing features are NULL
+    void addField( QVariant::Type type );
+
+    //! Removes the column of the field
+    void removeField( int field );
+
+    //! Appends the feature (with the id already set)
+    void addFeature( const QgsFeature& feature );
+
+    //! Deletes the feature, returns false if there is no such feature
+    bool deleteFeature( QgsFeatureId id );
+
+    //! Changes the value of an attribute, returns false if there is no such feature
+    bool changeAttributeValue( QgsFeatureId id, int field, const QVariant& value );
+
+    //! Changes the geometry of a feature, returns false if there is no such feature
+    bool changeGeometry( QgsFeatureId id, const QgsGeometry& geometry );
+
+  private:
+
+    //! Location of WKB of a geometry within the arena
+    struct GeometryRef
+    {
+      int chunk;  //!< index of the chunk, -1 if there is no geometry
+      int offset; //!< offset of WKB within the chunk
+      int size;   //!< size of WKB (zero for an empty geometry)
+    };
+
+    //! Values of one field
+    struct Column
+    {
+      enum Storage
+      {
+        Integer,
+        Double,
+        String,
+        Variant
+      };
+
+      QVariant::Type type;
+      Storage storage;
+      QVector<qint64> integers;
+      QVector<double> doubles;
+      QVector<QString> strings;
+      QVector<QVariant> variants;
+      QBitArray nulls; //!< not used with Variant storage
+      QBitArray invalid; //!< null rows holding an invalid QVariant rather than a null of the field type, not used with Variant storage
+    };
+
+    //! Resizes the array used by the column storage
+    static void resizeColumn( Column& column, int rowCount );
+    //! Stores the value in the row, switches column to QVariant storage if necessary
+    static void setValue( Column& column, int row, const QVariant& value );
+    //! Tries to store a non-null value of the field type in the typed array of the column
+    static bool setTypedValue( Column& column, int row, const QVariant& value );
+    //! Moves all values of the column to QVariant storage
+    static void convertToVariant( Column& column );
+    //! Returns value stored in the row of the column
+    static QVariant value( const Column& column, int row );
+
+    //! Appends WKB of the geometry to the arena
+    GeometryRef appendGeometry( const QgsGeometry* geometry );
+
+    //! Compacts storage if there is too much space occupied by deleted rows and replaced geometries
+    void compactIfNeeded();
+    //! Removes deleted rows and unreferenced WKB
+    void compact();
+
+    QVector<QgsFeatureId> mIds;
+    QHash<QgsFeatureId, int> mRows;
+    QBitArray mDeleted;
+    int mDeletedCount;
+
+    QVector<Column> mColumns;
+
+    QList<QByteArray> mArena;
+    qint64 mArenaSize;
+    qint64 mArenaGarbage;
+    QVector<GeometryRef> mGeometries;
+    QVector<QgsRectangle> mBoundingBoxes;
+};
+
+#endif // QGSMEMORYCOLUMNSTORE_H
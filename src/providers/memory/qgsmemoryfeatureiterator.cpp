@@ -20,12 +20,16 @@
 #include "qgsspatialindex.h"
 #include "qgsmessagelog.h"
 
+#include <QScopedPointer>
+
 
 
 QgsMemoryFeatureIterator::QgsMemoryFeatureIterator( QgsMemoryFeatureSource* source, bool ownSource, const QgsFeatureRequest& request )
     : QgsAbstractFeatureIteratorFromSource<QgsMemoryFeatureSource>( source, ownSource, request )
     , mSelectRectGeom( nullptr )
     , mSubsetExpression( nullptr )
+    , mSelectRow( 0 )
+    , mFetchGeometry( !( mRequest.flags() & QgsFeatureRequest::NoGeometry ) )
 {
   if ( !mSource->mSubsetString.isEmpty() )
   {
@@ -38,6 +42,28 @@ QgsMemoryFeatureIterator::QgsMemoryFeatureIterator( QgsMemoryFeatureSource* sour
     mSelectRectGeom = QgsGeometry::fromRect( request.filterRect() );
   }
 
+  if ( mSource->mColumnar )
+  {
+    // only the column oriented storage builds features on the fly, so it is worth
+    // to fetch just the requested attributes
+    mFetchAttributes = ( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes ) ? mRequest.subsetOfAttributes() : mSource->mFields.allAttributesList();
+
+    // ensure that all attributes required for expression filter are being fetched
+    if ( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes && mRequest.filterType() == QgsFeatureRequest::FilterExpression )
+    {
+      Q_FOREACH ( const QString& field, mRequest.filterExpression()->referencedColumns() )
+      {
+        int attrIdx = mSource->mFields.fieldNameIndex( field );
+        if ( attrIdx >= 0 && !mFetchAttributes.contains( attrIdx ) )
+          mFetchAttributes << attrIdx;
+      }
+    }
+    if ( mRequest.filterType() == QgsFeatureRequest::FilterExpression && mRequest.filterExpression()->needsGeometry() )
+    {
+      mFetchGeometry = true;
+    }
+  }
+
   // if there's spatial index, use it!
   // (but don't use it when selection rect is not specified)
   if ( !mRequest.filterRect().isNull() && mSource->mSpatialIndex )
@@ -49,9 +75,17 @@ QgsMemoryFeatureIterator::QgsMemoryFeatureIterator( QgsMemoryFeatureSource* sour
   else if ( mRequest.filterType() == QgsFeatureRequest::FilterFid )
   {
     mUsingFeatureIdList = true;
-    QgsFeatureMap::const_iterator it = mSource->mFeatures.constFind( mRequest.filterFid() );
-    if ( it != mSource->mFeatures.constEnd() )
-      mFeatureIdList.append( mRequest.filterFid() );
+    if ( mSource->mColumnar )
+    {
+      if ( mSource->mColumnStore.row( mRequest.filterFid() ) >= 0 )
+        mFeatureIdList.append( mRequest.filterFid() );
+    }
+    else
+    {
+      QgsFeatureMap::const_iterator it = mSource->mFeatures.constFind( mRequest.filterFid() );
+      if ( it != mSource->mFeatures.constEnd() )
+        mFeatureIdList.append( mRequest.filterFid() );
+    }
   }
   else
   {
@@ -76,7 +110,9 @@ bool QgsMemoryFeatureIterator::fetchFeature( QgsFeature& feature )
   if ( mClosed )
     return false;
 
-  if ( mUsingFeatureIdList )
+  if ( mSource->mColumnar )
+    return mUsingFeatureIdList ? nextRowUsingList( feature ) : nextRowTraverseAll( feature );
+  else if ( mUsingFeatureIdList )
     return nextFeatureUsingList( feature );
   else
     return nextFeatureTraverseAll( feature );
@@ -183,6 +219,76 @@ bool QgsMemoryFeatureIterator::nextFeatureTraverseAll( QgsFeature& feature )
   return hasFeature;
 }
 
+
+bool QgsMemoryFeatureIterator::nextRowUsingList( QgsFeature& feature )
+{
+  while ( mFeatureIdListIterator != mFeatureIdList.constEnd() )
+  {
+    int row = mSource->mColumnStore.row( *mFeatureIdListIterator );
+    ++mFeatureIdListIterator;
+
+    if ( row >= 0 && acceptRow( row, feature ) )
+      return true;
+  }
+
+  close();
+  return false;
+}
+
+
+bool QgsMemoryFeatureIterator::nextRowTraverseAll( QgsFeature& feature )
+{
+  const QgsMemoryColumnStore& store = mSource->mColumnStore;
+  while ( mSelectRow < store.rowCount() )
+  {
+    int row = mSelectRow++;
+
+    if ( !store.isDeleted( row ) && acceptRow( row, feature ) )
+      return true;
+  }
+
+  close();
+  return false;
+}
+
+
+bool QgsMemoryFeatureIterator::acceptRow( int row, QgsFeature& feature )
+{
+  const QgsMemoryColumnStore& store = mSource->mColumnStore;
+
+  // check just bounding box against rect first, it does not need the geometry to be built
+  if ( !mRequest.filterRect().isNull() )
+  {
+    if ( !store.hasGeometry( row ) || !store.boundingBox( row ).intersects( mRequest.filterRect() ) )
+      return false;
+  }
+
+  QScopedPointer<QgsGeometry> geom;
+  if ( mSelectRectGeom )
+  {
+    // using exact test when checking for intersection
+    geom.reset( store.geometry( row ) );
+    if ( !geom || !geom->intersects( mSelectRectGeom ) )
+      return false;
+  }
+
+  if ( mSubsetExpression )
+  {
+    QgsFeature f;
+    store.feature( row, f, mSource->mFields.allAttributesList(), mSubsetExpression->needsGeometry() );
+    f.setFields( mSource->mFields );
+    mSource->mExpressionContext.setFeature( f );
+    if ( !mSubsetExpression->evaluate( &mSource->mExpressionContext ).toBool() )
+      return false;
+  }
+
+  store.feature( row, feature, mFetchAttributes, mFetchGeometry && !geom );
+  if ( mFetchGeometry && geom )
+    feature.setGeometry( geom.take() );
+  feature.setFields( mSource->mFields ); // allow name-based attribute lookups
+  return true;
+}
+
 bool QgsMemoryFeatureIterator::rewind()
 {
   if ( mClosed )
@@ -193,6 +299,8 @@ bool QgsMemoryFeatureIterator::rewind()
   else
     mSelectIterator = mSource->mFeatures.constBegin();
 
+  mSelectRow = 0;
+
   return true;
 }
 
@@ -215,6 +323,8 @@ bool QgsMemoryFeatureIterator::close()
 QgsMemoryFeatureSource::QgsMemoryFeatureSource( const QgsMemoryProvider* p )
     : mFields( p->mFields )
     , mFeatures( p->mFeatures )
+    , mColumnar( p->mColumnar )
+    , mColumnStore( p->mColumnStore )
     , mSpatialIndex( p->mSpatialIndex ? new QgsSpatialIndex( *p->mSpatialIndex ) : nullptr )  // just shallow copy
     , mSubsetString( p->mSubsetString )
 {
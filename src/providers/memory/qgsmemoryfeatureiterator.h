@@ -17,6 +17,7 @@
 
 #include "qgsfeatureiterator.h"
 #include "qgsexpressioncontext.h"
+#include "qgsmemorycolumnstore.h"
 
 class QgsMemoryProvider;
 
@@ -36,6 +37,8 @@ class QgsMemoryFeatureSource : public QgsAbstractFeatureSource
   protected:
     QgsFields mFields;
     QgsFeatureMap mFeatures;
+    bool mColumnar;
+    QgsMemoryColumnStore mColumnStore;
     QgsSpatialIndex* mSpatialIndex;
     QString mSubsetString;
     QgsExpressionContext mExpressionContext;
@@ -65,6 +68,13 @@ class QgsMemoryFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Qgs
     bool nextFeatureUsingList( QgsFeature& feature );
     bool nextFeatureTraverseAll( QgsFeature& feature );
 
+    //! column oriented storage: fetch next feature from the list of feature ids
+    bool nextRowUsingList( QgsFeature& feature );
+    //! column oriented storage: fetch next feature traversing all rows
+    bool nextRowTraverseAll( QgsFeature& feature );
+    //! column oriented storage: test the row against the request and fill the feature
+    bool acceptRow( int row, QgsFeature& feature );
+
     QgsGeometry* mSelectRectGeom;
     QgsFeatureMap::const_iterator mSelectIterator;
     bool mUsingFeatureIdList;
@@ -72,6 +82,11 @@ class QgsMemoryFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Qgs
     QList<QgsFeatureId>::const_iterator mFeatureIdListIterator;
     QgsExpression* mSubsetExpression;
 
+    // used with column oriented storage only
+    int mSelectRow;
+    bool mFetchGeometry;
+    QgsAttributeList mFetchAttributes;
+
 };
 
 #endif // QGSMEMORYFEATUREITERATOR_H
@@ -32,6 +32,7 @@ static const QString TEXT_PROVIDER_DESCRIPTION = "Memory provider";
 
 QgsMemoryProvider::QgsMemoryProvider( const QString& uri )
     : QgsVectorDataProvider( uri )
+    , mColumnar( false )
     , mSpatialIndex( nullptr )
 {
   // Initialize the geometry with the uri to support old style uri's
@@ -71,6 +72,11 @@ QgsMemoryProvider::QgsMemoryProvider( const QString& uri )
     mCrs.createFromString( crsDef );
   }
 
+  if ( url.hasQueryItem( "storage" ) && url.queryItemValue( "storage" ) == "columnar" )
+  {
+    mColumnar = true;
+  }
+
   mNextFeatureId = 1;
 
   mNativeTypes
@@ -258,6 +264,10 @@ QString QgsMemoryProvider::dataSourceUri( bool expandAuthConfig ) const
   {
     uri.addQueryItem( "index", "yes" );
   }
+  if ( mColumnar )
+  {
+    uri.addQueryItem( "storage", "columnar" );
+  }
 
   QgsAttributeList attrs = const_cast<QgsMemoryProvider *>( this )->attributeIndexes();
   for ( int i = 0; i < attrs.size(); i++ )
@@ -296,7 +306,7 @@ QGis::WkbType QgsMemoryProvider::geometryType() const
 long QgsMemoryProvider::featureCount() const
 {
   if ( mSubsetString.isEmpty() )
-    return mFeatures.count();
+    return mColumnar ? mColumnStore.count() : mFeatures.count();
 
   // subset string set, no alternative but testing each feature
   QgsFeatureIterator fit = QgsFeatureIterator( new QgsMemoryFeatureIterator( new QgsMemoryFeatureSource( this ), true,  QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ) ) );
@@ -328,24 +338,40 @@ QgsCoordinateReferenceSystem QgsMemoryProvider::crs()
 
 bool QgsMemoryProvider::addFeatures( QgsFeatureList & flist )
 {
+  // the extent is only extended by the new features instead of being recalculated
+  if ( !flist.isEmpty() && ( mColumnar ? mColumnStore.count() : mFeatures.count() ) == 0 )
+    mExtent.setMinimal();
+
   // TODO: sanity checks of fields and geometries
   for ( QgsFeatureList::iterator it = flist.begin(); it != flist.end(); ++it )
   {
-    mFeatures[mNextFeatureId] = *it;
-    QgsFeature& newfeat = mFeatures[mNextFeatureId];
-    newfeat.setFeatureId( mNextFeatureId );
-    newfeat.setValid( true );
     it->setFeatureId( mNextFeatureId );
 
-    // update spatial index
-    if ( mSpatialIndex )
-      mSpatialIndex->insertFeature( newfeat );
+    if ( mColumnar )
+    {
+      mColumnStore.addFeature( *it );
+
+      // update spatial index
+      if ( mSpatialIndex )
+        mSpatialIndex->insertFeature( *it );
+    }
+    else
+    {
+      mFeatures[mNextFeatureId] = *it;
+      QgsFeature& newfeat = mFeatures[mNextFeatureId];
+      newfeat.setValid( true );
+
+      // update spatial index
+      if ( mSpatialIndex )
+        mSpatialIndex->insertFeature( newfeat );
+    }
+
+    if ( it->constGeometry() )
+      mExtent.unionRect( it->constGeometry()->boundingBox() );
 
     mNextFeatureId++;
   }
 
-  updateExtent();
-
   return true;
 }
 
@@ -353,6 +379,24 @@ bool QgsMemoryProvider::deleteFeatures( const QgsFeatureIds & id )
 {
   for ( QgsFeatureIds::const_iterator it = id.begin(); it != id.end(); ++it )
   {
+    if ( mColumnar )
+    {
+      int row = mColumnStore.row( *it );
+      if ( row < 0 )
+        continue;
+
+      // update spatial index
+      if ( mSpatialIndex )
+      {
+        QgsFeature feat;
+        mColumnStore.feature( row, feat, QgsAttributeList(), true );
+        mSpatialIndex->deleteFeature( feat );
+      }
+
+      mColumnStore.deleteFeature( *it );
+      continue;
+    }
+
     QgsFeatureMap::iterator fit = mFeatures.find( *it );
 
     // check whether such feature exists
@@ -392,6 +436,12 @@ bool QgsMemoryProvider::addAttributes( const QList<QgsField> &attributes )
     // add new field as a last one
     mFields.append( *it );
 
+    if ( mColumnar )
+    {
+      mColumnStore.addField( it->type() );
+      continue;
+    }
+
     for ( QgsFeatureMap::iterator fit = mFeatures.begin(); fit != mFeatures.end(); ++fit )
     {
       QgsFeature& f = fit.value();
@@ -438,6 +488,12 @@ bool QgsMemoryProvider::deleteAttributes( const QgsAttributeIds& attributes )
     int idx = *it;
     mFields.remove( idx );
 
+    if ( mColumnar )
+    {
+      mColumnStore.removeField( idx );
+      continue;
+    }
+
     for ( QgsFeatureMap::iterator fit = mFeatures.begin(); fit != mFeatures.end(); ++fit )
     {
       QgsFeature& f = fit.value();
@@ -453,6 +509,14 @@ bool QgsMemoryProvider::changeAttributeValues( const QgsChangedAttributesMap &at
 {
   for ( QgsChangedAttributesMap::const_iterator it = attr_map.begin(); it != attr_map.end(); ++it )
   {
+    if ( mColumnar )
+    {
+      const QgsAttributeMap& attrs = it.value();
+      for ( QgsAttributeMap::const_iterator it2 = attrs.constBegin(); it2 != attrs.constEnd(); ++it2 )
+        mColumnStore.changeAttributeValue( it.key(), it2.key(), it2.value() );
+      continue;
+    }
+
     QgsFeatureMap::iterator fit = mFeatures.find( it.key() );
     if ( fit == mFeatures.end() )
       continue;
@@ -468,6 +532,31 @@ bool QgsMemoryProvider::changeGeometryValues( const QgsGeometryMap &geometry_map
 {
   for ( QgsGeometryMap::const_iterator it = geometry_map.begin(); it != geometry_map.end(); ++it )
   {
+    if ( mColumnar )
+    {
+      int row = mColumnStore.row( it.key() );
+      if ( row < 0 )
+        continue;
+
+      // update spatial index
+      QgsFeature feat;
+      if ( mSpatialIndex )
+      {
+        mColumnStore.feature( row, feat, QgsAttributeList(), true );
+        mSpatialIndex->deleteFeature( feat );
+      }
+
+      mColumnStore.changeGeometry( it.key(), it.value() );
+
+      // update spatial index
+      if ( mSpatialIndex )
+      {
+        feat.setGeometry( it.value() );
+        mSpatialIndex->insertFeature( feat );
+      }
+      continue;
+    }
+
     QgsFeatureMap::iterator fit = mFeatures.find( it.key() );
     if ( fit == mFeatures.end() )
       continue;
@@ -518,9 +607,24 @@ bool QgsMemoryProvider::createSpatialIndex()
     mSpatialIndex = new QgsSpatialIndex();
 
     // add existing features to index
-    for ( QgsFeatureMap::const_iterator it = mFeatures.constBegin(); it != mFeatures.constEnd(); ++it )
+    if ( mColumnar )
+    {
+      QgsFeature feat;
+      for ( int row = 0; row < mColumnStore.rowCount(); ++row )
+      {
+        if ( mColumnStore.isDeleted( row ) )
+          continue;
+
+        mColumnStore.feature( row, feat, QgsAttributeList(), true );
+        mSpatialIndex->insertFeature( feat );
+      }
+    }
+    else
     {
-      mSpatialIndex->insertFeature( *it );
+      for ( QgsFeatureMap::const_iterator it = mFeatures.constBegin(); it != mFeatures.constEnd(); ++it )
+      {
+        mSpatialIndex->insertFeature( *it );
+      }
     }
   }
   return true;
@@ -536,10 +640,20 @@ int QgsMemoryProvider::capabilities() const
 
 void QgsMemoryProvider::updateExtent()
 {
-  if ( mFeatures.isEmpty() )
+  if (( mColumnar ? mColumnStore.count() : mFeatures.count() ) == 0 )
   {
     mExtent = QgsRectangle();
   }
+  else if ( mColumnar )
+  {
+    // stored bounding boxes avoid building the geometries
+    mExtent.setMinimal();
+    for ( int row = 0; row < mColumnStore.rowCount(); ++row )
+    {
+      if ( !mColumnStore.isDeleted( row ) && mColumnStore.hasGeometry( row ) )
+        mExtent.unionRect( mColumnStore.boundingBox( row ) );
+    }
+  }
   else
   {
     mExtent.setMinimal();
@@ -15,6 +15,7 @@
 
 #include "qgsvectordataprovider.h"
 #include "qgscoordinatereferencesystem.h"
+#include "qgsmemorycolumnstore.h"
 
 
 typedef QMap<QgsFeatureId, QgsFeature> QgsFeatureMap;
@@ -176,6 +177,10 @@ class QgsMemoryProvider : public QgsVectorDataProvider
     QgsFeatureMap mFeatures;
     QgsFeatureId mNextFeatureId;
 
+    // column oriented storage used instead of mFeatures with "storage=columnar" uri option
+    bool mColumnar;
+    QgsMemoryColumnStore mColumnStore;
+
     // indexing
     QgsSpatialIndex* mSpatialIndex;
 
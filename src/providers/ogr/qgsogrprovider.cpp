@@ -17,6 +17,7 @@ email                : sherman at mrcc.com
 
 #include "qgsogrprovider.h"
 #include "qgsogrfeatureiterator.h"
+#include "qgssqliteexpressioncompiler.h"
 #include "qgslogger.h"
 #include "qgsmessagelog.h"
 #include "qgslocalec.h"
@@ -2660,6 +2661,89 @@ QgsCoordinateReferenceSystem QgsOgrProvider::crs()
   return srs;
 }
 
+QVariant QgsOgrProvider::aggregate( QgsAggregateCalculator::Aggregate aggregate, int index,
+    const QgsAggregateCalculator::AggregateParameters& parameters, QgsExpressionContext* context, bool& ok )
+{
+  Q_UNUSED( context );
+  ok = false;
+
+  // only SQLite based formats execute SQL natively, other formats would be scanned by OGR anyway
+  if ( !mValid || index < 0 || index >= mAttributeFields.count() || ( ogrDriverName != "GPKG" && ogrDriverName != "SQLite" ) )
+  {
+    return QVariant();
+  }
+  const QgsField& fld = mAttributeFields.at( index );
+
+  // SQLite does not provide standard deviation aggregate functions
+  QString aggregateExpression = aggregateSql( aggregate, fld, mEncoding->toUnicode( quotedIdentifier( mEncoding->fromUnicode( fld.name() ) ) ), false );
+  if ( aggregateExpression.isEmpty() )
+  {
+    return QVariant();
+  }
+
+  QByteArray sql = "SELECT " + mEncoding->fromUnicode( aggregateExpression );
+  sql += " FROM " + quotedIdentifier( OGR_FD_GetName( OGR_L_GetLayerDefn( ogrOrigLayer ) ) );
+
+  QStringList whereClauses;
+  if ( !mSubsetString.isEmpty() )
+  {
+    whereClauses << '(' + mSubsetString + ')';
+  }
+
+  if ( !parameters.filter.isEmpty() )
+  {
+    // the filter must be evaluated completely by the database
+    if ( !QSettings().value( "/qgis/compileExpressions", true ).toBool() )
+    {
+      return QVariant();
+    }
+
+    QgsExpression filter( parameters.filter );
+    QgsSQLiteExpressionCompiler compiler( mAttributeFields );
+    if ( filter.hasParserError() || compiler.compile( &filter ) != QgsSqlExpressionCompiler::Complete )
+    {
+      return QVariant();
+    }
+
+    whereClauses << '(' + compiler.result() + ')';
+  }
+
+  if ( !whereClauses.isEmpty() )
+  {
+    sql += " WHERE " + mEncoding->fromUnicode( whereClauses.join( " AND " ) );
+  }
+
+  OGRLayerH l = OGR_DS_ExecuteSQL( ogrDataSource, sql.constData(), nullptr, nullptr );
+  if ( !l )
+  {
+    QgsDebugMsg( QString( "Failed to execute SQL: %1" ).arg( mEncoding->toUnicode( sql ) ) );
+    return QVariant();
+  }
+
+  // NULL results (eg. no matching values) are left to QgsAggregateCalculator
+  bool converted = false;
+  double value = 0;
+  OGRFeatureH f = OGR_L_GetNextFeature( l );
+  if ( f )
+  {
+    if ( OGR_F_IsFieldSet( f, 0 ) )
+    {
+      value = QString( OGR_F_GetFieldAsString( f, 0 ) ).toDouble( &converted );
+    }
+    OGR_F_Destroy( f );
+  }
+
+  OGR_DS_ReleaseResultSet( ogrDataSource, l );
+
+  if ( !converted )
+  {
+    return QVariant();
+  }
+
+  ok = true;
+  return value;
+}
+
 void QgsOgrProvider::uniqueValues( int index, QList<QVariant> &uniqueValues, int limit )
 {
   uniqueValues.clear();
@@ -2678,7 +2762,7 @@ void QgsOgrProvider::uniqueValues( int index, QList<QVariant> &uniqueValues, int
   return QgsVectorDataProvider::uniqueValues( index, uniqueValues, limit );
 #else
   QByteArray sql = "SELECT DISTINCT " + quotedIdentifier( mEncoding->fromUnicode( fld.name() ) );
-  sql += " FROM " + quotedIdentifier( OGR_FD_GetName( OGR_L_GetLayerDefn( ogrLayer ) ) );
+  sql += " FROM " + quotedIdentifier( OGR_FD_GetName( OGR_L_GetLayerDefn( ogrOrigLayer ) ) );
 
   if ( !mSubsetString.isEmpty() )
   {
@@ -2719,7 +2803,7 @@ QVariant QgsOgrProvider::minimumValue( int index )
 
   // Don't quote column name (see https://trac.osgeo.org/gdal/ticket/5799#comment:9)
   QByteArray sql = "SELECT MIN(" + mEncoding->fromUnicode( fld.name() );
-  sql += ") FROM " + quotedIdentifier( OGR_FD_GetName( OGR_L_GetLayerDefn( ogrLayer ) ) );
+  sql += ") FROM " + quotedIdentifier( OGR_FD_GetName( OGR_L_GetLayerDefn( ogrOrigLayer ) ) );
 
   if ( !mSubsetString.isEmpty() )
   {
@@ -2758,7 +2842,7 @@ QVariant QgsOgrProvider::maximumValue( int index )
 
   // Don't quote column name (see https://trac.osgeo.org/gdal/ticket/5799#comment:9)
   QByteArray sql = "SELECT MAX(" + mEncoding->fromUnicode( fld.name() );
-  sql += ") FROM " + quotedIdentifier( OGR_FD_GetName( OGR_L_GetLayerDefn( ogrLayer ) ) );
+  sql += ") FROM " + quotedIdentifier( OGR_FD_GetName( OGR_L_GetLayerDefn( ogrOrigLayer ) ) );
 
   if ( !mSubsetString.isEmpty() )
   {
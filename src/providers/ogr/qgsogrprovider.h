@@ -206,6 +206,20 @@ class QgsOgrProvider : public QgsVectorDataProvider
      */
     virtual void uniqueValues( int index, QList<QVariant> &uniqueValues, int limit = -1 ) override;
 
+    /** Calculates an aggregate in the database for SQLite based formats (GeoPackage, SQLite),
+     *  if the aggregate and the filter can be translated to SQL
+     *  @param aggregate aggregate to calculate
+     *  @param index the index of the attribute
+     *  @param parameters parameters controlling aggregate calculation
+     *  @param context expression context for filter
+     *  @param ok will be set to true if the aggregate was calculated by the database
+     */
+    virtual QVariant aggregate( QgsAggregateCalculator::Aggregate aggregate,
+                                int index,
+                                const QgsAggregateCalculator::AggregateParameters& parameters,
+                                QgsExpressionContext* context,
+                                bool& ok ) override;
+
     /** Return a provider name
      *
      * Essentially just returns the provider key.  Should be used to build file
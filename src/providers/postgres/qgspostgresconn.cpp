@@ -1159,6 +1159,18 @@ int QgsPostgresConn::PQsendQuery( const QString& query )
   return ::PQsendQuery( mConn, query.toUtf8() );
 }
 
+int QgsPostgresConn::PQputCopyData( const char *buffer, int nbytes )
+{
+  Q_ASSERT( mConn );
+  return ::PQputCopyData( mConn, buffer, nbytes );
+}
+
+int QgsPostgresConn::PQputCopyEnd( const char *errormsg )
+{
+  Q_ASSERT( mConn );
+  return ::PQputCopyEnd( mConn, errormsg );
+}
+
 bool QgsPostgresConn::begin()
 {
   if ( mTransaction )
@@ -1280,6 +1292,54 @@ qint64 QgsPostgresConn::getBinaryInt( QgsPostgresResult &queryResult, int row, i
   return oid;
 }
 
+double QgsPostgresConn::getBinaryDouble( QgsPostgresResult &queryResult, int row, int col )
+{
+  const char *p = PQgetvalue( queryResult.result(), row, col );
+  int s = PQgetlength( queryResult.result(), row, col );
+
+  if ( s != 8 )
+  {
+    QgsDebugMsg( QString( "unexpected size %1" ).arg( s ) );
+    return 0.0;
+  }
+
+  quint32 hi, lo;
+  memcpy( &hi, p, sizeof( quint32 ) );
+  memcpy( &lo, p + sizeof( quint32 ), sizeof( quint32 ) );
+  if ( mSwapEndian )
+  {
+    hi = ntohl( hi );
+    lo = ntohl( lo );
+  }
+
+  quint64 bits = ( quint64( hi ) << 32 ) | lo;
+  double value;
+  memcpy( &value, &bits, sizeof( double ) );
+  return value;
+}
+
+bool QgsPostgresConn::hasBinaryValue( const QgsField &fld )
+{
+  // float4 stays with text output, its binary value would show float rounding artifacts
+  const QString &type = fld.typeName();
+  return type == "int2" || type == "int4" || type == "int8" || type == "float8";
+}
+
+QVariant QgsPostgresConn::getBinaryValue( QgsPostgresResult &queryResult, int row, int col, const QgsField &fld )
+{
+  if ( ::PQgetisnull( queryResult.result(), row, col ) )
+    return QVariant( fld.type() );
+
+  if ( fld.typeName() == "float8" )
+    return QVariant( getBinaryDouble( queryResult, row, col ) );
+
+  qint64 value = getBinaryInt( queryResult, row, col );
+  if ( fld.type() == QVariant::LongLong )
+    return QVariant( value );
+  else
+    return QVariant( static_cast<int>( value ) );
+}
+
 QString QgsPostgresConn::fieldExpression( const QgsField &fld, QString expr )
 {
   const QString &type = fld.typeName();
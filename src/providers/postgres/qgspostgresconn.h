@@ -247,6 +247,8 @@ class QgsPostgresConn : public QObject
     void PQfinish();
     QString PQerrorMessage();
     int PQsendQuery( const QString& query );
+    int PQputCopyData( const char *buffer, int nbytes );
+    int PQputCopyEnd( const char *errormsg = nullptr );
     int PQstatus();
     PGresult *PQgetResult();
     PGresult *PQprepare( const QString& stmtName, const QString& query, int nParams, const Oid *paramTypes );
@@ -305,6 +307,17 @@ class QgsPostgresConn : public QObject
 
     qint64 getBinaryInt( QgsPostgresResult &queryResult, int row, int col );
 
+    //! get a float8 value from a binary cursor
+    double getBinaryDouble( QgsPostgresResult &queryResult, int row, int col );
+
+    /** Returns true if values of the field are fetched from binary cursors as they are
+     * instead of being converted to text (see getBinaryValue())
+     */
+    static bool hasBinaryValue( const QgsField &fld );
+
+    //! get the value of a field with hasBinaryValue() from a binary cursor
+    QVariant getBinaryValue( QgsPostgresResult &queryResult, int row, int col, const QgsField &fld );
+
     QString fieldExpression( const QgsField &fld, QString expr = "%1" );
 
     QString connInfo() const { return mConnInfo; }
@@ -27,11 +27,17 @@
 
 
 const int QgsPostgresFeatureIterator::sFeatureQueueSize = 2000;
+const int QgsPostgresFeatureIterator::sMinFeatureQueueSize = 500;
+const int QgsPostgresFeatureIterator::sMaxFeatureQueueSize = 50000;
+const qint64 QgsPostgresFeatureIterator::sMaxBatchBytes = 16 * 1024 * 1024;
 
 
 QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource* source, bool ownSource, const QgsFeatureRequest& request )
     : QgsAbstractFeatureIteratorFromSource<QgsPostgresFeatureSource>( source, ownSource, request )
-    , mFeatureQueueSize( sFeatureQueueSize )
+    , mBatchSize( sFeatureQueueSize, sMinFeatureQueueSize, sMaxFeatureQueueSize, sMaxBatchBytes )
+    , mBatchRequested( 0 )
+    , mPrefetch( false )
+    , mFetchPending( false )
     , mFetched( 0 )
     , mFetchGeometry( false )
     , mExpressionCompiled( false )
@@ -43,6 +49,10 @@ QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource
   {
     mConn = QgsPostgresConnPool::instance()->acquireConnection( mSource->mConnInfo );
     mIsTransactionConnection = false;
+
+    // the connection is ours until the iterator gets closed, so a request may stay
+    // in progress between calls to fetchFeature()
+    mPrefetch = QSettings().value( "/PostgreSQL/prefetchFeatures", true ).toBool();
   }
   else
   {
@@ -227,40 +237,8 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature& feature )
 
   if ( mFeatureQueue.empty() && !mLastFetch )
   {
-    QString fetch = QString( "FETCH FORWARD %1 FROM %2" ).arg( mFeatureQueueSize ).arg( mCursorName );
-    QgsDebugMsgLevel( QString( "fetching %1 features." ).arg( mFeatureQueueSize ), 4 );
-
     lock();
-    if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
-    {
-      QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-    }
-
-    QgsPostgresResult queryResult;
-    for ( ;; )
-    {
-      queryResult = mConn->PQgetResult();
-      if ( !queryResult.result() )
-        break;
-
-      if ( queryResult.PQresultStatus() != PGRES_TUPLES_OK )
-      {
-        QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-        break;
-      }
-
-      int rows = queryResult.PQntuples();
-      if ( rows == 0 )
-        continue;
-
-      mLastFetch = rows < mFeatureQueueSize;
-
-      for ( int row = 0; row < rows; row++ )
-      {
-        mFeatureQueue.enqueue( QgsFeature() );
-        getFeature( queryResult, row, mFeatureQueue.back() );
-      } // for each row in queue
-    }
+    fetchBatch();
     unlock();
   }
 
@@ -283,6 +261,94 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature& feature )
   return true;
 }
 
+bool QgsPostgresFeatureIterator::sendFetch()
+{
+  mBatchRequested = mBatchSize.size();
+
+  QString fetch = QString( "FETCH FORWARD %1 FROM %2" ).arg( mBatchRequested ).arg( mCursorName );
+  QgsDebugMsgLevel( QString( "fetching %1 features." ).arg( mBatchRequested ), 4 );
+
+  if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
+  {
+    QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+    return false;
+  }
+
+  mFetchPending = true;
+  return true;
+}
+
+void QgsPostgresFeatureIterator::fetchBatch()
+{
+  int consumeMsecs = mBatchReceived.isNull() ? 0 : mBatchReceived.elapsed();
+
+  QTime waitTime;
+  waitTime.start();
+
+  // without prefetching (or for the first batch) the request is sent just now
+  if ( !mFetchPending && !sendFetch() )
+  {
+    mLastFetch = true;
+    return;
+  }
+
+  QgsPostgresResult queryResult;
+  for ( ;; )
+  {
+    PGresult *res = mConn->PQgetResult();
+    if ( !res )
+      break;
+
+    if ( ::PQresultStatus( res ) != PGRES_TUPLES_OK )
+    {
+      QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+      ::PQclear( res );
+      continue;
+    }
+
+    // FETCH returns a single set of rows
+    queryResult = res;
+  }
+  mFetchPending = false;
+  mBatchReceived.start();
+
+  int rows = queryResult.result() ? queryResult.PQntuples() : 0;
+  mLastFetch = rows < mBatchRequested;
+
+  if ( rows > 0 )
+  {
+    qint64 bytes = 0;
+    int cols = queryResult.PQnfields();
+    for ( int row = 0; row < rows; row++ )
+    {
+      for ( int col = 0; col < cols; col++ )
+        bytes += ::PQgetlength( queryResult.result(), row, col );
+    }
+    mBatchSize.batchReceived( rows, bytes, waitTime.elapsed(), consumeMsecs );
+  }
+
+  // let the server prepare the next batch while this one is being decoded and consumed
+  if ( mPrefetch && !mLastFetch )
+    sendFetch();
+
+  for ( int row = 0; row < rows; row++ )
+  {
+    mFeatureQueue.enqueue( QgsFeature() );
+    getFeature( queryResult, row, mFeatureQueue.back() );
+  } // for each row in queue
+}
+
+void QgsPostgresFeatureIterator::discardPendingFetch()
+{
+  if ( !mFetchPending )
+    return;
+
+  while ( PGresult *res = mConn->PQgetResult() )
+    ::PQclear( res );
+
+  mFetchPending = false;
+}
+
 bool QgsPostgresFeatureIterator::nextFeatureFilterExpression( QgsFeature& f )
 {
   if ( !mExpressionCompiled )
@@ -344,11 +410,13 @@ bool QgsPostgresFeatureIterator::rewind()
   // move cursor to first record
 
   lock();
+  discardPendingFetch();
   mConn->PQexecNR( QString( "move absolute 0 in %1" ).arg( mCursorName ) );
   unlock();
   mFeatureQueue.clear();
   mFetched = 0;
   mLastFetch = false;
+  mBatchReceived = QTime();
 
   return true;
 }
@@ -359,6 +427,7 @@ bool QgsPostgresFeatureIterator::close()
     return false;
 
   lock();
+  discardPendingFetch();
   mConn->closeCursor( mCursorName );
   unlock();
 
@@ -598,13 +667,25 @@ bool QgsPostgresFeatureIterator::declareCursor( const QString& whereClause, long
       return false;
   }
 
+  // numeric values are fetched in their binary form, decoding them is cheaper than parsing text
+  mBinaryValues.fill( false, mSource->mFields.count() );
+
   bool subsetOfAttributes = mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes;
   Q_FOREACH ( int idx, subsetOfAttributes ? mRequest.subsetOfAttributes() : mSource->mFields.allAttributesList() )
   {
     if ( mSource->mPrimaryKeyAttrs.contains( idx ) )
       continue;
 
-    query += delim + mConn->fieldExpression( mSource->mFields.at( idx ) );
+    const QgsField &fld = mSource->mFields.at( idx );
+    if ( QgsPostgresConn::hasBinaryValue( fld ) )
+    {
+      mBinaryValues[idx] = true;
+      query += delim + QgsPostgresConn::quotedIdentifier( fld.name() );
+    }
+    else
+    {
+      query += delim + mConn->fieldExpression( fld );
+    }
   }
 
   query += " FROM " + mSource->mQuery;
@@ -768,7 +849,10 @@ void QgsPostgresFeatureIterator::getFeatureAttribute( int idx, QgsPostgresResult
   if ( mSource->mPrimaryKeyAttrs.contains( idx ) )
     return;
 
-  QVariant v = QgsPostgresProvider::convertValue( mSource->mFields.at( idx ).type(), queryResult.PQgetvalue( row, col ) );
+  const QgsField &fld = mSource->mFields.at( idx );
+  QVariant v = mBinaryValues.at( idx )
+               ? mConn->getBinaryValue( queryResult, row, col, fld )
+               : QgsPostgresProvider::convertValue( fld.type(), queryResult.PQgetvalue( row, col ) );
   feature.setAttribute( idx, v );
 
   col++;
@@ -16,8 +16,10 @@
 #define QGSPOSTGRESFEATUREITERATOR_H
 
 #include "qgsfeatureiterator.h"
+#include "qgsadaptivebatchsize.h"
 
 #include <QQueue>
+#include <QTime>
 
 #include "qgspostgresprovider.h"
 
@@ -99,6 +101,13 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
     void getFeatureAttribute( int idx, QgsPostgresResult& queryResult, int row, int& col, QgsFeature& feature );
     bool declareCursor( const QString& whereClause, long limit = -1, bool closeOnFail = true , const QString& orderBy = QString() );
 
+    //! send FETCH of the next batch of features from the cursor without waiting for the result
+    bool sendFetch();
+    //! wait for the pending batch, request the following one (when prefetching) and fill the feature queue
+    void fetchBatch();
+    //! wait for and drop the result of a prefetched batch which will not be used
+    void discardPendingFetch();
+
     QString mCursorName;
 
     /**
@@ -107,8 +116,20 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
      */
     QQueue<QgsFeature> mFeatureQueue;
 
-    //! Maximal size of the feature queue
-    int mFeatureQueueSize;
+    //! Number of features requested in a batch, adapted to the row size and latency
+    QgsAdaptiveBatchSize mBatchSize;
+
+    //! Number of features requested in the pending batch
+    int mBatchRequested;
+
+    //! Set to true, if the next batch is requested while the current one is consumed
+    bool mPrefetch;
+
+    //! Set to true, if a FETCH has been sent and its result not yet received
+    bool mFetchPending;
+
+    //! Time of receiving the last batch (to measure how long it takes to consume it)
+    QTime mBatchReceived;
 
     //! Number of retrieved features
     int mFetched;
@@ -116,9 +137,15 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
     //! Set to true, if geometry is in the requested columns
     bool mFetchGeometry;
 
+    //! Flags of attributes (by field index) fetched in binary form instead of text
+    QVector<bool> mBinaryValues;
+
     bool mIsTransactionConnection;
 
     static const int sFeatureQueueSize;
+    static const int sMinFeatureQueueSize;
+    static const int sMaxFeatureQueueSize;
+    static const qint64 sMaxBatchBytes;
 
   private:
     //! returns whether the iterator supports simplify geometries on provider side
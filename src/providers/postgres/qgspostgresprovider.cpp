@@ -25,6 +25,11 @@
 #include <qgscoordinatereferencesystem.h>
 
 #include <QMessageBox>
+#include <QSettings>
+#include <QtEndian>
+
+#include <cmath>
+#include <limits>
 
 #include "qgsvectorlayerimport.h"
 #include "qgsprovidercountcalcevent.h"
@@ -35,6 +40,7 @@
 #include "qgspgsourceselect.h"
 #include "qgspostgresdataitems.h"
 #include "qgspostgresfeatureiterator.h"
+#include "qgspostgresexpressioncompiler.h"
 #include "qgspostgrestransaction.h"
 #include "qgslogger.h"
 #include "qgscrscache.h"
@@ -1471,6 +1477,64 @@ QVariant QgsPostgresProvider::minimumValue( int index )
   }
 }
 
+QVariant QgsPostgresProvider::aggregate( QgsAggregateCalculator::Aggregate aggregate, int index,
+    const QgsAggregateCalculator::AggregateParameters& parameters, QgsExpressionContext* context, bool& ok )
+{
+  Q_UNUSED( context );
+  ok = false;
+
+  try
+  {
+    // get the field name
+    const QgsField &fld = field( index );
+    QString aggregateExpression = aggregateSql( aggregate, fld, quotedIdentifier( fld.name() ) );
+    if ( aggregateExpression.isEmpty() )
+      return QVariant();
+
+    QString whereClause = mSqlWhereClause;
+    if ( !parameters.filter.isEmpty() )
+    {
+      // the filter must be evaluated completely by the database
+      if ( !QSettings().value( "/qgis/compileExpressions", true ).toBool() )
+        return QVariant();
+
+      QgsExpression filter( parameters.filter );
+      QgsPostgresFeatureSource source( this );
+      QgsPostgresExpressionCompiler compiler( &source );
+      if ( filter.hasParserError() || compiler.compile( &filter ) != QgsSqlExpressionCompiler::Complete )
+        return QVariant();
+
+      whereClause = QgsPostgresUtils::andWhereClauses( whereClause, compiler.result() );
+    }
+
+    QString sql = QString( "SELECT %1 FROM %2" ).arg( aggregateExpression, mQuery );
+
+    if ( !whereClause.isEmpty() )
+    {
+      sql += QString( " WHERE %1" ).arg( whereClause );
+    }
+
+    QgsPostgresResult result( connectionRO()->PQexec( sql ) );
+    if ( result.PQresultStatus() != PGRES_TUPLES_OK || result.PQntuples() != 1 || result.PQgetisnull( 0, 0 ) )
+    {
+      // let QgsAggregateCalculator handle errors and empty sets
+      return QVariant();
+    }
+
+    bool converted = false;
+    double value = result.PQgetvalue( 0, 0 ).toDouble( &converted );
+    if ( !converted )
+      return QVariant();
+
+    ok = true;
+    return value;
+  }
+  catch ( PGFieldNotFound )
+  {
+    return QVariant();
+  }
+}
+
 // Returns the list of unique values of an attribute
 void QgsPostgresProvider::uniqueValues( int index, QList<QVariant> &uniqueValues, int limit )
 {
@@ -1796,6 +1860,303 @@ QString QgsPostgresProvider::geomParam( int offset ) const
   return geometry;
 }
 
+template<typename T> static void appendBigEndian( QByteArray &buffer, T value )
+{
+  uchar data[ sizeof( T )];
+  qToBigEndian<T>( value, data );
+  buffer.append( reinterpret_cast<const char *>( data ), sizeof( T ) );
+}
+
+// Appends value as a field of a binary COPY tuple.
+// Returns false if the value cannot be sent in the binary format of the type.
+static bool appendCopyValue( const QString &typeName, const QVariant &value, QByteArray &buffer )
+{
+  if ( value.isNull() )
+  {
+    appendBigEndian<qint32>( buffer, -1 );
+    return true;
+  }
+
+  bool ok = false;
+
+  if ( typeName == "int2" || typeName == "int4" || typeName == "int8" )
+  {
+    qint64 v;
+    if ( value.type() == QVariant::Double )
+    {
+      double d = value.toDouble();
+      ok = std::floor( d ) == d && qAbs( d ) < 9.0e18;
+      v = static_cast<qint64>( d );
+    }
+    else
+    {
+      v = value.toLongLong( &ok );
+    }
+
+    if ( !ok )
+      return false;
+
+    if ( typeName == "int2" )
+    {
+      if ( v < std::numeric_limits<qint16>::min() || v > std::numeric_limits<qint16>::max() )
+        return false;
+      appendBigEndian<qint32>( buffer, 2 );
+      appendBigEndian<qint16>( buffer, static_cast<qint16>( v ) );
+    }
+    else if ( typeName == "int4" )
+    {
+      if ( v < std::numeric_limits<qint32>::min() || v > std::numeric_limits<qint32>::max() )
+        return false;
+      appendBigEndian<qint32>( buffer, 4 );
+      appendBigEndian<qint32>( buffer, static_cast<qint32>( v ) );
+    }
+    else
+    {
+      appendBigEndian<qint32>( buffer, 8 );
+      appendBigEndian<qint64>( buffer, v );
+    }
+  }
+  else if ( typeName == "float4" || typeName == "float8" )
+  {
+    double d = value.toDouble( &ok );
+    if ( !ok )
+      return false;
+
+    if ( typeName == "float4" )
+    {
+      float f = static_cast<float>( d );
+      quint32 bits;
+      memcpy( &bits, &f, sizeof( bits ) );
+      appendBigEndian<qint32>( buffer, 4 );
+      appendBigEndian<quint32>( buffer, bits );
+    }
+    else
+    {
+      quint64 bits;
+      memcpy( &bits, &d, sizeof( bits ) );
+      appendBigEndian<qint32>( buffer, 8 );
+      appendBigEndian<quint64>( buffer, bits );
+    }
+  }
+  else if ( typeName == "bool" )
+  {
+    bool b;
+    if ( value.type() == QVariant::Bool )
+    {
+      b = value.toBool();
+    }
+    else
+    {
+      // textual values as returned by the server (e.g. for defaults)
+      QString s = value.toString().toLower();
+      if ( s == "t" || s == "true" )
+        b = true;
+      else if ( s == "f" || s == "false" )
+        b = false;
+      else
+        return false;
+    }
+
+    appendBigEndian<qint32>( buffer, 1 );
+    buffer.append( b ? '\1' : '\0' );
+  }
+  else if ( typeName == "text" || typeName == "varchar" || typeName == "bpchar" )
+  {
+    // the client encoding is always UNICODE
+    QByteArray data = value.toString().toUtf8();
+    appendBigEndian<qint32>( buffer, data.size() );
+    buffer.append( data );
+  }
+  else
+  {
+    return false;
+  }
+
+  return true;
+}
+
+bool QgsPostgresProvider::copyFeatures( QgsPostgresConn *conn, QgsFeatureList &flist )
+{
+  // COPY only pays off for larger numbers of features. It cannot apply the
+  // conversions of geomParam() (which are not needed for plain geometry columns,
+  // convertToProviderType() already takes care of multi types) and the new
+  // primary keys have to be determined in advance instead of being RETURNING
+  if ( flist.size() < 100 ||
+       ( mSpatialColType != sctNone && mSpatialColType != sctGeometry ) ||
+       ( mPrimaryKeyType != pktInt && mPrimaryKeyType != pktFidMap ) ||
+       connectionRO()->majorVersion() < 2 || mIsQuery )
+    return false;
+
+  // COPY fails for views (also for updatable ones) and skips the INSERT rules
+  // of tables, so only plain tables without rules are copied to
+  QgsPostgresResult relation( conn->PQexec( QString( "SELECT relkind='r' AND NOT relhasrules FROM pg_class WHERE oid=%1::regclass" )
+                              .arg( quotedValue( mQuery ) ) ) );
+  if ( relation.PQresultStatus() != PGRES_TUPLES_OK || relation.PQntuples() != 1 || relation.PQgetvalue( 0, 0 ) != "t" )
+    return false;
+
+  int srid = 0;
+  QString columns;
+  if ( !mGeometryColumn.isNull() )
+  {
+    bool ok;
+    srid = ( mRequestedSrid.isEmpty() ? mDetectedSrid : mRequestedSrid ).toInt( &ok );
+    if ( !ok )
+      return false;
+
+    columns = quotedIdentifier( mGeometryColumn );
+  }
+
+  QList<int> fieldIds;
+  QStringList defaultValues;
+  for ( int idx = 0; idx < mAttributeFields.count(); ++idx )
+  {
+    const QgsField &fld = mAttributeFields.at( idx );
+    if ( fld.name().isEmpty() || fld.name() == mGeometryColumn )
+      continue;
+
+    if ( !columns.isEmpty() )
+      columns += ',';
+    columns += quotedIdentifier( fld.name() );
+
+    fieldIds << idx;
+    defaultValues << defaultValue( idx ).toString();
+  }
+
+  // check values and collect the ones to be replaced by defaults (like paramValue() does)
+  QVector<QgsAttributes> values;
+  values.reserve( flist.size() );
+  QVector< QList<int> > defaultRows( fieldIds.size() );
+  QByteArray scratch;
+
+  for ( int row = 0; row < flist.size(); ++row )
+  {
+    QgsAttributes attrs = flist.at( row ).attributes();
+    attrs.resize( mAttributeFields.count() );
+
+    for ( int i = 0; i < fieldIds.size(); ++i )
+    {
+      int idx = fieldIds.at( i );
+      const QVariant &v = attrs.at( idx );
+
+      if ( !defaultValues.at( i ).isNull() && ( v.isNull() || v.toString() == defaultValues.at( i ) ) )
+      {
+        defaultRows[i] << row;
+        continue;
+      }
+
+      if ( v.isNull() && mPrimaryKeyAttrs.contains( idx ) )
+        return false;
+
+      scratch.resize( 0 );
+      if ( !appendCopyValue( mAttributeFields.at( idx ).typeName(), v, scratch ) )
+        return false;
+    }
+
+    values << attrs;
+  }
+
+  // evaluate the defaults for all rows at once
+  for ( int i = 0; i < fieldIds.size(); ++i )
+  {
+    if ( defaultRows.at( i ).isEmpty() )
+      continue;
+
+    const QgsField &fld = mAttributeFields.at( fieldIds.at( i ) );
+
+    QgsPostgresResult result( connectionRO()->PQexec( QString( "SELECT %1 FROM generate_series(1,%2)" )
+                              .arg( defaultValues.at( i ) )
+                              .arg( defaultRows.at( i ).size() ) ) );
+    if ( result.PQresultStatus() != PGRES_TUPLES_OK )
+      throw PGException( result );
+
+    for ( int j = 0; j < defaultRows.at( i ).size(); ++j )
+    {
+      // keep the text returned by the server, converting it to a boolean would not be safe
+      QVariant v = result.PQgetisnull( j, 0 ) ? QVariant( QVariant::String ) : QVariant( result.PQgetvalue( j, 0 ) );
+
+      if ( ( v.isNull() && mPrimaryKeyAttrs.contains( fieldIds.at( i ) ) ) ||
+           !appendCopyValue( fld.typeName(), v, scratch ) )
+        return false;
+
+      values[ defaultRows.at( i ).at( j )][ fieldIds.at( i )] = v;
+    }
+  }
+
+  QString copy = QString( "COPY %1(%2) FROM STDIN WITH BINARY" ).arg( mQuery, columns );
+  QgsDebugMsg( QString( "copy addfeatures: %1" ).arg( copy ) );
+
+  QgsPostgresResult result( conn->PQexec( copy, false ) );
+  if ( result.PQresultStatus() != PGRES_COPY_IN )
+    throw PGException( result );
+
+  const int chunkSize = 1 << 20;
+  QByteArray buffer;
+  buffer.reserve( chunkSize + chunkSize / 4 );
+
+  // header: signature, flags and length of header extension
+  buffer.append( "PGCOPY\n\377\r\n\0", 11 );
+  appendBigEndian<qint32>( buffer, 0 );
+  appendBigEndian<qint32>( buffer, 0 );
+
+  qint16 nFields = fieldIds.size() + ( mGeometryColumn.isNull() ? 0 : 1 );
+  bool sent = true;
+
+  for ( int row = 0; row < flist.size() && sent; ++row )
+  {
+    appendBigEndian<qint16>( buffer, nFields );
+
+    if ( !mGeometryColumn.isNull() )
+      appendCopyGeometry( flist.at( row ).constGeometry(), srid, buffer );
+
+    const QgsAttributes &attrs = values.at( row );
+    for ( int i = 0; i < fieldIds.size(); ++i )
+    {
+      int idx = fieldIds.at( i );
+      appendCopyValue( mAttributeFields.at( idx ).typeName(), attrs.at( idx ), buffer );
+    }
+
+    if ( buffer.size() >= chunkSize )
+    {
+      sent = conn->PQputCopyData( buffer.constData(), buffer.size() ) == 1;
+      buffer.resize( 0 );
+    }
+  }
+
+  // trailer
+  appendBigEndian<qint16>( buffer, -1 );
+
+  if ( sent )
+    sent = conn->PQputCopyData( buffer.constData(), buffer.size() ) == 1;
+
+  conn->PQputCopyEnd( sent ? nullptr : "sending data failed" );
+
+  result = conn->PQgetResult();
+  if ( result.PQresultStatus() != PGRES_COMMAND_OK )
+    throw PGException( result );
+
+  // there should be no further result, but a pending one would block the connection
+  while ( PGresult *res = conn->PQgetResult() )
+  {
+    QgsPostgresResult pending( res );
+  }
+
+  // pass the defaults back to the features like the INSERT does
+  for ( int i = 0; i < fieldIds.size(); ++i )
+  {
+    int idx = fieldIds.at( i );
+    const QgsField &fld = mAttributeFields.at( idx );
+
+    Q_FOREACH ( int row, defaultRows.at( i ) )
+    {
+      QgsFeature &f = flist[ row ];
+      if ( idx < f.attributes().size() )
+        f.setAttribute( idx, convertValue( fld.type(), values.at( row ).at( idx ).toString() ) );
+    }
+  }
+
+  return true;
+}
+
 bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist )
 {
   if ( flist.isEmpty() )
@@ -1817,205 +2178,210 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist )
   {
     conn->begin();
 
-    // Prepare the INSERT statement
-    QString insert = QString( "INSERT INTO %1(" ).arg( mQuery );
-    QString values = ") VALUES (";
-    QString delim = "";
-    int offset = 1;
-
-    QStringList defaultValues;
-    QList<int> fieldId;
+    bool copied = copyFeatures( conn, flist );
 
-    if ( !mGeometryColumn.isNull() )
+    if ( !copied )
     {
-      insert += quotedIdentifier( mGeometryColumn );
-
-      values += geomParam( offset++ );
+      // Prepare the INSERT statement
+      QString insert = QString( "INSERT INTO %1(" ).arg( mQuery );
+      QString values = ") VALUES (";
+      QString delim = "";
+      int offset = 1;
 
-      delim = ',';
-    }
+      QStringList defaultValues;
+      QList<int> fieldId;
 
-    if ( mPrimaryKeyType == pktInt || mPrimaryKeyType == pktFidMap )
-    {
-      Q_FOREACH ( int idx, mPrimaryKeyAttrs )
+      if ( !mGeometryColumn.isNull() )
       {
-        insert += delim + quotedIdentifier( field( idx ).name() );
-        values += delim + QString( "$%1" ).arg( defaultValues.size() + offset );
+        insert += quotedIdentifier( mGeometryColumn );
+
+        values += geomParam( offset++ );
+
         delim = ',';
-        fieldId << idx;
-        defaultValues << defaultValue( idx ).toString();
       }
-    }
 
-    QgsAttributes attributevec = flist[0].attributes();
+      if ( mPrimaryKeyType == pktInt || mPrimaryKeyType == pktFidMap )
+      {
+        Q_FOREACH ( int idx, mPrimaryKeyAttrs )
+        {
+          insert += delim + quotedIdentifier( field( idx ).name() );
+          values += delim + QString( "$%1" ).arg( defaultValues.size() + offset );
+          delim = ',';
+          fieldId << idx;
+          defaultValues << defaultValue( idx ).toString();
+        }
+      }
 
-    // look for unique attribute values to place in statement instead of passing as parameter
-    // e.g. for defaults
-    for ( int idx = 0; idx < attributevec.count(); ++idx )
-    {
-      QVariant v = attributevec.at( idx );
-      if ( fieldId.contains( idx ) )
-        continue;
+      QgsAttributes attributevec = flist[0].attributes();
 
-      if ( idx >= mAttributeFields.count() )
-        continue;
+      // look for unique attribute values to place in statement instead of passing as parameter
+      // e.g. for defaults
+      for ( int idx = 0; idx < attributevec.count(); ++idx )
+      {
+        QVariant v = attributevec.at( idx );
+        if ( fieldId.contains( idx ) )
+          continue;
 
-      QString fieldname = mAttributeFields.at( idx ).name();
-      QString fieldTypeName = mAttributeFields.at( idx ).typeName();
+        if ( idx >= mAttributeFields.count() )
+          continue;
 
-      QgsDebugMsg( "Checking field against: " + fieldname );
+        QString fieldname = mAttributeFields.at( idx ).name();
+        QString fieldTypeName = mAttributeFields.at( idx ).typeName();
 
-      if ( fieldname.isEmpty() || fieldname == mGeometryColumn )
-        continue;
+        QgsDebugMsg( "Checking field against: " + fieldname );
 
-      int i;
-      for ( i = 1; i < flist.size(); i++ )
-      {
-        QgsAttributes attrs2 = flist[i].attributes();
-        QVariant v2 = attrs2.at( idx );
+        if ( fieldname.isEmpty() || fieldname == mGeometryColumn )
+          continue;
 
-        if ( v2 != v )
-          break;
-      }
+        int i;
+        for ( i = 1; i < flist.size(); i++ )
+        {
+          QgsAttributes attrs2 = flist[i].attributes();
+          QVariant v2 = attrs2.at( idx );
 
-      insert += delim + quotedIdentifier( fieldname );
+          if ( v2 != v )
+            break;
+        }
 
-      QString defVal = defaultValue( idx ).toString();
+        insert += delim + quotedIdentifier( fieldname );
 
-      if ( i == flist.size() )
-      {
-        if ( v == defVal )
+        QString defVal = defaultValue( idx ).toString();
+
+        if ( i == flist.size() )
         {
-          if ( defVal.isNull() )
+          if ( v == defVal )
           {
-            values += delim + "NULL";
+            if ( defVal.isNull() )
+            {
+              values += delim + "NULL";
+            }
+            else
+            {
+              values += delim + defVal;
+            }
+          }
+          else if ( fieldTypeName == "geometry" )
+          {
+            values += QString( "%1%2(%3)" )
+                      .arg( delim,
+                            connectionRO()->majorVersion() < 2 ? "geomfromewkt" : "st_geomfromewkt",
+                            quotedValue( v.toString() ) );
+          }
+          else if ( fieldTypeName == "geography" )
+          {
+            values += QString( "%1st_geographyfromewkt(%2)" )
+                      .arg( delim,
+                            quotedValue( v.toString() ) );
           }
           else
           {
-            values += delim + defVal;
+            values += delim + quotedValue( v );
           }
         }
-        else if ( fieldTypeName == "geometry" )
-        {
-          values += QString( "%1%2(%3)" )
-                    .arg( delim,
-                          connectionRO()->majorVersion() < 2 ? "geomfromewkt" : "st_geomfromewkt",
-                          quotedValue( v.toString() ) );
-        }
-        else if ( fieldTypeName == "geography" )
-        {
-          values += QString( "%1st_geographyfromewkt(%2)" )
-                    .arg( delim,
-                          quotedValue( v.toString() ) );
-        }
-        else
-        {
-          values += delim + quotedValue( v );
-        }
-      }
-      else
-      {
-        // value is not unique => add parameter
-        if ( fieldTypeName == "geometry" )
-        {
-          values += QString( "%1%2($%3)" )
-                    .arg( delim,
-                          connectionRO()->majorVersion() < 2 ? "geomfromewkt" : "st_geomfromewkt" )
-                    .arg( defaultValues.size() + offset );
-        }
-        else if ( fieldTypeName == "geography" )
-        {
-          values += QString( "%1st_geographyfromewkt($%2)" )
-                    .arg( delim )
-                    .arg( defaultValues.size() + offset );
-        }
         else
         {
-          values += QString( "%1$%2" )
-                    .arg( delim )
-                    .arg( defaultValues.size() + offset );
+          // value is not unique => add parameter
+          if ( fieldTypeName == "geometry" )
+          {
+            values += QString( "%1%2($%3)" )
+                      .arg( delim,
+                            connectionRO()->majorVersion() < 2 ? "geomfromewkt" : "st_geomfromewkt" )
+                      .arg( defaultValues.size() + offset );
+          }
+          else if ( fieldTypeName == "geography" )
+          {
+            values += QString( "%1st_geographyfromewkt($%2)" )
+                      .arg( delim )
+                      .arg( defaultValues.size() + offset );
+          }
+          else
+          {
+            values += QString( "%1$%2" )
+                      .arg( delim )
+                      .arg( defaultValues.size() + offset );
+          }
+          defaultValues.append( defVal );
+          fieldId.append( idx );
         }
-        defaultValues.append( defVal );
-        fieldId.append( idx );
-      }
 
-      delim = ',';
-    }
-
-    insert += values + ')';
-
-    if ( mPrimaryKeyType == pktFidMap || mPrimaryKeyType == pktInt )
-    {
-      insert += " RETURNING ";
-
-      QString delim;
-      Q_FOREACH ( int idx, mPrimaryKeyAttrs )
-      {
-        insert += delim + quotedIdentifier( mAttributeFields.at( idx ).name() );
         delim = ',';
       }
-    }
-
-    QgsDebugMsg( QString( "prepare addfeatures: %1" ).arg( insert ) );
-    QgsPostgresResult stmt( conn->PQprepare( "addfeatures", insert, fieldId.size() + offset - 1, nullptr ) );
 
-    if ( stmt.PQresultStatus() != PGRES_COMMAND_OK )
-      throw PGException( stmt );
+      insert += values + ')';
 
-    for ( QgsFeatureList::iterator features = flist.begin(); features != flist.end(); ++features )
-    {
-      QgsAttributes attrs = features->attributes();
-
-      QStringList params;
-      if ( !mGeometryColumn.isNull() )
+      if ( mPrimaryKeyType == pktFidMap || mPrimaryKeyType == pktInt )
       {
-        appendGeomParam( features->constGeometry(), params );
+        insert += " RETURNING ";
+
+        QString delim;
+        Q_FOREACH ( int idx, mPrimaryKeyAttrs )
+        {
+          insert += delim + quotedIdentifier( mAttributeFields.at( idx ).name() );
+          delim = ',';
+        }
       }
 
-      params.reserve( fieldId.size() );
-      for ( int i = 0; i < fieldId.size(); i++ )
+      QgsDebugMsg( QString( "prepare addfeatures: %1" ).arg( insert ) );
+      QgsPostgresResult stmt( conn->PQprepare( "addfeatures", insert, fieldId.size() + offset - 1, nullptr ) );
+
+      if ( stmt.PQresultStatus() != PGRES_COMMAND_OK )
+        throw PGException( stmt );
+
+      for ( QgsFeatureList::iterator features = flist.begin(); features != flist.end(); ++features )
       {
-        int attrIdx = fieldId[i];
-        QVariant value = attrs.at( attrIdx );
+        QgsAttributes attrs = features->attributes();
 
-        QString v;
-        if ( value.isNull() )
+        QStringList params;
+        if ( !mGeometryColumn.isNull() )
         {
-          const QgsField &fld = field( attrIdx );
-          v = paramValue( defaultValues[ i ], defaultValues[ i ] );
-          features->setAttribute( attrIdx, convertValue( fld.type(), v ) );
+          appendGeomParam( features->constGeometry(), params );
         }
-        else
+
+        params.reserve( fieldId.size() );
+        for ( int i = 0; i < fieldId.size(); i++ )
         {
-          v = paramValue( value.toString(), defaultValues[ i ] );
+          int attrIdx = fieldId[i];
+          QVariant value = attrs.at( attrIdx );
 
-          if ( v != value.toString() )
+          QString v;
+          if ( value.isNull() )
           {
             const QgsField &fld = field( attrIdx );
+            v = paramValue( defaultValues[ i ], defaultValues[ i ] );
             features->setAttribute( attrIdx, convertValue( fld.type(), v ) );
           }
-        }
+          else
+          {
+            v = paramValue( value.toString(), defaultValues[ i ] );
 
-        params << v;
-      }
+            if ( v != value.toString() )
+            {
+              const QgsField &fld = field( attrIdx );
+              features->setAttribute( attrIdx, convertValue( fld.type(), v ) );
+            }
+          }
 
-      QgsPostgresResult result( conn->PQexecPrepared( "addfeatures", params ) );
+          params << v;
+        }
 
-      if ( result.PQresultStatus() == PGRES_TUPLES_OK )
-      {
-        for ( int i = 0; i < mPrimaryKeyAttrs.size(); ++i )
+        QgsPostgresResult result( conn->PQexecPrepared( "addfeatures", params ) );
+
+        if ( result.PQresultStatus() == PGRES_TUPLES_OK )
         {
-          int idx = mPrimaryKeyAttrs.at( i );
-          features->setAttribute( idx, convertValue( mAttributeFields.at( idx ).type(), result.PQgetvalue( 0, i ) ) );
+          for ( int i = 0; i < mPrimaryKeyAttrs.size(); ++i )
+          {
+            int idx = mPrimaryKeyAttrs.at( i );
+            features->setAttribute( idx, convertValue( mAttributeFields.at( idx ).type(), result.PQgetvalue( 0, i ) ) );
+          }
         }
-      }
-      else if ( result.PQresultStatus() != PGRES_COMMAND_OK )
-        throw PGException( result );
+        else if ( result.PQresultStatus() != PGRES_COMMAND_OK )
+          throw PGException( result );
 
-      if ( mPrimaryKeyType == pktOid )
-      {
-        features->setFeatureId( result.PQoidValue() );
-        QgsDebugMsgLevel( QString( "new fid=%1" ).arg( features->id() ), 4 );
+        if ( mPrimaryKeyType == pktOid )
+        {
+          features->setFeatureId( result.PQoidValue() );
+          QgsDebugMsgLevel( QString( "new fid=%1" ).arg( features->id() ), 4 );
+        }
       }
     }
 
@@ -2045,7 +2411,8 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist )
       }
     }
 
-    conn->PQexecNR( "DEALLOCATE addfeatures" );
+    if ( !copied )
+      conn->PQexecNR( "DEALLOCATE addfeatures" );
 
     returnvalue &= conn->commit();
 
@@ -2444,6 +2811,46 @@ void QgsPostgresProvider::appendGeomParam( const QgsGeometry *geom, QStringList
   params << param;
 }
 
+void QgsPostgresProvider::appendCopyGeometry( const QgsGeometry *geom, int srid, QByteArray &buffer ) const
+{
+  QScopedPointer<QgsGeometry> convertedGeom( convertToProviderType( geom ) );
+  const unsigned char *wkb = nullptr;
+  size_t wkbSize = 0;
+  if ( geom )
+  {
+    wkb = convertedGeom ? convertedGeom->asWkb() : geom->asWkb();
+    wkbSize = convertedGeom ? convertedGeom->wkbSize() : geom->wkbSize();
+  }
+
+  if ( !wkb || wkbSize < 5 )
+  {
+    appendBigEndian<qint32>( buffer, -1 );
+    return;
+  }
+
+  // EWKB: the type gets the SRID flag and is followed by the SRID, both in the byte order of the WKB
+  bool littleEndian = wkb[0] == 1;
+  quint32 type = littleEndian ? qFromLittleEndian<quint32>( wkb + 1 ) : qFromBigEndian<quint32>( wkb + 1 );
+  type |= 0x20000000;
+
+  uchar header[9];
+  header[0] = wkb[0];
+  if ( littleEndian )
+  {
+    qToLittleEndian<quint32>( type, header + 1 );
+    qToLittleEndian<quint32>( static_cast<quint32>( srid ), header + 5 );
+  }
+  else
+  {
+    qToBigEndian<quint32>( type, header + 1 );
+    qToBigEndian<quint32>( static_cast<quint32>( srid ), header + 5 );
+  }
+
+  appendBigEndian<qint32>( buffer, static_cast<qint32>( wkbSize + 4 ) );
+  buffer.append( reinterpret_cast<const char *>( header ), sizeof( header ) );
+  buffer.append( reinterpret_cast<const char *>( wkb + 5 ), static_cast<int>( wkbSize - 5 ) );
+}
+
 bool QgsPostgresProvider::changeGeometryValues( const QgsGeometryMap &geometry_map )
 {
   QgsDebugMsg( "entering." );
@@ -165,6 +165,19 @@ class QgsPostgresProvider : public QgsVectorDataProvider
      *  @param values reference to the list of unique values */
     virtual void uniqueValues( int index, QList<QVariant> &uniqueValues, int limit = -1 ) override;
 
+    /** Calculates an aggregate in the database, if the aggregate and the filter
+     *  can be translated to SQL
+     *  @param aggregate aggregate to calculate
+     *  @param index the index of the attribute
+     *  @param parameters parameters controlling aggregate calculation
+     *  @param context expression context for filter
+     *  @param ok will be set to true if the aggregate was calculated by the database */
+    virtual QVariant aggregate( QgsAggregateCalculator::Aggregate aggregate,
+                                int index,
+                                const QgsAggregateCalculator::AggregateParameters& parameters,
+                                QgsExpressionContext* context,
+                                bool& ok ) override;
+
     /** Returns the possible enum values of an attribute. Returns an empty stringlist if a provider does not support enum types
       or if the given attribute is not an enum type.
      * @param index the index of the attribute
@@ -458,6 +471,15 @@ class QgsPostgresProvider : public QgsVectorDataProvider
     int mEnabledCapabilities;
 
     void appendGeomParam( const QgsGeometry *geom, QStringList &param ) const;
+    //! Appends the geometry as EWKB field of a binary COPY tuple
+    void appendCopyGeometry( const QgsGeometry *geom, int srid, QByteArray &buffer ) const;
+
+    /** Inserts the features with a binary COPY instead of a prepared INSERT per feature.
+     * Returns false without touching the table if the features cannot be copied
+     * (e.g. there are only a few of them or values of types COPY is not implemented for),
+     * throws PGException if the COPY failed.
+     */
+    bool copyFeatures( QgsPostgresConn *conn, QgsFeatureList &flist );
     void appendPkParams( QgsFeatureId fid, QStringList &param ) const;
 
     QString paramValue( const QString& fieldvalue, const QString &defaultValue ) const;
@@ -29,11 +29,13 @@ email                : a.furieri@lqt.it
 #include "qgsspatialiteprovider.h"
 #include "qgsspatialiteconnpool.h"
 #include "qgsspatialitefeatureiterator.h"
+#include "qgssqliteexpressioncompiler.h"
 #include "qgscrscache.h"
 
 #include <QMessageBox>
 #include <QFileInfo>
 #include <QDir>
+#include <QSettings>
 
 
 const QString SPATIALITE_KEY = "spatialite";
@@ -3496,6 +3498,85 @@ QVariant QgsSpatiaLiteProvider::maximumValue( int index )
   }
 }
 
+QVariant QgsSpatiaLiteProvider::aggregate( QgsAggregateCalculator::Aggregate aggregate, int index,
+    const QgsAggregateCalculator::AggregateParameters& parameters, QgsExpressionContext* context, bool& ok )
+{
+  Q_UNUSED( context );
+  ok = false;
+
+  char **results;
+  int rows;
+  int columns;
+  char *errMsg = nullptr;
+
+  try
+  {
+    // get the field name
+    const QgsField& fld = field( index );
+    // SpatiaLite provides the stddev_pop() and stddev_samp() aggregate functions
+    QString aggregateExpression = aggregateSql( aggregate, fld, quotedIdentifier( fld.name() ) );
+    if ( aggregateExpression.isEmpty() )
+      return QVariant();
+
+    QString sql = QString( "SELECT %1 FROM %2" ).arg( aggregateExpression, mQuery );
+
+    QStringList whereClauses;
+    if ( !mSubsetString.isEmpty() )
+    {
+      whereClauses << "( " + mSubsetString + ')';
+    }
+
+    if ( !parameters.filter.isEmpty() )
+    {
+      // the filter must be evaluated completely by the database
+      if ( !QSettings().value( "/qgis/compileExpressions", true ).toBool() )
+        return QVariant();
+
+      QgsExpression filter( parameters.filter );
+      QgsSQLiteExpressionCompiler compiler( mAttributeFields );
+      if ( filter.hasParserError() || compiler.compile( &filter ) != QgsSqlExpressionCompiler::Complete )
+        return QVariant();
+
+      whereClauses << "( " + compiler.result() + ')';
+    }
+
+    if ( !whereClauses.isEmpty() )
+    {
+      sql += " WHERE " + whereClauses.join( " AND " );
+    }
+
+    int ret = sqlite3_get_table( mSqliteHandle, sql.toUtf8().constData(), &results, &rows, &columns, &errMsg );
+    if ( ret != SQLITE_OK )
+    {
+      QgsMessageLog::logMessage( tr( "SQLite error: %2\nSQL: %1" ).arg( sql, errMsg ? errMsg : tr( "unknown cause" ) ), tr( "SpatiaLite" ) );
+      if ( errMsg )
+      {
+        sqlite3_free( errMsg );
+      }
+      return QVariant();
+    }
+
+    // NULL results (eg. no matching values) are left to QgsAggregateCalculator
+    bool converted = false;
+    double value = 0;
+    if ( rows == 1 && columns == 1 && results[1] )
+    {
+      value = QString::fromUtf8( results[1] ).toDouble( &converted );
+    }
+    sqlite3_free_table( results );
+
+    if ( !converted )
+      return QVariant();
+
+    ok = true;
+    return value;
+  }
+  catch ( SLFieldNotFound )
+  {
+    return QVariant();
+  }
+}
+
 // Returns the list of unique values of an attribute
 void QgsSpatiaLiteProvider::uniqueValues( int index, QList < QVariant > &uniqueValues, int limit )
 {
@@ -147,6 +147,19 @@ class QgsSpatiaLiteProvider: public QgsVectorDataProvider
      *  @param limit maximum number of values */
     virtual void uniqueValues( int index, QList < QVariant > &uniqueValues, int limit = -1 ) override;
 
+    /** Calculates an aggregate in the database, if the aggregate and the filter
+     *  can be translated to SQL
+     *  @param aggregate aggregate to calculate
+     *  @param index the index of the attribute
+     *  @param parameters parameters controlling aggregate calculation
+     *  @param context expression context for filter
+     *  @param ok will be set to true if the aggregate was calculated by the database */
+    virtual QVariant aggregate( QgsAggregateCalculator::Aggregate aggregate,
+                                int index,
+                                const QgsAggregateCalculator::AggregateParameters& parameters,
+                                QgsExpressionContext* context,
+                                bool& ok ) override;
+
     /** Returns true if layer is valid
      */
     bool isValid() override;
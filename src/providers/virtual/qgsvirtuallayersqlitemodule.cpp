@@ -97,6 +97,7 @@ struct VTable
       , mPkColumn( -1 )
       , mCrs( -1 )
       , mValid( true )
+      , mHasGeometry( false )
   {
     if ( mLayer )
     {
@@ -116,6 +117,7 @@ struct VTable
       , mPkColumn( -1 )
       , mCrs( -1 )
       , mValid( true )
+      , mHasGeometry( false )
   {
     mProvider = static_cast<QgsVectorDataProvider*>( QgsProviderRegistry::instance()->provider( provider, source ) );
     if ( !mProvider )
@@ -161,6 +163,16 @@ struct VTable
 
   QgsFields fields() const { return mFields; }
 
+  // number of features, -1 if unknown
+  long featureCount() const
+  {
+    if ( !mValid )
+      return 0;
+    return mLayer ? mLayer->featureCount() : mProvider->featureCount();
+  }
+
+  bool hasGeometry() const { return mHasGeometry; }
+
 private:
   // connection
   sqlite3* mSql;
@@ -186,6 +198,8 @@ private:
 
   bool mValid;
 
+  bool mHasGeometry;
+
   QgsFields mFields;
 
   void init_()
@@ -219,7 +233,8 @@ private:
     }
 
     QgsVectorDataProvider* provider = mLayer ? mLayer->dataProvider() : mProvider;
-    if ( provider->geometryType() != QGis::WKBNoGeometry )
+    mHasGeometry = provider->geometryType() != QGis::WKBNoGeometry;
+    if ( mHasGeometry )
     {
       // we have here a convenient hack
       // the type of a column can be declared with two numeric arguments, usually for setting numeric precision
@@ -468,9 +483,102 @@ int vtableRename( sqlite3_vtab *vtab, const char *newName )
   return SQLITE_OK;
 }
 
+// QGIS expression operator for a comparison constraint, empty if the constraint cannot be translated
+static QString constraintOperator( unsigned char op )
+{
+  switch ( op )
+  {
+    case SQLITE_INDEX_CONSTRAINT_EQ:
+      return "=";
+    case SQLITE_INDEX_CONSTRAINT_GT:
+      return ">";
+    case SQLITE_INDEX_CONSTRAINT_LE:
+      return "<=";
+    case SQLITE_INDEX_CONSTRAINT_LT:
+      return "<";
+    case SQLITE_INDEX_CONSTRAINT_GE:
+      return ">=";
+#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
+    case SQLITE_INDEX_CONSTRAINT_LIKE:
+      // SQLite LIKE is case insensitive
+      return "ILIKE";
+#endif
+    default:
+      return QString();
+  }
+}
+
+// rough fraction of rows satisfying a constraint, used to estimate the number of returned rows
+static double constraintSelectivity( unsigned char op )
+{
+  switch ( op )
+  {
+    case SQLITE_INDEX_CONSTRAINT_EQ:
+      return 0.1;
+#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
+    case SQLITE_INDEX_CONSTRAINT_LIKE:
+      return 0.5;
+#endif
+    default:
+      return 0.3;
+  }
+}
+
+static bool isNumericType( QVariant::Type type )
+{
+  return type == QVariant::Int || type == QVariant::UInt || type == QVariant::LongLong || type == QVariant::Double;
+}
+
+static bool isLimitConstraint( unsigned char op )
+{
+#ifdef SQLITE_INDEX_CONSTRAINT_LIMIT
+  return op == SQLITE_INDEX_CONSTRAINT_LIMIT || op == SQLITE_INDEX_CONSTRAINT_OFFSET;
+#else
+  Q_UNUSED( op );
+  return false;
+#endif
+}
+
+// Type of the value a constraint compares with, if it is a constant known when planning (SQLite 3.38), 0 otherwise.
+// Only constraints whose value can be turned into the same filter in vtableFilter() may be omitted by SQLite.
+static int constraintValueType( sqlite3_index_info* indexInfo, int constraint )
+{
+#if SQLITE_VERSION_NUMBER >= 3038000
+  sqlite3_value* value = nullptr;
+  if ( sqlite3_vtab_rhs_value( indexInfo, constraint, &value ) != SQLITE_OK || !value )
+    return 0;
+  return sqlite3_value_type( value );
+#else
+  Q_UNUSED( indexInfo );
+  Q_UNUSED( constraint );
+  return 0;
+#endif
+}
+
+// The plan of a scan is passed from vtableBestIndex() to vtableFilter() in idxStr, one instruction per line.
+// Instructions using a value of argv are in the order of the values:
+//  fid              filter on the feature id
+//  rect             filter on the bounding box of a geometry blob
+//  expr <prefix>    comparison of an attribute with the value, all comparisons are combined with AND
+//  limit, offset    number of rows needed by SQLite
+// other instructions:
+//  attrs <i> ...    only fetch these attributes
+//  nogeom           do not fetch geometries
+//  order <i> <asc>  sort on the attribute
 int vtableBestIndex( sqlite3_vtab *pvtab, sqlite3_index_info* indexInfo )
 {
   VTable *vtab = reinterpret_cast< VTable* >( pvtab );
+  const QgsFields fields = vtab->fields();
+
+  long count = vtab->featureCount();
+  double rows = count >= 0 ? qMax( count, 1L ) : 1e6;
+
+  QStringList plan;
+  int argvIndex = 0;
+  // whether all constraints are checked by the filter, so that the provider may apply the LIMIT
+  bool allConsumed = true;
+  bool hasRect = false;
+
   for ( int i = 0; i < indexInfo->nConstraint; i++ )
   {
     // request for primary key filter with '='
@@ -478,89 +586,149 @@ int vtableBestIndex( sqlite3_vtab *pvtab, sqlite3_index_info* indexInfo )
         ( vtab->pkColumn() == indexInfo->aConstraint[i].iColumn ) &&
         ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ ) )
     {
+      for ( int j = 0; j < indexInfo->nConstraint; j++ )
+      {
+        indexInfo->aConstraintUsage[j].argvIndex = 0;
+        indexInfo->aConstraintUsage[j].omit = 0;
+      }
+      // values other than integers are converted to an id, SQLite has to check them again
+      bool omit = constraintValueType( indexInfo, i ) == SQLITE_INTEGER;
       indexInfo->aConstraintUsage[i].argvIndex = 1;
+      indexInfo->aConstraintUsage[i].omit = omit;
+      plan = QStringList() << "fid";
+      argvIndex = 1;
+      allConsumed = omit && indexInfo->nConstraint == 1;
+      rows = 1;
+      break;
+    }
+
+    if ( isLimitConstraint( indexInfo->aConstraint[i].op ) )
+      continue;
+
+    if ( !indexInfo->aConstraint[i].usable )
+    {
+      allConsumed = false;
+      continue;
+    }
+
+    // request for rtree filtering
+    if (( 0 == indexInfo->aConstraint[i].iColumn ) &&
+        ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ ) &&
+        !hasRect )
+    {
+      indexInfo->aConstraintUsage[i].argvIndex = ++argvIndex;
+      // do not test for equality, since it is used for filtering, not to return an actual value
       indexInfo->aConstraintUsage[i].omit = 1;
-      indexInfo->idxNum = 1; // PK filter
-      indexInfo->estimatedCost = 1.0;
-      indexInfo->idxStr = nullptr;
-      indexInfo->needToFreeIdxStr = 0;
-      return SQLITE_OK;
+      plan << "rect";
+      hasRect = true;
+      rows *= 0.1;
+      continue;
     }
 
     // request for filter with a comparison operator
-    if (( indexInfo->aConstraint[i].usable ) &&
-        ( indexInfo->aConstraint[i].iColumn > 0 ) &&
-        ( indexInfo->aConstraint[i].iColumn <= vtab->fields().count() ) &&
-        (( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ ) || // if no PK
-         ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_GT ) ||
-         ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_LE ) ||
-         ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_LT ) ||
-         ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_GE )
-#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
-         || ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_LIKE )
-#endif
-        ) )
+    // Expressions compare text which looks like numbers as numbers, so that on text columns
+    // only equality is pushed (it selects more rows than in SQLite, which checks them again).
+    // ILIKE may also select more rows than LIKE (e.g. non ASCII letters).
+    QString op = constraintOperator( indexInfo->aConstraint[i].op );
+    int column = indexInfo->aConstraint[i].iColumn;
+    bool numeric = column > 0 && column <= fields.count() && isNumericType( fields.at( column - 1 ).type() );
+    if (( column > 0 ) &&
+        ( column <= fields.count() ) &&
+        !op.isEmpty() &&
+        ( numeric || op == "=" || op == "ILIKE" ) )
     {
-      indexInfo->aConstraintUsage[i].argvIndex = 1;
-      indexInfo->aConstraintUsage[i].omit = 1;
-      indexInfo->idxNum = 3; // expression filter
-      indexInfo->estimatedCost = 2.0; // probably better than no index
+      // values which cannot be expressed as a literal (eg blobs) are not filtered in vtableFilter()
+      int valueType = constraintValueType( indexInfo, i );
+      indexInfo->aConstraintUsage[i].argvIndex = ++argvIndex;
+      bool omit = numeric && op != "ILIKE" &&
+                  ( valueType == SQLITE_INTEGER || valueType == SQLITE_FLOAT || valueType == SQLITE_NULL );
+      indexInfo->aConstraintUsage[i].omit = omit;
+      allConsumed = allConsumed && omit;
+      plan << QString( "expr %1 %2 " ).arg( QgsExpression::quotedColumnRef( fields.at( column - 1 ).name() ), op );
+      rows *= constraintSelectivity( indexInfo->aConstraint[i].op );
+      continue;
+    }
 
-      QString expr = vtab->fields().at( indexInfo->aConstraint[i].iColumn - 1 ).name();
-      switch ( indexInfo->aConstraint[i].op )
-      {
-        case SQLITE_INDEX_CONSTRAINT_EQ:
-          expr += " = ";
-          break;
-        case SQLITE_INDEX_CONSTRAINT_GT:
-          expr += " > ";
-          break;
-        case SQLITE_INDEX_CONSTRAINT_LE:
-          expr += " <= ";
-          break;
-        case SQLITE_INDEX_CONSTRAINT_LT:
-          expr += " < ";
-          break;
-        case SQLITE_INDEX_CONSTRAINT_GE:
-          expr += " >= ";
-          break;
-#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
-        case SQLITE_INDEX_CONSTRAINT_LIKE:
-          expr += " LIKE ";
-          break;
-#endif
-        default:
-          break;
-      }
+    allConsumed = false;
+  }
 
-      QByteArray ba = expr.toUtf8();
-      char* cp = ( char* )sqlite3_malloc( ba.size() + 1 );
-      memcpy( cp, ba.constData(), ba.size() + 1 );
+  // Sort by the provider (or the feature iterator). Only on numeric attributes, text would not
+  // be sorted in the same order as SQLite does.
+  bool orderConsumed = indexInfo->nOrderBy > 0;
+  for ( int i = 0; i < indexInfo->nOrderBy; i++ )
+  {
+    int column = indexInfo->aOrderBy[i].iColumn;
+    if ( column < 1 || column > fields.count() || !isNumericType( fields.at( column - 1 ).type() ) )
+      orderConsumed = false;
+  }
+  if ( orderConsumed )
+  {
+    for ( int i = 0; i < indexInfo->nOrderBy; i++ )
+    {
+      plan << QString( "order %1 %2" ).arg( indexInfo->aOrderBy[i].iColumn - 1 ).arg( indexInfo->aOrderBy[i].desc ? 0 : 1 );
+    }
+    indexInfo->orderByConsumed = 1;
+  }
 
-      indexInfo->idxStr = cp;
-      indexInfo->needToFreeIdxStr = 1;
-      return SQLITE_OK;
+#ifdef SQLITE_INDEX_CONSTRAINT_LIMIT
+  // The rows returned are the ones SQLite would return, SQLite still applies LIMIT and OFFSET itself
+  if ( allConsumed && ( indexInfo->nOrderBy == 0 || orderConsumed ) )
+  {
+    for ( int i = 0; i < indexInfo->nConstraint; i++ )
+    {
+      if ( indexInfo->aConstraint[i].usable && isLimitConstraint( indexInfo->aConstraint[i].op ) )
+      {
+        indexInfo->aConstraintUsage[i].argvIndex = ++argvIndex;
+        indexInfo->aConstraintUsage[i].omit = 0;
+        plan << ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_LIMIT ? "limit" : "offset" );
+      }
     }
+  }
+#else
+  Q_UNUSED( allConsumed );
+#endif
 
-    // request for rtree filtering
-    if (( indexInfo->aConstraint[i].usable ) &&
-        ( 0 == indexInfo->aConstraint[i].iColumn ) &&
-        ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ ) )
+#if SQLITE_VERSION_NUMBER >= 3010000
+  // columns used by the statement, the last bit stands for all columns from the 64th
+  sqlite3_uint64 colUsed = indexInfo->colUsed;
+  const sqlite3_uint64 lastBit = static_cast< sqlite3_uint64 >( 1 ) << 63;
+  QStringList attributes;
+  for ( int column = 1; column <= fields.count(); column++ )
+  {
+    if ( column >= 63 ? ( colUsed & lastBit ) : ( colUsed & ( static_cast< sqlite3_uint64 >( 1 ) << column ) ) )
+      attributes << QString::number( column - 1 );
+  }
+  // attributes to sort on are needed if the feature iterator sorts
+  if ( orderConsumed )
+  {
+    for ( int i = 0; i < indexInfo->nOrderBy; i++ )
     {
-      indexInfo->aConstraintUsage[i].argvIndex = 1;
-      // do not test for equality, since it is used for filtering, not to return an actual value
-      indexInfo->aConstraintUsage[i].omit = 1;
-      indexInfo->idxNum = 2; // RTree filter
-      indexInfo->estimatedCost = 1.0;
-      indexInfo->idxStr = nullptr;
-      indexInfo->needToFreeIdxStr = 0;
-      return SQLITE_OK;
+      QString index = QString::number( indexInfo->aOrderBy[i].iColumn - 1 );
+      if ( !attributes.contains( index ) )
+        attributes << index;
     }
   }
-  indexInfo->idxNum = 0;
-  indexInfo->estimatedCost = 10.0;
-  indexInfo->idxStr = nullptr;
-  indexInfo->needToFreeIdxStr = 0;
+  if ( attributes.size() < fields.count() )
+    plan << QString( "attrs %1" ).arg( attributes.join( " " ) ).trimmed();
+
+  int geometryColumn = fields.count() + 1;
+  bool geometryUsed = geometryColumn >= 63 ? ( colUsed & lastBit ) : ( colUsed & ( static_cast< sqlite3_uint64 >( 1 ) << geometryColumn ) );
+  if ( vtab->hasGeometry() && !geometryUsed && !hasRect )
+    plan << "nogeom";
+#endif
+
+  // the cost of a scan is mostly fetching the features
+  indexInfo->estimatedCost = rows;
+#if SQLITE_VERSION_NUMBER >= 3008002
+  indexInfo->estimatedRows = static_cast< sqlite3_int64 >( rows );
+#endif
+
+  indexInfo->idxNum = argvIndex;
+  QByteArray ba = plan.join( "\n" ).toUtf8();
+  char* cp = ( char* )sqlite3_malloc( ba.size() + 1 );
+  memcpy( cp, ba.constData(), ba.size() + 1 );
+  indexInfo->idxStr = cp;
+  indexInfo->needToFreeIdxStr = 1;
   return SQLITE_OK;
 }
 
@@ -580,55 +748,134 @@ int vtableClose( sqlite3_vtab_cursor * cursor )
   return SQLITE_OK;
 }
 
+// literal of a sqlite value to be used in a QGIS expression, empty if it cannot be expressed
+static QString expressionLiteral( sqlite3_value* value )
+{
+  switch ( sqlite3_value_type( value ) )
+  {
+    case SQLITE_INTEGER:
+      return QString::number( sqlite3_value_int64( value ) );
+    case SQLITE_FLOAT:
+      return QString::number( sqlite3_value_double( value ), 'g', 17 );
+    case SQLITE_TEXT:
+    {
+      int n = sqlite3_value_bytes( value );
+      const char* t = reinterpret_cast<const char*>( sqlite3_value_text( value ) );
+      return QgsExpression::quotedString( QString::fromUtf8( t, n ) );
+    }
+    case SQLITE_NULL:
+      // comparisons with NULL are never true, in SQLite as well as in expressions
+      return "NULL";
+    default:
+      return QString();
+  }
+}
+
 int vtableFilter( sqlite3_vtab_cursor * cursor, int idxNum, const char *idxStr, int argc, sqlite3_value **argv )
 {
-  Q_UNUSED( argc );
-  Q_UNUSED( idxStr );
+  Q_UNUSED( idxNum );
+
+  VTableCursor *c = reinterpret_cast<VTableCursor*>( cursor );
+  const QgsFields fields = c->mVtab->fields();
 
   QgsFeatureRequest request;
-  if ( idxNum == 1 )
+  QStringList expressions;
+  QgsFeatureRequest::OrderBy orderBy;
+  qint64 limit = -1;
+  qint64 offset = 0;
+  int arg = 0;
+  // whether an omitted constraint cannot be true for any row
+  bool noRows = false;
+
+  QStringList plan = QString::fromUtf8( idxStr ).split( '\n', QString::SkipEmptyParts );
+  Q_FOREACH ( const QString& instruction, plan )
   {
-    // id filter
-    request.setFilterFid( sqlite3_value_int( argv[0] ) );
-  }
-  else if ( idxNum == 2 )
-  {
-    // rtree filter
-    const char* blob = reinterpret_cast< const char* >( sqlite3_value_blob( argv[0] ) );
-    int bytes = sqlite3_value_bytes( argv[0] );
-    QgsRectangle r( spatialiteBlobBbox( blob, bytes ) );
-    request.setFilterRect( r );
-  }
-  else if ( idxNum == 3 )
-  {
-    // comparison operator filter
-    // build an expression filter and rely on expression compiler if available
-    QString expr = idxStr;
-    switch ( sqlite3_value_type( argv[0] ) )
+    if ( instruction == "fid" && arg < argc )
     {
-      case SQLITE_INTEGER:
-        expr += QString::number( sqlite3_value_int64( argv[0] ) );
-        break;
-      case SQLITE_FLOAT:
-        expr += QString::number( sqlite3_value_double( argv[0] ) );
-        break;
-      case SQLITE_TEXT:
+      // id filter
+      request.setFilterFid( sqlite3_value_int64( argv[arg++] ) );
+    }
+    else if ( instruction == "rect" && arg < argc )
+    {
+      // rtree filter, values other than a geometry blob do not select any feature
+      const char* blob = reinterpret_cast< const char* >( sqlite3_value_blob( argv[arg] ) );
+      int bytes = sqlite3_value_bytes( argv[arg] );
+      if ( sqlite3_value_type( argv[arg] ) == SQLITE_BLOB && blob && bytes >= static_cast< int >( SpatialiteBlobHeader::length ) )
       {
-        int n = sqlite3_value_bytes( argv[0] );
-        const char* t = reinterpret_cast<const char*>( sqlite3_value_text( argv[0] ) );
-        QString str = QString::fromUtf8( t, n );
-        expr += "'" + str.replace( "'", "''" ) + "'";
-        break;
+        QgsRectangle r( spatialiteBlobBbox( blob, bytes ) );
+        request.setFilterRect( r );
       }
-      default:
-        expr = "";
+      else
+      {
+        noRows = true;
+      }
+      arg++;
+    }
+    else if ( instruction.startsWith( "expr " ) && arg < argc )
+    {
+      // comparison operator filter
+      // build an expression filter and rely on expression compiler if available
+      QString literal = expressionLiteral( argv[arg++] );
+      // there is no escape character in a LIKE pattern in SQLite, keep such patterns for SQLite
+      if ( !literal.isEmpty() && !( instruction.endsWith( " ILIKE " ) && literal.contains( '\\' ) ) )
+      {
+        expressions << instruction.mid( 5 ) + literal;
+      }
+    }
+    else if ( instruction == "limit" && arg < argc )
+    {
+      limit = sqlite3_value_int64( argv[arg++] );
+    }
+    else if ( instruction == "offset" && arg < argc )
+    {
+      offset = sqlite3_value_int64( argv[arg++] );
+    }
+    else if ( instruction.startsWith( "attrs" ) )
+    {
+      QgsAttributeList attributes;
+      Q_FOREACH ( const QString& index, instruction.mid( 5 ).split( ' ', QString::SkipEmptyParts ) )
+      {
+        attributes << index.toInt();
+      }
+      request.setSubsetOfAttributes( attributes );
     }
-    if ( !expr.isEmpty() )
+    else if ( instruction == "nogeom" )
     {
-      request.setFilterExpression( expr );
+      request.setFlags( request.flags() | QgsFeatureRequest::NoGeometry );
+    }
+    else if ( instruction.startsWith( "order " ) )
+    {
+      QStringList parts = instruction.split( ' ' );
+      int index = parts.value( 1 ).toInt();
+      bool ascending = parts.value( 2 ) == "1";
+      if ( index >= 0 && index < fields.count() )
+      {
+        // NULL is the smallest value in SQLite
+        orderBy << QgsFeatureRequest::OrderByClause( QgsExpression::quotedColumnRef( fields.at( index ).name() ), ascending, ascending );
+      }
     }
   }
-  VTableCursor *c = reinterpret_cast<VTableCursor*>( cursor );
+
+  if ( noRows )
+  {
+    c->mEof = true;
+    return SQLITE_OK;
+  }
+
+  if ( !expressions.isEmpty() )
+  {
+    request.setFilterExpression( expressions.join( " AND " ) );
+  }
+  if ( !orderBy.isEmpty() )
+  {
+    request.setOrderBy( orderBy );
+  }
+  if ( limit >= 0 )
+  {
+    // SQLite skips the offset rows itself
+    request.setLimit( limit + offset );
+  }
+
   c->filter( request );
   return SQLITE_OK;
 }
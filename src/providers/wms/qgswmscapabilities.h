@@ -427,6 +427,7 @@ enum QgsWmsTileAttribute
   TileIndex = QNetworkRequest::User + 1,
   TileRect  = QNetworkRequest::User + 2,
   TileRetry = QNetworkRequest::User + 3,
+  TileUrl   = QNetworkRequest::User + 4,  //!< Original URL of the tile, before any redirection
 };
 
 enum QgsWmsDpiMode
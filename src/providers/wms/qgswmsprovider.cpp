@@ -60,6 +60,11 @@
 #include <QScriptValueIterator>
 #include <QNetworkDiskCache>
 #include <QTimer>
+#include <QCoreApplication>
+#include <QMutex>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
 
 #include <ogr_api.h>
 
@@ -78,6 +83,112 @@ static QString DEFAULT_LATLON_CRS = "CRS:84";
 
 QMap<QString, QgsWmsStatistics::Stat> QgsWmsStatistics::sData;
 
+QMutex QgsWmsTileCache::sMutex;
+QCache<QString, QgsWmsTileCache::CachedTile> QgsWmsTileCache::sCache;
+bool QgsWmsTileCache::sInitialized = false;
+
+//! Maximum number of tiles prefetched from the next finer tile matrix
+static const int MAX_PREFETCH_TILES = 32;
+
+//! Maximum number of tile prefetch requests running at the same time
+static const int MAX_PREFETCH_REQUESTS = 2;
+
+// hosts on which a tile request failed after it was pipelined
+Q_GLOBAL_STATIC( QMutex, sPipeliningMutex )
+Q_GLOBAL_STATIC( QSet<QString>, sPipeliningFailedHosts )
+
+// decoding of tile images, separate from the global pool used by rendering
+// so that waiting for decoded tiles never blocks the rendering threads
+Q_GLOBAL_STATIC( QThreadPool, sTileDecodingPool )
+
+//! Returns whether tile requests to the host of the url may be pipelined
+static bool tilePipeliningAllowed( const QUrl &url )
+{
+  QMutexLocker locker( sPipeliningMutex() );
+  return !sPipeliningFailedHosts()->contains( url.host() );
+}
+
+//! Sets attributes common to all tile requests (cache and pipelining)
+static void setTileRequestAttributes( QNetworkRequest &request )
+{
+  request.setAttribute( QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache );
+  request.setAttribute( QNetworkRequest::CacheSaveControlAttribute, true );
+  request.setAttribute( QNetworkRequest::HttpPipeliningAllowedAttribute, tilePipeliningAllowed( request.url() ) );
+}
+
+//! Drops Cache-Control of the cached tile and sets default expiry if the server did not provide any, returns the expiry
+static QDateTime updateTileCacheMetaData( QNetworkReply *reply )
+{
+  QSettings s;
+  QDateTime defaultExpiry = QDateTime::currentDateTime().addSecs( s.value( "/qgis/defaultTileExpiry", "24" ).toInt() * 60 * 60 );
+
+  if ( !QgsNetworkAccessManager::instance()->cache() )
+    return defaultExpiry;
+
+  QNetworkCacheMetaData cmd = QgsNetworkAccessManager::instance()->cache()->metaData( reply->request().url() );
+
+  QNetworkCacheMetaData::RawHeaderList hl;
+  Q_FOREACH ( const QNetworkCacheMetaData::RawHeader &h, cmd.rawHeaders() )
+  {
+    if ( h.first != "Cache-Control" )
+      hl.append( h );
+  }
+  cmd.setRawHeaders( hl );
+
+  QgsDebugMsg( QString( "expirationDate:%1" ).arg( cmd.expirationDate().toString() ) );
+  if ( cmd.expirationDate().isNull() )
+  {
+    cmd.setExpirationDate( defaultExpiry );
+  }
+
+  QgsNetworkAccessManager::instance()->cache()->updateMetaData( cmd );
+  return cmd.expirationDate();
+}
+
+//! Orders tiles by distance from the center of the view
+struct TileDistanceLessThan
+{
+  TileDistanceLessThan( double centerCol, double centerRow )
+      : mCenterCol( centerCol )
+      , mCenterRow( centerRow )
+  {}
+
+  bool operator()( const QPoint &a, const QPoint &b ) const
+  {
+    return distance( a ) < distance( b );
+  }
+
+  double distance( const QPoint &p ) const
+  {
+    return ( p.x() - mCenterCol ) * ( p.x() - mCenterCol ) + ( p.y() - mCenterRow ) * ( p.y() - mCenterRow );
+  }
+
+  double mCenterCol;
+  double mCenterRow;
+};
+
+//! Decodes a tile image in a worker thread and passes it back to the download handler
+class QgsWmsTileDecoder : public QRunnable
+{
+  public:
+    QgsWmsTileDecoder( QObject *handler, int decodeNo, const QByteArray &data )
+        : mHandler( handler )
+        , mDecodeNo( decodeNo )
+        , mData( data )
+    {}
+
+    void run() override
+    {
+      QImage image = QImage::fromData( mData );
+      QMetaObject::invokeMethod( mHandler, "tileDecoded", Qt::QueuedConnection, Q_ARG( int, mDecodeNo ), Q_ARG( QImage, image ) );
+    }
+
+  private:
+    QObject *mHandler;
+    int mDecodeNo;
+    QByteArray mData;
+};
+
 QgsWmsProvider::QgsWmsProvider( QString const& uri, const QgsWmsCapabilities* capabilities )
     : QgsRasterDataProvider( uri )
     , mHttpGetLegendGraphicResponse( nullptr )
@@ -667,27 +778,8 @@ QImage *QgsWmsProvider::draw( QgsRectangle const &viewExtent, int pixelWidth, in
     double thMap = tm->tileHeight * tres;
     QgsDebugMsg( QString( "tile map size: %1,%2" ).arg( qgsDoubleToString( twMap ), qgsDoubleToString( thMap ) ) );
 
-    int minTileCol = 0;
-    int maxTileCol = tm->matrixWidth - 1;
-    int minTileRow = 0;
-    int maxTileRow = tm->matrixHeight - 1;
-
-
-    if ( mTileLayer &&
-         mTileLayer->setLinks.contains( mTileMatrixSet->identifier ) &&
-         mTileLayer->setLinks[ mTileMatrixSet->identifier ].limits.contains( tm->identifier ) )
-    {
-      const QgsWmtsTileMatrixLimits &tml = mTileLayer->setLinks[ mTileMatrixSet->identifier ].limits[ tm->identifier ];
-      minTileCol = tml.minTileCol;
-      maxTileCol = tml.maxTileCol;
-      minTileRow = tml.minTileRow;
-      maxTileRow = tml.maxTileRow;
-      QgsDebugMsg( QString( "%1 %2: TileMatrixLimits col %3-%4 row %5-%6" )
-                   .arg( mTileMatrixSet->identifier,
-                         tm->identifier )
-                   .arg( minTileCol ).arg( maxTileCol )
-                   .arg( minTileRow ).arg( maxTileRow ) );
-    }
+    int minTileCol, maxTileCol, minTileRow, maxTileRow;
+    tileMatrixLimits( tm, minTileCol, maxTileCol, minTileRow, maxTileRow );
 
     int col0 = qBound( minTileCol, ( int ) floor(( viewExtent.xMinimum() - tm->topLeft.x() ) / twMap ), maxTileCol );
     int row0 = qBound( minTileRow, ( int ) floor(( tm->topLeft.y() - viewExtent.yMaximum() ) / thMap ), maxTileRow );
@@ -704,163 +796,263 @@ QImage *QgsWmsProvider::draw( QgsRectangle const &viewExtent, int pixelWidth, in
     }
 #endif
 
+    // request tiles in the middle of the view first, so that they are
+    // painted into the image first
+    QList<QPoint> tiles;
+    for ( int row = row0; row <= row1; row++ )
+    {
+      for ( int col = col0; col <= col1; col++ )
+      {
+        tiles << QPoint( col, row );
+      }
+    }
+    qStableSort( tiles.begin(), tiles.end(), TileDistanceLessThan( ( col0 + col1 ) / 2.0, ( row0 + row1 ) / 2.0 ) );
+
+    QStringList urls = tileUrls( tm, tres, tileMode, tiles );
+    if ( urls.isEmpty() )
+      return mCachedImage;
+
     QList<QgsWmsTiledImageDownloadHandler::TileRequest> requests;
+    for ( int i = 0; i < tiles.size(); i++ )
+    {
+      int col = tiles.at( i ).x();
+      int row = tiles.at( i ).y();
+      QgsDebugMsg( QString( "tileRequest %1 %2/%3 (%4,%5): %6" ).arg( mTileReqNo ).arg( i ).arg( n ).arg( row ).arg( col ).arg( urls.at( i ) ) );
+      QRectF rect( tm->topLeft.x() + col * twMap, tm->topLeft.y() - ( row + 1 ) * thMap, twMap, thMap );
+      requests << QgsWmsTiledImageDownloadHandler::TileRequest( urls.at( i ), rect, i );
+    }
+
+    emit statusChanged( tr( "Getting tiles." ) );
+
+    QgsWmsTiledImageDownloadHandler handler( dataSourceUri(), mSettings.authorization(), mTileReqNo, requests, mCachedImage, mCachedViewExtent, mSettings.mSmoothPixmapTransform );
+    handler.downloadBlocking();
+
+    if ( QSettings().value( "/qgis/wmsTilePrefetch", true ).toBool() )
+      prefetchTiles( viewExtent, tm, tres, tileMode, col0, row0, col1, row1 );
 
-    switch ( tileMode )
+#if 0
+    const QgsWmsStatistics::Stat& stat = QgsWmsStatistics::statForUri( dataSourceUri() );
+    emit statusChanged( tr( "%n tile requests in background", "tile request count", requests.count() )
+                        + tr( ", %n cache hits", "tile cache hits", stat.cacheHits )
+                        + tr( ", %n cache misses.", "tile cache missed", stat.cacheMisses )
+                        + tr( ", %n errors.", "errors", stat.errors )
+                      );
+#endif
+  }
+
+  return mCachedImage;
+}
+
+void QgsWmsProvider::tileMatrixLimits( const QgsWmtsTileMatrix *tm, int &minTileCol, int &maxTileCol, int &minTileRow, int &maxTileRow ) const
+{
+  minTileCol = 0;
+  maxTileCol = tm->matrixWidth - 1;
+  minTileRow = 0;
+  maxTileRow = tm->matrixHeight - 1;
+
+  if ( mTileLayer &&
+       mTileLayer->setLinks.contains( mTileMatrixSet->identifier ) &&
+       mTileLayer->setLinks[ mTileMatrixSet->identifier ].limits.contains( tm->identifier ) )
+  {
+    const QgsWmtsTileMatrixLimits &tml = mTileLayer->setLinks[ mTileMatrixSet->identifier ].limits[ tm->identifier ];
+    minTileCol = tml.minTileCol;
+    maxTileCol = tml.maxTileCol;
+    minTileRow = tml.minTileRow;
+    maxTileRow = tml.maxTileRow;
+    QgsDebugMsg( QString( "%1 %2: TileMatrixLimits col %3-%4 row %5-%6" )
+                 .arg( mTileMatrixSet->identifier,
+                       tm->identifier )
+                 .arg( minTileCol ).arg( maxTileCol )
+                 .arg( minTileRow ).arg( maxTileRow ) );
+  }
+}
+
+QStringList QgsWmsProvider::tileUrls( const QgsWmtsTileMatrix *tm, double tres, QgsTileMode tileMode, const QList<QPoint> &tiles )
+{
+  QStringList urls;
+
+  switch ( tileMode )
+  {
+    case WMSC:
     {
-      case WMSC:
+      bool changeXY = mCaps.shouldInvertAxisOrientation( mImageCrs );
+      double twMap = tm->tileWidth * tres;
+      double thMap = tm->tileHeight * tres;
+
+      // add WMS request
+      QUrl url( mSettings.mIgnoreGetMapUrl ? mSettings.mBaseUrl : getMapUrl() );
+      setQueryItem( url, "SERVICE", "WMS" );
+      setQueryItem( url, "VERSION", mCaps.mCapabilities.version );
+      setQueryItem( url, "REQUEST", "GetMap" );
+      setQueryItem( url, "WIDTH", QString::number( tm->tileWidth ) );
+      setQueryItem( url, "HEIGHT", QString::number( tm->tileHeight ) );
+      setQueryItem( url, "LAYERS", mSettings.mActiveSubLayers.join( "," ) );
+      setQueryItem( url, "STYLES", mSettings.mActiveSubStyles.join( "," ) );
+      setFormatQueryItem( url );
+
+      setSRSQueryItem( url );
+
+      if ( mSettings.mTiled )
       {
-        // add WMS request
-        QUrl url( mSettings.mIgnoreGetMapUrl ? mSettings.mBaseUrl : getMapUrl() );
-        setQueryItem( url, "SERVICE", "WMS" );
-        setQueryItem( url, "VERSION", mCaps.mCapabilities.version );
-        setQueryItem( url, "REQUEST", "GetMap" );
-        setQueryItem( url, "WIDTH", QString::number( tm->tileWidth ) );
-        setQueryItem( url, "HEIGHT", QString::number( tm->tileHeight ) );
-        setQueryItem( url, "LAYERS", mSettings.mActiveSubLayers.join( "," ) );
-        setQueryItem( url, "STYLES", mSettings.mActiveSubStyles.join( "," ) );
-        setFormatQueryItem( url );
+        setQueryItem( url, "TILED", "true" );
+      }
+
+      if ( mDpi != -1 )
+      {
+        if ( mSettings.mDpiMode & dpiQGIS )
+          setQueryItem( url, "DPI", QString::number( mDpi ) );
+        if ( mSettings.mDpiMode & dpiUMN )
+          setQueryItem( url, "MAP_RESOLUTION", QString::number( mDpi ) );
+        if ( mSettings.mDpiMode & dpiGeoServer )
+          setQueryItem( url, "FORMAT_OPTIONS", QString( "dpi:%1" ).arg( mDpi ) );
+      }
+
+      if ( mSettings.mImageMimeType == "image/x-jpegorpng" ||
+           ( !mSettings.mImageMimeType.contains( "jpeg", Qt::CaseInsensitive ) &&
+             !mSettings.mImageMimeType.contains( "jpg", Qt::CaseInsensitive ) ) )
+      {
+        setQueryItem( url, "TRANSPARENT", "TRUE" );  // some servers giving error for 'true' (lowercase)
+      }
+
+      QString baseUrl = url.toString();
+      Q_FOREACH ( const QPoint &tile, tiles )
+      {
+        int col = tile.x();
+        int row = tile.y();
+        urls << baseUrl + QString( changeXY ? "&BBOX=%2,%1,%4,%3" : "&BBOX=%1,%2,%3,%4" )
+        .arg( qgsDoubleToString( tm->topLeft.x() +         col * twMap /* + twMap * 0.001 */ ),
+              qgsDoubleToString( tm->topLeft.y() - ( row + 1 ) * thMap /* - thMap * 0.001 */ ),
+              qgsDoubleToString( tm->topLeft.x() + ( col + 1 ) * twMap /* - twMap * 0.001 */ ),
+              qgsDoubleToString( tm->topLeft.y() -         row * thMap /* + thMap * 0.001 */ ) );
+      }
+    }
+    break;
 
-        setSRSQueryItem( url );
+    case WMTS:
+    {
+      if ( !getTileUrl().isNull() )
+      {
+        // KVP
+        QUrl url( mSettings.mIgnoreGetMapUrl ? mSettings.mBaseUrl : getTileUrl() );
+
+        // compose static request arguments.
+        setQueryItem( url, "SERVICE", "WMTS" );
+        setQueryItem( url, "REQUEST", "GetTile" );
+        setQueryItem( url, "VERSION", mCaps.mCapabilities.version );
+        setQueryItem( url, "LAYER", mSettings.mActiveSubLayers[0] );
+        setQueryItem( url, "STYLE", mSettings.mActiveSubStyles[0] );
+        setQueryItem( url, "FORMAT", mSettings.mImageMimeType );
+        setQueryItem( url, "TILEMATRIXSET", mTileMatrixSet->identifier );
+        setQueryItem( url, "TILEMATRIX", tm->identifier );
 
-        if ( mSettings.mTiled )
+        for ( QHash<QString, QString>::const_iterator it = mSettings.mTileDimensionValues.constBegin(); it != mSettings.mTileDimensionValues.constEnd(); ++it )
         {
-          setQueryItem( url, "TILED", "true" );
+          setQueryItem( url, it.key(), it.value() );
         }
 
-        if ( mDpi != -1 )
+        url.removeQueryItem( "TILEROW" );
+        url.removeQueryItem( "TILECOL" );
+
+        QString baseUrl = url.toString();
+        Q_FOREACH ( const QPoint &tile, tiles )
         {
-          if ( mSettings.mDpiMode & dpiQGIS )
-            setQueryItem( url, "DPI", QString::number( mDpi ) );
-          if ( mSettings.mDpiMode & dpiUMN )
-            setQueryItem( url, "MAP_RESOLUTION", QString::number( mDpi ) );
-          if ( mSettings.mDpiMode & dpiGeoServer )
-            setQueryItem( url, "FORMAT_OPTIONS", QString( "dpi:%1" ).arg( mDpi ) );
+          urls << baseUrl + QString( "&TILEROW=%1&TILECOL=%2" ).arg( tile.y() ).arg( tile.x() );
         }
+      }
+      else
+      {
+        // REST
+        QString url = mTileLayer->getTileURLs[ mSettings.mImageMimeType ];
+
+        url.replace( "{layer}", mSettings.mActiveSubLayers[0], Qt::CaseInsensitive );
+        url.replace( "{style}", mSettings.mActiveSubStyles[0], Qt::CaseInsensitive );
+        url.replace( "{tilematrixset}", mTileMatrixSet->identifier, Qt::CaseInsensitive );
+        url.replace( "{tilematrix}", tm->identifier, Qt::CaseInsensitive );
 
-        if ( mSettings.mImageMimeType == "image/x-jpegorpng" ||
-             ( !mSettings.mImageMimeType.contains( "jpeg", Qt::CaseInsensitive ) &&
-               !mSettings.mImageMimeType.contains( "jpg", Qt::CaseInsensitive ) ) )
+        for ( QHash<QString, QString>::const_iterator it = mSettings.mTileDimensionValues.constBegin(); it != mSettings.mTileDimensionValues.constEnd(); ++it )
         {
-          setQueryItem( url, "TRANSPARENT", "TRUE" );  // some servers giving error for 'true' (lowercase)
+          url.replace( "{" + it.key() + "}", it.value(), Qt::CaseInsensitive );
         }
 
-        int i = 0;
-        for ( int row = row0; row <= row1; row++ )
+        Q_FOREACH ( const QPoint &tile, tiles )
         {
-          for ( int col = col0; col <= col1; col++ )
-          {
-            QString turl;
-            turl += url.toString();
-            turl += QString( changeXY ? "&BBOX=%2,%1,%4,%3" : "&BBOX=%1,%2,%3,%4" )
-                    .arg( qgsDoubleToString( tm->topLeft.x() +         col * twMap /* + twMap * 0.001 */ ),
-                          qgsDoubleToString( tm->topLeft.y() - ( row + 1 ) * thMap /* - thMap * 0.001 */ ),
-                          qgsDoubleToString( tm->topLeft.x() + ( col + 1 ) * twMap /* - twMap * 0.001 */ ),
-                          qgsDoubleToString( tm->topLeft.y() -         row * thMap /* + thMap * 0.001 */ ) );
-
-            QgsDebugMsg( QString( "tileRequest %1 %2/%3 (%4,%5): %6" ).arg( mTileReqNo ).arg( i++ ).arg( n ).arg( row ).arg( col ).arg( turl ) );
-            QRectF rect( tm->topLeft.x() + col * twMap, tm->topLeft.y() - ( row + 1 ) * thMap, twMap, thMap );
-            requests << QgsWmsTiledImageDownloadHandler::TileRequest( turl, rect, i );
-          }
+          QString turl( url );
+          turl.replace( "{tilerow}", QString::number( tile.y() ), Qt::CaseInsensitive );
+          turl.replace( "{tilecol}", QString::number( tile.x() ), Qt::CaseInsensitive );
+          urls << turl;
         }
       }
-      break;
-
-      case WMTS:
-      {
-        if ( !getTileUrl().isNull() )
-        {
-          // KVP
-          QUrl url( mSettings.mIgnoreGetMapUrl ? mSettings.mBaseUrl : getTileUrl() );
-
-          // compose static request arguments.
-          setQueryItem( url, "SERVICE", "WMTS" );
-          setQueryItem( url, "REQUEST", "GetTile" );
-          setQueryItem( url, "VERSION", mCaps.mCapabilities.version );
-          setQueryItem( url, "LAYER", mSettings.mActiveSubLayers[0] );
-          setQueryItem( url, "STYLE", mSettings.mActiveSubStyles[0] );
-          setQueryItem( url, "FORMAT", mSettings.mImageMimeType );
-          setQueryItem( url, "TILEMATRIXSET", mTileMatrixSet->identifier );
-          setQueryItem( url, "TILEMATRIX", tm->identifier );
-
-          for ( QHash<QString, QString>::const_iterator it = mSettings.mTileDimensionValues.constBegin(); it != mSettings.mTileDimensionValues.constEnd(); ++it )
-          {
-            setQueryItem( url, it.key(), it.value() );
-          }
-
-          url.removeQueryItem( "TILEROW" );
-          url.removeQueryItem( "TILECOL" );
+    }
+    break;
 
-          int i = 0;
-          for ( int row = row0; row <= row1; row++ )
-          {
-            for ( int col = col0; col <= col1; col++ )
-            {
-              QString turl;
-              turl += url.toString();
-              turl += QString( "&TILEROW=%1&TILECOL=%2" ).arg( row ).arg( col );
+    default:
+      QgsDebugMsg( QString( "unexpected tile mode %1" ).arg( tileMode ) );
+      break;
+  }
 
-              QgsDebugMsg( QString( "tileRequest %1 %2/%3 (%4,%5): %6" ).arg( mTileReqNo ).arg( i++ ).arg( n ).arg( row ).arg( col ).arg( turl ) );
-              QRectF rect( tm->topLeft.x() + col * twMap, tm->topLeft.y() - ( row + 1 ) * thMap, twMap, thMap );
-              requests << QgsWmsTiledImageDownloadHandler::TileRequest( turl, rect, i );
-            }
-          }
-        }
-        else
-        {
-          // REST
-          QString url = mTileLayer->getTileURLs[ mSettings.mImageMimeType ];
+  return urls;
+}
 
-          url.replace( "{layer}", mSettings.mActiveSubLayers[0], Qt::CaseInsensitive );
-          url.replace( "{style}", mSettings.mActiveSubStyles[0], Qt::CaseInsensitive );
-          url.replace( "{tilematrixset}", mTileMatrixSet->identifier, Qt::CaseInsensitive );
-          url.replace( "{tilematrix}", tm->identifier, Qt::CaseInsensitive );
+void QgsWmsProvider::prefetchTiles( const QgsRectangle &viewExtent, const QgsWmtsTileMatrix *tm, double tres, QgsTileMode tileMode, int col0, int row0, int col1, int row1 )
+{
+  QList<QPoint> tiles;
 
-          for ( QHash<QString, QString>::const_iterator it = mSettings.mTileDimensionValues.constBegin(); it != mSettings.mTileDimensionValues.constEnd(); ++it )
-          {
-            url.replace( "{" + it.key() + "}", it.value(), Qt::CaseInsensitive );
-          }
+  // ring of tiles around the view, needed when the map is panned
+  int minTileCol, maxTileCol, minTileRow, maxTileRow;
+  tileMatrixLimits( tm, minTileCol, maxTileCol, minTileRow, maxTileRow );
+  for ( int row = qMax( row0 - 1, minTileRow ); row <= qMin( row1 + 1, maxTileRow ); row++ )
+  {
+    for ( int col = qMax( col0 - 1, minTileCol ); col <= qMin( col1 + 1, maxTileCol ); col++ )
+    {
+      if ( row < row0 || row > row1 || col < col0 || col > col1 )
+        tiles << QPoint( col, row );
+    }
+  }
 
-          int i = 0;
-          for ( int row = row0; row <= row1; row++ )
-          {
-            for ( int col = col0; col <= col1; col++ )
-            {
-              QString turl( url );
-              turl.replace( "{tilerow}", QString::number( row ), Qt::CaseInsensitive );
-              turl.replace( "{tilecol}", QString::number( col ), Qt::CaseInsensitive );
+  QStringList urls = tileUrls( tm, tres, tileMode, tiles );
 
-              QgsDebugMsg( QString( "tileRequest %1 %2/%3 (%4,%5): %6" ).arg( mTileReqNo ).arg( i++ ).arg( n ).arg( row ).arg( col ).arg( turl ) );
-              QRectF rect( tm->topLeft.x() + col * twMap, tm->topLeft.y() - ( row + 1 ) * thMap, twMap, thMap );
-              requests << QgsWmsTiledImageDownloadHandler::TileRequest( turl, rect, i );
-            }
-          }
+  // tiles of the view in the next finer tile matrix, needed when zooming in
+  if ( mSettings.mTiled )
+  {
+    const QMap<double, QgsWmtsTileMatrix> &m = mTileMatrixSet->tileMatrices;
+    QMap<double, QgsWmtsTileMatrix>::const_iterator it = m.constFind( tres );
+    if ( it != m.constEnd() && it != m.constBegin() )
+    {
+      --it;
+      const QgsWmtsTileMatrix *finerTm = &it.value();
+      double twMap = finerTm->tileWidth * it.key();
+      double thMap = finerTm->tileHeight * it.key();
+
+      tileMatrixLimits( finerTm, minTileCol, maxTileCol, minTileRow, maxTileRow );
+      int finerCol0 = qBound( minTileCol, ( int ) floor(( viewExtent.xMinimum() - finerTm->topLeft.x() ) / twMap ), maxTileCol );
+      int finerRow0 = qBound( minTileRow, ( int ) floor(( finerTm->topLeft.y() - viewExtent.yMaximum() ) / thMap ), maxTileRow );
+      int finerCol1 = qBound( minTileCol, ( int ) floor(( viewExtent.xMaximum() - finerTm->topLeft.x() ) / twMap ), maxTileCol );
+      int finerRow1 = qBound( minTileRow, ( int ) floor(( finerTm->topLeft.y() - viewExtent.yMinimum() ) / thMap ), maxTileRow );
+
+      QList<QPoint> finerTiles;
+      for ( int row = finerRow0; row <= finerRow1 && finerTiles.size() < MAX_PREFETCH_TILES; row++ )
+      {
+        for ( int col = finerCol0; col <= finerCol1 && finerTiles.size() < MAX_PREFETCH_TILES; col++ )
+        {
+          finerTiles << QPoint( col, row );
         }
       }
-      break;
-
-      default:
-        QgsDebugMsg( QString( "unexpected tile mode %1" ).arg( mTileLayer->tileMode ) );
-        return mCachedImage;
+      urls << tileUrls( finerTm, it.key(), tileMode, finerTiles );
     }
+  }
 
-    emit statusChanged( tr( "Getting tiles." ) );
-
-    QgsWmsTiledImageDownloadHandler handler( dataSourceUri(), mSettings.authorization(), mTileReqNo, requests, mCachedImage, mCachedViewExtent, mSettings.mSmoothPixmapTransform );
-    handler.downloadBlocking();
-
-
-#if 0
-    const QgsWmsStatistics::Stat& stat = QgsWmsStatistics::statForUri( dataSourceUri() );
-    emit statusChanged( tr( "%n tile requests in background", "tile request count", requests.count() )
-                        + tr( ", %n cache hits", "tile cache hits", stat.cacheHits )
-                        + tr( ", %n cache misses.", "tile cache missed", stat.cacheMisses )
-                        + tr( ", %n errors.", "errors", stat.errors )
-                      );
-#endif
+  QList<QNetworkRequest> requests;
+  Q_FOREACH ( const QString &url, urls.mid( 0, 2 * MAX_PREFETCH_TILES ) )
+  {
+    QNetworkRequest request( url );
+    mSettings.authorization().setAuthorization( request );
+    request.setAttribute( QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache );
+    request.setAttribute( QNetworkRequest::CacheSaveControlAttribute, true );
+    request.setPriority( QNetworkRequest::LowPriority );
+    requests << request;
   }
 
-  return mCachedImage;
+  QgsWmsTilePrefetcher::instance()->prefetch( requests );
 }
 
 void QgsWmsProvider::readBlock( int bandNo, QgsRectangle  const & viewExtent, int pixelWidth, int pixelHeight, void *block )
@@ -2890,6 +3082,8 @@ void QgsWmsProvider::reloadData()
 {
   delete mCachedImage;
   mCachedImage = nullptr;
+
+  QgsWmsTileCache::removeTiles( dataSourceUri() );
 }
 
 
@@ -3353,17 +3547,29 @@ QgsWmsTiledImageDownloadHandler::QgsWmsTiledImageDownloadHandler( const QString&
     , mEventLoop( new QEventLoop )
     , mTileReqNo( tileReqNo )
     , mSmoothPixmapTransform( smoothPixmapTransform )
+    , mDecodeNo( 0 )
 {
+  QgsWmsTilePrefetcher::instance()->renderingStarted();
+
   Q_FOREACH ( const TileRequest& r, requests )
   {
+    QImage image;
+    if ( QgsWmsTileCache::tile( r.url, image ) )
+    {
+      QgsWmsStatistics::statForUri( mProviderUri ).memoryCacheHits++;
+      drawTile( tileDestination( r.rect ), image );
+      continue;
+    }
+
     QNetworkRequest request( r.url );
     auth.setAuthorization( request );
-    request.setAttribute( QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache );
-    request.setAttribute( QNetworkRequest::CacheSaveControlAttribute, true );
+    setTileRequestAttributes( request );
+    request.setPriority( QNetworkRequest::HighPriority );
     request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileReqNo ), mTileReqNo );
     request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileIndex ), r.index );
     request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileRect ), r.rect );
     request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileRetry ), 0 );
+    request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileUrl ), r.url );
 
     QNetworkReply *reply = QgsNetworkAccessManager::instance()->get( request );
     connect( reply, SIGNAL( finished() ), this, SLOT( tileReplyFinished() ) );
@@ -3375,13 +3581,17 @@ QgsWmsTiledImageDownloadHandler::QgsWmsTiledImageDownloadHandler( const QString&
 QgsWmsTiledImageDownloadHandler::~QgsWmsTiledImageDownloadHandler()
 {
   delete mEventLoop;
+
+  QgsWmsTilePrefetcher::instance()->renderingFinished();
 }
 
 void QgsWmsTiledImageDownloadHandler::downloadBlocking()
 {
-  mEventLoop->exec( QEventLoop::ExcludeUserInputEvents );
+  if ( !mReplies.isEmpty() )
+    mEventLoop->exec( QEventLoop::ExcludeUserInputEvents );
 
   Q_ASSERT( mReplies.isEmpty() );
+  Q_ASSERT( mDecodedTiles.isEmpty() );
 }
 
 
@@ -3407,27 +3617,7 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
   }
 #endif
 
-  if ( QgsNetworkAccessManager::instance()->cache() )
-  {
-    QNetworkCacheMetaData cmd = QgsNetworkAccessManager::instance()->cache()->metaData( reply->request().url() );
-
-    QNetworkCacheMetaData::RawHeaderList hl;
-    Q_FOREACH ( const QNetworkCacheMetaData::RawHeader &h, cmd.rawHeaders() )
-    {
-      if ( h.first != "Cache-Control" )
-        hl.append( h );
-    }
-    cmd.setRawHeaders( hl );
-
-    QgsDebugMsg( QString( "expirationDate:%1" ).arg( cmd.expirationDate().toString() ) );
-    if ( cmd.expirationDate().isNull() )
-    {
-      QSettings s;
-      cmd.setExpirationDate( QDateTime::currentDateTime().addSecs( s.value( "/qgis/defaultTileExpiry", "24" ).toInt() * 60 * 60 ) );
-    }
-
-    QgsNetworkAccessManager::instance()->cache()->updateMetaData( cmd );
-  }
+  QDateTime expiry = updateTileCacheMetaData( reply );
 
   int tileReqNo = reply->request().attribute( static_cast<QNetworkRequest::Attribute>( TileReqNo ) ).toInt();
   int tileNo = reply->request().attribute( static_cast<QNetworkRequest::Attribute>( TileIndex ) ).toInt();
@@ -3451,12 +3641,13 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
     {
       QNetworkRequest request( redirect.toUrl() );
       mAuth.setAuthorization( request );
-      request.setAttribute( QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache );
-      request.setAttribute( QNetworkRequest::CacheSaveControlAttribute, true );
+      setTileRequestAttributes( request );
+      request.setPriority( QNetworkRequest::HighPriority );
       request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileReqNo ), tileReqNo );
       request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileIndex ), tileNo );
       request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileRect ), r );
       request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileRetry ), 0 );
+      request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileUrl ), reply->request().attribute( static_cast<QNetworkRequest::Attribute>( TileUrl ) ) );
 
       mReplies.removeOne( reply );
       reply->deleteLater();
@@ -3480,8 +3671,7 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
       mReplies.removeOne( reply );
       reply->deleteLater();
 
-      if ( mReplies.isEmpty() )
-        finish();
+      finishIfDone();
 
       return;
     }
@@ -3519,8 +3709,7 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
       mReplies.removeOne( reply );
       reply->deleteLater();
 
-      if ( mReplies.isEmpty() )
-        finish();
+      finishIfDone();
 
       return;
     }
@@ -3528,40 +3717,19 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
     // only take results from current request number
     if ( mTileReqNo == tileReqNo )
     {
-      double cr = mCachedViewExtent.width() / mCachedImage->width();
-
-      QRectF dst(( r.left() - mCachedViewExtent.xMinimum() ) / cr,
-                 ( mCachedViewExtent.yMaximum() - r.bottom() ) / cr,
-                 r.width() / cr,
-                 r.height() / cr );
+      QRectF dst = tileDestination( r );
 
       QgsDebugMsg( QString( "tile reply: length %1" ).arg( reply->bytesAvailable() ) );
 
-      QImage myLocalImage = QImage::fromData( reply->readAll() );
-
-      if ( !myLocalImage.isNull() )
-      {
-        QPainter p( mCachedImage );
-        if ( mSmoothPixmapTransform )
-          p.setRenderHint( QPainter::SmoothPixmapTransform, true );
-        p.drawImage( dst, myLocalImage );
-#if 0
-        myLocalImage.save( QString( "%1/%2-tile-%3.png" ).arg( QDir::tempPath() ).arg( mTileReqNo ).arg( tileNo ) );
-        p.drawRect( dst ); // show tile bounds
-        p.drawText( dst, Qt::AlignCenter, QString( "(%1)\n%2,%3\n%4,%5\n%6x%7" )
-                    .arg( tileNo )
-                    .arg( r.left() ).arg( r.bottom() )
-                    .arg( r.right() ).arg( r.top() )
-                    .arg( r.width() ).arg( r.height() ) );
-#endif
-      }
-      else
-      {
-        QgsMessageLog::logMessage( tr( "Returned image is flawed [Content-Type:%1; URL: %2]" )
-                                   .arg( contentType, reply->url().toString() ), tr( "WMS" ) );
-
-        repeatTileRequest( reply->request() );
-      }
+      // decode in a worker thread, tiles are painted as soon as they are decoded
+      DecodedTile tile;
+      tile.request = reply->request();
+      tile.url = reply->request().attribute( static_cast<QNetworkRequest::Attribute>( TileUrl ) ).toUrl();
+      tile.dst = dst;
+      tile.contentType = contentType;
+      tile.expiry = expiry;
+      mDecodedTiles.insert( ++mDecodeNo, tile );
+      sTileDecodingPool()->start( new QgsWmsTileDecoder( this, mDecodeNo, reply->readAll() ) );
     }
     else
     {
@@ -3571,22 +3739,28 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
     mReplies.removeOne( reply );
     reply->deleteLater();
 
-    if ( mReplies.isEmpty() )
-      finish();
-
+    finishIfDone();
   }
   else
   {
     QgsWmsStatistics::Stat& stat = QgsWmsStatistics::statForUri( mProviderUri );
     stat.errors++;
 
+    if ( reply->attribute( QNetworkRequest::HttpPipeliningWasUsedAttribute ).toBool() )
+    {
+      // some servers and proxies do not handle pipelined requests correctly,
+      // the repeated and all following requests to the host are not pipelined
+      QgsDebugMsg( QString( "disabling pipelining of tile requests to %1" ).arg( reply->url().host() ) );
+      QMutexLocker locker( sPipeliningMutex() );
+      sPipeliningFailedHosts()->insert( reply->url().host() );
+    }
+
     repeatTileRequest( reply->request() );
 
     mReplies.removeOne( reply );
     reply->deleteLater();
 
-    if ( mReplies.isEmpty() )
-      finish();
+    finishIfDone();
   }
 
 #if 0
@@ -3600,6 +3774,50 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
 }
 
 
+QRectF QgsWmsTiledImageDownloadHandler::tileDestination( const QRectF &rect ) const
+{
+  double cr = mCachedViewExtent.width() / mCachedImage->width();
+
+  return QRectF(( rect.left() - mCachedViewExtent.xMinimum() ) / cr,
+                ( mCachedViewExtent.yMaximum() - rect.bottom() ) / cr,
+                rect.width() / cr,
+                rect.height() / cr );
+}
+
+void QgsWmsTiledImageDownloadHandler::drawTile( const QRectF &dst, const QImage &image )
+{
+  QPainter p( mCachedImage );
+  if ( mSmoothPixmapTransform )
+    p.setRenderHint( QPainter::SmoothPixmapTransform, true );
+  p.drawImage( dst, image );
+#if 0
+  p.drawRect( dst ); // show tile bounds
+#endif
+}
+
+void QgsWmsTiledImageDownloadHandler::tileDecoded( int decodeNo, const QImage &image )
+{
+  DecodedTile tile = mDecodedTiles.take( decodeNo );
+
+  QgsWmsStatistics::statForUri( mProviderUri ).decodedTiles++;
+
+  if ( !image.isNull() )
+  {
+    // keyed by the requested URL, the tile may have been redirected
+    QgsWmsTileCache::insertTile( tile.url, image, tile.expiry, mProviderUri );
+    drawTile( tile.dst, image );
+  }
+  else
+  {
+    QgsMessageLog::logMessage( tr( "Returned image is flawed [Content-Type:%1; URL: %2]" )
+                               .arg( tile.contentType, tile.request.url().toString() ), tr( "WMS" ) );
+
+    repeatTileRequest( tile.request );
+  }
+
+  finishIfDone();
+}
+
 void QgsWmsTiledImageDownloadHandler::repeatTileRequest( QNetworkRequest const &oldRequest )
 {
   QgsWmsStatistics::Stat& stat = QgsWmsStatistics::statForUri( mProviderUri );
@@ -3637,12 +3855,171 @@ void QgsWmsTiledImageDownloadHandler::repeatTileRequest( QNetworkRequest const &
   }
   QgsDebugMsg( QString( "repeat tileRequest %1 %2(retry %3) for url: %4" ).arg( tileReqNo ).arg( tileNo ).arg( retry ).arg( url ) );
   request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileRetry ), retry );
+  request.setAttribute( QNetworkRequest::HttpPipeliningAllowedAttribute, tilePipeliningAllowed( request.url() ) );
 
   QNetworkReply *reply = QgsNetworkAccessManager::instance()->get( request );
   mReplies << reply;
   connect( reply, SIGNAL( finished() ), this, SLOT( tileReplyFinished() ) );
 }
 
+
+// ----------
+
+
+void QgsWmsTileCache::init()
+{
+  if ( sInitialized )
+    return;
+
+  QSettings s;
+  sCache.setMaxCost( s.value( "/qgis/wmsTileMemoryCacheSize", 64 ).toInt() * 1024 );
+  sInitialized = true;
+}
+
+bool QgsWmsTileCache::tile( const QUrl &url, QImage &image )
+{
+  QMutexLocker locker( &sMutex );
+  init();
+
+  QString key = url.toString();
+  CachedTile *cached = sCache.object( key );
+  if ( !cached )
+    return false;
+
+  if ( cached->expiry < QDateTime::currentDateTime() )
+  {
+    sCache.remove( key );
+    return false;
+  }
+
+  image = cached->image;
+  return true;
+}
+
+void QgsWmsTileCache::insertTile( const QUrl &url, const QImage &image, const QDateTime &expiry, const QString &providerUri )
+{
+  QMutexLocker locker( &sMutex );
+  init();
+
+  CachedTile *tile = new CachedTile;
+  tile->image = image;
+  tile->expiry = expiry;
+  tile->providerUri = providerUri;
+
+  // cost in kilobytes
+  sCache.insert( url.toString(), tile, qMax( image.byteCount() / 1024, 1 ) );
+}
+
+void QgsWmsTileCache::removeTiles( const QString &providerUri )
+{
+  QMutexLocker locker( &sMutex );
+
+  Q_FOREACH ( const QString &key, sCache.keys() )
+  {
+    CachedTile *tile = sCache.object( key );
+    if ( tile && tile->providerUri == providerUri )
+      sCache.remove( key );
+  }
+}
+
+
+// ----------
+
+
+Q_GLOBAL_STATIC( QMutex, sPrefetcherMutex )
+
+QgsWmsTilePrefetcher *QgsWmsTilePrefetcher::instance()
+{
+  static QgsWmsTilePrefetcher *sInstance = nullptr;
+
+  QMutexLocker locker( sPrefetcherMutex() );
+  if ( !sInstance )
+  {
+    sInstance = new QgsWmsTilePrefetcher();
+    // network requests are started in the main thread
+    if ( QCoreApplication::instance() )
+      sInstance->moveToThread( QCoreApplication::instance()->thread() );
+  }
+  return sInstance;
+}
+
+QgsWmsTilePrefetcher::QgsWmsTilePrefetcher()
+    : mRenderingCount( 0 )
+    , mRunning( 0 )
+{
+}
+
+void QgsWmsTilePrefetcher::prefetch( const QList<QNetworkRequest> &requests )
+{
+  {
+    QMutexLocker locker( &mMutex );
+    mQueue = requests;
+  }
+  QMetaObject::invokeMethod( this, "startRequests", Qt::QueuedConnection );
+}
+
+void QgsWmsTilePrefetcher::renderingStarted()
+{
+  QMutexLocker locker( &mMutex );
+  mRenderingCount++;
+  mQueue.clear();
+}
+
+void QgsWmsTilePrefetcher::renderingFinished()
+{
+  {
+    QMutexLocker locker( &mMutex );
+    mRenderingCount--;
+    if ( mRenderingCount > 0 || mQueue.isEmpty() )
+      return;
+  }
+  QMetaObject::invokeMethod( this, "startRequests", Qt::QueuedConnection );
+}
+
+void QgsWmsTilePrefetcher::startRequests()
+{
+  QAbstractNetworkCache *cache = QgsNetworkAccessManager::instance()->cache();
+
+  while ( mRunning < MAX_PREFETCH_REQUESTS )
+  {
+    QNetworkRequest request;
+    {
+      QMutexLocker locker( &mMutex );
+      if ( !cache )
+      {
+        // there is nowhere to keep the prefetched tiles
+        mQueue.clear();
+        return;
+      }
+      if ( mRenderingCount > 0 || mQueue.isEmpty() )
+        return;
+      request = mQueue.takeFirst();
+    }
+
+    if ( cache->metaData( request.url() ).isValid() )
+      continue;
+
+    QgsDebugMsgLevel( QString( "prefetching tile: %1" ).arg( request.url().toString() ), 3 );
+    QNetworkReply *reply = QgsNetworkAccessManager::instance()->get( request );
+    connect( reply, SIGNAL( finished() ), this, SLOT( replyFinished() ) );
+    mRunning++;
+  }
+}
+
+void QgsWmsTilePrefetcher::replyFinished()
+{
+  QNetworkReply *reply = qobject_cast<QNetworkReply*>( sender() );
+
+  if ( reply->error() == QNetworkReply::NoError )
+    updateTileCacheMetaData( reply );
+
+  reply->deleteLater();
+  mRunning--;
+
+  startRequests();
+}
+
+
 QString QgsWmsProvider::toParamValue( const QgsRectangle& rect, bool changeXY )
 {
   // Warning: does not work with scientific notation
@@ -24,13 +24,18 @@
 #include "qgsnetworkreplyparser.h"
 #include "qgswmscapabilities.h"
 
+#include <QCache>
 #include <QString>
 #include <QStringList>
 #include <QDomElement>
 #include <QHash>
 #include <QMap>
+#include <QMutex>
+#include <QNetworkRequest>
+#include <QPoint>
 #include <QVector>
 #include <QUrl>
+#include <QDateTime>
 
 class QgsCoordinateTransform;
 class QgsNetworkAccessManager;
@@ -38,7 +43,6 @@ class QgsWmsCapabilities;
 
 class QNetworkAccessManager;
 class QNetworkReply;
-class QNetworkRequest;
 
 /**
  * \class Handles asynchronous download of WMS legend
@@ -449,6 +453,21 @@ class QgsWmsProvider : public QgsRasterDataProvider
     //! add image FORMAT parameter to url
     void setFormatQueryItem( QUrl &url );
 
+    //! Gets the range of tiles available in the tile matrix
+    void tileMatrixLimits( const QgsWmtsTileMatrix *tm, int &minTileCol, int &maxTileCol, int &minTileRow, int &maxTileRow ) const;
+
+    /** Returns URLs of the tiles of the tile matrix
+     * @param tm tile matrix
+     * @param tres resolution of the tile matrix
+     * @param tileMode mode of tile requests
+     * @param tiles column (x) and row (y) of tiles
+     * @return URLs in the order of tiles or empty list if the tile mode is not supported
+     */
+    QStringList tileUrls( const QgsWmtsTileMatrix *tm, double tres, QgsTileMode tileMode, const QList<QPoint> &tiles );
+
+    //! Queues tiles around the drawn tiles and of the next finer tile matrix for prefetching
+    void prefetchTiles( const QgsRectangle &viewExtent, const QgsWmtsTileMatrix *tm, double tres, QgsTileMode tileMode, int col0, int row0, int col1, int row1 );
+
     //! Name of the stored connection
     QString mConnectionName;
 
@@ -621,6 +640,9 @@ class QgsWmsTiledImageDownloadHandler : public QObject
   protected slots:
     void tileReplyFinished();
 
+    //! Paints the tile image decoded in a worker thread or repeats the request if it is flawed
+    void tileDecoded( int decodeNo, const QImage &image );
+
   protected:
     /**
      * \brief Relaunch tile request cloning previous request parameters and managing max repeat
@@ -633,6 +655,27 @@ class QgsWmsTiledImageDownloadHandler : public QObject
 
     void finish() { QMetaObject::invokeMethod( mEventLoop, "quit", Qt::QueuedConnection ); }
 
+    //! Returns the rectangle of the cached image covered by the tile with given map rectangle
+    QRectF tileDestination( const QRectF &rect ) const;
+
+    //! Paints the tile image into the cached image
+    void drawTile( const QRectF &dst, const QImage &image );
+
+    //! Finishes if no tile is being downloaded or decoded
+    void finishIfDone() { if ( mReplies.isEmpty() && mDecodedTiles.isEmpty() ) finish(); }
+
+    //! Tile which is being decoded
+    struct DecodedTile
+    {
+      QNetworkRequest request;
+      //! URL the tile was requested with, before any redirection
+      QUrl url;
+      QRectF dst;
+      QString contentType;
+      //! Expiry of the tile, as for the network disk cache
+      QDateTime expiry;
+    };
+
     QString mProviderUri;
 
     QgsWmsAuthorization mAuth;
@@ -647,6 +690,46 @@ class QgsWmsTiledImageDownloadHandler : public QObject
 
     //! Running tile requests
     QList<QNetworkReply*> mReplies;
+
+    //! Tiles being decoded, by decoding number
+    QHash<int, DecodedTile> mDecodedTiles;
+    int mDecodeNo;
+};
+
+
+/** Downloads tiles which are likely to be needed next (around the view and in the next
+ * zoom level) to the network cache while no tiles are requested for rendering.
+ * It lives in the main thread, tiles may be queued from any thread.
+ */
+class QgsWmsTilePrefetcher : public QObject
+{
+    Q_OBJECT
+  public:
+    static QgsWmsTilePrefetcher *instance();
+
+    //! Replaces the queued requests with new ones
+    void prefetch( const QList<QNetworkRequest> &requests );
+
+    //! Marks start of a download of tiles for rendering, queued requests are dropped and no new are started
+    void renderingStarted();
+
+    //! Marks end of a download of tiles for rendering, queued requests are started when no rendering is running
+    void renderingFinished();
+
+  private slots:
+    void startRequests();
+    void replyFinished();
+
+  private:
+    QgsWmsTilePrefetcher();
+
+    //! Protects mQueue and mRenderingCount
+    QMutex mMutex;
+    QList<QNetworkRequest> mQueue;
+    int mRenderingCount;
+
+    //! Number of running requests, only used in the main thread
+    int mRunning;
 };
 
 
@@ -660,10 +743,16 @@ class QgsWmsStatistics
           : errors( 0 )
           , cacheHits( 0 )
           , cacheMisses( 0 )
+          , memoryCacheHits( 0 )
+          , decodedTiles( 0 )
       {}
       int errors;
       int cacheHits;
       int cacheMisses;
+      //! Number of tiles taken from QgsWmsTileCache without any request
+      int memoryCacheHits;
+      //! Number of decoded tile images
+      int decodedTiles;
     };
 
     //! get reference to layer's statistics - insert to map if does not exist yet
@@ -674,6 +763,41 @@ class QgsWmsStatistics
 };
 
 
+/** Process-wide cache of decoded tile images, shared by all renders of WMS-C/WMTS
+ * layers (map canvas, overview, composer). Tiles are identified by their URL,
+ * which includes layer, style, tile matrix, row and column. Least recently
+ * used tiles are dropped when the size of cached images exceeds the budget set
+ * in /qgis/wmsTileMemoryCacheSize (in MB).
+ */
+class QgsWmsTileCache
+{
+  public:
+    //! Returns true and sets the image if the tile is cached and has not expired
+    static bool tile( const QUrl& url, QImage& image );
+
+    //! Stores the decoded image of the tile of a provider until it expires
+    static void insertTile( const QUrl& url, const QImage& image, const QDateTime& expiry, const QString& providerUri );
+
+    //! Drops all tiles of a provider, eg when its layer is reloaded
+    static void removeTiles( const QString& providerUri );
+
+  private:
+    struct CachedTile
+    {
+      QImage image;
+      QDateTime expiry;
+      QString providerUri;
+    };
+
+    //! Sets the budget of the cache if not set yet, needs sMutex locked
+    static void init();
+
+    static QMutex sMutex;
+    static QCache<QString, CachedTile> sCache;
+    static bool sInitialized;
+};
+
+
 #endif
 
 // ENDS
@@ -34,6 +34,7 @@ class TestOpenStreetMap : public QObject
     /** Our tests proper begin here */
     void download();
     void importAndQueries();
+    void importPbf();
   private:
 
 };
@@ -188,6 +189,62 @@ void TestOpenStreetMap::importAndQueries()
 }
 
 
+void TestOpenStreetMap::importPbf()
+{
+  QString dbFilename =  QDir::tempPath() + "/testdata-pbf.db";
+  QString pbfFilename = TEST_DATA_DIR "/openstreetmap/testdata.osm.pbf";
+
+  QgsOSMXmlImport import( pbfFilename, dbFilename );
+  QSignalSpy spy( &import, SIGNAL( progress( int ) ) );
+  bool res = import.import();
+  if ( import.hasError() )
+    qDebug( "PBF ERR: %s", import.errorString().toAscii().data() );
+  QCOMPARE( res, true );
+  QCOMPARE( import.hasError(), false );
+  QVERIFY( spy.count() > 0 );
+
+  QgsOSMDatabase db( dbFilename );
+  QCOMPARE( db.open(), true );
+
+  // same content as the XML test data, the relation is skipped
+  QCOMPARE( db.countNodes(), 5 );
+  QCOMPARE( db.countWays(), 1 );
+
+  QgsOSMNode n = db.node( 11111 );
+  QCOMPARE( n.isValid(), true );
+  QCOMPARE( n.point().x(), 14.4277148 );
+  QCOMPARE( n.point().y(), 50.0651387 );
+
+  QgsOSMTags tags = db.tags( false, 11111 );
+  QCOMPARE( tags.count(), 7 );
+  QCOMPARE( tags.value( "addr:postcode" ), QString( "12800" ) );
+  QCOMPARE( tags.value( "addr:street" ), QString::fromUtf8( "Jaromírova" ) );
+  QCOMPARE( db.tags( false, 360769661 ).count(), 0 );
+
+  QgsOSMWay w = db.way( 32137532 );
+  QCOMPARE( w.isValid(), true );
+  QCOMPARE( w.nodes().count(), 5 );
+  QCOMPARE( w.nodes().at( 0 ), ( qint64 )360769661 );
+  QCOMPARE( w.nodes().at( 1 ), ( qint64 )360769664 );
+  QCOMPARE( w.nodes().at( 4 ), ( qint64 )360769661 );
+
+  QgsOSMTags tagsW = db.tags( true, 32137532 );
+  QCOMPARE( tagsW.count(), 3 );
+  QCOMPARE( tagsW.value( "building" ), QString( "yes" ) );
+
+  // points of the way
+  QgsPolyline points = db.wayPoints( 32137532 );
+  QCOMPARE( points.count(), 5 );
+  QCOMPARE( points.at( 2 ), QgsPoint( 14.4270765, 50.0665127 ) );
+
+  bool exportRes = db.exportSpatiaLite( QgsOSMDatabase::Polygon, "sl_polygons", QStringList( "building" ) );
+  if ( !db.errorString().isEmpty() )
+    qDebug( "EXPORT ERR: %s", db.errorString().toAscii().data() );
+  QCOMPARE( exportRes, true );
+  QCOMPARE( db.errorString(), QString() );
+}
+
+
 QTEST_MAIN( TestOpenStreetMap )
 
 #include "testopenstreetmap.moc"
@@ -0,0 +1,331 @@
+/***************************************************************************
+     testqgsinterpolator.cpp
+     -----------------------
+    Date                 : October 2026
+    Copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest/QtTest>
+#include <QObject>
+#include <QDir>
+
+#include <gdal.h>
+
+#include "DualEdgeTriangulation.h"
+#include "LinTriangleInterpolator.h"
+#include "qgsapplication.h"
+#include "qgsgridfilewriter.h"
+#include "qgsidwinterpolator.h"
+#include "qgstininterpolator.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+
+/** \ingroup UnitTests
+ * Unit tests for the IDW and TIN interpolators and the grid file writer
+ */
+class TestQgsInterpolator : public QObject
+{
+    Q_OBJECT
+
+  public:
+    TestQgsInterpolator()
+        : mPointLayer( nullptr )
+    {}
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void idwAllPoints();
+    void idwNearestNeighbors();
+    void idwSearchRadius();
+    void gridFileWriter();
+    void tinBulkInsertion();
+    void tinInterpolator();
+    void benchmarkTinIncremental();
+    void benchmarkTinBulk();
+
+  private:
+    QgsInterpolator::LayerData layerData() const;
+    //! IDW value computed from all sample points within radius (or the count nearest points)
+    double bruteForceIdw( double x, double y, double radius, int count, bool& ok ) const;
+    //! Random points without exact duplicates, owned by the caller
+    QList<Point3D*> randomPoints( int count ) const;
+
+    QgsVectorLayer* mPointLayer;
+    QList<QgsPoint> mPoints;
+    QList<double> mValues;
+};
+
+void TestQgsInterpolator::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  mPointLayer = new QgsVectorLayer( "Point?crs=epsg:4326&field=value:double", "points", "memory" );
+  QVERIFY( mPointLayer->isValid() );
+
+  qsrand( 1 );
+  QgsFeatureList features;
+  for ( int i = 0; i < 500; ++i )
+  {
+    QgsPoint point( qrand() % 10000 / 100.0, qrand() % 10000 / 100.0 );
+    double value = qrand() % 1000 / 10.0;
+    mPoints << point;
+    mValues << value;
+
+    QgsFeature f( mPointLayer->fields() );
+    f.setGeometry( QgsGeometry::fromPoint( point ) );
+    f.setAttribute( 0, value );
+    features << f;
+  }
+  QVERIFY( mPointLayer->dataProvider()->addFeatures( features ) );
+}
+
+void TestQgsInterpolator::cleanupTestCase()
+{
+  delete mPointLayer;
+  QgsApplication::exitQgis();
+}
+
+QgsInterpolator::LayerData TestQgsInterpolator::layerData() const
+{
+  QgsInterpolator::LayerData ld;
+  ld.vectorLayer = mPointLayer;
+  ld.zCoordInterpolation = false;
+  ld.interpolationAttribute = 0;
+  ld.mInputType = QgsInterpolator::POINTS;
+  return ld;
+}
+
+double TestQgsInterpolator::bruteForceIdw( double x, double y, double radius, int count, bool& ok ) const
+{
+  QList< QPair<double, double> > neighbors;
+  for ( int i = 0; i < mPoints.size(); ++i )
+  {
+    double distance = sqrt( mPoints.at( i ).sqrDist( x, y ) );
+    if ( radius <= 0 || distance <= radius )
+      neighbors << qMakePair( distance, mValues.at( i ) );
+  }
+  qSort( neighbors );
+  if ( count > 0 )
+    neighbors = neighbors.mid( 0, count );
+
+  ok = !neighbors.isEmpty();
+  double sumCounter = 0;
+  double sumDenominator = 0;
+  for ( int i = 0; i < neighbors.size(); ++i )
+  {
+    double weight = 1 / pow( neighbors.at( i ).first, 2.0 );
+    sumCounter += weight * neighbors.at( i ).second;
+    sumDenominator += weight;
+  }
+  return ok ? sumCounter / sumDenominator : 0;
+}
+
+void TestQgsInterpolator::idwAllPoints()
+{
+  QgsIDWInterpolator interpolator( QList<QgsInterpolator::LayerData>() << layerData() );
+  QVERIFY( interpolator.isThreadSafe() );
+
+  double result;
+  QCOMPARE( interpolator.interpolatePoint( 50.005, 49.995, result ), 0 );
+  bool ok;
+  QVERIFY( qgsDoubleNear( result, bruteForceIdw( 50.005, 49.995, 0, 0, ok ), 0.000001 ) );
+
+  // value of a sample point
+  QCOMPARE( interpolator.interpolatePoint( mPoints.at( 3 ).x(), mPoints.at( 3 ).y(), result ), 0 );
+  QCOMPARE( result, mValues.at( 3 ) );
+}
+
+void TestQgsInterpolator::idwNearestNeighbors()
+{
+  QgsIDWInterpolator interpolator( QList<QgsInterpolator::LayerData>() << layerData() );
+  interpolator.setMaximumNeighbors( 8 );
+  QCOMPARE( interpolator.maximumNeighbors(), 8 );
+
+  for ( int i = 0; i < 100; ++i )
+  {
+    double x = ( i % 10 ) * 10.003 + 1.5;
+    double y = ( i / 10 ) * 10.007 + 2.5;
+    double result;
+    bool ok;
+    double expected = bruteForceIdw( x, y, 0, 8, ok );
+    QCOMPARE( interpolator.interpolatePoint( x, y, result ), 0 );
+    QVERIFY( qgsDoubleNear( result, expected, 0.000001 ) );
+  }
+}
+
+void TestQgsInterpolator::idwSearchRadius()
+{
+  QgsIDWInterpolator interpolator( QList<QgsInterpolator::LayerData>() << layerData() );
+  interpolator.setSearchRadius( 5.0 );
+  QCOMPARE( interpolator.searchRadius(), 5.0 );
+
+  for ( int i = 0; i < 100; ++i )
+  {
+    double x = ( i % 10 ) * 10.003 + 1.5;
+    double y = ( i / 10 ) * 10.007 + 2.5;
+    double result = 0;
+    bool ok;
+    double expected = bruteForceIdw( x, y, 5.0, 0, ok );
+    QCOMPARE( interpolator.interpolatePoint( x, y, result ) == 0, ok );
+    if ( ok )
+      QVERIFY( qgsDoubleNear( result, expected, 0.000001 ) );
+  }
+
+  // radius and count together
+  interpolator.setMaximumNeighbors( 3 );
+  double result;
+  bool ok;
+  double expected = bruteForceIdw( 50.5, 50.5, 5.0, 3, ok );
+  QCOMPARE( interpolator.interpolatePoint( 50.5, 50.5, result ) == 0, ok );
+  if ( ok )
+    QVERIFY( qgsDoubleNear( result, expected, 0.000001 ) );
+}
+
+void TestQgsInterpolator::gridFileWriter()
+{
+  QgsIDWInterpolator interpolator( QList<QgsInterpolator::LayerData>() << layerData() );
+  interpolator.setMaximumNeighbors( 12 );
+  QgsRectangle extent( 0, 0, 100, 100 );
+
+  QString asciiFileName = QDir::tempPath() + "/interpolation.asc";
+  QgsGridFileWriter asciiWriter( &interpolator, asciiFileName, extent, 50, 40, 2.0, 2.5 );
+  QCOMPARE( asciiWriter.writeFile(), 0 );
+
+  QString tiffFileName = QDir::tempPath() + "/interpolation.tif";
+  QgsGridFileWriter tiffWriter( &interpolator, tiffFileName, extent, 50, 40, 2.0, 2.5 );
+  tiffWriter.setOutputFormat( "GTiff" );
+  QCOMPARE( tiffWriter.outputFormat(), QString( "GTiff" ) );
+  QCOMPARE( tiffWriter.writeFile(), 0 );
+
+  // rows written in parallel match the values of the interpolator, in both formats
+  QFile asciiFile( asciiFileName );
+  QVERIFY( asciiFile.open( QIODevice::ReadOnly ) );
+  QStringList lines = QString( asciiFile.readAll() ).split( '\n', QString::SkipEmptyParts );
+  QCOMPARE( lines.size(), 7 + 40 );
+
+  GDALDatasetH dataset = GDALOpen( tiffFileName.toUtf8().constData(), GA_ReadOnly );
+  QVERIFY( dataset );
+  QCOMPARE( GDALGetRasterXSize( dataset ), 50 );
+  QCOMPARE( GDALGetRasterYSize( dataset ), 40 );
+  GDALRasterBandH band = GDALGetRasterBand( dataset, 1 );
+  QVector<double> tiffRow( 50 );
+
+  for ( int row = 0; row < 40; ++row )
+  {
+    QStringList values = lines.at( 7 + row ).split( ' ', QString::SkipEmptyParts );
+    QCOMPARE( values.size(), 50 );
+    QCOMPARE( GDALRasterIO( band, GF_Read, 0, row, 50, 1, tiffRow.data(), 50, 1, GDT_Float64, 0, 0 ), CE_None );
+    for ( int column = 0; column < 50; ++column )
+    {
+      double expected;
+      QCOMPARE( interpolator.interpolatePoint( 1.0 + column * 2.0, 98.75 - row * 2.5, expected ), 0 );
+      QVERIFY( qgsDoubleNear( values.at( column ).toDouble(), expected, 0.0001 ) );
+      QVERIFY( qgsDoubleNear( tiffRow.at( column ), expected, 0.0001 ) );
+    }
+  }
+  GDALClose( dataset );
+}
+
+QList<Point3D*> TestQgsInterpolator::randomPoints( int count ) const
+{
+  qsrand( 2 );
+  QList<Point3D*> points;
+  for ( int i = 0; i < count; ++i )
+  {
+    double x = qrand() / ( double )RAND_MAX * 1000 + i * 0.0000001;
+    double y = qrand() / ( double )RAND_MAX * 1000;
+    points << new Point3D( x, y, qrand() % 1000 / 10.0 );
+  }
+  return points;
+}
+
+void TestQgsInterpolator::tinBulkInsertion()
+{
+  QList<Point3D*> points = randomPoints( 5000 );
+
+  DualEdgeTriangulation incremental( 5000, nullptr );
+  Q_FOREACH ( Point3D* p, points )
+  {
+    incremental.addPoint( new Point3D( *p ) );
+  }
+  DualEdgeTriangulation bulk( 5000, nullptr );
+  bulk.addPoints( points );
+  QCOMPARE( bulk.getNumberOfPoints(), incremental.getNumberOfPoints() );
+
+  // the Delaunay triangulation does not depend on the order of insertion
+  LinTriangleInterpolator incrementalInterpolator( &incremental );
+  LinTriangleInterpolator bulkInterpolator( &bulk );
+  for ( int i = 0; i < 400; ++i )
+  {
+    double x = ( i % 20 ) * 47.3 + 25.1;
+    double y = ( i / 20 ) * 46.9 + 27.7;
+    Point3D expected;
+    Point3D result;
+    bool ok = incrementalInterpolator.calcPoint( x, y, &expected );
+    QCOMPARE( bulkInterpolator.calcPoint( x, y, &result ), ok );
+    if ( ok )
+      QVERIFY( qgsDoubleNear( result.getZ(), expected.getZ(), 0.000001 ) );
+  }
+
+  // collinear points at the start of the Hilbert curve
+  QList<Point3D*> linePoints;
+  for ( int i = 0; i < 10; ++i )
+  {
+    linePoints << new Point3D( i, 0, 1 );
+  }
+  linePoints << new Point3D( 5, 5, 1 );
+  DualEdgeTriangulation lineTriangulation;
+  lineTriangulation.addPoints( linePoints );
+  QCOMPARE( lineTriangulation.getNumberOfPoints(), 11 );
+}
+
+void TestQgsInterpolator::tinInterpolator()
+{
+  QgsTINInterpolator interpolator( QList<QgsInterpolator::LayerData>() << layerData() );
+
+  // values of the sample points inside the convex hull are reproduced
+  for ( int i = 0; i < mPoints.size(); ++i )
+  {
+    const QgsPoint& point = mPoints.at( i );
+    if ( point.x() < 10 || point.x() > 90 || point.y() < 10 || point.y() > 90 )
+      continue;
+
+    double result;
+    QCOMPARE( interpolator.interpolatePoint( point.x(), point.y(), result ), 0 );
+    QVERIFY( qgsDoubleNear( result, mValues.at( i ), 0.000001 ) );
+  }
+}
+
+void TestQgsInterpolator::benchmarkTinIncremental()
+{
+  QList<Point3D*> points = randomPoints( 100000 );
+  QBENCHMARK_ONCE
+  {
+    DualEdgeTriangulation triangulation( 100000, nullptr );
+    Q_FOREACH ( Point3D* p, points )
+    {
+      triangulation.addPoint( p );
+    }
+  }
+}
+
+void TestQgsInterpolator::benchmarkTinBulk()
+{
+  QList<Point3D*> points = randomPoints( 100000 );
+  QBENCHMARK_ONCE
+  {
+    DualEdgeTriangulation triangulation( 100000, nullptr );
+    triangulation.addPoints( points );
+  }
+}
+
+QTEST_MAIN( TestQgsInterpolator )
+#include "testqgsinterpolator.moc"
@@ -16,6 +16,7 @@ Email                : sherman at mrcc dot com
 
 //header for class being tested
 #include <qgsgeometryanalyzer.h>
+#include <qgsoverlayanalyzer.h>
 #include <qgsapplication.h>
 #include <qgsproviderregistry.h>
 
@@ -44,7 +45,15 @@ class TestQgsVectorAnalyzer : public QObject
     void simplifyGeometry();
     void polygonCentroids();
     void layerExtent();
+    void dissolve();
+    void dissolveByField();
+    void bufferDissolve();
+    void convexHull();
+    void intersection();
   private:
+    //! Area of the union of the geometries of features with the given value in field (all features if field is -1), united one by one
+    double combinedArea( QgsVectorLayer* layer, int field, const QString& value );
+
     QgsGeometryAnalyzer mAnalyzer;
     QgsVectorLayer * mpLineLayer;
     QgsVectorLayer * mpPolyLayer;
@@ -140,5 +149,154 @@ void TestQgsVectorAnalyzer::layerExtent()
   QVERIFY( mAnalyzer.extent( mpPointLayer, myFileName ) );
 }
 
+void TestQgsVectorAnalyzer::dissolve()
+{
+  QString myTmpDir = QDir::tempPath() + '/';
+  QString myFileName = myTmpDir +  "dissolve_layer.shp";
+  QVERIFY( mAnalyzer.dissolve( mpPolyLayer, myFileName ) );
+
+  QgsVectorLayer dissolved( myFileName, "dissolved", "ogr" );
+  QVERIFY( dissolved.isValid() );
+  QCOMPARE( dissolved.featureCount(), 1L );
+  QgsFeature f;
+  QVERIFY( dissolved.getFeatures().nextFeature( f ) );
+  QVERIFY( f.constGeometry() );
+  QVERIFY( qgsDoubleNear( f.constGeometry()->area(), combinedArea( mpPolyLayer, -1, QString() ), 0.0001 ) );
+}
+
+void TestQgsVectorAnalyzer::dissolveByField()
+{
+  QString myTmpDir = QDir::tempPath() + '/';
+  QString myFileName = myTmpDir +  "dissolve_field_layer.shp";
+  int nameField = mpPolyLayer->fieldNameIndex( "Name" );
+  QVERIFY( mAnalyzer.dissolve( mpPolyLayer, myFileName, false, nameField ) );
+
+  QgsVectorLayer dissolved( myFileName, "dissolved", "ogr" );
+  QVERIFY( dissolved.isValid() );
+  QCOMPARE( dissolved.featureCount(), 2L );
+  QgsFeatureIterator fit = dissolved.getFeatures();
+  QgsFeature f;
+  QStringList names;
+  while ( fit.nextFeature( f ) )
+  {
+    QString name = f.attribute( nameField ).toString();
+    names << name;
+    QVERIFY( f.constGeometry() );
+    QVERIFY( qgsDoubleNear( f.constGeometry()->area(), combinedArea( mpPolyLayer, nameField, name ), 0.0001 ) );
+  }
+  names.sort();
+  QCOMPARE( names, QStringList() << "Dam" << "Lake" );
+}
+
+void TestQgsVectorAnalyzer::bufferDissolve()
+{
+  QString myTmpDir = QDir::tempPath() + '/';
+  QString myFileName = myTmpDir +  "buffer_dissolve_layer.shp";
+  QVERIFY( mAnalyzer.buffer( mpPointLayer, myFileName, 1.0, false, true ) );
+
+  QgsVectorLayer buffered( myFileName, "buffered", "ogr" );
+  QVERIFY( buffered.isValid() );
+  QCOMPARE( buffered.featureCount(), 1L );
+  QgsFeature f;
+  QVERIFY( buffered.getFeatures().nextFeature( f ) );
+  QVERIFY( f.constGeometry() );
+
+  // every point is covered by the dissolved buffers
+  QgsFeatureIterator fit = mpPointLayer->getFeatures();
+  QgsFeature point;
+  while ( fit.nextFeature( point ) )
+  {
+    QVERIFY( f.constGeometry()->contains( point.constGeometry() ) );
+  }
+}
+
+void TestQgsVectorAnalyzer::convexHull()
+{
+  QString myTmpDir = QDir::tempPath() + '/';
+  QString myFileName = myTmpDir +  "convex_hull_layer.shp";
+  int nameField = mpPolyLayer->fieldNameIndex( "Name" );
+  QVERIFY( mAnalyzer.convexHull( mpPolyLayer, myFileName, false, nameField ) );
+
+  QgsVectorLayer hulls( myFileName, "hulls", "ogr" );
+  QVERIFY( hulls.isValid() );
+  QCOMPARE( hulls.featureCount(), 2L );
+  QgsFeatureIterator fit = hulls.getFeatures();
+  QgsFeature f;
+  while ( fit.nextFeature( f ) )
+  {
+    QVERIFY( f.constGeometry() );
+    QVERIFY( f.attribute( "AREA" ).toDouble() >= combinedArea( mpPolyLayer, nameField, f.attribute( "UID" ).toString() ) - 0.0001 );
+  }
+}
+
+void TestQgsVectorAnalyzer::intersection()
+{
+  QString myTmpDir = QDir::tempPath() + '/';
+  QString myFileName = myTmpDir +  "intersection_layer.shp";
+  QgsOverlayAnalyzer overlayAnalyzer;
+  QVERIFY( overlayAnalyzer.intersection( mpPolyLayer, mpPolyLayer, myFileName ) );
+
+  // compare with intersections of all pairs of features
+  int expectedCount = 0;
+  double expectedArea = 0;
+  QgsFeature f1;
+  QgsFeatureIterator fit1 = mpPolyLayer->getFeatures();
+  while ( fit1.nextFeature( f1 ) )
+  {
+    QgsFeature f2;
+    QgsFeatureIterator fit2 = mpPolyLayer->getFeatures();
+    while ( fit2.nextFeature( f2 ) )
+    {
+      if ( !f1.constGeometry()->intersects( f2.constGeometry() ) )
+        continue;
+      QScopedPointer<QgsGeometry> intersection( f1.constGeometry()->intersection( f2.constGeometry() ) );
+      // touching polygons intersect in lines, which cannot be written to the polygon layer
+      if ( intersection->type() != QGis::Polygon )
+        continue;
+      ++expectedCount;
+      expectedArea += intersection->area();
+    }
+  }
+
+  QgsVectorLayer intersected( myFileName, "intersected", "ogr" );
+  QVERIFY( intersected.isValid() );
+  QVERIFY( intersected.featureCount() >= expectedCount );
+  double area = 0;
+  QgsFeature f;
+  QgsFeatureIterator fit = intersected.getFeatures();
+  while ( fit.nextFeature( f ) )
+  {
+    if ( f.constGeometry() )
+      area += f.constGeometry()->area();
+  }
+  QVERIFY( qgsDoubleNear( area, expectedArea, 0.0001 ) );
+}
+
+double TestQgsVectorAnalyzer::combinedArea( QgsVectorLayer* layer, int field, const QString& value )
+{
+  QgsGeometry* combined = nullptr;
+  QgsFeatureIterator fit = layer->getFeatures();
+  QgsFeature f;
+  while ( fit.nextFeature( f ) )
+  {
+    if ( !f.constGeometry() || ( field != -1 && f.attribute( field ).toString() != value ) )
+      continue;
+
+    if ( !combined )
+    {
+      combined = new QgsGeometry( *f.constGeometry() );
+    }
+    else
+    {
+      QgsGeometry* tmp = combined->combine( f.constGeometry() );
+      delete combined;
+      combined = tmp;
+    }
+  }
+  double area = combined ? combined->area() : 0;
+  delete combined;
+  return area;
+}
+
 QTEST_MAIN( TestQgsVectorAnalyzer )
 #include "testqgsvectoranalyzer.moc"
@@ -0,0 +1,90 @@
+/***************************************************************************
+     testqgsadaptivebatchsize.cpp
+     ----------------------------
+    Date                 : October 2026
+    Copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest/QtTest>
+#include <QObject>
+
+#include "qgsadaptivebatchsize.h"
+
+/** \ingroup UnitTests
+ * Unit tests for QgsAdaptiveBatchSize
+ */
+class TestQgsAdaptiveBatchSize : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initialSize();
+    void growWhenWaiting();
+    void keepWhenHidden();
+    void memoryLimit();
+    void lastBatch();
+};
+
+void TestQgsAdaptiveBatchSize::initialSize()
+{
+  QCOMPARE( QgsAdaptiveBatchSize( 2000, 500, 50000, 1000000 ).size(), 2000 );
+  QCOMPARE( QgsAdaptiveBatchSize( 100, 500, 50000, 1000000 ).size(), 500 );
+  QCOMPARE( QgsAdaptiveBatchSize( 100000, 500, 50000, 1000000 ).size(), 50000 );
+}
+
+void TestQgsAdaptiveBatchSize::growWhenWaiting()
+{
+  QgsAdaptiveBatchSize batchSize( 1000, 100, 4000, 1 << 30 );
+
+  // first batch is always waited for
+  batchSize.batchReceived( 1000, 100000, 500, 0 );
+  QCOMPARE( batchSize.size(), 1000 );
+
+  // consumer was blocked for a long time compared to the work on the batch
+  batchSize.batchReceived( 1000, 100000, 50, 100 );
+  QCOMPARE( batchSize.size(), 2000 );
+  batchSize.batchReceived( 2000, 200000, 50, 100 );
+  QCOMPARE( batchSize.size(), 4000 );
+  batchSize.batchReceived( 4000, 400000, 50, 100 );
+  QCOMPARE( batchSize.size(), 4000 );
+}
+
+void TestQgsAdaptiveBatchSize::keepWhenHidden()
+{
+  QgsAdaptiveBatchSize batchSize( 1000, 100, 4000, 1 << 30 );
+  batchSize.batchReceived( 1000, 100000, 0, 200 );
+  batchSize.batchReceived( 1000, 100000, 10, 200 );
+  QCOMPARE( batchSize.size(), 1000 );
+}
+
+void TestQgsAdaptiveBatchSize::memoryLimit()
+{
+  QgsAdaptiveBatchSize batchSize( 1000, 10, 4000, 100000 );
+  batchSize.batchReceived( 1000, 1000000, 0, 0 );
+  QCOMPARE( batchSize.averageRowBytes(), 1000.0 );
+  QCOMPARE( batchSize.size(), 100 );
+
+  // never below the minimum
+  batchSize.batchReceived( 100, 100000000, 0, 0 );
+  QCOMPARE( batchSize.size(), 10 );
+}
+
+void TestQgsAdaptiveBatchSize::lastBatch()
+{
+  QgsAdaptiveBatchSize batchSize( 1000, 100, 4000, 1 << 30 );
+
+  // incomplete (last) batch or no rows do not make the batches grow
+  batchSize.batchReceived( 10, 1000, 50, 100 );
+  QCOMPARE( batchSize.size(), 1000 );
+  batchSize.batchReceived( 0, 0, 50, 100 );
+  QCOMPARE( batchSize.size(), 1000 );
+}
+
+QTEST_MAIN( TestQgsAdaptiveBatchSize )
+#include "testqgsadaptivebatchsize.moc"
@@ -21,6 +21,7 @@
 #include "qgsapplication.h"
 #include "qgsproject.h"
 #include "qgscolorscheme.h"
+#include "qgsgeometry.h"
 #include <QObject>
 #include <QtTest/QtTest>
 
@@ -49,6 +50,8 @@ class TestQgsExpressionContext : public QObject
     void featureBasedContext();
 
     void cache();
+    void featureCache();
+    void pureFunctions();
 
   private:
 
@@ -112,6 +115,25 @@ class TestQgsExpressionContext : public QObject
 
         int* mVal;
     };
+
+    class CountingFunction : public QgsExpression::Function
+    {
+      public:
+        explicit CountingFunction( int* v )
+            : QgsExpression::Function( "test_counting_function", 1, "test" )
+            , mVal( v )
+        {}
+
+        virtual QVariant func( const QVariantList& values, const QgsExpressionContext*, QgsExpression* ) override
+        {
+          ++( *mVal );
+          return values.at( 0 );
+        }
+
+      private:
+
+        int* mVal;
+    };
 };
 
 void TestQgsExpressionContext::initTestCase()
@@ -675,5 +697,108 @@ void TestQgsExpressionContext::cache()
   QVERIFY( !c.cachedValue( "test" ).isValid() );
 }
 
+void TestQgsExpressionContext::featureCache()
+{
+  QgsExpressionContext context;
+  const QgsExpressionContext& c = context;
+
+  QgsFeature f1( 1 );
+  f1.setAttributes( QgsAttributes() << 5 );
+  QVERIFY( !c.hasCachedFeatureValue( f1, "test" ) );
+  QVERIFY( !c.cachedFeatureValue( f1, "test" ).isValid() );
+
+  c.setCachedFeatureValue( f1, "test", "my value" );
+  QVERIFY( c.hasCachedFeatureValue( f1, "test" ) );
+  QCOMPARE( c.cachedFeatureValue( f1, "test" ), QVariant( "my value" ) );
+  QVERIFY( !c.hasCachedFeatureValue( f1, "other" ) );
+
+  // copies of the feature share the cached values
+  QgsFeature copy( f1 );
+  QVERIFY( c.hasCachedFeatureValue( copy, "test" ) );
+
+  // features with the same id but other attributes or geometry do not
+  QgsFeature modifiedAttributes( f1 );
+  modifiedAttributes.setAttribute( 0, 6 );
+  QVERIFY( !c.hasCachedFeatureValue( modifiedAttributes, "test" ) );
+  QVERIFY( !c.cachedFeatureValue( modifiedAttributes, "test" ).isValid() );
+  QgsFeature modifiedGeometry( f1 );
+  modifiedGeometry.setGeometry( QgsGeometry::fromPoint( QgsPoint( 1, 2 ) ) );
+  QVERIFY( !c.hasCachedFeatureValue( modifiedGeometry, "test" ) );
+
+  // only the values of the most recent feature are kept
+  QgsFeature f2( 2 );
+  c.setCachedFeatureValue( f2, "test", "other value" );
+  QVERIFY( c.hasCachedFeatureValue( f2, "test" ) );
+  QCOMPARE( c.cachedFeatureValue( f2, "test" ), QVariant( "other value" ) );
+  QVERIFY( !c.hasCachedFeatureValue( f1, "test" ) );
+
+  // copy should copy cache
+  QgsExpressionContext context2( c );
+  QVERIFY( context2.hasCachedFeatureValue( f2, "test" ) );
+
+  // clear cache
+  c.clearCachedValues();
+  QVERIFY( !c.hasCachedFeatureValue( f2, "test" ) );
+}
+
+void TestQgsExpressionContext::pureFunctions()
+{
+  QVERIFY( QgsExpression::Functions().at( QgsExpression::functionIndex( "sqrt" ) )->isPure() );
+  QVERIFY( QgsExpression::Functions().at( QgsExpression::functionIndex( "upper" ) )->isPure() );
+  QVERIFY( !QgsExpression::Functions().at( QgsExpression::functionIndex( "rand" ) )->isPure() );
+  QVERIFY( !QgsExpression::Functions().at( QgsExpression::functionIndex( "now" ) )->isPure() );
+  QVERIFY( !QgsExpression::Functions().at( QgsExpression::functionIndex( "$area" ) )->isPure() );
+  QVERIFY( !QgsExpression::Functions().at( QgsExpression::functionIndex( "var" ) )->isPure() );
+  QVERIFY( !QgsExpression::Functions().at( QgsExpression::functionIndex( "ramp_color" ) )->isPure() );
+  QVERIFY( !QgsExpression::Functions().at( QgsExpression::functionIndex( "order_parts" ) )->isPure() );
+
+  int calls = 0;
+  CountingFunction function( &calls );
+  function.setPure( true );
+  QVERIFY( QgsExpression::registerFunction( &function ) );
+
+  QgsFields fields;
+  fields.append( QgsField( "x", QVariant::Int ) );
+  QgsFeature f( fields, 1 );
+  f.setAttributes( QgsAttributes() << 5 );
+  QgsExpressionContext context = QgsExpressionContextUtils::createFeatureBasedContext( f, fields );
+
+  // calls with constant arguments are only evaluated once, when the expression is prepared
+  QgsExpression staticExp( "test_counting_function( 1 + 2 ) * 2" );
+  QVERIFY( staticExp.prepare( &context ) );
+  QCOMPARE( calls, 1 );
+  QCOMPARE( staticExp.evaluate( &context ).toInt(), 6 );
+  QCOMPARE( staticExp.evaluate( &context ).toInt(), 6 );
+  QCOMPARE( calls, 1 );
+
+  // copies share the prepared tree
+  QgsExpression staticExpCopy( staticExp );
+  QCOMPARE( staticExpCopy.evaluate( &context ).toInt(), 6 );
+  QCOMPARE( calls, 1 );
+
+  // without preparing the expression the calls are evaluated every time
+  QgsExpression unpreparedExp( "test_counting_function( 2 )" );
+  QCOMPARE( unpreparedExp.evaluate( &context ).toInt(), 2 );
+  QCOMPARE( unpreparedExp.evaluate( &context ).toInt(), 2 );
+  QCOMPARE( calls, 3 );
+
+  // calls with arguments depending on the feature are evaluated every time
+  QgsExpression featureExp( "test_counting_function( \"x\" )" );
+  QVERIFY( featureExp.prepare( &context ) );
+  QCOMPARE( featureExp.evaluate( &context ).toInt(), 5 );
+  QCOMPARE( featureExp.evaluate( &context ).toInt(), 5 );
+  QCOMPARE( calls, 5 );
+
+  // calls of functions which are not pure are evaluated every time
+  function.setPure( false );
+  QgsExpression impureExp( "test_counting_function( 1 )" );
+  QVERIFY( impureExp.prepare( &context ) );
+  QCOMPARE( impureExp.evaluate( &context ).toInt(), 1 );
+  QCOMPARE( impureExp.evaluate( &context ).toInt(), 1 );
+  QCOMPARE( calls, 7 );
+
+  QVERIFY( QgsExpression::unregisterFunction( "test_counting_function" ) );
+}
+
 QTEST_MAIN( TestQgsExpressionContext )
 #include "testqgsexpressioncontext.moc"
@@ -0,0 +1,197 @@
+/***************************************************************************
+     testqgsfeaturesorter.cpp
+     ------------------------
+    Date                 : October 2026
+    Copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest/QtTest>
+#include <QObject>
+
+#include "qgsapplication.h"
+#include "qgsfeaturesorter.h"
+#include "qgsgeometry.h"
+
+/** \ingroup UnitTests
+ * Unit tests for QgsFeatureSorter
+ */
+class TestQgsFeatureSorter : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void sortInMemory();
+    void sortSpilledRuns();
+    void sortWithLimit();
+    void sortSpilledRunsWithLimit();
+    void sortDescendingNulls();
+    void roundtripFeatures();
+
+  private:
+    QgsFields mFields;
+
+    QgsIndexedFeature indexedFeature( QgsFeatureId id, const QVariant& value ) const;
+    QList<QgsFeatureId> sortedIds( QgsFeatureSorter& sorter ) const;
+};
+
+void TestQgsFeatureSorter::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  mFields.append( QgsField( "value", QVariant::Int ) );
+  mFields.append( QgsField( "name", QVariant::String ) );
+}
+
+void TestQgsFeatureSorter::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QgsIndexedFeature TestQgsFeatureSorter::indexedFeature( QgsFeatureId id, const QVariant& value ) const
+{
+  QgsIndexedFeature indexedFeature;
+  indexedFeature.mFeature = QgsFeature( mFields, id );
+  indexedFeature.mFeature.setAttributes( QgsAttributes() << value << QString( "feature %1" ).arg( id ) );
+  indexedFeature.mFeature.setValid( true );
+  indexedFeature.mIndexes << value;
+  return indexedFeature;
+}
+
+QList<QgsFeatureId> TestQgsFeatureSorter::sortedIds( QgsFeatureSorter& sorter ) const
+{
+  QList<QgsFeatureId> ids;
+  QgsFeature feature;
+  while ( sorter.nextFeature( feature ) )
+    ids << feature.id();
+  return ids;
+}
+
+void TestQgsFeatureSorter::sortInMemory()
+{
+  QgsFeatureSorter sorter( QList<QgsFeatureRequest::OrderByClause>() << QgsFeatureRequest::OrderByClause( "value" ) );
+  sorter.addFeature( indexedFeature( 1, 30 ) );
+  sorter.addFeature( indexedFeature( 2, 10 ) );
+  sorter.addFeature( indexedFeature( 3, 20 ) );
+  sorter.addFeature( indexedFeature( 4, 10 ) );
+  sorter.finish();
+
+  QCOMPARE( sorter.spilledRunCount(), 0 );
+  // equal features keep their order
+  QCOMPARE( sortedIds( sorter ), QList<QgsFeatureId>() << 2 << 4 << 3 << 1 );
+}
+
+void TestQgsFeatureSorter::sortSpilledRuns()
+{
+  QgsFeatureSorter sorter( QList<QgsFeatureRequest::OrderByClause>() << QgsFeatureRequest::OrderByClause( "value" ), -1, 100 );
+
+  // values 0..99 repeated, each feature id encodes its value and position
+  QList<QgsFeatureId> expected;
+  for ( int i = 0; i < 1000; ++i )
+  {
+    int value = ( i * 37 ) % 100;
+    sorter.addFeature( indexedFeature( value * 1000 + i, value ) );
+    expected << value * 1000 + i;
+  }
+  sorter.finish();
+  qSort( expected );
+
+  QCOMPARE( sorter.spilledRunCount(), 10 );
+  QCOMPARE( sortedIds( sorter ), expected );
+}
+
+void TestQgsFeatureSorter::sortWithLimit()
+{
+  QgsFeatureSorter sorter( QList<QgsFeatureRequest::OrderByClause>() << QgsFeatureRequest::OrderByClause( "value" ), 3, 100 );
+  for ( int i = 0; i < 1000; ++i )
+  {
+    sorter.addFeature( indexedFeature( i, 1000 - i ) );
+  }
+  sorter.finish();
+
+  QCOMPARE( sorter.spilledRunCount(), 0 );
+  QCOMPARE( sortedIds( sorter ), QList<QgsFeatureId>() << 999 << 998 << 997 );
+}
+
+void TestQgsFeatureSorter::sortSpilledRunsWithLimit()
+{
+  QgsFeatureSorter sorter( QList<QgsFeatureRequest::OrderByClause>() << QgsFeatureRequest::OrderByClause( "value" ), 150, 100 );
+  QList<QgsFeatureId> expected;
+  for ( int i = 0; i < 1000; ++i )
+  {
+    sorter.addFeature( indexedFeature( i, 1000 - i ) );
+    if ( i >= 850 )
+      expected.prepend( i );
+  }
+  sorter.finish();
+
+  QVERIFY( sorter.spilledRunCount() > 0 );
+  // the sorter returns at most the first 150 features of every run, the iterator applies the limit
+  QCOMPARE( sortedIds( sorter ).mid( 0, 150 ), expected );
+}
+
+void TestQgsFeatureSorter::sortDescendingNulls()
+{
+  QgsFeatureSorter sorter( QList<QgsFeatureRequest::OrderByClause>() << QgsFeatureRequest::OrderByClause( "value", false, true ), -1, 2 );
+  sorter.addFeature( indexedFeature( 1, 10 ) );
+  sorter.addFeature( indexedFeature( 2, QVariant( QVariant::Int ) ) );
+  sorter.addFeature( indexedFeature( 3, 30 ) );
+  sorter.addFeature( indexedFeature( 4, 20 ) );
+  sorter.addFeature( indexedFeature( 5, QVariant( QVariant::Int ) ) );
+  sorter.finish();
+
+  QCOMPARE( sortedIds( sorter ), QList<QgsFeatureId>() << 2 << 5 << 3 << 4 << 1 );
+}
+
+void TestQgsFeatureSorter::roundtripFeatures()
+{
+  QgsFeatureSorter sorter( QList<QgsFeatureRequest::OrderByClause>() << QgsFeatureRequest::OrderByClause( "value" ), -1, 1 );
+
+  QgsIndexedFeature withGeometry = indexedFeature( 1, 2 );
+  withGeometry.mFeature.setGeometry( QgsGeometry::fromWkt( "LineString(1 2, 3 4)" ) );
+  sorter.addFeature( withGeometry );
+
+  QgsIndexedFeature emptyGeometry = indexedFeature( 2, 1 );
+  emptyGeometry.mFeature.setGeometry( new QgsGeometry() );
+  sorter.addFeature( emptyGeometry );
+
+  QgsIndexedFeature invalid = indexedFeature( 3, 3 );
+  invalid.mFeature.setValid( false );
+  sorter.addFeature( invalid );
+
+  sorter.finish();
+  QCOMPARE( sorter.spilledRunCount(), 3 );
+
+  QgsFeature feature;
+  QVERIFY( sorter.nextFeature( feature ) );
+  QCOMPARE( feature.id(), 2LL );
+  QVERIFY( feature.constGeometry() );
+  QVERIFY( feature.constGeometry()->isEmpty() );
+
+  QVERIFY( sorter.nextFeature( feature ) );
+  QCOMPARE( feature.id(), 1LL );
+  QVERIFY( feature.isValid() );
+  QCOMPARE( feature.attribute( "value" ).toInt(), 2 );
+  QCOMPARE( feature.attribute( "name" ).toString(), QString( "feature 1" ) );
+  QVERIFY( feature.fields() );
+  QCOMPARE( feature.fields()->count(), 2 );
+  QCOMPARE( feature.constGeometry()->exportToWkt(), QString( "LineString (1 2, 3 4)" ) );
+
+  QVERIFY( sorter.nextFeature( feature ) );
+  QCOMPARE( feature.id(), 3LL );
+  QVERIFY( !feature.constGeometry() );
+  QVERIFY( !feature.isValid() );
+
+  QVERIFY( !sorter.nextFeature( feature ) );
+}
+
+QTEST_MAIN( TestQgsFeatureSorter )
+#include "testqgsfeaturesorter.moc"
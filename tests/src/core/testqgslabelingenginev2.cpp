@@ -17,6 +17,7 @@
 
 #include <qgsapplication.h>
 #include <qgslabelingenginev2.h>
+#include <qgslabelplacementcache.h>
 #include <qgsmaplayerregistry.h>
 #include <qgsmaprenderersequentialjob.h>
 #include <qgsrulebasedlabeling.h>
@@ -43,6 +44,7 @@ class TestQgsLabelingEngineV2 : public QObject
     void testRuleBased();
     void zOrder(); //test that labels are stacked correctly
     void testEncodeDecodePositionOrder();
+    void testPlacementCache();
 
   private:
     QgsVectorLayer* vl;
@@ -413,6 +415,61 @@ void TestQgsLabelingEngineV2::testEncodeDecodePositionOrder()
   QCOMPARE( decoded, expected );
 }
 
+void TestQgsLabelingEngineV2::testPlacementCache()
+{
+  QSize size( 640, 480 );
+  QgsMapSettings mapSettings;
+  mapSettings.setOutputSize( size );
+  mapSettings.setExtent( vl->extent() );
+  mapSettings.setLayers( QStringList() << vl->id() );
+  mapSettings.setOutputDpi( 96 );
+
+  vl->setCustomProperty( "labeling", "pal" );
+  vl->setCustomProperty( "labeling/enabled", true );
+  vl->setCustomProperty( "labeling/fieldName", "Class" );
+  setDefaultLabelParams( vl );
+
+  QgsLabelPlacementCache cache;
+
+  // first rendering fills the cache
+  QImage img1( size, QImage::Format_ARGB32_Premultiplied );
+  img1.fill( Qt::white );
+  QPainter p1( &img1 );
+  QgsRenderContext context1 = QgsRenderContext::fromMapSettings( mapSettings );
+  context1.setPainter( &p1 );
+
+  QgsLabelingEngineV2 engine1;
+  engine1.setMapSettings( mapSettings );
+  engine1.setPlacementCache( &cache );
+  engine1.addProvider( new QgsVectorLayerLabelProvider( vl, QString() ) );
+  engine1.run( context1 );
+  p1.end();
+
+  int cachedCount = cache.count();
+  QVERIFY( cachedCount > 0 );
+
+  // second rendering of the same view is warm started and must give the same result
+  QImage img2( size, QImage::Format_ARGB32_Premultiplied );
+  img2.fill( Qt::white );
+  QPainter p2( &img2 );
+  QgsRenderContext context2 = QgsRenderContext::fromMapSettings( mapSettings );
+  context2.setPainter( &p2 );
+
+  QgsLabelingEngineV2 engine2;
+  engine2.setMapSettings( mapSettings );
+  engine2.setPlacementCache( &cache );
+  engine2.addProvider( new QgsVectorLayerLabelProvider( vl, QString() ) );
+  engine2.run( context2 );
+  p2.end();
+
+  QCOMPARE( cache.count(), cachedCount );
+  QVERIFY( img1 == img2 );
+
+  // change of scale invalidates the cache
+  QVERIFY( !cache.init( mapSettings.scale() * 2, mapSettings.rotation(), mapSettings.mapUnitsPerPixel() ) );
+  QCOMPARE( cache.count(), 0 );
+}
+
 bool TestQgsLabelingEngineV2::imageCheck( const QString& testName, QImage &image, int mismatchCount )
 {
   //draw background
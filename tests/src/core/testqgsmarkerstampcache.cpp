@@ -0,0 +1,149 @@
+/***************************************************************************
+     testqgsmarkerstampcache.cpp
+     ---------------------------
+    Date                 : October 2026
+    Copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest/QtTest>
+#include <QObject>
+#include <QImage>
+#include <QPainter>
+#include <QPainterPath>
+
+#include "qgsmarkerstampcache.h"
+#include "qgsrendercontext.h"
+
+/** \ingroup UnitTests
+ * Unit tests for QgsMarkerStampCache
+ */
+class TestQgsMarkerStampCache : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void supportsContext();
+    void keys();
+    void drawStamps();
+    void disableForDistinctMarkers();
+};
+
+void TestQgsMarkerStampCache::supportsContext()
+{
+  QImage image( 20, 20, QImage::Format_ARGB32_Premultiplied );
+  QPainter p( &image );
+  QgsRenderContext context;
+  QVERIFY( !QgsMarkerStampCache::supportsContext( context ) );
+
+  context.setPainter( &p );
+  QVERIFY( QgsMarkerStampCache::supportsContext( context ) );
+
+  context.setForceVectorOutput( true );
+  QVERIFY( !QgsMarkerStampCache::supportsContext( context ) );
+  p.end();
+}
+
+void TestQgsMarkerStampCache::keys()
+{
+  QImage image( 20, 20, QImage::Format_ARGB32_Premultiplied );
+  QPainter p( &image );
+  QgsMarkerStampCache cache;
+  QPen pen( Qt::black );
+  QBrush brush( Qt::red );
+
+  QgsMarkerStampCache::Key key1;
+  QgsMarkerStampCache::Key key2;
+  QVERIFY( cache.markerKey( &p, QPointF( 5, 5 ), "circle", 4, 4, 9.8, pen, brush, key1 ) );
+  QVERIFY( cache.markerKey( &p, QPointF( 8, 3 ), "circle", 4.01, 4, 10.2, pen, brush, key2 ) );
+  QVERIFY( key1 == key2 );
+  QCOMPARE( qHash( key1 ), qHash( key2 ) );
+
+  // rotation is normalized
+  QVERIFY( cache.markerKey( &p, QPointF( 5, 5 ), "circle", 4, 4, -350, pen, brush, key2 ) );
+  QVERIFY( key1 == key2 );
+
+  // sub-pixel position
+  QVERIFY( cache.markerKey( &p, QPointF( 5.5, 5 ), "circle", 4, 4, 10, pen, brush, key2 ) );
+  QVERIFY( !( key1 == key2 ) );
+  QCOMPARE( key2.phaseX, 2 );
+  QCOMPARE( key2.phaseY, 0 );
+  QVERIFY( cache.markerKey( &p, QPointF( 5.9, 4.95 ), "circle", 4, 4, 10, pen, brush, key2 ) );
+  QVERIFY( key1 == key2 );
+
+  QVERIFY( cache.markerKey( &p, QPointF( 5, 5 ), "circle", 4, 4, 10, pen, QBrush( Qt::blue ), key2 ) );
+  QVERIFY( !( key1 == key2 ) );
+  QVERIFY( cache.markerKey( &p, QPointF( 5, 5 ), "square", 4, 4, 10, pen, brush, key2 ) );
+  QVERIFY( !( key1 == key2 ) );
+
+  // markers which cannot be stamped
+  QVERIFY( !cache.markerKey( &p, QPointF( 5, 5 ), "circle", 1000, 4, 10, pen, brush, key2 ) );
+  QVERIFY( !cache.markerKey( &p, QPointF( 5, 5 ), "circle", 4, 4, 10, pen, QBrush( Qt::red, Qt::CrossPattern ), key2 ) );
+  p.rotate( 45 );
+  QVERIFY( !cache.markerKey( &p, QPointF( 5, 5 ), "circle", 4, 4, 10, pen, brush, key2 ) );
+  p.end();
+}
+
+void TestQgsMarkerStampCache::drawStamps()
+{
+  QImage image( 100, 100, QImage::Format_ARGB32_Premultiplied );
+  image.fill( QColor( Qt::white ).rgba() );
+  QPainter p( &image );
+  p.translate( 10, 10 );
+
+  QgsMarkerStampCache cache;
+  QPainterPath path;
+  path.addRect( -5, -5, 10, 10 );
+  QPen pen( Qt::NoPen );
+  QBrush brush( Qt::red );
+
+  for ( int i = 0; i < 4; ++i )
+  {
+    QPointF point( 10 + i * 20, 10 );
+    QgsMarkerStampCache::Key key;
+    QVERIFY( cache.markerKey( &p, point, "square", 10, 10, 0, pen, brush, key ) );
+    if ( !cache.drawStamp( &p, point, key ) )
+    {
+      QVERIFY( cache.drawNewStamp( &p, point, key, path, pen, brush ) );
+    }
+  }
+  p.end();
+
+  QCOMPARE( cache.misses(), 1 );
+  QCOMPARE( cache.hits(), 3 );
+  for ( int i = 0; i < 4; ++i )
+  {
+    QCOMPARE( image.pixel( 20 + i * 20, 20 ), QColor( Qt::red ).rgba() );
+    QCOMPARE( image.pixel( 20 + i * 20 + 8, 20 ), QColor( Qt::white ).rgba() );
+  }
+}
+
+void TestQgsMarkerStampCache::disableForDistinctMarkers()
+{
+  QImage image( 20, 20, QImage::Format_ARGB32_Premultiplied );
+  QPainter p( &image );
+
+  QgsMarkerStampCache cache;
+  QPainterPath path;
+  path.addEllipse( -2, -2, 4, 4 );
+  for ( int i = 0; i < 1000 && cache.isEnabled(); ++i )
+  {
+    QBrush brush( QColor( i % 256, i / 256, 0 ) );
+    QgsMarkerStampCache::Key key;
+    QVERIFY( cache.markerKey( &p, QPointF( 10, 10 ), "circle", 4, 4, 0, QPen(), brush, key ) );
+    QVERIFY( !cache.drawStamp( &p, QPointF( 10, 10 ), key ) );
+    QVERIFY( cache.drawNewStamp( &p, QPointF( 10, 10 ), key, path, QPen(), brush ) );
+  }
+  p.end();
+
+  QVERIFY( !cache.isEnabled() );
+  QVERIFY( cache.misses() < 1000 );
+}
+
+QTEST_MAIN( TestQgsMarkerStampCache )
+#include "testqgsmarkerstampcache.moc"
@@ -0,0 +1,114 @@
+/***************************************************************************
+     testqgsrasterblock.cpp
+     ----------------------
+    Date                 : October 2026
+    Copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest/QtTest>
+#include <QObject>
+#include <QVector>
+
+#include "qgsrasterblock.h"
+#include "qgsrastervaluecache.h"
+
+/** \ingroup UnitTests
+ * Unit tests for QgsRasterBlock
+ */
+class TestQgsRasterBlock : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void readRow();
+    void readRowNoDataValue();
+    void readRowNoDataBitmap();
+    void valueCache();
+};
+
+void TestQgsRasterBlock::readRow()
+{
+  QgsRasterBlock block( QGis::Int16, 3, 2 );
+  for ( int i = 0; i < 6; ++i )
+    block.setValue( static_cast< qgssize >( i ), -100 * i );
+
+  QVector<double> values( 3 );
+  QVector<bool> noData( 3, true );
+  block.readRow( 1, values.data(), noData.data() );
+  QCOMPARE( values.at( 0 ), -300.0 );
+  QCOMPARE( values.at( 1 ), -400.0 );
+  QCOMPARE( values.at( 2 ), -500.0 );
+  QVERIFY( !noData.at( 0 ) && !noData.at( 1 ) && !noData.at( 2 ) );
+
+  // no data flags are optional
+  block.readRow( 0, values.data() );
+  QCOMPARE( values.at( 2 ), -200.0 );
+}
+
+void TestQgsRasterBlock::readRowNoDataValue()
+{
+  QgsRasterBlock block( QGis::Float32, 4, 1, -9999 );
+  block.setValue( 0, 0, 1.5 );
+  block.setValue( 0, 1, -9999 );
+  block.setValue( 0, 2, std::numeric_limits<double>::quiet_NaN() );
+  block.setValue( 0, 3, 2.5 );
+
+  QVector<double> values( 4 );
+  QVector<bool> noData( 4 );
+  block.readRow( 0, values.data(), noData.data() );
+  QCOMPARE( values.at( 0 ), 1.5 );
+  QCOMPARE( values.at( 3 ), 2.5 );
+  QVERIFY( !noData.at( 0 ) );
+  QVERIFY( noData.at( 1 ) );
+  QVERIFY( noData.at( 2 ) );
+  QVERIFY( !noData.at( 3 ) );
+}
+
+void TestQgsRasterBlock::readRowNoDataBitmap()
+{
+  // wider than a byte of the bitmap
+  QgsRasterBlock block( QGis::Byte, 10, 2 );
+  for ( int col = 0; col < 10; ++col )
+    block.setValue( 1, col, col );
+  block.setIsNoData( 1, 3 );
+  block.setIsNoData( 1, 9 );
+
+  QVector<double> values( 10 );
+  QVector<bool> noData( 10 );
+  block.readRow( 1, values.data(), noData.data() );
+  for ( int col = 0; col < 10; ++col )
+  {
+    QCOMPARE( values.at( col ), static_cast< double >( col ) );
+    QCOMPARE( noData.at( col ), block.isNoData( 1, col ) );
+  }
+  QVERIFY( noData.at( 3 ) );
+  QVERIFY( noData.at( 9 ) );
+
+  block.readRow( 0, values.data(), noData.data() );
+  QVERIFY( !noData.contains( true ) );
+}
+
+void TestQgsRasterBlock::valueCache()
+{
+  QVERIFY( QgsRasterValueCache<int>::supportsDataType( QGis::UInt16 ) );
+  QVERIFY( !QgsRasterValueCache<int>::supportsDataType( QGis::Float32 ) );
+  QVERIFY( QgsRasterValueCache<int>::useForBlock( QGis::Byte, 256 ) );
+  QVERIFY( !QgsRasterValueCache<int>::useForBlock( QGis::UInt16, 256 ) );
+
+  QgsRasterValueCache<int> cache( QGis::Int16 );
+  QVERIFY( !cache.find( -32768 ) );
+  QCOMPARE( cache.insert( -32768, 1 ), 1 );
+  QCOMPARE( cache.insert( 32767, 2 ), 2 );
+  QCOMPARE( *cache.find( -32768 ), 1 );
+  QCOMPARE( *cache.find( 32767 ), 2 );
+  QVERIFY( !cache.find( 0 ) );
+}
+
+QTEST_MAIN( TestQgsRasterBlock )
+#include "testqgsrasterblock.moc"
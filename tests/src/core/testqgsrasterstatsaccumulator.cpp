@@ -0,0 +1,143 @@
+/***************************************************************************
+     testqgsrasterstatsaccumulator.cpp
+     ---------------------------------
+    Date                 : October 2026
+    Copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest/QtTest>
+#include <QObject>
+
+#include "qgsrasterbandstats.h"
+#include "qgsrasterblock.h"
+#include "qgsrasterstatsaccumulator.h"
+
+/** \ingroup UnitTests
+ * Unit tests for QgsRasterStatsAccumulator and QgsRasterHistogramAccumulator
+ */
+class TestQgsRasterStatsAccumulator : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void statistics();
+    void mergeStatistics();
+    void block();
+    void histogram();
+    void mergeHistograms();
+};
+
+void TestQgsRasterStatsAccumulator::statistics()
+{
+  QgsRasterStatsAccumulator accumulator;
+  QCOMPARE( accumulator.count(), static_cast< qgssize >( 0 ) );
+
+  accumulator.addValue( 2 );
+  accumulator.addValue( 4 );
+  accumulator.addValue( 4 );
+  accumulator.addValue( 6 );
+
+  QgsRasterBandStats stats;
+  accumulator.fillStatistics( stats );
+  QCOMPARE( stats.elementCount, static_cast< qgssize >( 4 ) );
+  QCOMPARE( stats.minimumValue, 2.0 );
+  QCOMPARE( stats.maximumValue, 6.0 );
+  QCOMPARE( stats.range, 4.0 );
+  QCOMPARE( stats.sum, 16.0 );
+  QCOMPARE( stats.mean, 4.0 );
+  QVERIFY( qgsDoubleNear( stats.sumOfSquares, 8.0, 1e-12 ) );
+  QVERIFY( qgsDoubleNear( stats.stdDev, sqrt( 8.0 / 3 ), 1e-12 ) );
+  QVERIFY( qgsDoubleNear( accumulator.meanStandardError(), sqrt( 8.0 / 3 ) / 2, 1e-12 ) );
+}
+
+void TestQgsRasterStatsAccumulator::mergeStatistics()
+{
+  QgsRasterStatsAccumulator all;
+  QgsRasterStatsAccumulator first;
+  QgsRasterStatsAccumulator second;
+  for ( int i = 0; i < 1000; ++i )
+  {
+    double value = ( i * 7919 ) % 1000 / 10.0 + 1e6;
+    all.addValue( value );
+    if ( i < 300 )
+      first.addValue( value );
+    else
+      second.addValue( value );
+  }
+
+  QgsRasterStatsAccumulator merged;
+  merged.merge( first );
+  merged.merge( QgsRasterStatsAccumulator() );
+  merged.merge( second );
+
+  QCOMPARE( merged.count(), all.count() );
+  QCOMPARE( merged.minimum(), all.minimum() );
+  QCOMPARE( merged.maximum(), all.maximum() );
+  QVERIFY( qgsDoubleNear( merged.sum(), all.sum(), 1e-6 ) );
+  QVERIFY( qgsDoubleNear( merged.mean(), all.mean(), 1e-9 ) );
+  QVERIFY( qgsDoubleNear( merged.stdDev(), all.stdDev(), 1e-9 ) );
+}
+
+void TestQgsRasterStatsAccumulator::block()
+{
+  QgsRasterBlock block( QGis::Float32, 3, 2, -1 );
+  block.setValue( 0, 0, 1 );
+  block.setValue( 0, 1, -1 );
+  block.setValue( 0, 2, 3 );
+  block.setValue( 1, 0, 5 );
+  block.setValue( 1, 1, -1 );
+  block.setValue( 1, 2, 7 );
+
+  QgsRasterStatsAccumulator accumulator;
+  accumulator.addBlock( &block );
+  QCOMPARE( accumulator.count(), static_cast< qgssize >( 4 ) );
+  QCOMPARE( accumulator.minimum(), 1.0 );
+  QCOMPARE( accumulator.maximum(), 7.0 );
+  QVERIFY( qgsDoubleNear( accumulator.mean(), 4.0, 1e-12 ) );
+
+  QgsRasterHistogramAccumulator histogram( 2, 0, 8, false );
+  histogram.addBlock( &block );
+  QCOMPARE( histogram.count(), 4 );
+  QCOMPARE( histogram.counts().at( 0 ), 2 );
+  QCOMPARE( histogram.counts().at( 1 ), 2 );
+}
+
+void TestQgsRasterStatsAccumulator::histogram()
+{
+  QgsRasterHistogramAccumulator histogram( 4, 0, 4, false );
+  histogram.addValue( 0.5 );
+  histogram.addValue( 1.0 );
+  histogram.addValue( 3.9 );
+  histogram.addValue( -1 );
+  histogram.addValue( 4.5 );
+  QCOMPARE( histogram.count(), 3 );
+  QCOMPARE( histogram.counts(), QVector<int>() << 1 << 1 << 0 << 1 );
+
+  QgsRasterHistogramAccumulator outOfRange( 4, 0, 4, true );
+  outOfRange.addValue( -1 );
+  outOfRange.addValue( 4.5 );
+  QCOMPARE( outOfRange.count(), 2 );
+  QCOMPARE( outOfRange.counts(), QVector<int>() << 1 << 0 << 0 << 1 );
+}
+
+void TestQgsRasterStatsAccumulator::mergeHistograms()
+{
+  QgsRasterHistogramAccumulator first( 2, 0, 2, false );
+  first.addValue( 0.5 );
+  first.addValue( 1.5 );
+  QgsRasterHistogramAccumulator second( 2, 0, 2, false );
+  second.addValue( 1.5 );
+
+  first.merge( second );
+  QCOMPARE( first.count(), 3 );
+  QCOMPARE( first.counts(), QVector<int>() << 1 << 2 );
+}
+
+QTEST_MAIN( TestQgsRasterStatsAccumulator )
+#include "testqgsrasterstatsaccumulator.moc"
@@ -142,7 +142,104 @@ class TestQgsRuleBasedRenderer: public QObject
       delete clone;
     }
 
+    void test_filterIndex()
+    {
+      QgsFields fields = indexTestFields();
+
+      RRule* rootRule = new RRule( nullptr );
+      for ( int i = 0; i < 50; ++i )
+        rootRule->appendChild( new RRule( QgsSymbolV2::defaultSymbol( QGis::Point ), 0, 0, QString( "cls = %1" ).arg( i ) ) );
+      // overlapping ranges
+      for ( int i = 0; i < 20; ++i )
+        rootRule->appendChild( new RRule( QgsSymbolV2::defaultSymbol( QGis::Point ), 0, 0, QString( "\"value\" >= %1 AND \"value\" < %2" ).arg( i * 10 ).arg( i * 10 + 15 ) ) );
+      rootRule->appendChild( new RRule( QgsSymbolV2::defaultSymbol( QGis::Point ), 0, 0, "100 < value" ) );
+      rootRule->appendChild( new RRule( QgsSymbolV2::defaultSymbol( QGis::Point ), 0, 0, "name IN ('a', 'b', '5')" ) );
+      rootRule->appendChild( new RRule( QgsSymbolV2::defaultSymbol( QGis::Point ), 0, 0, "name = 'abc'" ) );
+      rootRule->appendChild( new RRule( QgsSymbolV2::defaultSymbol( QGis::Point ), 0, 0, "cls % 7 = 3" ) );
+      rootRule->appendChild( new RRule( QgsSymbolV2::defaultSymbol( QGis::Point ), 0, 0, "ELSE" ) );
+      QgsRuleBasedRendererV2 r( rootRule );
+
+      QgsRenderContext ctx;
+      ctx.expressionContext().setFields( fields );
+      r.startRender( ctx, fields );
+
+      QVariantList clsValues;
+      clsValues << QVariant() << -1 << 0 << 3 << 49 << 50 << "7" << "x";
+      QVariantList valueValues;
+      valueValues << QVariant() << 0.0 << 14.5 << 15.0 << 100.0 << 250.0 << "20" << "abc";
+      QVariantList nameValues;
+      nameValues << QVariant() << "a" << "5" << 5 << "abc" << "x";
+      Q_FOREACH ( const QVariant& cls, clsValues )
+      {
+        Q_FOREACH ( const QVariant& value, valueValues )
+        {
+          Q_FOREACH ( const QVariant& name, nameValues )
+          {
+            QgsFeature f( fields );
+            f.setAttribute( 0, cls );
+            f.setAttribute( 1, value );
+            f.setAttribute( 2, name );
+            ctx.expressionContext().setFeature( f );
+
+            // rules selected through the index must be the same as those found by evaluating all filters
+            RRule::RuleList expected;
+            Q_FOREACH ( RRule* rule, rootRule->children() )
+            {
+              if ( rule->isElse() || rule->filter()->evaluate( &ctx.expressionContext() ).toInt() != 0 )
+                expected << rule;
+            }
+            QCOMPARE( rootRule->rulesForFeature( f, &ctx ), expected );
+          }
+        }
+      }
+
+      r.stopRender( ctx );
+    }
+
+    void benchmark_filterIndex()
+    {
+      QgsFields fields = indexTestFields();
+
+      RRule* rootRule = new RRule( nullptr );
+      for ( int i = 0; i < 150; ++i )
+        rootRule->appendChild( new RRule( QgsSymbolV2::defaultSymbol( QGis::Point ), 0, 0, QString( "cls = %1" ).arg( i ) ) );
+      rootRule->appendChild( new RRule( QgsSymbolV2::defaultSymbol( QGis::Point ), 0, 0, "ELSE" ) );
+      QgsRuleBasedRendererV2 r( rootRule );
+
+      QgsRenderContext ctx;
+      ctx.expressionContext().setFields( fields );
+      r.startRender( ctx, fields );
+
+      QList<QgsFeature> features;
+      for ( int i = 0; i < 1000; ++i )
+      {
+        QgsFeature f( fields );
+        f.setAttribute( 0, i % 200 );
+        features << f;
+      }
+
+      QBENCHMARK
+      {
+        Q_FOREACH ( QgsFeature f, features )
+        {
+          ctx.expressionContext().setFeature( f );
+          QVERIFY( !r.symbolsForFeature( f, ctx ).isEmpty() );
+        }
+      }
+
+      r.stopRender( ctx );
+    }
+
   private:
+    QgsFields indexTestFields()
+    {
+      QgsFields fields;
+      fields.append( QgsField( "cls", QVariant::Int ) );
+      fields.append( QgsField( "value", QVariant::Double ) );
+      fields.append( QgsField( "name", QVariant::String ) );
+      return fields;
+    }
+
     void xml2domElement( const QString& testFile, QDomDocument& doc )
     {
       QString fileName = QString( TEST_DATA_DIR ) + '/' + testFile;
@@ -0,0 +1,95 @@
+/***************************************************************************
+     testqgssvgcache.cpp
+     -------------------
+    Date                 : October 2026
+    Copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest/QtTest>
+#include <QObject>
+#include <QtConcurrentRun>
+#include <QFuture>
+
+#include "qgsapplication.h"
+#include "qgssvgcache.h"
+
+static QImage renderSvg( const QString& file, const QColor& fill )
+{
+  bool fitsInCache = true;
+  return QgsSvgCache::instance()->svgAsImage( file, 20, fill, Qt::black, 1, 1, 1, fitsInCache );
+}
+
+/** \ingroup UnitTests
+ * Unit tests for QgsSvgCache
+ */
+class TestQgsSvgCache : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void hitsAndMisses();
+    void concurrentReads();
+
+  private:
+    QString mSvgFile;
+};
+
+void TestQgsSvgCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+  mSvgFile = QString( TEST_DATA_DIR ) + "/svg_params.svg";
+}
+
+void TestQgsSvgCache::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsSvgCache::hitsAndMisses()
+{
+  QgsSvgCache* cache = QgsSvgCache::instance();
+  int hits = cache->hitCount();
+  int misses = cache->missCount();
+
+  QImage first = renderSvg( mSvgFile, QColor( 255, 0, 0 ) );
+  QVERIFY( !first.isNull() );
+  QCOMPARE( cache->missCount(), misses + 1 );
+
+  // same parameters are served from the cache
+  QImage second = renderSvg( mSvgFile, QColor( 255, 0, 0 ) );
+  QCOMPARE( cache->missCount(), misses + 1 );
+  QVERIFY( cache->hitCount() > hits );
+  QCOMPARE( second, first );
+
+  // a different fill needs a new entry
+  QImage other = renderSvg( mSvgFile, QColor( 0, 0, 255 ) );
+  QCOMPARE( cache->missCount(), misses + 2 );
+  QVERIFY( other != first );
+}
+
+void TestQgsSvgCache::concurrentReads()
+{
+  QImage expected = renderSvg( mSvgFile, QColor( 0, 255, 0 ) );
+
+  QList< QFuture<QImage> > futures;
+  for ( int i = 0; i < 8; ++i )
+  {
+    futures << QtConcurrent::run( renderSvg, mSvgFile, QColor( 0, 255, 0 ) );
+  }
+  Q_FOREACH ( QFuture<QImage> future, futures )
+  {
+    QCOMPARE( future.result(), expected );
+  }
+}
+
+QTEST_MAIN( TestQgsSvgCache )
+#include "testqgssvgcache.moc"
@@ -15,7 +15,7 @@ __copyright__ = 'Copyright 2015, The QGIS Project'
 # This will get replaced with a git SHA1 when you do a git archive
 __revision__ = '$Format:%H$'
 
-from qgis.core import QgsRectangle, QgsFeatureRequest, QgsFeature, QgsGeometry, QgsAbstractFeatureIterator, NULL
+from qgis.core import QgsRectangle, QgsFeatureRequest, QgsFeature, QgsGeometry, QgsAbstractFeatureIterator, QgsAggregateCalculator, NULL
 
 from utilities import(
     compareWkt
@@ -87,6 +87,11 @@ class ProviderTestCase(object):
         should be partially compiled """
         return set()
 
+    def providerAggregates(self):
+        """ Individual derived provider tests should override this to return a list of aggregates which
+        are calculated by the provider itself """
+        return []
+
     def assert_query(self, provider, expression, expected):
         request = QgsFeatureRequest().setFilterExpression(expression).setFlags(QgsFeatureRequest.NoGeometry)
         result = set([f['pk'] for f in provider.getFeatures(request)])
@@ -498,6 +503,42 @@ class ProviderTestCase(object):
         self.provider.setSubsetString(None)
         self.assertEqual(max_value, 300)
 
+    def testAggregate(self):
+        """ Test that aggregates calculated by the provider match the client side calculation """
+        aggregates = [QgsAggregateCalculator.Count,
+                      QgsAggregateCalculator.CountDistinct,
+                      QgsAggregateCalculator.CountMissing,
+                      QgsAggregateCalculator.Min,
+                      QgsAggregateCalculator.Max,
+                      QgsAggregateCalculator.Sum,
+                      QgsAggregateCalculator.Mean,
+                      QgsAggregateCalculator.StDev,
+                      QgsAggregateCalculator.StDevSample,
+                      QgsAggregateCalculator.Range]
+        for filter in ['', 'cnt > 100', 'cnt > 1000']:
+            params = QgsAggregateCalculator.AggregateParameters()
+            params.filter = filter
+            calculator = QgsAggregateCalculator(self.vl)
+            calculator.setParameters(params)
+            for aggregate in aggregates:
+                val, ok = self.vl.aggregate(aggregate, 'cnt', params)
+                expected, expected_ok = calculator.calculate(aggregate, 'cnt')
+                self.assertEqual(ok, expected_ok)
+                self.assertAlmostEqual(val, expected, 3, 'Aggregate {} with filter "{}": expected {}, got {}'.format(aggregate, filter, expected, val))
+
+        # the aggregates the provider supports must not fall back to the client side calculation
+        try:
+            self.enableCompiler()
+        except AttributeError:
+            pass
+        index = self.provider.fields().indexFromName('cnt')
+        for filter in ['', 'cnt > 100']:
+            params = QgsAggregateCalculator.AggregateParameters()
+            params.filter = filter
+            for aggregate in self.providerAggregates():
+                val, ok = self.provider.aggregate(aggregate, index, params, None)
+                self.assertTrue(ok, 'Aggregate {} with filter "{}" was not calculated by the provider'.format(aggregate, filter))
+
     def testExtent(self):
         reference = QgsGeometry.fromRect(
             QgsRectangle(-71.123, 66.33, -65.32, 78.3))
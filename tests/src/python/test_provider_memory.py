@@ -22,6 +22,7 @@ from qgis.core import (
     QgsFeatureRequest,
     QgsFeature,
     QgsGeometry,
+    QgsRectangle,
     NULL
 )
 
@@ -374,5 +375,121 @@ class TestPyQgsMemoryProviderIndexed(unittest.TestCase, ProviderTestCase):
         """
         pass
 
+
+class TestPyQgsMemoryProviderColumnar(unittest.TestCase, ProviderTestCase):
+
+    """Runs the provider test suite against a memory layer with column oriented storage"""
+
+    @classmethod
+    def setUpClass(cls):
+        """Run before all tests"""
+        # Create test layer
+        cls.vl = QgsVectorLayer(u'Point?crs=epsg:4326&storage=columnar&field=pk:integer&field=cnt:int8&field=name:string(0)&field=name2:string(0)&field=num_char:string&key=pk',
+                                u'test', u'memory')
+        assert (cls.vl.isValid())
+        cls.provider = cls.vl.dataProvider()
+
+        f1 = QgsFeature()
+        f1.setAttributes([5, -200, NULL, 'NuLl', '5'])
+        f1.setGeometry(QgsGeometry.fromWkt('Point (-71.123 78.23)'))
+
+        f2 = QgsFeature()
+        f2.setAttributes([3, 300, 'Pear', 'PEaR', '3'])
+
+        f3 = QgsFeature()
+        f3.setAttributes([1, 100, 'Orange', 'oranGe', '1'])
+        f3.setGeometry(QgsGeometry.fromWkt('Point (-70.332 66.33)'))
+
+        f4 = QgsFeature()
+        f4.setAttributes([2, 200, 'Apple', 'Apple', '2'])
+        f4.setGeometry(QgsGeometry.fromWkt('Point (-68.2 70.8)'))
+
+        f5 = QgsFeature()
+        f5.setAttributes([4, 400, 'Honey', 'Honey', '4'])
+        f5.setGeometry(QgsGeometry.fromWkt('Point (-65.32 78.3)'))
+
+        cls.provider.addFeatures([f1, f2, f3, f4, f5])
+
+        # poly layer
+        cls.poly_vl = QgsVectorLayer(u'Polygon?crs=epsg:4326&storage=columnar&field=pk:integer&key=pk',
+                                     u'test', u'memory')
+        assert (cls.poly_vl.isValid())
+        cls.poly_provider = cls.poly_vl.dataProvider()
+
+        f1 = QgsFeature()
+        f1.setAttributes([1])
+        f1.setGeometry(QgsGeometry.fromWkt('Polygon ((-69.0 81.4, -69.0 80.2, -73.7 80.2, -73.7 76.3, -74.9 76.3, -74.9 81.4, -69.0 81.4))'))
+
+        f2 = QgsFeature()
+        f2.setAttributes([2])
+        f2.setGeometry(QgsGeometry.fromWkt('Polygon ((-67.6 81.2, -66.3 81.2, -66.3 76.9, -67.6 76.9, -67.6 81.2))'))
+
+        f3 = QgsFeature()
+        f3.setAttributes([3])
+        f3.setGeometry(QgsGeometry.fromWkt('Polygon ((-68.4 75.8, -67.5 72.6, -68.6 73.7, -70.2 72.9, -68.4 75.8))'))
+
+        f4 = QgsFeature()
+        f4.setAttributes([4])
+
+        cls.poly_provider.addFeatures([f1, f2, f3, f4])
+
+    @classmethod
+    def tearDownClass(cls):
+        """Run after all tests"""
+
+    def testStorageUri(self):
+        """Test that the storage mode is kept in the data source uri"""
+        self.assertTrue('storage=columnar' in self.provider.dataSourceUri())
+
+    def testEditing(self):
+        """Test changing and deleting features stored in columns"""
+        vl = QgsVectorLayer(u'Point?storage=columnar&field=id:integer&field=name:string(20)&field=value:double',
+                            u'test', u'memory')
+        assert (vl.isValid())
+        provider = vl.dataProvider()
+
+        features = []
+        for i in range(3000):
+            f = QgsFeature()
+            f.setAttributes([i, 'name {}'.format(i), i / 2.0])
+            f.setGeometry(QgsGeometry.fromPoint(QgsPoint(i, -i)))
+            features.append(f)
+        self.assertTrue(provider.addFeatures(features))
+        self.assertEqual(provider.featureCount(), 3000)
+        self.assertEqual(provider.extent().toString(0), '0,-2999 : 2999,0')
+
+        # deleting most of the features compacts the storage
+        self.assertTrue(provider.deleteFeatures([f.id() for f in features[:2000]]))
+        self.assertEqual(provider.featureCount(), 1000)
+        self.assertEqual(provider.extent().toString(0), '2000,-2999 : 2999,-2000')
+
+        f = next(provider.getFeatures(QgsFeatureRequest(features[2500].id())))
+        self.assertEqual(f.attributes(), [2500, 'name 2500', 1250.0])
+        self.assertEqual(f.geometry().exportToWkt(), 'Point (2500 -2500)')
+        self.assertFalse(provider.getFeatures(QgsFeatureRequest(features[1500].id())).nextFeature(f))
+
+        # a value which does not fit the field type is kept as is
+        fid = features[2001].id()
+        self.assertTrue(provider.changeAttributeValues({fid: {0: 'not a number', 2: NULL}}))
+        self.assertTrue(provider.changeGeometryValues({fid: QgsGeometry.fromPoint(QgsPoint(5, 6))}))
+        f = next(provider.getFeatures(QgsFeatureRequest(fid)))
+        self.assertEqual(f.attributes(), ['not a number', 'name 2001', NULL])
+        self.assertEqual(f.geometry().exportToWkt(), 'Point (5 6)')
+        f = next(provider.getFeatures(QgsFeatureRequest(features[2002].id())))
+        self.assertEqual(f.attributes(), [2002, 'name 2002', 1001.0])
+
+        # values keep their type, an integer in a double field is not converted
+        fid = features[2003].id()
+        self.assertTrue(provider.changeAttributeValues({fid: {2: 7}}))
+        f = next(provider.getFeatures(QgsFeatureRequest(fid)))
+        self.assertEqual(f.attributes(), [2003, 'name 2003', 7])
+        self.assertFalse(isinstance(f.attributes()[2], float))
+        f = next(provider.getFeatures(QgsFeatureRequest(features[2004].id())))
+        self.assertTrue(isinstance(f.attributes()[2], float))
+
+        request = QgsFeatureRequest().setFilterRect(QgsRectangle(4, 5, 6, 7))
+        self.assertEqual([f.id() for f in provider.getFeatures(request)], [fid])
+
+
 if __name__ == '__main__':
     unittest.main()
@@ -21,7 +21,10 @@ from qgis.core import (
     QgsVectorLayer,
     QgsFeatureRequest,
     QgsFeature,
+    QgsGeometry,
+    QgsPoint,
     QgsTransactionGroup,
+    QgsAggregateCalculator,
     NULL
 )
 from qgis.PyQt.QtCore import QSettings, QDate, QTime, QDateTime, QVariant
@@ -65,6 +68,18 @@ class TestPyQgsPostgresProvider(unittest.TestCase, ProviderTestCase):
     def partiallyCompiledFilters(self):
         return set([])
 
+    def providerAggregates(self):
+        return [QgsAggregateCalculator.Count,
+                QgsAggregateCalculator.CountDistinct,
+                QgsAggregateCalculator.CountMissing,
+                QgsAggregateCalculator.Min,
+                QgsAggregateCalculator.Max,
+                QgsAggregateCalculator.Sum,
+                QgsAggregateCalculator.Mean,
+                QgsAggregateCalculator.StDev,
+                QgsAggregateCalculator.StDevSample,
+                QgsAggregateCalculator.Range]
+
     # HERE GO THE PROVIDER SPECIFIC TESTS
     def testDefaultValue(self):
         self.assertEqual(self.provider.defaultValue(0), u'nextval(\'qgis_test."someData_pk_seq"\'::regclass)')
@@ -196,6 +211,43 @@ class TestPyQgsPostgresProvider(unittest.TestCase, ProviderTestCase):
         self.assertNotEqual(f[0]['obj_id'], NULL, f[0].attributes())
         vl.deleteFeatures([f[0].id()])
 
+    def testBulkInsert(self):
+        """Test adding enough features at once for them to be copied"""
+        vl = QgsVectorLayer(self.dbconn + ' sslmode=disable key=\'pk\' srid=4326 type=POINT table="qgis_test"."someData" (geom) sql=', 'test', 'postgres')
+        self.assertTrue(vl.isValid())
+
+        features = []
+        for i in range(500):
+            f = QgsFeature(vl.fields())
+            f['pk'] = NULL
+            f['cnt'] = 1000 + i
+            f['name'] = NULL
+            f['name2'] = u'bulk\xe9 {}'.format(i)
+            f['num_char'] = NULL
+            f.setGeometry(QgsGeometry.fromPoint(QgsPoint(i, -i)))
+            features.append(f)
+
+        r, features = vl.dataProvider().addFeatures(features)
+        self.assertTrue(r)
+
+        ids = [f.id() for f in features]
+        self.assertEqual(len(set(ids)), 500)
+        for f in features:
+            self.assertNotEqual(f['pk'], NULL, f.attributes())
+            # default value is passed back
+            self.assertEqual(f['name'], u'qgis')
+
+        added = dict((f['cnt'], f) for f in vl.getFeatures(QgsFeatureRequest().setFilterFids(ids)))
+        self.assertEqual(len(added), 500)
+        for i in range(500):
+            f = added[1000 + i]
+            self.assertEqual(f['name'], u'qgis')
+            self.assertEqual(f['name2'], u'bulk\xe9 {}'.format(i))
+            self.assertEqual(f['num_char'], NULL)
+            self.assertEqual(f.geometry().exportToWkt(), QgsGeometry.fromPoint(QgsPoint(i, -i)).exportToWkt())
+
+        self.assertTrue(vl.dataProvider().deleteFeatures(ids))
+
     def testNestedInsert(self):
         tg = QgsTransactionGroup()
         tg.addLayer(self.vl)
@@ -19,7 +19,7 @@ import sys
 import shutil
 import tempfile
 
-from qgis.core import QgsVectorLayer, QgsPoint, QgsFeature
+from qgis.core import QgsVectorLayer, QgsPoint, QgsFeature, QgsAggregateCalculator
 
 from qgis.testing import start_app, unittest
 from utilities import unitTestDataPath
@@ -139,6 +139,18 @@ class TestQgsSpatialiteProvider(unittest.TestCase, ProviderTestCase):
                     'name LIKE \'aPple\''
                     ])
 
+    def providerAggregates(self):
+        return [QgsAggregateCalculator.Count,
+                QgsAggregateCalculator.CountDistinct,
+                QgsAggregateCalculator.CountMissing,
+                QgsAggregateCalculator.Min,
+                QgsAggregateCalculator.Max,
+                QgsAggregateCalculator.Sum,
+                QgsAggregateCalculator.Mean,
+                QgsAggregateCalculator.StDev,
+                QgsAggregateCalculator.StDevSample,
+                QgsAggregateCalculator.Range]
+
     def test_SplitFeature(self):
         """Create spatialite database"""
         layer = QgsVectorLayer("dbname=%s table=test_pg (geometry)" % self.dbname, "test_pg", "spatialite")
@@ -731,6 +731,40 @@ class TestQgsVirtualLayerProvider(unittest.TestCase, ProviderTestCase):
         ids = [f.id() for f in vl2.getFeatures()]
         self.assertEqual(ids, [])
 
+    def test_pushdown(self):
+        ml = QgsVectorLayer("Point?srid=EPSG:4326&field=a:int&field=b:string", "mem_pushdown", "memory")
+        self.assertEqual(ml.isValid(), True)
+        QgsMapLayerRegistry.instance().addMapLayer(ml)
+
+        features = []
+        for i in range(20):
+            f = QgsFeature(ml.fields())
+            f.setAttributes([i if i != 7 else None, 'Name%d' % (i % 3)])
+            f.setGeometry(QgsGeometry.fromWkt('POINT(%d %d)' % (i, i)))
+            features.append(f)
+        self.assertTrue(ml.dataProvider().addFeatures(features)[0])
+
+        def query(sql):
+            vl = QgsVectorLayer("?query=%s" % QUrl.toPercentEncoding(sql), "vl", "virtual")
+            self.assertEqual(vl.isValid(), True)
+            return [f.attributes() for f in vl.getFeatures()]
+
+        # conjunction of comparisons
+        self.assertEqual(query("SELECT a FROM mem_pushdown WHERE a > 3 AND a <= 6 AND b = 'Name1'"), [[4]])
+        # comparisons on text columns, LIKE is case insensitive
+        self.assertEqual(query("SELECT a FROM mem_pushdown WHERE b LIKE 'name2' AND a < 6"), [[2], [5]])
+        self.assertEqual(query("SELECT a FROM mem_pushdown WHERE b < 'Name1' AND a < 6"), [[0], [3]])
+        # NULL never matches
+        self.assertEqual(query("SELECT a FROM mem_pushdown WHERE a = NULL"), [])
+        # order and limit
+        self.assertEqual(query("SELECT a FROM mem_pushdown ORDER BY a DESC LIMIT 3"), [[19], [18], [17]])
+        self.assertEqual(query("SELECT a FROM mem_pushdown ORDER BY a LIMIT 2 OFFSET 1"), [[0], [1]])
+        self.assertEqual(query("SELECT a FROM mem_pushdown WHERE a >= 10 ORDER BY a LIMIT 2"), [[10], [11]])
+        # only some of the columns
+        self.assertEqual(query("SELECT b FROM mem_pushdown WHERE a = 4"), [['Name1']])
+
+        QgsMapLayerRegistry.instance().removeMapLayer(ml.id())
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -813,6 +813,40 @@ class TestQgsDelimitedTextProviderOther(unittest.TestCase):
         requests = None
         self.runTest(filename, requests, **params)
 
+    def test_041_random_access_by_fid(self):
+        # Features requested in random order from a file spanning several
+        # indexed line blocks
+        (filehandle, filename) = tempfile.mkstemp(suffix='.csv')
+        if os.name == "nt":
+            filename = filename.replace("\\", "/")
+        with os.fdopen(filehandle, "w") as f:
+            f.write("id,name,x,y\n")
+            for i in range(1, 3001):
+                if i % 3 == 0:
+                    f.write('{0},"name, {0}",{0},{0}\n'.format(i))
+                else:
+                    f.write('{0},name {0},{0},{0}\n'.format(i))
+
+        url = MyUrl.fromLocalFile(filename)
+        url.addQueryItem('type', 'csv')
+        url.addQueryItem('xField', 'x')
+        url.addQueryItem('yField', 'y')
+        layer = QgsVectorLayer(url.toString(), 'test', 'delimitedtext')
+        assert layer.isValid(), "Layer is not valid"
+        assert layer.featureCount() == 3000, "Expected 3000 features, got {}".format(layer.featureCount())
+
+        # Feature ids are line numbers, the header is on line 1
+        for fid in [2500, 3, 1999, 258, 257, 3001, 1000, 2]:
+            f = QgsFeature()
+            assert layer.getFeatures(QgsFeatureRequest(fid)).nextFeature(f), "Feature {} not found".format(fid)
+            id = fid - 1
+            expected = 'name, {}'.format(id) if id % 3 == 0 else 'name {}'.format(id)
+            assert f['id'] == id, "Feature {} has id {}".format(fid, f['id'])
+            assert f['name'] == expected, "Feature {} has name {}".format(fid, f['name'])
+
+        del layer
+        os.remove(filename)
+
 
 if __name__ == '__main__':
     unittest.main()